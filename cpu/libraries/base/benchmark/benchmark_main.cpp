@@ -0,0 +1,97 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <string>
+
+#include "motion_detector.hpp"
+#include "image_utils.hpp"
+
+/*
+    Measures the generic convolutions of the base library. Every kernel is run twice on the same frame, the way it used
+    to be computed and the way the library computes it now:
+     - Kernels called through a std::function, which is how the convolutions dispatched kernel operators before they were
+       templated on the callable type, against Kernel_functor_, which lets the compiler inline them.
+     - The median with the sorting network run on each pixel, against median_filter, which shares sorted columns
+       between neighbouring pixels and is vectorized.
+*/
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Run a function several times and get the average time it took.
+     * @param func Function to time.
+     * @param runs Amount of times to run it. >0.
+     * @return double Average milliseconds per run.
+     */
+    template <typename FUNC>
+    double time_ms(FUNC func, const std::size_t runs)
+    {
+        func(); // Warm up caches and page in the images.
+
+        Clock::time_point start = Clock::now();
+        for(std::size_t r = 0; r < runs; ++r) func();
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / runs;
+    }
+
+    void print_result(const std::string &name, const double before_ms, const double after_ms)
+    {
+        std::cout << name << ": before " << before_ms << " ms, after " << after_ms << " ms, speedup x" << before_ms / after_ms << std::endl;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    using namespace motdet::imgutil;
+
+    std::size_t width = 1920, height = 1080, runs = 10;
+    if(argc > 1) runs = std::stoul(argv[1]);
+    if(runs == 0)
+    {
+        std::cerr << "ERROR: runs must be >0." << std::endl;
+        return 1;
+    }
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 255);
+
+    motdet::Image<unsigned char> in(width, height, 0), out_uchar(width, height, 0);
+    motdet::Image<float> out_float(width, height, 0);
+    motdet::Image<short> out_short(width, height, 0);
+    for(std::size_t i = 0; i < in.get_total(); ++i) in[i] = distribution(generator);
+
+    std::cout << "Convolutions over a " << width << "x" << height << " frame, average of " << runs << " runs." << std::endl;
+
+    // Median 3x3
+    std::function<unsigned char(std::array<unsigned char, 9>&)> median_function = detail::kernel_op_median_3x3_<unsigned char, unsigned char>;
+    print_result("median 3x3 std::function",
+        time_ms([&]() { detail::square_convolution<unsigned char, unsigned char, 9>(in, out_uchar, median_function); }, runs),
+        time_ms([&]() { detail::square_convolution<unsigned char, unsigned char, 9>(in, out_uchar, detail::Kernel_functor_<detail::kernel_op_median_3x3_<unsigned char, unsigned char>>()); }, runs));
+
+    // Median 3x3 with sorted columns, against the inlined sorting network per pixel
+    print_result("median 3x3 sorted columns",
+        time_ms([&]() { detail::square_convolution<unsigned char, unsigned char, 9>(in, out_uchar, detail::Kernel_functor_<detail::kernel_op_median_3x3_<unsigned char, unsigned char>>()); }, runs),
+        time_ms([&]() { median_filter<unsigned char, unsigned char>(in, out_uchar); }, runs));
+
+    // Sobel 3x3
+    std::function<short(std::array<unsigned char, 9>&)> sobel_function = detail::kernel_op_sobel_h_3x3_<unsigned char, short>;
+    print_result("sobel 3x3 std::function",
+        time_ms([&]() { detail::square_convolution<unsigned char, short, 9>(in, out_short, sobel_function); }, runs),
+        time_ms([&]() { detail::square_convolution<unsigned char, short, 9>(in, out_short, detail::Kernel_functor_<detail::kernel_op_sobel_h_3x3_<unsigned char, short>>()); }, runs));
+
+    // Gaussian 5 vertical line
+    std::function<float(std::array<unsigned char, 5>&)> gaussian_function = detail::kernel_op_gaussian_5_<unsigned char, float>;
+    print_result("gaussian vline 5 std::function",
+        time_ms([&]() { detail::vline_convolution<unsigned char, float, 5>(in, out_float, gaussian_function); }, runs),
+        time_ms([&]() { detail::vline_convolution<unsigned char, float, 5>(in, out_float, detail::Kernel_functor_<detail::kernel_op_gaussian_5_<unsigned char, float>>()); }, runs));
+
+    // Dilation 3 horizontal line
+    std::function<unsigned char(std::array<unsigned char, 3>&)> dilation_function = detail::kernel_op_dilation_<unsigned char, unsigned char, 3>;
+    print_result("dilation hline 3 std::function",
+        time_ms([&]() { detail::hline_convolution<unsigned char, unsigned char, 3>(in, out_uchar, dilation_function); }, runs),
+        time_ms([&]() { detail::hline_convolution<unsigned char, unsigned char, 3>(in, out_uchar, detail::Kernel_functor_<detail::kernel_op_dilation_<unsigned char, unsigned char, 3>>()); }, runs));
+
+    return 0;
+}
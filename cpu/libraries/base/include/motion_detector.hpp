@@ -10,12 +10,124 @@
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <stdexcept>
+#include <type_traits>
 
 namespace motdet
 {
 
     // Class definitions
 
+    /**
+     * @brief Non-owning view of an image, or of a rectangular region of one. Every imgutil kernel works on views, so
+     * regions, horizontal strips or external buffers can be processed without copying them into an Image first.
+     * @details Pixel (i, j) is at row(i)[j], or at operator[](i*get_stride() + j). Images convert to views implicitly.
+     * The view does not own the pixels, the buffer must outlive it.
+     * @tparam T Type of pixel in the image. Use const T for read-only views.
+     */
+    template <typename T> class Image_view
+    {
+    public:
+        /**
+         * @brief Construct a view of an external buffer.
+         * @param data Pointer to the first pixel.
+         * @param width Length of each row.
+         * @param height Row count.
+         * @param stride Elements between the start of consecutive rows, padding included. 0 means no padding. Otherwise >= width.
+         * @throw invalid_argument if stride < width.
+         */
+        Image_view(T *data, const std::size_t width, const std::size_t height, const std::size_t stride = 0):
+            data_(data),
+            w_(width),
+            h_(height),
+            stride_(stride == 0 ? width : stride)
+        {
+            if(stride_ < w_) throw std::invalid_argument("ERROR Image_view: stride must be >= width.");
+        };
+
+        /**
+         * @brief Construct a read-only view from a mutable one.
+         */
+        template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+        Image_view(const Image_view<U> &other):
+            data_(other.data()),
+            w_(other.get_width()),
+            h_(other.get_height()),
+            stride_(other.get_stride())
+        {}
+
+        Image_view() = default;
+
+        // Operator Overload
+
+        /**
+         * @brief Returns the T element located at idx elements from the first pixel.
+         * @param idx Index to access. Rows are get_stride() elements apart.
+         * @return Element located at idx.
+         */
+        inline T& operator [](const std::size_t idx) const { return data_[idx]; };
+
+        // Getters and Setters
+
+        /**
+         * @brief Get the width
+         * @return std::size_t
+         */
+        inline std::size_t get_width() const  { return w_; };
+
+        /**
+         * @brief Get the height
+         * @return std::size_t
+         */
+        inline std::size_t get_height() const { return h_; };
+
+        /**
+         * @brief Get the total pixels, padding excluded
+         * @return std::size_t
+         */
+        inline std::size_t get_total() const  { return w_*h_; };
+
+        /**
+         * @brief Get the elements between the start of consecutive rows, padding included.
+         * @return std::size_t
+         */
+        inline std::size_t get_stride() const { return stride_; };
+
+        /**
+         * @brief Get a pointer to the first pixel.
+         * @return T*
+         */
+        inline T* data() const { return data_; };
+
+        /**
+         * @brief Get a pointer to the first pixel of a row.
+         * @param i Index of the row. <height.
+         * @return T*
+         */
+        inline T* row(const std::size_t i) const { return data_ + i*stride_; };
+
+        // General Methods
+
+        /**
+         * @brief Get a view of a rectangular region of this view. Shares the pixels and the stride.
+         * @param x Column where the region starts.
+         * @param y Row where the region starts.
+         * @param width Width of the region.
+         * @param height Height of the region.
+         * @return Image_view<T>
+         * @throw invalid_argument if the region does not fit within this view.
+         */
+        Image_view sub_view(const std::size_t x, const std::size_t y, const std::size_t width, const std::size_t height) const
+        {
+            if(x + width > w_ || y + height > h_) throw std::invalid_argument("ERROR sub_view: The region does not fit within the view.");
+            return Image_view(data_ + y*stride_ + x, width, height, stride_);
+        };
+
+    private:
+        T *data_ = nullptr;
+        std::size_t w_ = 0, h_ = 0, stride_ = 0;
+    };
+
     /**
      * @brief Represents an image (or video frame) as a flat structure.
      * @tparam T Type of pixel in the image. Cannot be bool, use unsigned char to store boolean values.
@@ -98,6 +210,16 @@ namespace motdet
          */
         inline std::size_t get_total() const  { return total_; };
 
+        /**
+         * @brief Get a view of the whole image. Images also convert to views implicitly.
+         * @return Image_view<T>
+         */
+        inline Image_view<T> view() { return Image_view<T>(data_.data(), w_, h_); };
+        inline Image_view<const T> view() const { return Image_view<const T>(data_.data(), w_, h_); };
+
+        inline operator Image_view<T>() { return view(); };
+        inline operator Image_view<const T>() const { return view(); };
+
         /**
          * @brief Get the internal data vector.
          * @return const std::vector<T>&
@@ -141,7 +263,7 @@ namespace motdet
         }
 
     private:
-        std::size_t w_, h_, total_;
+        std::size_t w_ = 0, h_ = 0, total_ = 0;
         std::vector<T> data_;
     };
 
@@ -367,6 +489,15 @@ namespace motdet
      */
     void uchar_to_bw(const unsigned char *in, const std::size_t n_pix, Image<unsigned short> &out);
 
+    /**
+     * @brief Turns an 8b luma (Y) plane into a 16b grayscale image, using the same scale as the RGB conversions.
+     * @details Useful for YUV inputs such as Y4M or NV12, where the luma plane can be used directly without decoding to RGB.
+     * @param in uchar C array with the luma plane. Must be of length n_pix.
+     * @param n_pix Number of pixels present in array "in".
+     * @param out 16b grayscale image that will be outputted.
+     */
+    void luma_to_bw(const unsigned char *in, const std::size_t n_pix, Image<unsigned short> &out);
+
 } // namespace motdet
 
 #endif // __MOTDET_MOTION_DETECTOR_HPP__
@@ -39,7 +39,7 @@ namespace motdet
          * @return true a valid pixel was found, and out_i, out_j is valid.
          * @return false a valid pixel was not found, and out_i, out_j is not valid.
          */
-        bool ccw_not0_(const Image<int> &in, const std::size_t i0, const std::size_t j0, const std::size_t i, const std::size_t j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j);
+        bool ccw_not0_(Image_view<const int> in, const std::size_t i0, const std::size_t j0, const std::size_t i, const std::size_t j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j);
 
         /**
          * @brief Find the first 0-pixel in the neighbourhood of a pixel x0,y0. Check neighbours rotating clockwise.
@@ -54,12 +54,12 @@ namespace motdet
          * @return true a valid pixel was found, and out_i, out_j is valid.
          * @return false a valid pixel was not found, and out_i, out_j is not valid.
          */
-        bool cw_not0_(const Image<int> &in, const int i0, const int j0, const int i, const int j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j);
+        bool cw_not0_(Image_view<const int> in, const int i0, const int j0, const int i, const int j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j);
 
         /**
          * @brief Follow a contour border while updating the Contour object. Modifies the input image with the ID for the contour that is being followed.
          * @param in Contour image that will be read and updated as we follow the contour.
-         * @param width Length of a row in the image.
+         * @param stride Elements between the start of consecutive rows of the image.
          * @param found_contour contour object that will be filled in with the found border.
          * @param i y position of the pixel that is beign analyzed.
          * @param j x position of the pixel that is beign analyzed.
@@ -68,7 +68,7 @@ namespace motdet
          * @param nbd the id of the current border.
          * @param lnbd the id of the prebious encoutnered border.
          */
-        void follow_border(Image<int> &in, std::size_t width, Extended_contour &found_contour, const std::size_t i, const std::size_t j, std::size_t i2, std::size_t j2, const int nbd, unsigned int &lnbd);
+        void follow_border(Image_view<int> in, std::size_t stride, Extended_contour &found_contour, const std::size_t i, const std::size_t j, std::size_t i2, std::size_t j2, const int nbd, unsigned int &lnbd);
 
 
 
@@ -104,50 +104,50 @@ namespace motdet
             return -1;
         }
 
-        bool ccw_not0_(const Image<int> &in, const std::size_t i0, const std::size_t j0, const std::size_t i, const std::size_t j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j)
+        bool ccw_not0_(Image_view<const int> in, const std::size_t i0, const std::size_t j0, const std::size_t i, const std::size_t j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j)
         {
             signed char id = neighbor_index_to_id_(i0,j0,i,j);
-            std::size_t width = in.get_width();
+            std::size_t stride = in.get_stride();
 
             for (std::size_t k = 0; k < 8; ++k)
             {
                 int kk = (k + id + offset) % 8;
                 neighbor_id_to_index_(i0, j0, kk, out_i, out_j);
 
-                if (in[out_i*width + out_j] != 0) return true;
+                if (in[out_i*stride + out_j] != 0) return true;
             }
             return false;
         }
 
 
-        bool cw_not0_(const Image<int> &in, const int i0, const int j0, const int i, const int j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j)
+        bool cw_not0_(Image_view<const int> in, const int i0, const int j0, const int i, const int j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j)
         {
             signed char id = neighbor_index_to_id_(i0,j0,i,j);
-            std::size_t width = in.get_width();
+            std::size_t stride = in.get_stride();
 
             for (std::size_t k = 0; k < 8; ++k)
             {
                 int kk = (-k + id - offset) % 8;
                 neighbor_id_to_index_(i0, j0, kk, out_i, out_j);
 
-                if (in[out_i*width + out_j] != 0) return true;
+                if (in[out_i*stride + out_j] != 0) return true;
             }
             return false;
         }
 
-        void contour_detection(Image<int> &conts_image, std::vector<Extended_contour> &conts, bool trim_borders)
+        void contour_detection(Image_view<int> conts_image, std::vector<Extended_contour> &conts, bool trim_borders)
         {
             // Topological Structural Analysis of Digitized Binary Images by Border Following.
             // By Suzuki, S. and Abe, K. 1985
             // Referece, by Lingdong Huang: https://github.com/LingDong-/PContour/blob/master/src/pcontour/PContour.java
 
-            std::size_t height = conts_image.get_height(), width = conts_image.get_width();
+            std::size_t height = conts_image.get_height(), width = conts_image.get_width(), stride = conts_image.get_stride();
 
             // Se the borders to zero. Required by the algorithm to avoid infinite loops and indexing errors.
             if(trim_borders)
             {
-                for(std::size_t i = 0; i < height; ++i) conts_image[i*width] = conts_image[(i+1)*width-1] = 0;
-                for(std::size_t i = 1; i < width-1; ++i) conts_image[i] = conts_image[(height-1)*width+i] = 0;
+                for(std::size_t i = 0; i < height; ++i) conts_image[i*stride] = conts_image[i*stride+width-1] = 0;
+                for(std::size_t i = 1; i < width-1; ++i) conts_image[i] = conts_image[(height-1)*stride+i] = 0;
             }
 
             int nbd = 1;           // Current contour
@@ -167,7 +167,7 @@ namespace motdet
                     std::size_t i2 = 0, j2 = 0;
 
                     // If the pixel is not a contour edge, nothing to do.
-                    if (conts_image[i*width + j] == 0) continue;
+                    if (conts_image[i*stride + j] == 0) continue;
 
                     // (a) If fij = 1 and fi, j-1 = 0, then decide that the pixel (i, j) is the border following
                     // starting point of an outer border, increment NBD, and (i2, j2) <- (i, j - 1).
@@ -175,7 +175,7 @@ namespace motdet
                     // hole border, increment NBD, (i2, j2) <- (i, j + 1), and LNBD + fij in case fij > 1.
                     // (c) Otherwise, go to (4).
 
-                    std::size_t curr_idx = i*width + j;
+                    std::size_t curr_idx = i*stride + j;
                     if (conts_image[curr_idx] == 1 && conts_image[curr_idx - 1] == 0)
                     {
                         ++nbd;
@@ -240,13 +240,13 @@ namespace motdet
                     }
 
                     // Follow the contour while updating it's data.
-                    follow_border(conts_image, width, found_contour, i, j, i2, j2, nbd, lnbd);
+                    follow_border(conts_image, stride, found_contour, i, j, i2, j2, nbd, lnbd);
                     conts.push_back(std::move(found_contour));
                 }
             }
         }
 
-        void follow_border(Image<int> &in, std::size_t width, Extended_contour &found_contour, const std::size_t i, const std::size_t j, std::size_t i2, std::size_t j2, const int nbd, unsigned int &lnbd)
+        void follow_border(Image_view<int> in, std::size_t stride, Extended_contour &found_contour, const std::size_t i, const std::size_t j, std::size_t i2, std::size_t j2, const int nbd, unsigned int &lnbd)
         {
             // (3) From the starting point (i, j), follow the detected border:
             // this is done by the following substeps (3.1) through (3.5).
@@ -256,7 +256,7 @@ namespace motdet
             // Let (i1, j1) be the first found nonzero pixel. If no nonzero
             // pixel is found, assign -NBD to fij and go to (4).
 
-            std::size_t curr_idx = i*width + j;
+            std::size_t curr_idx = i*stride + j;
             std::size_t i1 = 0, j1 = 0;
             if(!cw_not0_(in, i, j, i2, j2, 0, i1, j1))
             {
@@ -301,7 +301,7 @@ namespace motdet
                 //     in the substep (3.3) and fi3,j3 = 1, then fi3,j3 <- NBD.
                 // (c) Otherwise, do not change fi3, j3.
 
-                std::size_t curr_idx3 = i3*width + j3;
+                std::size_t curr_idx3 = i3*stride + j3;
                 if (in[curr_idx3 + 1] == 0) in[curr_idx3] = -nbd;
                 else if(in[curr_idx3] == 1) in[curr_idx3] = nbd;
 
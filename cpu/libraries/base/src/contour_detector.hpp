@@ -18,7 +18,7 @@ namespace motdet
          * @param trim_borders if the input image has any value other than 0 in the outermost borders, it must be trimmed to apply this algorithm to it.
          * Deactivate for better speed but make sure the input matrix has 0-pixel borders, else the function can hang in an infinite loop or segfault.
          */
-        void contour_detection(Image<int> &in, std::vector<Extended_contour> &conts, bool trim_borders = true);
+        void contour_detection(Image_view<int> in, std::vector<Extended_contour> &conts, bool trim_borders = true);
 
     } // namespace imgutil
 } // namespace motdet
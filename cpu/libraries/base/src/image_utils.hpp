@@ -6,9 +6,11 @@
 #include <iostream>
 #include <cstddef>    // std::size_t
 #include <array>      // std::array
-#include <functional> // std::function
 #include <cmath>      // std::atan2 std::abs
 #include <stack>      // std::stack
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+#include <algorithm>  // std::min std::max
 
 /*
     This a template headers file. The implementation of the functions has been put in image_utils.ipp so that it resembled the structure
@@ -19,6 +21,10 @@
     For example if you have an uchar image and need an int image for another function (i.e. contour detection)
     you template the function to input uchar and output int and it will be done.
     These templates require the type to be a BASIC TYPE, but if you make a custom type behave like a basic type, it will work too.
+
+    Every function takes Image_view arguments, so they can also work on regions of an image or on external buffers.
+    Images convert to views implicitly, but template arguments are not deduced through that conversion, so the pixel
+    types have to be given explicitly when passing Images, i.e. dilation<unsigned char, int>(in, out).
 */
 
 namespace motdet
@@ -30,17 +36,17 @@ namespace motdet
             inline float pi_ = 3.1416; /**< The constant PI. */
             inline unsigned char n_pixel_neighbor_ = 8; /**< Amount of pixels that surround a given pixel. In this case, 8. */
 
-            inline std::array<float, 7> gaussian_kernel_5_({ 0.06136, 0.24477, 0.38775, 0.24477, 0.06136 });
+            inline constexpr std::array<float, 7> gaussian_kernel_5_({ 0.06136, 0.24477, 0.38775, 0.24477, 0.06136 });
 
             // 3x3 Horizontal sobel edge detection kernel.
-            inline std::array<signed char, 9> sobel_h_kernel_3x3_({
+            inline constexpr std::array<signed char, 9> sobel_h_kernel_3x3_({
                 1,  0, -1,
                 2,  0, -2,
                 1,  0, -1
             });
 
             // 3x3 Vertical sobel edge detection kernel.
-            inline std::array<signed char, 9> sobel_v_kernel_3x3_({
+            inline constexpr std::array<signed char, 9> sobel_v_kernel_3x3_({
                 1,   2,  1,
                 0,   0,  0,
                -1,  -2, -1
@@ -54,7 +60,7 @@ namespace motdet
              * @return The pixel from these 9 pixels that represents the median.
              */
             template <typename IN_T, typename OUT_T>
-            OUT_T kernel_op_median_3x3_(std::array<IN_T, 9> &p);
+            OUT_T kernel_op_median_3x3_(std::array<IN_T, 9> p);
 
             /**
              * @brief Image kernel function. Get the Gaussian blur value of a line kernel of length 5.
@@ -64,7 +70,7 @@ namespace motdet
              * @return The value of the final blurred pixel.
              */
             template <typename IN_T, typename OUT_T>
-            OUT_T kernel_op_gaussian_5_(const std::array<IN_T, 5> &p);
+            OUT_T kernel_op_gaussian_5_(const std::array<IN_T, 5> p);
 
             /**
              * @brief Image kernel function. Detect horizontal edge value of a 3x3 kernel. The result can be negative.
@@ -74,7 +80,7 @@ namespace motdet
              * @return The value of the horizontal edge.
              */
             template <typename IN_T, typename OUT_T>
-            OUT_T kernel_op_sobel_h_3x3_(const std::array<IN_T, 9> &p);
+            OUT_T kernel_op_sobel_h_3x3_(const std::array<IN_T, 9> p);
 
             /**
              * @brief Image kernel function. Detect vertical edge value of a 3x3 kernel. The result can be negative.
@@ -84,7 +90,7 @@ namespace motdet
              * @return The value of the vertical edge.
              */
             template <typename IN_T, typename OUT_T>
-            OUT_T kernel_op_sobel_v_3x3_(const std::array<IN_T, 9> &p);
+            OUT_T kernel_op_sobel_v_3x3_(const std::array<IN_T, 9> p);
 
             /**
              * @brief Image kernel function. Returns 1 if any 1-pixel is in the kernel, else return 0.
@@ -95,7 +101,7 @@ namespace motdet
              * @return The value of the dilated pixel.
              */
             template <typename IN_T, typename OUT_T, std::size_t SIZE_K>
-            OUT_T kernel_op_dilation_(const std::array<IN_T, SIZE_K> &p);
+            OUT_T kernel_op_dilation_(const std::array<IN_T, SIZE_K> p);
 
             /**
              * @brief Image kernel function. Returns 0 if a 0-pixel is in the kernel, else return 1.
@@ -106,7 +112,20 @@ namespace motdet
              * @return The value of the eroded pixel.
              */
             template <typename IN_T, typename OUT_T, std::size_t SIZE_K>
-            OUT_T kernel_op_erosion_(const std::array<IN_T, SIZE_K> &p);
+            OUT_T kernel_op_erosion_(const std::array<IN_T, SIZE_K> p);
+
+            /**
+             * @brief Wraps a kernel function into a type of its own. The convolutions are templated on the type of the
+             * kernel operator, so passing this instead of a function pointer lets the compiler inline the kernel function
+             * into the pixel loop.
+             * @tparam KERNEL_FUNC Kernel function to wrap, i.e. kernel_op_median_3x3_<unsigned char, unsigned char>.
+             */
+            template <auto KERNEL_FUNC>
+            struct Kernel_functor_
+            {
+                template <typename ARRAY_T>
+                inline auto operator()(const ARRAY_T &p) const { return KERNEL_FUNC(p); }
+            };
 
             /**
              * @brief Fast square root approximation by Jim Ulery.
@@ -134,6 +153,14 @@ namespace motdet
             template <typename IN_T>
             inline void pixel_sort_(IN_T &a, IN_T &b) { if (a > b) pixel_swap_<IN_T>(a, b); }
 
+            /**
+             * @brief Median of 3 values, with min and max only so it compiles to vector instructions in a loop.
+             * @tparam IN_T Type of the values. Must be a basic type.
+             * @return The value that is neither the smallest nor the biggest.
+             */
+            template <typename IN_T>
+            inline IN_T median_3_(const IN_T a, const IN_T b, const IN_T c) { return std::max(std::min(a, b), std::min(std::max(a, b), c)); }
+
             /**
              * @brief Apply a generic square kernel to an image.
              * The kernel is applied by a function that takes all the pixels in and array and outputs the pixel result.
@@ -142,10 +169,13 @@ namespace motdet
              * @tparam K_SIZE is the size of the kernel to extract around each pixel. Must be powers of odd numbers: 1, 9, 25, 49...
              * @param in Image to convolute.
              * @param out Image convoluted with the given kernel operator.
-             * @param kernel_operator Function that receives the values of all the kernel elements and outputs the pixel value.
+             * @tparam KERNEL_OP Type of the kernel operator. Lambdas, functors and Kernel_functor_ are inlined in the pixel
+             * loop, while function pointers and std::function add an indirect call per pixel.
+             * @param kernel_operator Callable that receives an std::array<IN_T, K_SIZE> with the values of all the kernel
+             * elements, and returns the pixel value as OUT_T. The array can be modified.
              */
-            template<typename IN_T, typename OUT_T, std::size_t K_SIZE>
-            void square_convolution(const Image<IN_T> &in, Image<OUT_T> &out, const std::function<OUT_T(std::array<IN_T, K_SIZE>&)> kernel_operator);
+            template<typename IN_T, typename OUT_T, std::size_t K_SIZE, typename KERNEL_OP>
+            void square_convolution(Image_view<const IN_T> in, Image_view<OUT_T> out, KERNEL_OP kernel_operator);
 
             /**
              * @brief Apply a vertical line kernel to an image.
@@ -155,10 +185,13 @@ namespace motdet
              * @tparam K_SIZE is the size of the kernel to extract. Must be odd numbers: 1, 3, 5, 7...
              * @param in Image to convolute.
              * @param out Image convoluted with the given kernel operator.
-             * @param kernel_operator Function that receives the values of all the kernel elements and outputs the pixel value.
+             * @tparam KERNEL_OP Type of the kernel operator. Lambdas, functors and Kernel_functor_ are inlined in the pixel
+             * loop, while function pointers and std::function add an indirect call per pixel.
+             * @param kernel_operator Callable that receives an std::array<IN_T, K_SIZE> with the values of all the kernel
+             * elements, and returns the pixel value as OUT_T. The array can be modified.
              */
-            template<typename IN_T, typename OUT_T, std::size_t K_SIZE>
-            void vline_convolution(const Image<IN_T> &in, Image<OUT_T> &out, const std::function<OUT_T(std::array<IN_T, K_SIZE>&)> kernel_operator);
+            template<typename IN_T, typename OUT_T, std::size_t K_SIZE, typename KERNEL_OP>
+            void vline_convolution(Image_view<const IN_T> in, Image_view<OUT_T> out, KERNEL_OP kernel_operator);
 
             /**
              * @brief Apply a horizontal line kernel to an image.
@@ -168,10 +201,13 @@ namespace motdet
              * @tparam K_SIZE is the size of the kernel to extract. Must be odd numbers: 1, 3, 5, 7...
              * @param in Image to convolute.
              * @param out Image convoluted with the given kernel operator.
-             * @param kernel_operator Function that receives the values of all the kernel elements and outputs the pixel value.
+             * @tparam KERNEL_OP Type of the kernel operator. Lambdas, functors and Kernel_functor_ are inlined in the pixel
+             * loop, while function pointers and std::function add an indirect call per pixel.
+             * @param kernel_operator Callable that receives an std::array<IN_T, K_SIZE> with the values of all the kernel
+             * elements, and returns the pixel value as OUT_T. The array can be modified.
              */
-            template<typename IN_T, typename OUT_T, std::size_t K_SIZE>
-            void hline_convolution(const Image<IN_T> &in, Image<OUT_T> &out, const std::function<OUT_T(std::array<IN_T, K_SIZE>&)> kernel_operator);
+            template<typename IN_T, typename OUT_T, std::size_t K_SIZE, typename KERNEL_OP>
+            void hline_convolution(Image_view<const IN_T> in, Image_view<OUT_T> out, KERNEL_OP kernel_operator);
 
         } // namespace detail
 
@@ -183,17 +219,21 @@ namespace motdet
          * @param out Grayscale blurred image.
          */
         template <typename IN_T, typename OUT_T>
-        void gaussian_blur_filter(const Image<IN_T> &in, Image<OUT_T> &out);
+        void gaussian_blur_filter(Image_view<const IN_T> in, Image_view<OUT_T> out);
 
         /**
          * @brief Apply a 3x3 median filter to an image. Useful for salt&pepper noise.
+         * @details Gives the same result as a square_convolution with kernel_op_median_3x3_, but much faster. The 3 pixels
+         * of every column are sorted once and shared by the 3 output pixels that contain them, and the median of the 3
+         * sorted columns is found with the 3 minimums, 3 medians and 3 maximums. Each step is a min/max over whole rows,
+         * which the compiler turns into vector instructions.
          * @tparam IN_T must be a basic type of any length.
          * @tparam OUT_T must be a basic type of equal or greater length than IN_T.
          * @param in Grayscale image to process.
          * @param out Grayscale image with noise removed.
          */
         template <typename IN_T, typename OUT_T>
-        void median_filter(const Image<IN_T> &in, Image<OUT_T> &out);
+        void median_filter(Image_view<const IN_T> in, Image_view<OUT_T> out);
 
         /**
          * @brief Gets the absolute difference between 2 images (always positive). Useful for motion detection.
@@ -204,7 +244,7 @@ namespace motdet
          * @param out Subtracted grayscale image, values are always positive.
          */
         template <typename IN_T, typename OUT_T>
-        void image_subtraction(const Image<IN_T> &in1, const Image<IN_T> &in2, Image<OUT_T> &out);
+        void image_subtraction(Image_view<const IN_T> in1, Image_view<const IN_T> in2, Image_view<OUT_T> out);
 
         /**
          * @brief Edge detection that produces a strictly binary image. 0 for no edge, 1 for edge.
@@ -216,7 +256,7 @@ namespace motdet
          * @param high_threshold Edges above this strength value are assured to appear in the final result. Strong edges.
          */
         template <typename OUT_T>
-        void canny_edge_detection_8b(const Image<unsigned char> &in, Image<OUT_T> &out, const unsigned char low_threshold, const unsigned char high_threshold);
+        void canny_edge_detection_8b(Image_view<const unsigned char> in, Image_view<OUT_T> out, const unsigned char low_threshold, const unsigned char high_threshold);
 
 
         /**
@@ -227,7 +267,7 @@ namespace motdet
          * @param out_gradient Grayscale image with the direction of the edges. 0 is 0 deg, 255 is 360 deg, it prioritizes memory efficiency to precision.
          */
         template<typename OUT_T>
-        void sobel_edge_detection_8b(const Image<unsigned char> &in, Image<OUT_T> &out_magnitude, Image<unsigned char> &out_gradient);
+        void sobel_edge_detection_8b(Image_view<const unsigned char> in, Image_view<OUT_T> out_magnitude, Image_view<unsigned char> out_gradient);
 
 
         /**
@@ -239,7 +279,7 @@ namespace motdet
          * @param out Grayscale image with reduces edge thickness.
          */
         template<typename IN_T, typename OUT_T>
-        void non_max_suppression(const Image<IN_T> &in_magnitude, const Image<unsigned char> &in_gradient, Image<OUT_T> &out);
+        void non_max_suppression(Image_view<const IN_T> in_magnitude, Image_view<const unsigned char> in_gradient, Image_view<OUT_T> out);
 
         /**
          * @brief Collapses all the values in a grayscale image to the states Culled 0, Strong 1 and Weak 2 depending on 2 thresholds.
@@ -251,7 +291,7 @@ namespace motdet
          * @param high_threshold Any value equal or above this threshold is transformed to Strong. REQ: high_threshold > low_threshold.
          */
         template <typename IN_T, typename OUT_T>
-        void double_threshold(const Image<IN_T> &in, Image<OUT_T> &out, const IN_T low_threshold, const IN_T high_threshold);
+        void double_threshold(Image_view<const IN_T> in, Image_view<OUT_T> out, const IN_T low_threshold, const IN_T high_threshold);
 
         /**
          * @brief Collapses all the values in a grayscale image to the states Culled 0 and Strong 1 depending on a threshold.
@@ -262,7 +302,7 @@ namespace motdet
          * @param threshold Any value below this threshold is set to Culled, the rest are Strong.
          */
         template <typename IN_T, typename OUT_T>
-        void single_threshold(const Image<IN_T> &in, Image<OUT_T> &out, const IN_T threshold);
+        void single_threshold(Image_view<const IN_T> in, Image_view<OUT_T> out, const IN_T threshold);
 
         /**
          * @brief Takes the output of a double threshold function and turns Weak pixel into either Strong or Culled.
@@ -273,7 +313,7 @@ namespace motdet
          * @param out Image with 2 possible values: Culled 0, Strong 1.
          */
         template <typename IN_T, typename OUT_T>
-        void hysteresis(const Image<IN_T> &in, Image<OUT_T> &out);
+        void hysteresis(Image_view<const IN_T> in, Image_view<OUT_T> out);
 
         /**
          * @brief Creates an intermediate image between 2 given images. If ratio is 1 it will be equivalent to "to", and 0 will be equivalent to "from".
@@ -285,7 +325,7 @@ namespace motdet
          * @param ratio Selector for which input image has more relevance. [0-1]
          */
         template <typename IN_T, typename OUT_T>
-        void image_interpolation(const Image<IN_T> &from, const Image<IN_T> &to, Image<OUT_T> &out, const float ratio);
+        void image_interpolation(Image_view<const IN_T> from, Image_view<const IN_T> to, Image_view<OUT_T> out, const float ratio);
 
         /**
          * @brief Takes a binary image (0 or 1) and dilates the 1-pixels. It interprets any value above 1 as 1. Below 0 is 0.
@@ -295,7 +335,7 @@ namespace motdet
          * @param out Dilated binary image.
          */
         template <typename IN_T, typename OUT_T>
-        void dilation(const Image<IN_T> &in, Image<OUT_T> &out);
+        void dilation(Image_view<const IN_T> in, Image_view<OUT_T> out);
 
         /**
          * @brief Takes a binary image (0 or 1) and erodes the 1-pixels. It interprets any value above 1 as 1. Below 0 is 0.
@@ -305,7 +345,7 @@ namespace motdet
          * @param out Eroded binary image.
          */
         template <typename IN_T, typename OUT_T>
-        void erosion(const Image<IN_T> &in, Image<OUT_T> &out);
+        void erosion(Image_view<const IN_T> in, Image_view<OUT_T> out);
 
         /**
          * @brief Turn an image that only contains the values 0 and 1 to an image that only contains the values 0 and max_val.
@@ -316,7 +356,7 @@ namespace motdet
          * @param max_val The value that will represent 1 in the output image.
          */
         template<typename IN_T, typename OUT_T>
-        void reescale_pix_length(const Image<IN_T> &in, Image<OUT_T> &out, IN_T in_max_val, OUT_T out_max_val);
+        void reescale_pix_length(Image_view<const IN_T> in, Image_view<OUT_T> out, IN_T in_max_val, OUT_T out_max_val);
 
         /**
          * @brief Resizes to a lower resolution by a given factor. Ignores floating point precision.
@@ -327,7 +367,7 @@ namespace motdet
          * @param factor Factor to resize the image, must be > 0.
          */
         template<typename IN_T, typename OUT_T>
-        void downsample(const Image<IN_T> &in, Image<OUT_T> &out, std::size_t factor);
+        void downsample(Image_view<const IN_T> in, Image_view<OUT_T> out, std::size_t factor);
 
         /**
          * @brief Resizes to a higher resolution by a given factor.
@@ -338,7 +378,7 @@ namespace motdet
          * @param factor Factor to resize the image, must be > 0.
          */
         template<typename IN_T, typename OUT_T>
-        void upsample(const Image<IN_T> &in, Image<OUT_T> &out, std::size_t factor);
+        void upsample(Image_view<const IN_T> in, Image_view<OUT_T> out, std::size_t factor);
 
         // Include the file with the actual definitions for the headers we have declared above.
         #include "image_utils.ipp"
@@ -2,7 +2,7 @@
 namespace detail
 {
     template <typename IN_T, typename OUT_T>
-    OUT_T kernel_op_median_3x3_(std::array<IN_T, 9> &p)
+    OUT_T kernel_op_median_3x3_(std::array<IN_T, 9> p)
     {
         // This is the fastest known algorithm without making assumptions about the input.
         // "Borrowed" from http://ndevilla.free.fr/median/median.pdf
@@ -19,7 +19,7 @@ namespace detail
     }
 
     template <typename IN_T, typename OUT_T>
-    OUT_T kernel_op_gaussian_5_(const std::array<IN_T, 5> &p)
+    OUT_T kernel_op_gaussian_5_(const std::array<IN_T, 5> p)
     {
         double total = 0;
         for(std::size_t i = 0; i < 5; ++i) total += p[i] * gaussian_kernel_5_[i];
@@ -27,7 +27,7 @@ namespace detail
     }
 
     template <typename IN_T, typename OUT_T>
-    OUT_T kernel_op_sobel_h_3x3_(const std::array<IN_T, 9> &p)
+    OUT_T kernel_op_sobel_h_3x3_(const std::array<IN_T, 9> p)
     {
         OUT_T total = 0;
         for(std::size_t i = 0; i < 9; ++i) total += p[i] * sobel_h_kernel_3x3_[i];
@@ -35,7 +35,7 @@ namespace detail
     }
 
     template <typename IN_T, typename OUT_T>
-    OUT_T kernel_op_sobel_v_3x3_(const std::array<IN_T, 9> &p)
+    OUT_T kernel_op_sobel_v_3x3_(const std::array<IN_T, 9> p)
     {
         OUT_T total = 0;
         for(std::size_t i = 0; i < 9; ++i) total += p[i] * sobel_v_kernel_3x3_[i];
@@ -43,7 +43,7 @@ namespace detail
     }
 
     template <typename IN_T, typename OUT_T, std::size_t SIZE_K>
-    OUT_T kernel_op_dilation_(const std::array<IN_T, SIZE_K> &p)
+    OUT_T kernel_op_dilation_(const std::array<IN_T, SIZE_K> p)
     {
         for(const IN_T &i: p)
         {
@@ -53,7 +53,7 @@ namespace detail
     }
 
     template <typename IN_T, typename OUT_T, std::size_t SIZE_K>
-    OUT_T kernel_op_erosion_(const std::array<IN_T, SIZE_K> &p)
+    OUT_T kernel_op_erosion_(const std::array<IN_T, SIZE_K> p)
     {
         for(const IN_T &i: p)
         {
@@ -80,11 +80,11 @@ namespace detail
         return g;
     }
 
-    template<typename IN_T, typename OUT_T, std::size_t K_SIZE>
-    void square_convolution(const Image<IN_T> &in, Image<OUT_T> &out, const std::function<OUT_T(std::array<IN_T, K_SIZE>&)> kernel_operator)
+    template<typename IN_T, typename OUT_T, std::size_t K_SIZE, typename KERNEL_OP>
+    void square_convolution(Image_view<const IN_T> in, Image_view<OUT_T> out, KERNEL_OP kernel_operator)
     {
         std::size_t current_pos;
-        std::size_t height = in.get_height(), width = in.get_width();
+        std::size_t height = in.get_height(), width = in.get_width(), in_stride = in.get_stride(), out_stride = out.get_stride();
         int kernel_side, kernel_radius;
 
         kernel_side = detail::fast_sqrt_(K_SIZE); // Since a kernel is strictly square, the square root is the side length.
@@ -98,7 +98,7 @@ namespace detail
         {
             for(std::size_t j = 0; j < width; ++j)
             {
-                current_pos = i * width + j;
+                current_pos = i * out_stride + j;
 
                 for(int ki = -kernel_radius; ki <= kernel_radius; ++ki)
                 {
@@ -114,7 +114,7 @@ namespace detail
                         else if (real_kj >= width) real_kj = width-1;
 
                         // Fill in the kernel that will be passed to the function with the values extracted from the image.
-                        extracted_kernel[(ki + kernel_radius)*kernel_side + kj + kernel_radius] = in[real_ki*width + real_kj];
+                        extracted_kernel[(ki + kernel_radius)*kernel_side + kj + kernel_radius] = in[real_ki*in_stride + real_kj];
                     }
                 }
                 // The kernel has been fully extracted, time to execute kernel operation.
@@ -123,11 +123,11 @@ namespace detail
         }
     }
 
-    template<typename IN_T, typename OUT_T, std::size_t K_SIZE>
-    void vline_convolution(const Image<IN_T> &in, Image<OUT_T> &out, const std::function<OUT_T(std::array<IN_T, K_SIZE>&)> kernel_operator)
+    template<typename IN_T, typename OUT_T, std::size_t K_SIZE, typename KERNEL_OP>
+    void vline_convolution(Image_view<const IN_T> in, Image_view<OUT_T> out, KERNEL_OP kernel_operator)
     {
         std::size_t current_pos;
-        std::size_t height = in.get_height(), width = in.get_width();
+        std::size_t height = in.get_height(), width = in.get_width(), in_stride = in.get_stride(), out_stride = out.get_stride();
         int kernel_radius;
 
         if(K_SIZE % 2 == 0) throw std::invalid_argument("Kernel is of invalid size.");
@@ -140,7 +140,7 @@ namespace detail
         {
             for(std::size_t j = 0; j < width; ++j)
             {
-                current_pos = i * width + j;
+                current_pos = i * out_stride + j;
 
                 for(int ki = -kernel_radius; ki <= kernel_radius; ++ki)
                 {
@@ -150,7 +150,7 @@ namespace detail
                     else if (real_ki >= height) real_ki = height-1;
 
                     // Fill in the kernel that will be passed to the function with the values extracted from the image.
-                    extracted_kernel[ki + kernel_radius] = in[real_ki*width + j];
+                    extracted_kernel[ki + kernel_radius] = in[real_ki*in_stride + j];
                 }
                 // The kernel has been fully extracted, time to execute kernel operation.
                 out[current_pos] = kernel_operator(extracted_kernel);
@@ -158,11 +158,11 @@ namespace detail
         }
     }
 
-    template<typename IN_T, typename OUT_T, std::size_t K_SIZE>
-    void hline_convolution(const Image<IN_T> &in, Image<OUT_T> &out, const std::function<OUT_T(std::array<IN_T, K_SIZE>&)> kernel_operator)
+    template<typename IN_T, typename OUT_T, std::size_t K_SIZE, typename KERNEL_OP>
+    void hline_convolution(Image_view<const IN_T> in, Image_view<OUT_T> out, KERNEL_OP kernel_operator)
     {
         std::size_t current_pos;
-        std::size_t height = in.get_height(), width = in.get_width();
+        std::size_t height = in.get_height(), width = in.get_width(), in_stride = in.get_stride(), out_stride = out.get_stride();
         int kernel_radius;
 
         if(K_SIZE % 2 == 0) throw std::invalid_argument("Kernel is of invalid size.");
@@ -175,7 +175,7 @@ namespace detail
         {
             for(std::size_t j = 0; j < width; ++j)
             {
-                current_pos = i * width + j;
+                current_pos = i * out_stride + j;
 
                 for(int kj = -kernel_radius; kj <= kernel_radius; ++kj)
                 {
@@ -185,7 +185,7 @@ namespace detail
                     else if (real_kj >= width) real_kj = width-1;
 
                     // Fill in the kernel that will be passed to the function with the values extracted from the image.
-                    extracted_kernel[kj + kernel_radius] = in[i*width + real_kj];
+                    extracted_kernel[kj + kernel_radius] = in[i*in_stride + real_kj];
                 }
                 // The kernel has been fully extracted, time to execute kernel operation.
                 out[current_pos] = kernel_operator(extracted_kernel);
@@ -196,7 +196,7 @@ namespace detail
 } // namespace detail
 
 template <typename IN_T, typename OUT_T>
-void gaussian_blur_filter(const Image<IN_T> &in, Image<OUT_T> &out)
+void gaussian_blur_filter(Image_view<const IN_T> in, Image_view<OUT_T> out)
 {
     std::size_t height = in.get_height(), width = in.get_width();
     Image<float> half_blurred(width, height, {});
@@ -204,30 +204,66 @@ void gaussian_blur_filter(const Image<IN_T> &in, Image<OUT_T> &out)
     // An NxN gaussian blur can be decomposed into 2 1-dimensional kernels, N vertical and N horizontal.
     // Using float as the intermediate pixel type to avoid detail loss between steps.
 
-    detail::vline_convolution<IN_T, float, 5>(in, half_blurred, detail::kernel_op_gaussian_5_<IN_T, float>);
-    detail::hline_convolution<float, OUT_T, 5>(half_blurred, out, detail::kernel_op_gaussian_5_<float, IN_T>);
+    detail::vline_convolution<IN_T, float, 5>(in, half_blurred, detail::Kernel_functor_<detail::kernel_op_gaussian_5_<IN_T, float>>());
+    detail::hline_convolution<float, OUT_T, 5>(half_blurred, out, detail::Kernel_functor_<detail::kernel_op_gaussian_5_<float, IN_T>>());
 }
 
 template <typename IN_T, typename OUT_T>
-void median_filter(const Image<IN_T> &in, Image<OUT_T> &out)
+void median_filter(Image_view<const IN_T> in, Image_view<OUT_T> out)
 {
-    detail::square_convolution<IN_T, OUT_T, 9>(in, out, detail::kernel_op_median_3x3_<IN_T, OUT_T>);
+    std::size_t height = in.get_height(), width = in.get_width();
+
+    // Minimum, median and maximum of the 3 pixels of each column around the current row. The columns outside the image
+    // replicate the border ones, same as square_convolution.
+    std::vector<IN_T> col_min(width + 2), col_med(width + 2), col_max(width + 2);
+
+    for(std::size_t i = 0; i < height; ++i)
+    {
+        const IN_T *up = in.row(i == 0 ? 0 : i-1), *center = in.row(i), *down = in.row(i == height-1 ? height-1 : i+1);
+        OUT_T *out_row = out.row(i);
+
+        for(std::size_t j = 0; j < width; ++j)
+        {
+            IN_T low = std::min(up[j], center[j]), high = std::max(up[j], center[j]);
+            col_min[j+1] = std::min(low, down[j]);
+            col_med[j+1] = std::max(low, std::min(high, down[j]));
+            col_max[j+1] = std::max(high, down[j]);
+        }
+        col_min[0] = col_min[1]; col_min[width+1] = col_min[width];
+        col_med[0] = col_med[1]; col_med[width+1] = col_med[width];
+        col_max[0] = col_max[1]; col_max[width+1] = col_max[width];
+
+        // The median of the 9 pixels is the median of the biggest minimum, the median of medians and the smallest maximum.
+        for(std::size_t j = 0; j < width; ++j)
+        {
+            IN_T max_of_min = std::max(std::max(col_min[j], col_min[j+1]), col_min[j+2]);
+            IN_T med_of_med = detail::median_3_(col_med[j], col_med[j+1], col_med[j+2]);
+            IN_T min_of_max = std::min(std::min(col_max[j], col_max[j+1]), col_max[j+2]);
+            out_row[j] = detail::median_3_(max_of_min, med_of_med, min_of_max);
+        }
+    }
 }
 
 template <typename IN_T, typename OUT_T>
-void image_subtraction(const Image<IN_T> &in1, const Image<IN_T> &in2, Image<OUT_T> &out)
+void image_subtraction(Image_view<const IN_T> in1, Image_view<const IN_T> in2, Image_view<OUT_T> out)
 {
-    std::size_t total = in1.get_total();
+    std::size_t height = in1.get_height(), width = in1.get_width();
 
-    for(std::size_t i = 0; i < total; ++i)
+    for(std::size_t i = 0; i < height; ++i)
     {
-        if(in1[i] > in2[i]) out[i] = in1[i] - in2[i];
-        else                out[i] = in2[i] - in1[i];
+        const IN_T *in1_row = in1.row(i), *in2_row = in2.row(i);
+        OUT_T *out_row = out.row(i);
+
+        for(std::size_t j = 0; j < width; ++j)
+        {
+            if(in1_row[j] > in2_row[j]) out_row[j] = in1_row[j] - in2_row[j];
+            else                        out_row[j] = in2_row[j] - in1_row[j];
+        }
     }
 }
 
 template <typename OUT_T>
-void canny_edge_detection_8b(const Image<unsigned char> &in, Image<OUT_T> &out, const unsigned char low_threshold, const unsigned char high_threshold)
+void canny_edge_detection_8b(Image_view<const unsigned char> in, Image_view<OUT_T> out, const unsigned char low_threshold, const unsigned char high_threshold)
 {
     std::size_t height = in.get_height(), width = in.get_width();
 
@@ -240,49 +276,57 @@ void canny_edge_detection_8b(const Image<unsigned char> &in, Image<OUT_T> &out,
 }
 
 template<typename OUT_T>
-void sobel_edge_detection_8b(const Image<unsigned char> &in, Image<OUT_T> &out_magnitude, Image<unsigned char> &out_gradient)
+void sobel_edge_detection_8b(Image_view<const unsigned char> in, Image_view<OUT_T> out_magnitude, Image_view<unsigned char> out_gradient)
 {
     short aux_mag; // input is 8b and we need a signed type of 10b. Closest candidate is short.
     double aux_gra;
 
-    std::size_t height = in.get_height(), width = in.get_width(), total = in.get_total();
+    std::size_t height = in.get_height(), width = in.get_width();
     Image<short> sobel_h(width, height, {}), sobel_v(width, height, {});
 
-    detail::square_convolution<unsigned char, short, 9>(in, sobel_h, detail::kernel_op_sobel_h_3x3_<unsigned char, short>);
-    detail::square_convolution<unsigned char, short, 9>(in, sobel_v, detail::kernel_op_sobel_v_3x3_<unsigned char, short>);
+    detail::square_convolution<unsigned char, short, 9>(in, sobel_h, detail::Kernel_functor_<detail::kernel_op_sobel_h_3x3_<unsigned char, short>>());
+    detail::square_convolution<unsigned char, short, 9>(in, sobel_v, detail::Kernel_functor_<detail::kernel_op_sobel_v_3x3_<unsigned char, short>>());
 
-    for(std::size_t i = 0; i < total; ++i)
+    for(std::size_t i = 0; i < height; ++i)
     {
-        aux_mag = detail::fast_sqrt_(sobel_h[i] * sobel_h[i] + sobel_v[i] * sobel_v[i]);
+        OUT_T *magnitude_row = out_magnitude.row(i);
+        unsigned char *gradient_row = out_gradient.row(i);
+
+        for(std::size_t j = 0; j < width; ++j)
+        {
+            std::size_t current_pos = i * width + j;
+            aux_mag = detail::fast_sqrt_(sobel_h[current_pos] * sobel_h[current_pos] + sobel_v[current_pos] * sobel_v[current_pos]);
 
-        // Intensity of the edge from 0 (B) to 255 (W)
-        out_magnitude[i] = aux_mag > 255 ? 255 : aux_mag;
+            // Intensity of the edge from 0 (B) to 255 (W)
+            magnitude_row[j] = aux_mag > 255 ? 255 : aux_mag;
 
-        // Angle of the edge in radians. Returns the angle of radians from origin (0, 0) to point (sobel_h[i], sobel_v[i])
-        aux_gra = atan2(sobel_h[i], sobel_v[i]);
+            // Angle of the edge in radians. Returns the angle of radians from origin (0, 0) to point (sobel_h[i], sobel_v[i])
+            aux_gra = atan2(sobel_h[current_pos], sobel_v[current_pos]);
 
-        // Convert rad to deg: degrees = radians * 180 * PI
-        // To map from 360 deg range to 255 deg, multiply by 0.71: degrees = radians * 127.8 * PI
-        // Fuse that number with PI and the final instruction is: degrees = radians * 401.45
-        out_gradient[i] = aux_gra * 401.45;
+            // Convert rad to deg: degrees = radians * 180 * PI
+            // To map from 360 deg range to 255 deg, multiply by 0.71: degrees = radians * 127.8 * PI
+            // Fuse that number with PI and the final instruction is: degrees = radians * 401.45
+            gradient_row[j] = aux_gra * 401.45;
+        }
     }
 }
 
 template<typename IN_T, typename OUT_T>
-void non_max_suppression(const Image<IN_T> &in_magnitude, const Image<unsigned char> &in_gradient, Image<OUT_T> &out)
+void non_max_suppression(Image_view<const IN_T> in_magnitude, Image_view<const unsigned char> in_gradient, Image_view<OUT_T> out)
 {
     IN_T q, r;
     bool valid_pixel;
     unsigned short deg;
     std::size_t height = in_magnitude.get_height(), width = in_magnitude.get_width(), current_pos;
+    std::size_t stride = in_magnitude.get_stride();
 
     for(std::size_t i = 1; i < height-1; ++i)
     {
         for(std::size_t j = 1; j < width-1; ++j)
         {
-            current_pos = i * width + j;
+            current_pos = i * stride + j;
 
-            deg = in_gradient[current_pos] * 1.4; // Map the degrees from 255 back to 360. This is an approximation, but it's good enough.
+            deg = in_gradient.row(i)[j] * 1.4; // Map the degrees from 255 back to 360. This is an approximation, but it's good enough.
             valid_pixel = false;
 
             if((0 <= deg && deg < 22.5) || (157.5 <= deg && deg <= 180)){ // Angle 0 (-)
@@ -290,58 +334,70 @@ void non_max_suppression(const Image<IN_T> &in_magnitude, const Image<unsigned c
                 r = in_magnitude[current_pos-1];
             }
             else if(22.5 <= deg && deg < 67.5){                    // Angle 45 (/)
-                q = in_magnitude[current_pos+width-1];
-                r = in_magnitude[current_pos-width+1];
+                q = in_magnitude[current_pos+stride-1];
+                r = in_magnitude[current_pos-stride+1];
             }
             else if(67.5 <= deg && deg < 112.5){                   // Angle 90 (|)
-                q = in_magnitude[current_pos+width];
-                r = in_magnitude[current_pos-width];
+                q = in_magnitude[current_pos+stride];
+                r = in_magnitude[current_pos-stride];
             }
             else if(112.5 <= deg && deg < 157.5){                  // Angle 135 (\)
-                q = in_magnitude[current_pos-width-1];
-                r = in_magnitude[current_pos+width+1];
+                q = in_magnitude[current_pos-stride-1];
+                r = in_magnitude[current_pos+stride+1];
             }
 
-            if( in_magnitude[current_pos] >= q && in_magnitude[current_pos] >= r) out[current_pos] = in_magnitude[current_pos];
-            else out[current_pos] = 0;
+            if( in_magnitude[current_pos] >= q && in_magnitude[current_pos] >= r) out.row(i)[j] = in_magnitude[current_pos];
+            else out.row(i)[j] = 0;
         }
     }
 }
 
 template <typename IN_T, typename OUT_T>
-void double_threshold(const Image<IN_T> &in, Image<OUT_T> &out, const IN_T low_threshold, const IN_T high_threshold)
+void double_threshold(Image_view<const IN_T> in, Image_view<OUT_T> out, const IN_T low_threshold, const IN_T high_threshold)
 {
-    std::size_t total = in.get_total();
+    std::size_t height = in.get_height(), width = in.get_width();
     IN_T val;
 
-    for(int i = 0; i < total; ++i)
+    for(std::size_t i = 0; i < height; ++i)
     {
-        val = in[i];
-        if     (val >= high_threshold) out[i] = 1; // Strong
-        else if(val < low_threshold)   out[i] = 0; // Culled
-        else                           out[i] = 2; // Weak
+        const IN_T *in_row = in.row(i);
+        OUT_T *out_row = out.row(i);
+
+        for(std::size_t j = 0; j < width; ++j)
+        {
+            val = in_row[j];
+            if     (val >= high_threshold) out_row[j] = 1; // Strong
+            else if(val < low_threshold)   out_row[j] = 0; // Culled
+            else                           out_row[j] = 2; // Weak
+        }
     }
 }
 
 template <typename IN_T, typename OUT_T>
-void single_threshold(const Image<IN_T> &in, Image<OUT_T> &out, const IN_T threshold)
+void single_threshold(Image_view<const IN_T> in, Image_view<OUT_T> out, const IN_T threshold)
 {
-    std::size_t total = in.get_total();
+    std::size_t height = in.get_height(), width = in.get_width();
     IN_T val;
 
-    for(int i = 0; i < total; ++i)
+    for(std::size_t i = 0; i < height; ++i)
     {
-        val = in[i];
-        if     (val >= threshold) out[i] = 1; // Strong
-        else                      out[i] = 0; // Culled
+        const IN_T *in_row = in.row(i);
+        OUT_T *out_row = out.row(i);
+
+        for(std::size_t j = 0; j < width; ++j)
+        {
+            val = in_row[j];
+            if     (val >= threshold) out_row[j] = 1; // Strong
+            else                      out_row[j] = 0; // Culled
+        }
     }
 }
 
 template <typename IN_T, typename OUT_T>
-void hysteresis(const Image<IN_T> &in, Image<OUT_T> &out)
+void hysteresis(Image_view<const IN_T> in, Image_view<OUT_T> out)
 {
-    std::size_t stack_top = 0, current_pos, k_pos;
-    std::stack<std::size_t> strong_pixel_stack;
+    // Pixels are tracked by their row and column, since the input and output can have different strides.
+    std::stack<std::pair<std::size_t, std::size_t>> strong_pixel_stack;
     std::size_t height = in.get_height(), width = in.get_width();
 
     Image<unsigned char> visited_map(width, height, 0); // We need a way to check if a pixel has already been processed.
@@ -349,35 +405,38 @@ void hysteresis(const Image<IN_T> &in, Image<OUT_T> &out)
     // First iterate over image to set borders to 0 and collect all the strong edges into a stack.
     for(std::size_t i = 0; i < height; ++i)
     {
+        const IN_T *in_row = in.row(i);
+        OUT_T *out_row = out.row(i);
+
         for(std::size_t j = 0; j < width; ++j)
         {
-            current_pos = i * width + j;
-
             // If edge of image, set to Culled and mark as visited.
             if(j == 0 || j == width-1 || i == 0 || i == height-1)
             {
-                out[current_pos] = 0;
-                visited_map[current_pos] = 1;
+                out_row[j] = 0;
+                visited_map[i * width + j] = 1;
             }
             // If current position is a strong edge, add to the stack to check later
-            else if(in[current_pos] == 1) strong_pixel_stack.push(current_pos);
+            else if(in_row[j] == 1) strong_pixel_stack.emplace(i, j);
         }
     }
 
     // Once all the strong edges are collected, analyze them for neighboring weak edges that can be set as strong.
     while(!strong_pixel_stack.empty())
     {
-        current_pos = strong_pixel_stack.top();
+        auto [i, j] = strong_pixel_stack.top();
         strong_pixel_stack.pop();
 
-        out[current_pos] = 1;
+        out.row(i)[j] = 1;
 
         for(signed char ki = -1; ki < 2; ++ki)
         {
+            const IN_T *in_row = in.row(i + ki);
+
             for(signed char kj = -1; kj < 2; ++kj)
             {
-                k_pos = current_pos + width*ki + kj;
-                if(!visited_map[k_pos] && in[k_pos] == 2) strong_pixel_stack.push(k_pos);
+                std::size_t k_pos = (i + ki) * width + j + kj;
+                if(!visited_map[k_pos] && in_row[j + kj] == 2) strong_pixel_stack.emplace(i + ki, j + kj);
                 visited_map[k_pos] = true;
             }
         }
@@ -385,54 +444,65 @@ void hysteresis(const Image<IN_T> &in, Image<OUT_T> &out)
 }
 
 template <typename IN_T, typename OUT_T>
-void image_interpolation(const Image<IN_T> &from, const Image<IN_T> &to, Image<OUT_T> &out, const float ratio)
+void image_interpolation(Image_view<const IN_T> from, Image_view<const IN_T> to, Image_view<OUT_T> out, const float ratio)
 {
-    std::size_t total = out.get_total();
+    std::size_t height = out.get_height(), width = out.get_width();
 
-    for(std::size_t i = 0; i < total; ++i)
+    for(std::size_t i = 0; i < height; ++i)
     {
-        out[i] = from[i] + ratio * (to[i] - from[i]); // Simplified from equation: from[i]*(1-ratio) + to[i]*ratio
+        const IN_T *from_row = from.row(i), *to_row = to.row(i);
+        OUT_T *out_row = out.row(i);
+
+        for(std::size_t j = 0; j < width; ++j)
+        {
+            out_row[j] = from_row[j] + ratio * (to_row[j] - from_row[j]); // Simplified from equation: from[i]*(1-ratio) + to[i]*ratio
+        }
     }
 }
 
 
 template <typename IN_T, typename OUT_T>
-void dilation(const Image<IN_T> &in, Image<OUT_T> &out)
+void dilation(Image_view<const IN_T> in, Image_view<OUT_T> out)
 {
     std::size_t height = in.get_height(), width = in.get_width();
     Image<IN_T> half_dilated(width, height, {});
 
-    detail::vline_convolution<IN_T, IN_T, 3>(in, half_dilated, detail::kernel_op_dilation_<IN_T, IN_T, 3>);
-    detail::hline_convolution<IN_T, OUT_T, 3>(half_dilated, out, detail::kernel_op_dilation_<IN_T, OUT_T, 3>);
+    detail::vline_convolution<IN_T, IN_T, 3>(in, half_dilated, detail::Kernel_functor_<detail::kernel_op_dilation_<IN_T, IN_T, 3>>());
+    detail::hline_convolution<IN_T, OUT_T, 3>(half_dilated, out, detail::Kernel_functor_<detail::kernel_op_dilation_<IN_T, OUT_T, 3>>());
 }
 
 template <typename IN_T, typename OUT_T>
-void erosion(const Image<IN_T> &in, Image<OUT_T> &out)
+void erosion(Image_view<const IN_T> in, Image_view<OUT_T> out)
 {
     std::size_t height = in.get_height(), width = in.get_width();
     Image<IN_T> half_eroded(width, height, {});
 
-    detail::vline_convolution<IN_T, IN_T, 3>(in, half_eroded, detail::kernel_op_erosion_<IN_T, IN_T, 3>);
-    detail::hline_convolution<IN_T, OUT_T, 3>(half_eroded, out, detail::kernel_op_erosion_<IN_T, OUT_T, 3>);
+    detail::vline_convolution<IN_T, IN_T, 3>(in, half_eroded, detail::Kernel_functor_<detail::kernel_op_erosion_<IN_T, IN_T, 3>>());
+    detail::hline_convolution<IN_T, OUT_T, 3>(half_eroded, out, detail::Kernel_functor_<detail::kernel_op_erosion_<IN_T, OUT_T, 3>>());
 }
 
 template<typename IN_T, typename OUT_T>
-void reescale_pix_length(const Image<IN_T> &in, Image<OUT_T> &out, IN_T in_max_val, OUT_T out_max_val)
+void reescale_pix_length(Image_view<const IN_T> in, Image_view<OUT_T> out, IN_T in_max_val, OUT_T out_max_val)
 {
-    std::size_t total = out.get_total();
+    std::size_t height = out.get_height(), width = out.get_width();
 
     double slope = (double)out_max_val/(double)in_max_val;
 
-    for(std::size_t i = 0; i < total; ++i)
-    { out[i] = ((float)in[i])*slope; }
+    for(std::size_t i = 0; i < height; ++i)
+    {
+        const IN_T *in_row = in.row(i);
+        OUT_T *out_row = out.row(i);
+
+        for(std::size_t j = 0; j < width; ++j) out_row[j] = ((float)in_row[j])*slope;
+    }
 }
 
 
 template<typename IN_T, typename OUT_T>
-void downsample(const Image<IN_T> &in, Image<OUT_T> &out, std::size_t factor)
+void downsample(Image_view<const IN_T> in, Image_view<OUT_T> out, std::size_t factor)
 {
-    std::size_t in_height = in.get_height(), in_width = in.get_width();
-    std::size_t out_height = out.get_height(), out_width = out.get_width();
+    std::size_t in_height = in.get_height(), in_width = in.get_width(), in_stride = in.get_stride();
+    std::size_t out_height = out.get_height(), out_width = out.get_width(), out_stride = out.get_stride();
 
     std::size_t excess_height = in_height%factor, excess_width = in_width%factor;
     std::size_t iter_height = out_height, iter_width = out_width;
@@ -459,36 +529,36 @@ void downsample(const Image<IN_T> &in, Image<OUT_T> &out, std::size_t factor)
         for(std::size_t j = 0; j < iter_width; ++j)
         {
             std::size_t sampler_j = j*factor;
-            std::size_t sampler_pos = sampler_i*in_width + sampler_j;
+            std::size_t sampler_pos = sampler_i*in_stride + sampler_j;
             sampler_accumulator = 0;
 
             for(std::size_t box_i = 0; box_i < factor; ++box_i)
             {
-                std::size_t box_i_dis = box_i*in_width;
+                std::size_t box_i_dis = box_i*in_stride;
                 for(std::size_t box_j = 0; box_j < factor; ++box_j)
                 {
                     sampler_accumulator += in[sampler_pos + box_i_dis + box_j];
                 }
             }
-            out[i*out_width + j] = sampler_accumulator / sampler_divisor;
+            out[i*out_stride + j] = sampler_accumulator / sampler_divisor;
         }
 
         if(excess_width)
         {
             // Now process the excess width for the corresponding sampler row
 
-            std::size_t sampler_pos = (sampler_i+1)*in_width - excess_width;
+            std::size_t sampler_pos = sampler_i*in_stride + in_width - excess_width;
             sampler_accumulator = 0;
 
             for(std::size_t box_i = 0; box_i < factor; ++box_i)
             {
-                std::size_t box_i_dis = box_i*in_width;
+                std::size_t box_i_dis = box_i*in_stride;
                 for(std::size_t box_j = 0; box_j < excess_width; ++box_j)
                 {
                     sampler_accumulator += in[sampler_pos + box_i_dis + box_j];
                 }
             }
-            out[(i+1)*out_width - 1] = sampler_accumulator / sampler_divisor_excessw;
+            out[i*out_stride + out_width - 1] = sampler_accumulator / sampler_divisor_excessw;
         }
     }
 
@@ -496,7 +566,7 @@ void downsample(const Image<IN_T> &in, Image<OUT_T> &out, std::size_t factor)
     {
         // Now process the excess height of the image, the ramaining excess bottom
 
-        std::size_t sampler_i = (in_height-excess_width+1)*in_width;
+        std::size_t sampler_i = (in_height-excess_height)*in_stride;
         for(std::size_t j = 0; j < iter_width; ++j)
         {
             std::size_t sampler_pos = sampler_i + j*factor;
@@ -504,52 +574,52 @@ void downsample(const Image<IN_T> &in, Image<OUT_T> &out, std::size_t factor)
 
             for(std::size_t box_i = 0; box_i < excess_height; ++box_i)
             {
-                std::size_t box_i_dis = box_i*in_width;
+                std::size_t box_i_dis = box_i*in_stride;
                 for(std::size_t box_j = 0; box_j < factor; ++box_j)
                 {
                     sampler_accumulator += in[sampler_pos + box_i_dis + box_j];
                 }
             }
-            out[(out_height-1)*out_width + j] = sampler_accumulator / sampler_divisor_excessh;
+            out[(out_height-1)*out_stride + j] = sampler_accumulator / sampler_divisor_excessh;
         }
 
         if(excess_width)
         {
             // Process the last excess corner at the bottom right
-            std::size_t sampler_pos = ((in_height-excess_width+1)*in_width) + in_width-excess_width;
+            std::size_t sampler_pos = sampler_i + in_width-excess_width;
             sampler_accumulator = 0;
 
             for(std::size_t box_i = 0; box_i < excess_height; ++box_i)
             {
-                std::size_t box_i_dis = box_i*in_width;
+                std::size_t box_i_dis = box_i*in_stride;
                 for(std::size_t box_j = 0; box_j < excess_width; ++box_j)
                 {
                     sampler_accumulator += in[sampler_pos + box_i_dis + box_j];
                 }
             }
 
-            out[(out_height-1)*out_width + out_width - 1] = sampler_accumulator / sampler_divisor_excesswh;
+            out[(out_height-1)*out_stride + out_width - 1] = sampler_accumulator / sampler_divisor_excesswh;
         }
     }
 }
 
 
 template<typename IN_T, typename OUT_T>
-void upsample(const Image<IN_T> &in, Image<OUT_T> &out, std::size_t factor)
+void upsample(Image_view<const IN_T> in, Image_view<OUT_T> out, std::size_t factor)
 {
-    std::size_t in_height = in.get_height(), in_width = in.get_width();
-    std::size_t out_height = out.get_height(), out_width = out.get_width();
+    std::size_t in_height = in.get_height(), in_width = in.get_width(), in_stride = in.get_stride();
+    std::size_t out_stride = out.get_stride();
 
     for(std::size_t i = 0; i < in_height; ++i)
     {
         std::size_t scaled_i = i*factor;
         for(std::size_t j = 0; j < in_width; ++j)
         {
-            std::size_t scaled_pos = scaled_i*out_width + j*factor;
-            IN_T val = in[i*in_width + j];
+            std::size_t scaled_pos = scaled_i*out_stride + j*factor;
+            IN_T val = in[i*in_stride + j];
             for(std::size_t box_i = 0; box_i < factor; ++box_i)
             {
-                std::size_t box_i_dis = box_i*out_width;
+                std::size_t box_i_dis = box_i*out_stride;
                 for(std::size_t box_j = 0; box_j < factor; ++box_j)
                 {
                     out[scaled_pos + box_i_dis + box_j] = val;
@@ -130,7 +130,7 @@ namespace motdet
             Image<unsigned short> in(std::move(*to_process->image.get()));
             Image<unsigned short> downsampled_in(downsampled_w_, downsampled_h_, 0);
 
-            if(downsample_factor_ > 1) imgutil::downsample(in, downsampled_in, downsample_factor_);
+            if(downsample_factor_ > 1) imgutil::downsample<unsigned short, unsigned short>(in, downsampled_in, downsample_factor_);
             else downsampled_in = std::move(in);
 
             // If the motion detector has a reference frame, compare with it to check for motion. If not, make a new reference.
@@ -267,4 +267,9 @@ namespace motdet
         }
     }
 
+    void luma_to_bw(const unsigned char *in, const std::size_t n_pix, Image<unsigned short> &out)
+    {
+        for(std::size_t i = 0; i < n_pix; ++i) out[i] = in[i] * 255;
+    }
+
 } // namespace motdet
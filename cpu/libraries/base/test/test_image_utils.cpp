@@ -29,6 +29,7 @@ namespace test
          log_test_result(test_reescale_pix_length(), "reescale_pix_length");
          log_test_result(test_downsample(), "downsample");
          log_test_result(test_upsample(), "upsample");
+         log_test_result(test_image_views(), "image views");
 
          std::cout << "Finished tests for module image_utils." << std::endl << std::endl;
       }
@@ -413,7 +414,18 @@ namespace test
          bool test_img2 = test_compare_vectors<char, char>(img2_out.get_data(),img2_expected.get_data());
          CHECK_TRUE(test_img2);
 
-         return test_img0 && test_img1 && test_img2;
+         // Check 3: Same result as the generic sorting network, on pseudo random pixels with repeated values
+
+         motdet::Image<unsigned short> img3_in(37, 11, 0), img3_out(37, 11, 0), img3_expected(37, 11, 0);
+         for(std::size_t i = 0; i < img3_in.get_total(); ++i) img3_in[i] = (i * 7919) % 23;
+
+         motdet::imgutil::median_filter<unsigned short, unsigned short>(img3_in, img3_out);
+         motdet::imgutil::detail::square_convolution<unsigned short, unsigned short, 9>(img3_in, img3_expected, motdet::imgutil::detail::kernel_op_median_3x3_<unsigned short, unsigned short>);
+
+         bool test_img3 = test_compare_vectors<unsigned short, unsigned short>(img3_out.get_data(),img3_expected.get_data());
+         CHECK_TRUE(test_img3);
+
+         return test_img0 && test_img1 && test_img2 && test_img3;
       }
 
       bool test_image_subtraction()
@@ -1104,7 +1116,33 @@ namespace test
          bool test_img0 = test_compare_vectors<unsigned char, unsigned char>(img0_out.get_data(),img0_expected.get_data());
          CHECK_TRUE(test_img0);
 
-         return test_img0;
+         // Check 2: The excess rows at the bottom are the last ones of the image, whatever the excess columns.
+
+         std::vector<unsigned char> data1_in = {
+            0,   3,   6,   9,  12,  15,  18,  21,
+            8,  11,  14,  17,  20,  23,  26,  29,
+           16,  19,  22,  25,  28,  31,  34,  37,
+           24,  27,  30,  33,  36,  39,  42,  45,
+           32,  35,  38,  41,  44,  47,   0,   3,
+           40,  43,  46,  49,   2,   5,   8,  11,
+           88,  41,  44,  47,  50,  53,  56,  59,
+           46,  49,  52,  55,  58,  61,  64,  67
+         };
+
+         std::vector<unsigned char> data1_expected = {
+           11,  20,  27,
+           35,  32,  18,
+           53,  54,  61
+         };
+
+         motdet::Image<unsigned char> img1_in(data1_in, 8), img1_out(3, 3, 0), img1_expected(data1_expected, 3);
+
+         motdet::imgutil::downsample<unsigned char, unsigned char>(img1_in, img1_out, 3);
+
+         bool test_img1 = test_compare_vectors<unsigned char, unsigned char>(img1_out.get_data(),img1_expected.get_data());
+         CHECK_TRUE(test_img1);
+
+         return test_img0 && test_img1;
       }
 
       bool test_upsample()
@@ -1137,5 +1175,55 @@ namespace test
          return test_img0;
       }
 
+      bool test_image_views()
+      {
+         // Check 1: Filtering a region in place is the same as filtering a copy of it
+
+         std::vector<unsigned char> data0_in = {
+            9,   9,   9,   9,   9,   9,
+            9,   0,  10,  20,  30,   9,
+            9,  40,  50,  60,  70,   9,
+            9,  80,  90, 100, 110,   9,
+            9, 120, 130, 140, 150,   9,
+            9,   9,   9,   9,   9,   9
+         };
+
+         std::vector<unsigned char> data0_region = {
+              0,  10,  20,  30,
+             40,  50,  60,  70,
+             80,  90, 100, 110,
+            120, 130, 140, 150
+         };
+
+         motdet::Image<unsigned char> img0_big(data0_in, 6), img0_region(data0_region, 4), img0_out(4, 4, 0), img0_expected(4, 4, 0);
+         motdet::Image_view<const unsigned char> img0_in = img0_big.view().sub_view(1, 1, 4, 4);
+
+         motdet::imgutil::median_filter<unsigned char, unsigned char>(img0_in, img0_out);
+         motdet::imgutil::median_filter<unsigned char, unsigned char>(img0_region, img0_expected);
+
+         bool test_img0 = test_compare_vectors<unsigned char, unsigned char>(img0_out.get_data(), img0_expected.get_data());
+         CHECK_TRUE(test_img0);
+
+         // Check 2: Write into a region of a bigger image, leaving the rest untouched
+
+         std::vector<unsigned char> data1_expected = {
+            0,   0,   0,   0,   0,   0,
+            0,   0,   0,  10,  10,   0,
+            0,   0,   0,  10,  10,   0,
+            0,  40,  40,  50,  50,   0,
+            0,  40,  40,  50,  50,   0,
+            0,   0,   0,   0,   0,   0
+         };
+
+         motdet::Image<unsigned char> img1_out(6, 6, 0), img1_expected(data1_expected, 6);
+
+         motdet::imgutil::upsample<unsigned char, unsigned char>(img0_region.view().sub_view(0, 0, 2, 2), img1_out.view().sub_view(1, 1, 4, 4), 2);
+
+         bool test_img1 = test_compare_vectors<unsigned char, unsigned char>(img1_out.get_data(), img1_expected.get_data());
+         CHECK_TRUE(test_img1);
+
+         return test_img0 && test_img1;
+      }
+
    } // namespace test
 } // namespace image_utils
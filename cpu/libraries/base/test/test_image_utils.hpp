@@ -28,6 +28,7 @@ namespace test
         bool test_reescale_pix_length();
         bool test_downsample();
         bool test_upsample();
+        bool test_image_views();
     } // namespace image_utils
 } // namespace test
 
@@ -22,6 +22,7 @@ namespace test
 
             log_test_result(test_rgb_to_bw(), "RGB to BW");
             log_test_result(test_uchar_to_bw(), "uchar to BW");
+            log_test_result(test_luma_to_bw(), "luma to BW");
 
             std::cout << "Finished tests for module motion_detector." << std::endl << std::endl;
         }
@@ -676,5 +677,29 @@ namespace test
             return test_img0;
         }
 
+        bool test_luma_to_bw()
+        {
+            std::unique_ptr<unsigned char[]> data0_in(new unsigned char[9]{
+               0, 255,  16,
+             235, 128,   1,
+              64,   0, 200
+            });
+
+            std::vector<unsigned short> data0_expected = {
+                 0, 65025,  4080,
+             59925, 32640,   255,
+             16320,     0, 51000
+            };
+
+            motdet::Image<unsigned short> img0_out(3, 3, 0), img0_expected(data0_expected, 3);
+
+            motdet::luma_to_bw(data0_in.get(), 9, img0_out);
+
+            bool test_img0 = test_compare_vectors<unsigned short, unsigned short>(img0_out.get_data(),img0_expected.get_data());
+            CHECK_TRUE(test_img0);
+
+            return test_img0;
+        }
+
     } // namespace image_utils
 } // namespace test
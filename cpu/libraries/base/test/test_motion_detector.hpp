@@ -20,6 +20,7 @@ namespace test
 
         bool test_rgb_to_bw();
         bool test_uchar_to_bw();
+        bool test_luma_to_bw();
     } // namespace image_utils
 } // namespace test
 
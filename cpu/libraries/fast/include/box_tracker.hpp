@@ -0,0 +1,74 @@
+#ifndef __MOTDET_BOX_TRACKER_HPP__
+#define __MOTDET_BOX_TRACKER_HPP__
+
+#include <cstddef>
+#include <vector>
+
+#include "motion_detector.hpp"
+
+namespace motdet
+{
+
+    /**
+     * @brief Associates the boxes of consecutive frames and gives each moving object a persistent track ID, so consumers can
+     * classify an object once per track instead of once per frame.
+     * @details Every track predicts where its box will be with a constant velocity model. The boxes of a new frame are then
+     * matched greedily against the predictions, from the pair with the highest intersection over union to the lowest.
+     * Boxes left unmatched start new tracks, and tracks left unmatched keep coasting on their prediction until they have
+     * been missed for too many frames in a row. Frames must be given in chronological order.
+     */
+    class Box_tracker
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param min_iou Boxes overlapping the prediction of a track by this or less are never assigned to it. In [0, 1).
+         * @param max_missed_frames Frames in a row a track can go unmatched before it is dropped. 0 drops it on the first miss.
+         * @throw invalid_argument if min_iou is not in [0, 1).
+         */
+        Box_tracker(const float min_iou = 0.3, const std::size_t max_missed_frames = 5);
+
+        // Getters and Setters
+
+        /**
+         * @brief Get the amount of live tracks, including those coasting after a miss.
+         * @return std::size_t
+         */
+        inline std::size_t get_track_count() const { return tracks_.size(); };
+
+        // General Methods
+
+        /**
+         * @brief Associates the boxes of a frame with the current tracks and sets their track_id.
+         * @param contours Boxes of the frame. Their track_id is overwritten.
+         * @param timestamp Time of the frame in milliseconds. Must not be older than the previous one.
+         * @throw invalid_argument if the timestamp is older than the one of the previous frame.
+         */
+        void update(std::vector<Contour> &contours, const unsigned long long timestamp);
+
+        /**
+         * @brief Drops every track. IDs keep increasing, they are never reused.
+         */
+        void reset();
+
+    private:
+        struct Track_
+        {
+            std::size_t id;
+            double tl_x, tl_y, br_x, br_y; /**< Box of the last match, or prediction if coasting. */
+            double vel_x = 0, vel_y = 0;   /**< Velocity of the center of the box, in pixels per millisecond. */
+            bool has_velocity = false;     /**< False until the track has been matched in two frames. */
+            std::size_t missed = 0;        /**< Consecutive frames without a match. */
+        };
+
+        float min_iou_;
+        std::size_t max_missed_frames_;
+        std::vector<Track_> tracks_;
+        std::size_t next_id_ = 1;
+        bool has_frames_ = false;
+        unsigned long long last_timestamp_ = 0;
+    };
+
+} // namespace motdet
+
+#endif // __MOTDET_BOX_TRACKER_HPP__
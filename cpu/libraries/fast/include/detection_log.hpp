@@ -0,0 +1,110 @@
+#ifndef __MOTDET_DETECTION_LOG_HPP__
+#define __MOTDET_DETECTION_LOG_HPP__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "motion_detector.hpp"
+
+namespace motdet
+{
+
+    /**
+     * @brief Appends the results of the motion detector to a compact binary log, for later analysis.
+     * @details The log is a file header followed by one record per frame. Every record has the same fixed-width header
+     * (timestamp delta from the previous record, flags, box count, processing time and stage times) followed by
+     * 8 bytes per box. Every index_interval records, and whenever a timestamp delta does not fit in 32b, a
+     * (timestamp, offset) pair is appended to a side file "<path>.idx", so readers can jump close to any timestamp.
+     * Values are stored in the byte order of the machine that writes the log.
+     */
+    class Detection_log_writer
+    {
+    public:
+        /**
+         * @brief Open a log to append records to. If the log already exists, new records are added after the last
+         * complete one; a record cut in half by a crash is discarded. If the index is missing or none of its entries can
+         * be used, it is rebuilt from the records, with timestamps starting at 0.
+         * @param path Path to the log. The index is stored in path + ".idx".
+         * @param index_interval Records between index entries. Lower values make queries faster and the index larger. >0.
+         * @throw invalid_argument if index_interval == 0, or the file exists and is not a detection log.
+         * @throw runtime_error if the files cannot be opened.
+         */
+        Detection_log_writer(const std::string &path, const std::size_t index_interval = 256);
+
+        Detection_log_writer(const Detection_log_writer &other) = delete;
+        Detection_log_writer& operator=(const Detection_log_writer &other) = delete;
+
+        // General Methods
+
+        /**
+         * @brief Append the result of a frame to the log.
+         * @param det Result to append. Timestamps must be chronologically ordered. Bounding boxes must fit in 16b.
+         * @throw invalid_argument if the timestamp is older than the last appended or a box does not fit in 16b.
+         */
+        void append(const Detection &det);
+
+        /**
+         * @brief Write any buffered record to disk, so readers can see it.
+         */
+        void flush();
+
+    private:
+        std::ofstream log_, index_;
+        std::size_t index_interval_;
+        std::size_t records_since_index_ = 0;
+        bool has_records_ = false;
+        unsigned long long last_timestamp_ = 0;
+        unsigned long long offset_ = 0; /**< Size of the log, where the next record will be written. */
+
+        /**
+         * @brief Walks the complete records of an existing log from start, learning the last timestamp, the records since
+         * the last index entry and where the last complete record ends.
+         * @param start_timestamp Timestamp of the record at start.
+         * @param rebuilt_index If not NULL, the index entries append would have written are added to it.
+         * @return std::size_t Complete records found. If 0, has_records_ and offset_ are left as they were.
+         */
+        std::size_t walk_records_(std::ifstream &log_in, const std::size_t start, const std::size_t log_size, const unsigned long long start_timestamp, std::vector<unsigned char> *rebuilt_index);
+    };
+
+    /**
+     * @brief Maps a detection log and its index into memory to answer time range queries.
+     * @details Only the records between the closest index entry before the range and the end of the range are read.
+     * Records and index entries appended after opening the reader are not seen.
+     */
+    class Detection_log_reader
+    {
+    public:
+        /**
+         * @brief Open and map a log written by Detection_log_writer.
+         * @param path Path to the log. The index is read from path + ".idx".
+         * @throw invalid_argument if the file is not a detection log.
+         * @throw runtime_error if the files cannot be opened or mapped.
+         */
+        Detection_log_reader(const std::string &path);
+
+        Detection_log_reader(const Detection_log_reader &other) = delete;
+        Detection_log_reader& operator=(const Detection_log_reader &other) = delete;
+
+        ~Detection_log_reader();
+
+        // General Methods
+
+        /**
+         * @brief Get the results of every frame in the time range [from, to].
+         * @param from First timestamp of the range, in milliseconds.
+         * @param to Last timestamp of the range, in milliseconds. Inclusive.
+         * @param only_detections If true, frames without motion are not returned.
+         * @return std::vector<Detection> In chronological order. data_keep is always empty and track IDs are not stored, so 0.
+         */
+        std::vector<Detection> query(const unsigned long long from, const unsigned long long to, const bool only_detections = true) const;
+
+    private:
+        const unsigned char *log_ = nullptr, *index_ = nullptr;
+        std::size_t log_size_ = 0, index_size_ = 0, index_entries_ = 0;
+    };
+
+} // namespace motdet
+
+#endif // __MOTDET_DETECTION_LOG_HPP__
@@ -4,39 +4,255 @@
 #include <iostream>
 #include <cstddef>
 #include <vector>
+#include <string>
 #include <array>
 #include <deque>
 #include <fstream>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <memory>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <sys/mman.h> // madvise
+#endif
 
 namespace motdet
 {
 
     // Class definitions
 
+    /**
+     * @brief Allocator for image buffers. Every buffer is aligned to Alignment bytes so rows can be accessed with aligned
+     * SIMD loads, and buffers of at least huge_page_size are aligned to it and advised for transparent huge pages, which
+     * cuts the TLB misses of walking multi-megabyte frames.
+     * @details Elements constructed without a value are default initialized, so pixels of trivial types are left
+     * uninitialized instead of zero-filled. Only Image(width, height, uninitialized) relies on it.
+     * @tparam T Type of the elements.
+     * @tparam Alignment Alignment of the buffers in bytes. Power of 2 and at least alignof(T).
+     */
+    template <typename T, std::size_t Alignment = 64> class Aligned_allocator
+    {
+    public:
+        using value_type = T;
+        template <typename U> struct rebind { using other = Aligned_allocator<U, Alignment>; };
+
+        static constexpr std::size_t huge_page_size = 2*1024*1024;
+
+        Aligned_allocator() noexcept = default;
+        template <typename U> Aligned_allocator(const Aligned_allocator<U, Alignment> &other) noexcept {}
+
+        /**
+         * @brief Allocates an aligned buffer for n elements. Never returns NULL.
+         * @throw bad_alloc if there is not enough memory.
+         */
+        T* allocate(const std::size_t n)
+        {
+            std::size_t bytes = n * sizeof(T);
+            void *ptr = ::operator new(bytes, std::align_val_t(alignment_(bytes)));
+#ifdef MADV_HUGEPAGE
+            if(bytes >= huge_page_size) madvise(ptr, bytes, MADV_HUGEPAGE); // Only a hint, failing is harmless.
+#endif
+            return static_cast<T*>(ptr);
+        };
+
+        void deallocate(T *ptr, const std::size_t n) noexcept { ::operator delete(ptr, std::align_val_t(alignment_(n * sizeof(T)))); };
+
+        template <typename U> void construct(U *ptr) noexcept(std::is_nothrow_default_constructible<U>::value) { ::new((void *)ptr) U; }
+        template <typename U, typename... Args> void construct(U *ptr, Args&&... args) { ::new((void *)ptr) U(std::forward<Args>(args)...); }
+
+    private:
+        static constexpr std::size_t alignment_(const std::size_t bytes) { return bytes >= huge_page_size ? huge_page_size : Alignment; };
+    };
+
+    template <typename T, typename U, std::size_t Alignment>
+    inline bool operator==(const Aligned_allocator<T, Alignment> &lhs, const Aligned_allocator<U, Alignment> &rhs) noexcept { return true; }
+
+    template <typename T, typename U, std::size_t Alignment>
+    inline bool operator!=(const Aligned_allocator<T, Alignment> &lhs, const Aligned_allocator<U, Alignment> &rhs) noexcept { return false; }
+
+    /**
+     * @brief Tag type to construct images without initializing their pixels.
+     */
+    struct Uninitialized_t { explicit Uninitialized_t() = default; };
+
+    /**
+     * @brief Pass to the Image constructor to skip filling the pixels, for images that are fully overwritten right after.
+     */
+    inline constexpr Uninitialized_t uninitialized{};
+
+    /**
+     * @brief Non-owning view of an image, or of a rectangular region of one. Every imgutil kernel works on views, so
+     * regions, horizontal strips or external buffers can be processed without copying them into an Image first.
+     * @details Pixel (i, j) is at row(i)[j], or at operator[](i*get_stride() + j). Images convert to views implicitly.
+     * The view does not own the pixels, the buffer must outlive it.
+     * @tparam T Type of pixel in the image. Use const T for read-only views.
+     */
+    template <typename T> class Image_view
+    {
+    public:
+        /**
+         * @brief Construct a view of an external buffer.
+         * @param data Pointer to the first pixel.
+         * @param width Length of each row.
+         * @param height Row count.
+         * @param stride Elements between the start of consecutive rows, padding included. 0 means no padding. Otherwise >= width.
+         * @throw invalid_argument if stride < width.
+         */
+        Image_view(T *data, const std::size_t width, const std::size_t height, const std::size_t stride = 0):
+            data_(data),
+            w_(width),
+            h_(height),
+            stride_(stride == 0 ? width : stride)
+        {
+            if(stride_ < w_) throw std::invalid_argument("ERROR Image_view: stride must be >= width.");
+        };
+
+        /**
+         * @brief Construct a read-only view from a mutable one.
+         */
+        template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+        Image_view(const Image_view<U> &other):
+            data_(other.data()),
+            w_(other.get_width()),
+            h_(other.get_height()),
+            stride_(other.get_stride())
+        {}
+
+        Image_view() = default;
+
+        // Operator Overload
+
+        /**
+         * @brief Returns the T element located at idx elements from the first pixel.
+         * @param idx Index to access. Rows are get_stride() elements apart.
+         * @return Element located at idx.
+         */
+        inline T& operator [](const std::size_t idx) const { return data_[idx]; };
+
+        // Getters and Setters
+
+        /**
+         * @brief Get the width
+         * @return std::size_t
+         */
+        inline std::size_t get_width() const  { return w_; };
+
+        /**
+         * @brief Get the height
+         * @return std::size_t
+         */
+        inline std::size_t get_height() const { return h_; };
+
+        /**
+         * @brief Get the total pixels, padding excluded
+         * @return std::size_t
+         */
+        inline std::size_t get_total() const  { return w_*h_; };
+
+        /**
+         * @brief Get the elements between the start of consecutive rows, padding included.
+         * @return std::size_t
+         */
+        inline std::size_t get_stride() const { return stride_; };
+
+        /**
+         * @brief Get a pointer to the first pixel.
+         * @return T*
+         */
+        inline T* data() const { return data_; };
+
+        /**
+         * @brief Get a pointer to the first pixel of a row.
+         * @param i Index of the row. <height.
+         * @return T*
+         */
+        inline T* row(const std::size_t i) const { return data_ + i*stride_; };
+
+        // General Methods
+
+        /**
+         * @brief Get a view of a rectangular region of this view. Shares the pixels and the stride.
+         * @param x Column where the region starts.
+         * @param y Row where the region starts.
+         * @param width Width of the region.
+         * @param height Height of the region.
+         * @return Image_view<T>
+         * @throw invalid_argument if the region does not fit within this view.
+         */
+        Image_view sub_view(const std::size_t x, const std::size_t y, const std::size_t width, const std::size_t height) const
+        {
+            if(x + width > w_ || y + height > h_) throw std::invalid_argument("ERROR sub_view: The region does not fit within the view.");
+            return Image_view(data_ + y*stride_ + x, width, height, stride_);
+        };
+
+    private:
+        T *data_ = nullptr;
+        std::size_t w_ = 0, h_ = 0, stride_ = 0;
+    };
+
     /**
      * @brief Represents an image (or video frame) as a flat structure.
+     * @details Rows can be padded, so that each one starts get_stride() elements after the previous one. Flat indexing
+     * with operator[] is only valid for images without padding (stride == width), which is always the case unless
+     * a stride is given explicitly. Use row() to access padded images.
      * @tparam T Type of pixel in the image. Cannot be bool, use unsigned char to store boolean values.
+     * @tparam Alloc Allocator of the pixel storage.
      */
-    template <typename T> class Image
+    template <typename T, typename Alloc = Aligned_allocator<T>> class Image
     {
     public:
+        /**
+         * @brief Storage of the pixels. Buffers of this type are adopted by set_data without copying them.
+         */
+        using Buffer = std::vector<T, Alloc>;
+
+        /**
+         * @brief Get a buffer for a width*height image without padding, with the pixels left uninitialized, so that a
+         * producer can fill it directly and hand it over with set_data.
+         * @param width Length of each row.
+         * @param height Row count.
+         * @return Buffer
+         */
+        static Buffer make_buffer(const std::size_t width, const std::size_t height) { return Buffer(width*height); }
+
         /**
          * @brief Construct a new Image object with the given width and height. Will fill all the pixels with the default value fill_value.
          * @param width Length of each row. >0.
          * @param height Row count. >0.
          * @param fill_value Value to use as default. Use {} for default initializer.
+         * @param stride Elements between the start of consecutive rows, padding included. 0 means no padding. Otherwise >= width.
          */
-        Image(const std::size_t width, const std::size_t height, const T fill_value):
+        Image(const std::size_t width, const std::size_t height, const T fill_value, const std::size_t stride = 0):
             w_(width),
             h_(height),
+            stride_(stride == 0 ? width : stride),
             total_(width*height)
         {
-            if(w_ == 0) throw std::invalid_argument("ERROR Constructor: width must be >0.");
-            if(h_ == 0) throw std::invalid_argument("ERROR Constructor: height must be >0.");
-            data_.resize(total_, fill_value);
+            check_dimensions_();
+            data_.resize(stride_*h_, fill_value);
+        };
+
+        /**
+         * @brief Construct a new Image object with the given width and height, leaving the pixels uninitialized.
+         * Use it for images that are completely overwritten right after, to skip filling them.
+         * @param width Length of each row. >0.
+         * @param height Row count. >0.
+         * @param tag Pass motdet::uninitialized.
+         * @param stride Elements between the start of consecutive rows, padding included. 0 means no padding. Otherwise >= width.
+         */
+        Image(const std::size_t width, const std::size_t height, const Uninitialized_t tag, const std::size_t stride = 0):
+            w_(width),
+            h_(height),
+            stride_(stride == 0 ? width : stride),
+            total_(width*height)
+        {
+            check_dimensions_();
+            data_.resize(stride_*h_); // Default initialization through Aligned_allocator, nothing is written.
         };
 
         /**
@@ -47,12 +263,13 @@ namespace motdet
         Image(const std::vector<T> &init_data, const std::size_t width):
             w_(width),
             h_(init_data.size()),
+            stride_(width),
             total_(init_data.size())
         {
             if(w_ == 0) throw std::invalid_argument("ERROR Constructor: width must be >0.");
             h_ /= width;
             if(w_*h_ != init_data.size()) throw std::invalid_argument("ERROR Constructor: Invalid width for this vector length.");
-            data_ = init_data;
+            data_.assign(init_data.begin(), init_data.end());
         };
 
         Image() = default;
@@ -99,13 +316,44 @@ namespace motdet
         inline std::size_t get_total() const  { return total_; };
 
         /**
-         * @brief Get the internal data vector.
-         * @return const std::vector<T>&
+         * @brief Get the elements between the start of consecutive rows, padding included.
+         * @return std::size_t
+         */
+        inline std::size_t get_stride() const { return stride_; };
+
+        /**
+         * @brief Get a pointer to the first pixel.
+         * @return T*
          */
-        inline const std::vector<T>& get_data() const { return data_; }
+        inline T* data() { return data_.data(); };
+        inline const T* data() const { return data_.data(); };
 
         /**
-         * @brief Set a new value for the internal data vector.
+         * @brief Get a pointer to the first pixel of a row.
+         * @param i Index of the row. <height.
+         * @return T*
+         */
+        inline T* row(const std::size_t i) { return data_.data() + i*stride_; };
+        inline const T* row(const std::size_t i) const { return data_.data() + i*stride_; };
+
+        /**
+         * @brief Get a view of the whole image. Images also convert to views implicitly.
+         * @return Image_view<T>
+         */
+        inline Image_view<T> view() { return Image_view<T>(data_.data(), w_, h_, stride_); };
+        inline Image_view<const T> view() const { return Image_view<const T>(data_.data(), w_, h_, stride_); };
+
+        inline operator Image_view<T>() { return view(); };
+        inline operator Image_view<const T>() const { return view(); };
+
+        /**
+         * @brief Get the internal data vector. Includes the padding of the rows, if any.
+         * @return const std::vector<T, Alloc>&
+         */
+        inline const std::vector<T, Alloc>& get_data() const { return data_; }
+
+        /**
+         * @brief Set a new value for the internal data vector. Removes any row padding.
          * @param data Data vector, must be of the same type as the current one.
          * @param width Length of each row in the image.
          * @throw invalid_argument if width == 0 or the given width is not compatible with the given data vector.
@@ -116,33 +364,57 @@ namespace motdet
             std::size_t height = data.size()/width;
             if(width*height != data.size()) throw std::invalid_argument("ERROR Constructor: Invalid width for this vector length.");
 
-            w_ = width;
+            w_ = stride_ = width;
             h_ = height;
             total_ = data.size();
-            data_ = data;
+            data_.assign(data.begin(), data.end());
         }
 
         /**
-         * @brief Set a new value for the internal data vector. But now for rvalues!
-         * @param data Data vector, must be of the same type as the current one.
+         * @brief Set a new value for the internal data vector. But now for rvalues! Removes any row padding.
+         * @details The storage uses a different allocator, so the pixels are copied, but the vector is still consumed.
+         * Fill a buffer from make_buffer instead to hand the pixels over without a copy.
+         * @param data Data vector, must be of the same type as the current one. Left empty.
          * @param width Length of each row in the image.
          * @throw invalid_argument if width == 0 or the given width is not compatible with the given data vector.
          */
+        template <typename A = Alloc, typename = std::enable_if_t<!std::is_same<A, std::allocator<T>>::value>>
         inline void set_data(std::vector<T>&& data, const std::size_t width)
+        {
+            set_data(static_cast<const std::vector<T>&>(data), width);
+            std::vector<T>().swap(data);
+        }
+
+        /**
+         * @brief Set a new value for the internal data vector, adopting the pixels of a buffer of the same allocator,
+         * such as one from make_buffer, without copying them. Removes any row padding.
+         * @param data Data vector. Left empty, or untouched if it is refused.
+         * @param width Length of each row in the image.
+         * @throw invalid_argument if width == 0 or the given width is not compatible with the given data vector.
+         */
+        inline void set_data(Buffer&& data, const std::size_t width)
         {
             if(width == 0) throw std::invalid_argument("ERROR Constructor: width must be >0.");
             std::size_t height = data.size()/width;
             if(width*height != data.size()) throw std::invalid_argument("ERROR Constructor: Invalid width for this vector length.");
 
-            w_ = width;
+            w_ = stride_ = width;
             h_ = height;
             total_ = data.size();
             data_ = std::move(data);
+            data.clear();
         }
 
     private:
-        std::size_t w_, h_, total_;
-        std::vector<T> data_;
+        std::size_t w_ = 0, h_ = 0, stride_ = 0, total_ = 0;
+        std::vector<T, Alloc> data_;
+
+        inline void check_dimensions_() const
+        {
+            if(w_ == 0) throw std::invalid_argument("ERROR Constructor: width must be >0.");
+            if(h_ == 0) throw std::invalid_argument("ERROR Constructor: height must be >0.");
+            if(stride_ < w_) throw std::invalid_argument("ERROR Constructor: stride must be >= width.");
+        }
     };
 
 
@@ -160,9 +432,52 @@ namespace motdet
 
         std::size_t bb_tl_x, bb_tl_y; /**< Top left point of the bounding box of the Contour                                      */
         std::size_t bb_br_x, bb_br_y; /**< Bottom right point of the bounding box of the Contour                                  */
+        std::size_t track_id = 0;     /**< ID of the object across frames, see Motion_detector::set_tracking. 0 if not tracked.    */
     };
 
 
+    /**
+     * @brief Time a frame spent in each processing step, in microseconds. Steps that were not run are left at 0.
+     */
+    struct Stage_times
+    {
+        unsigned int downsample = 0;  /**< Downsampling of the input, including the refine resolution if enabled.   */
+        unsigned int blur = 0;        /**< Gaussian blur of the downsampled input, and median denoise if enabled.   */
+        unsigned int subtraction = 0; /**< Reference update and subtraction, including the wait for the reference. */
+        unsigned int threshold = 0;   /**< Double threshold and hysteresis.                                         */
+        unsigned int dilation = 0;    /**< Dilation of the thresholded image.                                       */
+        unsigned int contours = 0;    /**< Contour detection.                                                       */
+        unsigned int filtering = 0;   /**< Area filtering and scaling of the contours, or refinement if enabled.    */
+    };
+
+    /**
+     * @brief Criterion used to merge the bounding boxes of a frame, so an object split in several fragments is returned as one.
+     */
+    enum class Contour_merge : unsigned char
+    {
+        none, /**< Boxes are returned as detected.                                                            */
+        gap,  /**< Boxes at most Detector_config::merge_gap pixels apart, both horizontally and vertically.   */
+        iou   /**< Boxes whose intersection over union is above Detector_config::merge_iou.                   */
+    };
+
+    /**
+     * @brief Tunable parameters of a Motion_detector. Can be swapped at any time with Motion_detector::set_config.
+     */
+    struct Detector_config
+    {
+        unsigned int downsample_factor = 1;    /**< Resolution reduction applied before processing. 1 will not downsample. >0.     */
+        float frame_update_ratio = 0.0067;     /**< Ratio at which the reference is updated, see the Motion_detector constructor.  */
+        unsigned short low_threshold = 5000;   /**< Differences with the reference up to this value are never movement.             */
+        unsigned short high_threshold = 22500; /**< Differences above this value are always movement. In between, only if they
+                                                    are connected to a difference above it. >= low_threshold.                      */
+        unsigned int min_contour_area = 0;     /**< Contours with this area or less are discarded.                                 */
+        bool denoise = false;                  /**< Apply a 3x3 median filter before the blur. Removes salt and pepper noise, such
+                                                    as the one of IR night footage, that the blur alone would spread into motion.  */
+        Contour_merge contour_merge = Contour_merge::none; /**< How the boxes left after the area filter are merged.        */
+        unsigned int merge_gap = 0;            /**< Distance in pixels of the original resolution for Contour_merge::gap.           */
+        float merge_iou = 0.1;                 /**< Minimum overlap for Contour_merge::iou, in [0, 1). 0 merges any overlap.        */
+    };
+
     /**
      * @brief Container for all the relevant info to return as a result when a frame is checked for movement.
      * @details Also contains the data_keep container that points at whatever data was sent as extra metadata when enqueing.
@@ -173,10 +488,25 @@ namespace motdet
         bool has_detections;                     /**< True if motion has been detected                        */
         std::vector<Contour> detection_contours; /**< Contour of the detected movements                       */
         unsigned long long processing_time;      /**< Time it took the frame to be processed                  */
+        Stage_times stage_times;                 /**< Breakdown of processing_time per processing step        */
+        bool skipped = false;                    /**< True if the frame was not processed because the scene was idle.
+                                                      The contours are then the ones of the last processed frame. */
 
         std::shared_ptr<void> data_keep; /**< Will point at NULL if no data_keep was sent when enqueueing     */
     };
 
+    /**
+     * @brief How the work of the detector is spread among threads, see Motion_detector::set_executor.
+     */
+    enum class Executor : unsigned char
+    {
+        frame_parallel, /**< Every worker runs all the stages of a frame, several frames are processed at once.         */
+        stage_pipeline  /**< Every stage runs in its own thread and frames flow from stage to stage, like the dataflow
+                             region of the HLS IP core.                                                                 */
+    };
+
+    class Box_tracker;
+
     /**
      * @brief Detects motion in a given grayscale frame, comparing against previous frames.
      */
@@ -187,15 +517,20 @@ namespace motdet
          * @details Creates a threaded motion detector object.
          * It uses a reference image internally to compare to and this reference is slowly interpolated with new frames to adapt to scenario changes.
          * If the update span is too high, precision loss might make the reference not update, 5 seconds is a good update span.
-         * @param threads Number of threads to use for frame processing. Min 1. Reference updating is not 100% deterministic with >1 threads.
+         * @param threads Number of threads to use for frame processing. Min 1. Reference updating is not 100% deterministic with >1 threads, see set_executor.
          * @param queue_size Amount of frames enqueued (waiting or processing). Any less than "threads" will cripple concurrency.
          * Recommended values is threads*2.
          * @param downsample_factor Reduce the size of the image for faster processing. 1 will not downsample. Must be >0.
          * @param frame_update_ratio Ratio at which the reference is updated. Closer to 0 is slower.
          * Calculate using the following formula: 1/(fps*seconds). The default used is fps = 30 and seconds = 5.
+         * @param reference_checkpoint Path to a checkpoint made with save_reference to start from, see load_reference.
+         * Ignored if empty or if the file does not exist, so the same path can be used to save and restore across restarts.
+         * It is read here and becomes the reference when the first frame is enqueued, so set_refine_factor and
+         * set_contour_callback can still be called, and the refined reference it holds is restored if refinement is enabled.
          * @throw invalid_argument if threads == 0, queue_size == 0, downsample_factor == 0, width < 10 or height < 10
+         * @throw invalid_argument if the checkpoint exists but cannot be loaded, see load_reference.
          */
-        Motion_detector(const std::size_t width, const std::size_t height, const std::size_t threads = 1, const std::size_t queue_size = 2, const unsigned int downsample_factor = 1, const float frame_update_ratio = 0.0067);
+        Motion_detector(const std::size_t width, const std::size_t height, const std::size_t threads = 1, const std::size_t queue_size = 2, const unsigned int downsample_factor = 1, const float frame_update_ratio = 0.0067, const std::string &reference_checkpoint = "");
 
         Motion_detector() = delete;
         Motion_detector(const Motion_detector &other) = delete;
@@ -246,6 +581,120 @@ namespace motdet
          */
         inline std::size_t get_result_queue_size() const { return result_queue_.size(); };
 
+        /**
+         * @brief Get the factor used to refine the detected movement. 0 means refinement is disabled.
+         * @return unsigned int
+         */
+        inline unsigned int get_refine_factor() const { return refine_factor_; };
+
+        /**
+         * @brief Enables coarse-to-fine detection. Frames are fully processed at downsample_factor, and then only the regions where
+         * movement was found are processed again at refine_factor, giving bounding boxes with the precision of the finer resolution.
+         * @details The finer image is computed first and then downsampled again to get the coarse image, so the cost of the first
+         * downsampling is not paid twice. Must be called before the first frame is enqueued.
+         * @param refine_factor Resolution reduction for the refinement step. 0 disables refinement.
+         * If not 0, it must be smaller than downsample_factor and divide it exactly.
+         * @throw invalid_argument if refine_factor is not 0 and does not meet the requirements above.
+         * @throw invalid_argument if refine_factor is not 0 and the checkpoint given to the constructor has another one.
+         * @throw runtime_error if frames have already been enqueued.
+         */
+        void set_refine_factor(const unsigned int refine_factor);
+
+        /**
+         * @brief Enables frame decimation while the scene is idle. After idle_frames consecutive processed frames without movement,
+         * only 1 of every "decimation" frames is processed, the rest are returned right away flagged as skipped.
+         * As soon as a processed frame has movement, every frame is processed again.
+         * @details The reference update ratio is scaled for the processed frames, so the reference adapts at the same pace
+         * regardless of how many frames are being skipped.
+         * @param idle_frames Amount of consecutive frames without movement before the scene is considered idle.
+         * @param decimation Process 1 out of "decimation" frames while idle. 1 disables decimation.
+         * @throw invalid_argument if decimation == 0.
+         */
+        void set_idle_decimation(const std::size_t idle_frames, const std::size_t decimation);
+
+        /**
+         * @brief Sets a function to be called with every contour of a frame as soon as it is known, without waiting for the rest
+         * of the frame to be labelled or for older frames to be finished, so alarms can be raised with the lowest latency.
+         * @details The contours are found with imgutil::streaming_contour_detection instead, which reports each moving object
+         * once no pixel of the current row is connected to it. They are filtered and scaled like any other contour, and are
+         * still returned by get_detection as usual. Holes inside objects are not reported in this mode, and the contour
+         * stage time includes the filtering. When refining, the contours are reported once the refinement of the frame ends.
+         * The callback is called from the worker threads, so concurrently and out of order if there are several threads,
+         * and it delays the processing of the frame, so it should return quickly. The contours are reported before they are
+         * merged, see Detector_config::contour_merge. Must be called before the first frame
+         * is enqueued.
+         * @param callback Receives the timestamp of the frame and the contour. Empty to go back to the regular contour detection.
+         * @throw runtime_error if frames have already been enqueued.
+         */
+        void set_contour_callback(std::function<void(unsigned long long timestamp, const Contour &contour)> callback);
+
+        /**
+         * @brief Enables tracking. The contours of every frame are associated with those of the previous frames with a
+         * Box_tracker, and their track_id identifies the same moving object for as long as it is tracked.
+         * @details Tracking runs when results are submitted, so frames are tracked in chronological order regardless of the
+         * thread that processed them. Skipped frames repeat the contours of the last processed frame, IDs included. Can be
+         * called at any time, disabling and enabling it again starts new tracks.
+         * @param enabled False to stop tracking. track_id is 0 for frames submitted while disabled.
+         * @param min_iou Minimum overlap of a box with the predicted box of a track to continue it, see Box_tracker. In [0, 1).
+         * @param max_missed_frames Processed frames a track survives without being matched, see Box_tracker.
+         * @throw invalid_argument if min_iou is not in [0, 1).
+         */
+        void set_tracking(const bool enabled, const float min_iou = 0.3, const std::size_t max_missed_frames = 5);
+
+        /**
+         * @brief Get the executor in use.
+         * @return Executor
+         */
+        inline Executor get_executor() const { return executor_; };
+
+        /**
+         * @brief Changes how the processing is spread among threads. By default, Executor::frame_parallel with the threads
+         * given in the constructor.
+         * @details With Executor::stage_pipeline, each stage (downsample, blur, reference and subtraction, threshold and
+         * hysteresis, dilation, contours) runs in its own thread, and frames are handed from one stage to the next through
+         * bounded lock free rings. The threads given in the constructor are ignored. A stage keeps its working set hot in
+         * the cache of its core, the reference is only touched by one thread, and frames go through every stage in the
+         * order they were enqueued, so results do not depend on timing. Throughput is bound by the slowest stage, so use a
+         * queue_size of at least 6 to keep every stage busy. processing_time includes the time a frame waits between stages.
+         * @param executor Executor to use.
+         * @param pin_threads Pin every thread to a core, in order among the cores the process may run on. Best effort,
+         * threads are left unpinned if the system does not allow it.
+         * @throw runtime_error if frames are enqueued.
+         */
+        void set_executor(const Executor executor, const bool pin_threads = false);
+
+        /**
+         * @brief Get the configuration frames enqueued from now on will be processed with.
+         * @return Detector_config
+         */
+        Detector_config get_config() const;
+
+        /**
+         * @brief Get the epoch of the current configuration. Starts at 0 and increases by 1 with every set_config.
+         * @return std::size_t
+         */
+        std::size_t get_config_epoch() const;
+
+        /**
+         * @brief Swaps the configuration without stopping the detector. Every frame is processed entirely with the configuration
+         * that was current when it was enqueued, so frames already in the queue are not affected.
+         * @details If the downsample factor changes, the reference is resampled to the new resolution by the first frame that
+         * uses it instead of being learned again. Frames still in flight with the old factor are compared against a resampled
+         * copy and do not update the reference.
+         * @param config New configuration. If refinement is enabled, the refine factor must still divide the downsample factor.
+         * @return std::size_t Epoch of the new configuration.
+         * @throw invalid_argument if downsample_factor == 0, low_threshold > high_threshold, frame_update_ratio is not in (0, 1]
+         * or the refine factor is not compatible with the new downsample factor.
+         * @throw invalid_argument if merge_iou is not in [0, 1).
+         */
+        std::size_t set_config(const Detector_config &config);
+
+        /**
+         * @brief Get the ratio of frames that were actually processed among the last results returned, from 0 to 1.
+         * @return float 1 if no frames have been skipped.
+         */
+        float get_processing_rate() const;
+
         // General Methods
 
         /**
@@ -270,6 +719,29 @@ namespace motdet
          */
         Detection get_detection(bool blocking);
 
+        /**
+         * @brief Saves the reference image, and the refined reference if refinement is enabled, to a checkpoint file.
+         * Restoring it later with load_reference skips the seconds the detector needs to adapt to the scene after starting.
+         * @details The file is written next to path and then renamed over it, so a crash never leaves a half written checkpoint.
+         * Frames can keep being processed while saving, the reference is copied out at once.
+         * @param path Path of the checkpoint.
+         * @throw runtime_error if no frame has been processed yet or the file cannot be written.
+         */
+        void save_reference(const std::string &path) const;
+
+        /**
+         * @brief Restores a reference saved with save_reference, so detection resumes immediately instead of taking the
+         * first frame as the reference. The file is mapped into memory and copied straight into the reference.
+         * @details The resolution and downsample_factor must match the ones of the detector that saved it. If refinement is
+         * enabled, the checkpoint must have been saved with the same refine_factor; a checkpoint with a refined reference
+         * can be loaded by a detector without refinement. Must be called while there are no frames enqueued, and after
+         * set_refine_factor, which cannot be called once there is a reference.
+         * @param path Path of the checkpoint.
+         * @throw invalid_argument if the file is not a checkpoint or was saved with incompatible parameters.
+         * @throw runtime_error if the file cannot be read or frames are enqueued.
+         */
+        void load_reference(const std::string &path);
+
         /**
          * @brief Returns whether the oldest frame submitted has been processed. Thread safe method.
          * @return true if the oldest contours detected can be extracted safely with a non blocking get.
@@ -279,17 +751,53 @@ namespace motdet
 
     private:
 
-        std::size_t w_, h_, total_, downsampled_w_, downsampled_h_;
+        std::size_t w_, h_, total_;
         std::size_t queue_size_;
 
-        float frame_update_ratio_;
-        unsigned int min_cont_area_, downsample_factor_;
+        /**
+         * @brief Immutable configuration shared by all the frames enqueued while it was current.
+         */
+        struct Config_snapshot_
+        {
+            Detector_config config;
+            std::size_t epoch;
+            std::size_t downsampled_w, downsampled_h;
+        };
+        std::shared_ptr<const Config_snapshot_> config_; /**< Current configuration. Swapped under tasks_mutex_. */
 
         bool has_reference_ = false;
         Image<unsigned short> reference_;
+        std::size_t reference_epoch_ = 0;          /**< Epoch of the newest configuration the reference was resampled for. */
+        unsigned int reference_factor_;            /**< Downsample factor the reference is stored at. */
+
+        std::size_t idle_frames_threshold_ = 0, idle_decimation_ = 1;
+        std::size_t idle_frames_ = 0;            /**< Consecutive processed frames without movement, updated when results are submitted. */
+        std::size_t frames_since_processed_ = 0; /**< Frames skipped since the last frame sent to process, updated when enqueueing. */
+        std::vector<Contour> last_result_conts_; /**< Returned for skipped frames. */
+        std::deque<bool> processed_history_;     /**< Whether each of the last results was processed or skipped. */
+        static constexpr std::size_t processing_rate_window_ = 300;
+
+        unsigned int refine_factor_ = 0;
+        std::size_t refined_w_ = 0, refined_h_ = 0;
+        Image<unsigned short> refined_reference_; /**< Not blurred, the blur is applied on the regions that are refined. */
 
         unsigned long long last_ref_update_time_, last_submitted_time_;
 
+        /**
+         * @brief Contents of a reference checkpoint, see save_reference.
+         */
+        struct Reference_checkpoint_
+        {
+            unsigned int reference_factor, refine_factor;
+            std::size_t idle_frames;
+            std::size_t reference_w;
+            Image<unsigned short>::Buffer reference, refined_reference; /**< refined_reference is empty if refine_factor is 0. */
+        };
+        std::unique_ptr<Reference_checkpoint_> pending_checkpoint_; /**< Given to the constructor, applied by the first frame enqueued. */
+
+        std::function<void(unsigned long long, const Contour &)> contour_callback_;
+        std::unique_ptr<Box_tracker> tracker_; /**< Only used when submitting results. NULL if tracking is disabled. */
+
         /**
          * @brief Container for a motion detection job that is either pending for processing, is being processed or is done but not yet submitted.
          */
@@ -298,7 +806,11 @@ namespace motdet
             enum class task_state : unsigned char { waiting, processing, done };
 
             unsigned long long timestamp, processing_time = 0;
+            Stage_times stage_times;
+            std::shared_ptr<const Config_snapshot_> config; /**< Configuration current when the frame was enqueued. */
             task_state state = task_state::waiting;
+            bool skipped = false;
+            float update_ratio; /**< Reference update ratio, scaled with the frames skipped before this one. */
 
             std::unique_ptr<Image<unsigned short>> image;
             std::vector<Contour> result_conts;
@@ -318,7 +830,87 @@ namespace motdet
         std::deque<Motdet_task_> task_queue_; /**< Stores the queued tasks sent to the motion detector. From oldest to newest. */
         std::deque<Detection> result_queue_;  /**< Stores the resulting contorus detected. */
 
-        void detect_motion_(std::size_t thread_id); /**< Executed by the worker threads on loop. */
+        Executor executor_ = Executor::frame_parallel;
+        bool pin_threads_ = false;
+
+        struct Frame_work_; /**< A frame being processed, with the images handed from one stage to the next. */
+        class Stage_ring_;  /**< Queue between two consecutive stages of Executor::stage_pipeline.           */
+        std::vector<std::unique_ptr<Stage_ring_>> stage_rings_;
+
+        static constexpr std::size_t pipeline_stage_count_ = 6;
+        static constexpr std::size_t reference_stage_index_ = 2;
+
+        void detect_motion_(std::size_t thread_id); /**< Executed by the worker threads on loop with Executor::frame_parallel. */
+        void stage_worker_(const std::size_t stage); /**< Executed by the thread of a stage with Executor::stage_pipeline.    */
+
+        /**
+         * @brief Starts the threads of the current executor.
+         */
+        void start_workers_();
+
+        /**
+         * @brief Stops and joins every thread. Frames being processed are abandoned.
+         */
+        void stop_workers_();
+
+        /**
+         * @brief Waits for the oldest frame not taken by any thread yet, and marks it as being processed.
+         * @return The frame, or NULL if the detector is stopping.
+         */
+        std::unique_ptr<Frame_work_> take_task_();
+
+        // Stages of the processing, in order. Each one consumes the images of the previous one.
+
+        void downsample_stage_(Frame_work_ &work);
+        void blur_stage_(Frame_work_ &work);
+        void reference_stage_(Frame_work_ &work);
+        void threshold_stage_(Frame_work_ &work);
+        void dilation_stage_(Frame_work_ &work);
+        void contour_stage_(Frame_work_ &work);
+
+        /**
+         * @brief Runs a stage on a frame, by index. Frames that became the reference skip the stages after it.
+         */
+        void run_stage_(Frame_work_ &work, const std::size_t stage);
+
+        /**
+         * @brief Marks the frame as done and submits every finished frame that is ready.
+         */
+        void finish_task_(Frame_work_ &work);
+
+        /**
+         * @brief Maps a checkpoint and copies it out, checking it was saved with the resolution of the detector.
+         * @throw invalid_argument if the file is not a checkpoint or was saved with another resolution.
+         * @throw runtime_error if the file cannot be read.
+         */
+        std::unique_ptr<Reference_checkpoint_> read_checkpoint_(const std::string &path) const;
+
+        /**
+         * @brief Makes a checkpoint the reference. Must be called with tasks_mutex_ locked and no frames enqueued, and the
+         * checkpoint must have the refine factor of the detector if refinement is enabled.
+         */
+        void apply_checkpoint_(Reference_checkpoint_ &checkpoint);
+
+        /**
+         * @brief Processes again the areas of the coarse contours at the refine resolution, and updates the refined reference.
+         * @param coarse_contours Unfiltered contours detected at the downsampled resolution.
+         * @param refined_in Input frame downsampled by refine_factor_.
+         * @param update_ratio Ratio used to update the refined reference.
+         * @param config Configuration of the frame.
+         * @return Contours found in the refined areas, filtered and scaled to the original resolution.
+         */
+        std::vector<Contour> refine_contours_(const std::vector<Contour> &coarse_contours, const Image<unsigned short> &refined_in, const float update_ratio, const Detector_config &config);
+
+        /**
+         * @brief Creates the immutable snapshot of a configuration, with the resolution it processes frames at.
+         */
+        std::shared_ptr<const Config_snapshot_> make_config_snapshot_(const Detector_config &config, const std::size_t epoch) const;
+
+        /**
+         * @brief Moves the finished tasks at the front of the task queue to the result queue, keeping the chronological order.
+         * Does not lock the mutexes, so lock both tasks_mutex_ and results_mutex_ before calling it.
+         */
+        void submit_done_tasks_();
 
         /**
          * @brief Checks if there is at least one task in the queue that can be processed. Does not lock mutex, so do it before calling the method.
@@ -355,6 +947,15 @@ namespace motdet
      */
     void uchar_to_bw(const unsigned char *in, const std::size_t n_pix, Image<unsigned short> &out);
 
+    /**
+     * @brief Turns an 8b luma (Y) plane into a 16b grayscale image, using the same scale as the RGB conversions.
+     * @details Useful for YUV inputs such as Y4M or NV12, where the luma plane can be used directly without decoding to RGB.
+     * @param in uchar C array with the luma plane. Must be of length n_pix.
+     * @param n_pix Number of pixels present in array "in".
+     * @param out 16b grayscale image that will be outputted.
+     */
+    void luma_to_bw(const unsigned char *in, const std::size_t n_pix, Image<unsigned short> &out);
+
 } // namespace motdet
 
 #endif // __MOTDET_MOTION_DETECTOR_HPP__
@@ -0,0 +1,119 @@
+#include "box_tracker.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <tuple>
+
+namespace motdet
+{
+
+    Box_tracker::Box_tracker(const float min_iou, const std::size_t max_missed_frames):
+        min_iou_(min_iou),
+        max_missed_frames_(max_missed_frames)
+    {
+        if(!(min_iou >= 0 && min_iou < 1)) throw std::invalid_argument("ERROR Box_tracker: min_iou must be in [0, 1).");
+    }
+
+    void Box_tracker::update(std::vector<Contour> &contours, const unsigned long long timestamp)
+    {
+        if(has_frames_ && timestamp < last_timestamp_) throw std::invalid_argument("ERROR update: The timestamp is older than the previous frame.");
+
+        const double dt = has_frames_ ? timestamp - last_timestamp_ : 0;
+        has_frames_ = true;
+        last_timestamp_ = timestamp;
+
+        // Move every track to where it is expected to be in this frame.
+        for(Track_ &track : tracks_)
+        {
+            double dx = track.vel_x * dt, dy = track.vel_y * dt;
+            track.tl_x += dx;
+            track.br_x += dx;
+            track.tl_y += dy;
+            track.br_y += dy;
+        }
+
+        // Score every track and box that overlap enough. Areas count the pixels of the edges, like merge_contours.
+        std::vector<std::tuple<double, std::size_t, std::size_t>> pairs; // IoU, track, contour.
+        for(std::size_t t = 0; t < tracks_.size(); ++t)
+        {
+            const Track_ &track = tracks_[t];
+            double track_area = (track.br_x - track.tl_x + 1) * (track.br_y - track.tl_y + 1);
+
+            for(std::size_t c = 0; c < contours.size(); ++c)
+            {
+                const Contour &cont = contours[c];
+                double inter_w = std::min<double>(track.br_x, cont.bb_br_x) - std::max<double>(track.tl_x, cont.bb_tl_x) + 1;
+                double inter_h = std::min<double>(track.br_y, cont.bb_br_y) - std::max<double>(track.tl_y, cont.bb_tl_y) + 1;
+                if(inter_w <= 0 || inter_h <= 0) continue;
+
+                double cont_area = (double)(cont.bb_br_x - cont.bb_tl_x + 1) * (cont.bb_br_y - cont.bb_tl_y + 1);
+                double intersection = inter_w * inter_h;
+                double iou = intersection / (track_area + cont_area - intersection);
+                if(iou > min_iou_) pairs.emplace_back(iou, t, c);
+            }
+        }
+
+        // Greedy assignment, best overlap first. Ties keep the oldest track and the first box.
+        std::stable_sort(pairs.begin(), pairs.end(), [](const auto &a, const auto &b) { return std::get<0>(a) > std::get<0>(b); });
+
+        std::vector<bool> track_matched(tracks_.size(), false), cont_matched(contours.size(), false);
+        for(const auto &[iou, t, c] : pairs)
+        {
+            if(track_matched[t] || cont_matched[c]) continue;
+            track_matched[t] = cont_matched[c] = true;
+
+            Track_ &track = tracks_[t];
+            Contour &cont = contours[c];
+            cont.track_id = track.id;
+
+            // The velocity is smoothed, since box edges jitter from frame to frame.
+            if(dt > 0)
+            {
+                double prev_x = (track.tl_x + track.br_x) / 2 - track.vel_x * dt, prev_y = (track.tl_y + track.br_y) / 2 - track.vel_y * dt;
+                double vel_x = ((cont.bb_tl_x + cont.bb_br_x) / 2.0 - prev_x) / dt, vel_y = ((cont.bb_tl_y + cont.bb_br_y) / 2.0 - prev_y) / dt;
+                track.vel_x = track.has_velocity ? (track.vel_x + vel_x) / 2 : vel_x;
+                track.vel_y = track.has_velocity ? (track.vel_y + vel_y) / 2 : vel_y;
+                track.has_velocity = true;
+            }
+
+            track.tl_x = cont.bb_tl_x;
+            track.tl_y = cont.bb_tl_y;
+            track.br_x = cont.bb_br_x;
+            track.br_y = cont.bb_br_y;
+            track.missed = 0;
+        }
+
+        // Drop the tracks that have been missed for too long, the rest keep coasting.
+        std::size_t kept = 0;
+        for(std::size_t t = 0; t < tracks_.size(); ++t)
+        {
+            if(!track_matched[t] && ++tracks_[t].missed > max_missed_frames_) continue;
+            tracks_[kept++] = tracks_[t];
+        }
+        tracks_.resize(kept);
+
+        // Every box left is a new object.
+        for(std::size_t c = 0; c < contours.size(); ++c)
+        {
+            if(cont_matched[c]) continue;
+
+            Contour &cont = contours[c];
+            cont.track_id = next_id_++;
+
+            Track_ track;
+            track.id = cont.track_id;
+            track.tl_x = cont.bb_tl_x;
+            track.tl_y = cont.bb_tl_y;
+            track.br_x = cont.bb_br_x;
+            track.br_y = cont.bb_br_y;
+            tracks_.push_back(track);
+        }
+    }
+
+    void Box_tracker::reset()
+    {
+        tracks_.clear();
+        has_frames_ = false;
+    }
+
+} // namespace motdet
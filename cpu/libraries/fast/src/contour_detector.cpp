@@ -1,5 +1,10 @@
 #include "contour_detector.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <cmath>
+
 namespace motdet
 {
     namespace imgutil
@@ -39,7 +44,7 @@ namespace motdet
          * @return true a valid pixel was found, and out_i, out_j is valid.
          * @return false a valid pixel was not found, and out_i, out_j is not valid.
          */
-        bool ccw_not0_(const Image<unsigned char> &in, const std::size_t i0, const std::size_t j0, const std::size_t i, const std::size_t j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j);
+        bool ccw_not0_(Image_view<const unsigned char> in, const std::size_t i0, const std::size_t j0, const std::size_t i, const std::size_t j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j);
 
         /**
          * @brief Find the first 0-pixel in the neighbourhood of a pixel x0,y0. Check neighbours rotating clockwise.
@@ -54,12 +59,12 @@ namespace motdet
          * @return true a valid pixel was found, and out_i, out_j is valid.
          * @return false a valid pixel was not found, and out_i, out_j is not valid.
          */
-        bool cw_not0_(const Image<unsigned char> &in, const int i0, const int j0, const int i, const int j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j);
+        bool cw_not0_(Image_view<const unsigned char> in, const int i0, const int j0, const int i, const int j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j);
 
         /**
          * @brief Follow a contour border while updating the Contour object. Modifies the input image with the ID for the contour that is being followed.
          * @param in Contour image that will be read and updated as we follow the contour.
-         * @param width Length of a row in the image.
+         * @param stride Elements between the start of consecutive rows of the image.
          * @param i y position of the pixel that is beign analyzed.
          * @param j x position of the pixel that is beign analyzed.
          * @param i2 y position of the first neighbour to check.
@@ -68,7 +73,7 @@ namespace motdet
          * @param lnbd the id of the prebious encoutnered border.
          * @return Contour that has been followed.
          */
-        Contour follow_border(Image<unsigned char> &in, std::size_t width, const std::size_t i, const std::size_t j, std::size_t i2, std::size_t j2);
+        Contour follow_border(Image_view<unsigned char> in, std::size_t stride, const std::size_t i, const std::size_t j, std::size_t i2, std::size_t j2);
 
 
 
@@ -104,38 +109,38 @@ namespace motdet
             return -1;
         }
 
-        bool ccw_not0_(const Image<unsigned char> &in, const std::size_t i0, const std::size_t j0, const std::size_t i, const std::size_t j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j)
+        bool ccw_not0_(Image_view<const unsigned char> in, const std::size_t i0, const std::size_t j0, const std::size_t i, const std::size_t j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j)
         {
             signed char id = neighbor_index_to_id_(i0,j0,i,j);
-            std::size_t width = in.get_width();
+            std::size_t stride = in.get_stride();
 
             for (std::size_t k = 0; k < 8; ++k)
             {
                 int kk = (k + id + offset) % 8;
                 neighbor_id_to_index_(i0, j0, kk, out_i, out_j);
 
-                if (in[out_i*width + out_j] != 0) return true;
+                if (in[out_i*stride + out_j] != 0) return true;
             }
             return false;
         }
 
 
-        bool cw_not0_(const Image<unsigned char> &in, const int i0, const int j0, const int i, const int j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j)
+        bool cw_not0_(Image_view<const unsigned char> in, const int i0, const int j0, const int i, const int j, const unsigned char offset, std::size_t &out_i, std::size_t &out_j)
         {
             signed char id = neighbor_index_to_id_(i0,j0,i,j);
-            std::size_t width = in.get_width();
+            std::size_t stride = in.get_stride();
 
             for (std::size_t k = 0; k < 8; ++k)
             {
                 int kk = (-k + id - offset) % 8;
                 neighbor_id_to_index_(i0, j0, kk, out_i, out_j);
 
-                if (in[out_i*width + out_j] != 0) return true;
+                if (in[out_i*stride + out_j] != 0) return true;
             }
             return false;
         }
 
-        std::vector<Contour> contour_detection(Image<unsigned char> &conts_image, bool trim_borders)
+        std::vector<Contour> contour_detection(Image_view<unsigned char> conts_image, bool trim_borders)
         {
             // Modified Topological Structural Analysis of Digitized Binary Images by Border Following.
             // By Suzuki, S. and Abe, K. 1985
@@ -144,14 +149,14 @@ namespace motdet
             // Edited to work on a unsigned char image, without analyzing hierarchy or topology.
             // 0 = No pixel. 1 = Unexplore or not border. 2 = Explored border. 3 = Explored end of border,
 
-            std::size_t height = conts_image.get_height(), width = conts_image.get_width();
+            std::size_t height = conts_image.get_height(), width = conts_image.get_width(), stride = conts_image.get_stride();
             std::vector<Contour> detections;
 
             // Se the borders to zero. Required by the algorithm to avoid infinite loops and indexing errors.
             if(trim_borders)
             {
-                for(std::size_t i = 0; i < height; ++i) conts_image[i*width] = conts_image[(i+1)*width-1] = 0;
-                for(std::size_t i = 1; i < width-1; ++i) conts_image[i] = conts_image[(height-1)*width+i] = 0;
+                for(std::size_t i = 0; i < height; ++i) conts_image[i*stride] = conts_image[i*stride+width-1] = 0;
+                for(std::size_t i = 1; i < width-1; ++i) conts_image[i] = conts_image[(height-1)*stride+i] = 0;
             }
 
             for(std::size_t i = 1; i < height-1; ++i)
@@ -161,9 +166,9 @@ namespace motdet
                     std::size_t i2 = 0, j2 = 0;
 
                     // If the pixel is not a contour edge, nothing to do.
-                    if (conts_image[i*width + j] == 0) continue;
+                    if (conts_image[i*stride + j] == 0) continue;
 
-                    std::size_t curr_idx = i*width + j;
+                    std::size_t curr_idx = i*stride + j;
                     if (conts_image[curr_idx] == 1 && conts_image[curr_idx - 1] == 0)
                     {
                         i2 = i;
@@ -176,7 +181,7 @@ namespace motdet
                     }
                     else continue;
 
-                    Contour detection = follow_border(conts_image, width, i, j, i2, j2);
+                    Contour detection = follow_border(conts_image, stride, i, j, i2, j2);
                     detections.push_back(detection);
                 }
             }
@@ -184,11 +189,199 @@ namespace motdet
             return detections;
         }
 
-        Contour follow_border(Image<unsigned char> &in, std::size_t width, const std::size_t i, const std::size_t j, std::size_t i2, std::size_t j2)
+        std::size_t streaming_contour_detection(Image_view<const unsigned char> in, const std::function<void(const Contour &)> &on_contour)
+        {
+            // Horizontal run of pixels [start, end] of a row, and the component it was labelled with.
+            struct Run_ { std::size_t start, end, label; };
+
+            // Union-find over the run labels. Only the root of a component holds valid box and last_row values.
+            // last_row is the last row a pixel of the component was found in, or closed once it has been reported.
+            const std::size_t closed = std::numeric_limits<std::size_t>::max();
+            std::vector<std::size_t> parent, last_row;
+            std::vector<Contour> boxes;
+            std::vector<Run_> prev_runs, curr_runs;
+            std::size_t reported = 0;
+
+            auto find = [&parent](std::size_t label)
+            {
+                while(parent[label] != label) label = parent[label] = parent[parent[label]];
+                return label;
+            };
+
+            // Reports the components of the runs of the previous row that did not reach the given row.
+            auto close_components = [&](const std::size_t row)
+            {
+                for(const Run_ &run : prev_runs)
+                {
+                    std::size_t root = find(run.label);
+                    if(last_row[root] >= row) continue; // Still open, or already reported.
+
+                    last_row[root] = closed;
+                    on_contour(boxes[root]);
+                    ++reported;
+                }
+            };
+
+            for(std::size_t i = 0; i < in.get_height(); ++i)
+            {
+                const unsigned char *row = in.row(i);
+                curr_runs.clear();
+
+                std::size_t prev_idx = 0;
+                for(std::size_t j = 0; j < in.get_width(); ++j)
+                {
+                    if(row[j] == 0) continue;
+
+                    std::size_t start = j;
+                    while(j + 1 < in.get_width() && row[j + 1] != 0) ++j;
+
+                    std::size_t label = parent.size();
+                    parent.push_back(label);
+                    last_row.push_back(i);
+                    boxes.push_back(Contour(start, i, j, i));
+                    curr_runs.push_back({start, j, label});
+
+                    // Join every run of the previous row that touches this one, diagonals included.
+                    // Runs are sorted, so those that end before this run can be skipped for the next runs too.
+                    while(prev_idx < prev_runs.size() && prev_runs[prev_idx].end + 1 < start) ++prev_idx;
+                    for(std::size_t k = prev_idx; k < prev_runs.size() && prev_runs[k].start <= j + 1; ++k)
+                    {
+                        std::size_t root_a = find(label), root_b = find(prev_runs[k].label);
+                        if(root_a == root_b) continue;
+
+                        Contour &box_a = boxes[root_a];
+                        const Contour &box_b = boxes[root_b];
+                        box_a.bb_tl_x = std::min(box_a.bb_tl_x, box_b.bb_tl_x);
+                        box_a.bb_tl_y = std::min(box_a.bb_tl_y, box_b.bb_tl_y);
+                        box_a.bb_br_x = std::max(box_a.bb_br_x, box_b.bb_br_x);
+                        parent[root_b] = root_a;
+                    }
+                }
+
+                close_components(i);
+                std::swap(prev_runs, curr_runs);
+            }
+
+            close_components(in.get_height());
+            return reported;
+        }
+
+        void merge_contours(std::vector<Contour> &contours, const Contour_merge criterion, const std::size_t max_gap, const float min_iou)
+        {
+            if(criterion == Contour_merge::none) return;
+
+            auto should_merge = [criterion, max_gap, min_iou](const Contour &a, const Contour &b)
+            {
+                if(criterion == Contour_merge::gap)
+                {
+                    std::size_t gap_x = a.bb_br_x < b.bb_tl_x ? b.bb_tl_x - a.bb_br_x : (b.bb_br_x < a.bb_tl_x ? a.bb_tl_x - b.bb_br_x : 0);
+                    std::size_t gap_y = a.bb_br_y < b.bb_tl_y ? b.bb_tl_y - a.bb_br_y : (b.bb_br_y < a.bb_tl_y ? a.bb_tl_y - b.bb_br_y : 0);
+                    return gap_x <= max_gap && gap_y <= max_gap;
+                }
+
+                std::size_t tl_x = std::max(a.bb_tl_x, b.bb_tl_x), tl_y = std::max(a.bb_tl_y, b.bb_tl_y);
+                std::size_t br_x = std::min(a.bb_br_x, b.bb_br_x), br_y = std::min(a.bb_br_y, b.bb_br_y);
+                if(tl_x > br_x || tl_y > br_y) return false;
+
+                auto area = [](const Contour &c) { return (double)(c.bb_br_x - c.bb_tl_x + 1) * (c.bb_br_y - c.bb_tl_y + 1); };
+                double intersection = (double)(br_x - tl_x + 1) * (br_y - tl_y + 1);
+                return intersection / (area(a) + area(b) - intersection) > min_iou;
+            };
+
+            // Boxes are stretched by reach to the right and bottom when bucketing, so boxes close enough to be merged by gap
+            // always share a cell.
+            const std::size_t reach = criterion == Contour_merge::gap ? max_gap : 0;
+
+            std::vector<std::size_t> parent, cell_start, cell_fill, cell_entries;
+            bool merged = true;
+            while(merged && contours.size() > 1)
+            {
+                merged = false;
+                const std::size_t n = contours.size();
+
+                // Size the grid so cells are about as big as the average box, without having more cells than boxes.
+                std::size_t min_x = std::numeric_limits<std::size_t>::max(), min_y = min_x, max_x = 0, max_y = 0;
+                double extent_sum = 0;
+                for(const Contour &c : contours)
+                {
+                    min_x = std::min(min_x, c.bb_tl_x);
+                    min_y = std::min(min_y, c.bb_tl_y);
+                    max_x = std::max(max_x, c.bb_br_x + reach);
+                    max_y = std::max(max_y, c.bb_br_y + reach);
+                    extent_sum += std::max(c.bb_br_x - c.bb_tl_x, c.bb_br_y - c.bb_tl_y) + 1;
+                }
+                const std::size_t span_x = max_x - min_x + 1, span_y = max_y - min_y + 1;
+                const std::size_t cell = std::max({(std::size_t)std::ceil(extent_sum / n), (std::size_t)std::ceil(std::sqrt((double)span_x * span_y / n)), (std::size_t)1});
+                const std::size_t cols = (span_x - 1) / cell + 1, rows = (span_y - 1) / cell + 1;
+
+                // Counting sort of the boxes into every cell they cover.
+                auto for_each_cell = [&](const Contour &c, auto &&func)
+                {
+                    for(std::size_t r = (c.bb_tl_y - min_y) / cell; r <= (c.bb_br_y + reach - min_y) / cell; ++r)
+                        for(std::size_t q = (c.bb_tl_x - min_x) / cell; q <= (c.bb_br_x + reach - min_x) / cell; ++q) func(r*cols + q);
+                };
+
+                cell_start.assign(rows*cols + 1, 0);
+                for(const Contour &c : contours) for_each_cell(c, [&cell_start](std::size_t idx) { ++cell_start[idx + 1]; });
+                std::partial_sum(cell_start.begin(), cell_start.end(), cell_start.begin());
+
+                cell_fill.assign(cell_start.begin(), cell_start.end() - 1);
+                cell_entries.resize(cell_start.back());
+                for(std::size_t k = 0; k < n; ++k) for_each_cell(contours[k], [&](std::size_t idx) { cell_entries[cell_fill[idx]++] = k; });
+
+                // Join the boxes sharing a cell that meet the criterion. The root of every group is its first box.
+                parent.resize(n);
+                std::iota(parent.begin(), parent.end(), 0);
+                auto find = [&parent](std::size_t k)
+                {
+                    while(parent[k] != k) k = parent[k] = parent[parent[k]];
+                    return k;
+                };
+
+                for(std::size_t idx = 0; idx + 1 < cell_start.size(); ++idx)
+                {
+                    for(std::size_t a = cell_start[idx]; a < cell_start[idx + 1]; ++a)
+                    {
+                        for(std::size_t b = a + 1; b < cell_start[idx + 1]; ++b)
+                        {
+                            std::size_t root_a = find(cell_entries[a]), root_b = find(cell_entries[b]);
+                            if(root_a == root_b || !should_merge(contours[cell_entries[a]], contours[cell_entries[b]])) continue;
+
+                            parent[std::max(root_a, root_b)] = std::min(root_a, root_b);
+                            merged = true;
+                        }
+                    }
+                }
+                if(!merged) break;
+
+                // Replace every group by its bounding box.
+                std::vector<Contour> groups;
+                std::vector<std::size_t> group_idx(n);
+                for(std::size_t k = 0; k < n; ++k)
+                {
+                    std::size_t root = find(k);
+                    if(root == k)
+                    {
+                        group_idx[k] = groups.size();
+                        groups.push_back(contours[k]);
+                        continue;
+                    }
+
+                    Contour &group = groups[group_idx[root]];
+                    group.bb_tl_x = std::min(group.bb_tl_x, contours[k].bb_tl_x);
+                    group.bb_tl_y = std::min(group.bb_tl_y, contours[k].bb_tl_y);
+                    group.bb_br_x = std::max(group.bb_br_x, contours[k].bb_br_x);
+                    group.bb_br_y = std::max(group.bb_br_y, contours[k].bb_br_y);
+                }
+                contours = std::move(groups);
+            }
+        }
+
+        Contour follow_border(Image_view<unsigned char> in, std::size_t stride, const std::size_t i, const std::size_t j, std::size_t i2, std::size_t j2)
         {
             Contour detection(j2, i2, j2, i2);
 
-            std::size_t curr_idx = i*width + j;
+            std::size_t curr_idx = i*stride + j;
             std::size_t i1 = 0, j1 = 0;
             if(!cw_not0_(in, i, j, i2, j2, 0, i1, j1)){
                 in[curr_idx] = 3;
@@ -220,7 +413,7 @@ namespace motdet
                     else if(detection.bb_tl_y >= i4) detection.bb_tl_y = i4;
                 }
 
-                std::size_t curr_idx3 = i3*width + j3;
+                std::size_t curr_idx3 = i3*stride + j3;
                 if(in[curr_idx3 + 1] == 0) in[curr_idx3] = 3;
                 else if(in[curr_idx3] == 1) in[curr_idx3] = 2;
 
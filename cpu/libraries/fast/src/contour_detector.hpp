@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <iostream>
 #include <vector>
+#include <functional> // std::function
 
 #include "motion_detector.hpp"
 
@@ -22,7 +23,33 @@ namespace motdet
          * Deactivate for better speed but make sure the input matrix has 0-pixel borders, else the function can hang in an infinite loop or segfault.
          * @return Vector of the bounding boxes of all the contours detected, regardless of their size.
          */
-        std::vector<Contour> contour_detection(Image<unsigned char> &in, bool trim_borders = true);
+        std::vector<Contour> contour_detection(Image_view<unsigned char> in, bool trim_borders = true);
+
+        /**
+         * @brief Finds the 8-connected components of a binary image in a single top to bottom pass, and reports each of them as
+         * soon as it is closed, that is, as soon as a row has no pixel connected to it. Does not modify the input.
+         * @details Rows are split into runs of non 0 pixels that are joined with the overlapping runs of the previous row using
+         * union-find, so only the runs of the previous row and the bounding boxes of the open components are kept.
+         * Unlike contour_detection, holes are not reported and the boxes are exactly those of the pixels of each component,
+         * with inclusive coordinates. Components are reported in the order they are closed, so top to bottom by their last row.
+         * @param in Binary image. Any value other than 0 is a pixel. The borders do not need to be 0.
+         * @param on_contour Called with the bounding box of every component, from the calling thread, before the function returns.
+         * @return std::size_t Amount of components reported.
+         */
+        std::size_t streaming_contour_detection(Image_view<const unsigned char> in, const std::function<void(const Contour &)> &on_contour);
+
+        /**
+         * @brief Merges the bounding boxes that meet the criterion into their common bounding box, repeating until no pair does.
+         * @details Boxes are bucketed in a uniform grid with cells about the size of the average box, and only boxes sharing a
+         * cell are compared, so each pass is linear in the amount of boxes unless they are crowded in a few cells.
+         * Merged boxes are compared again in the next pass, since they can reach boxes none of their fragments did.
+         * @param contours Boxes to merge. Replaced by the merged boxes, in the order of the first fragment of each of them.
+         * @param criterion Contour_merge::none leaves the boxes as they are.
+         * @param max_gap With Contour_merge::gap, boxes whose edges are at most this apart on both axes are merged.
+         * @param min_iou With Contour_merge::iou, boxes with an intersection over union above this are merged.
+         * Areas count the pixels of the edges.
+         */
+        void merge_contours(std::vector<Contour> &contours, const Contour_merge criterion, const std::size_t max_gap, const float min_iou);
 
     } // namespace imgutil
 } // namespace motdet
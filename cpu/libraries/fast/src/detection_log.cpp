@@ -0,0 +1,371 @@
+#include "detection_log.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <filesystem>
+#include <algorithm>
+
+#include <fcntl.h>    // open
+#include <unistd.h>   // close
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+
+namespace motdet
+{
+
+    namespace
+    {
+        // Layout of the log. All the values are stored with the byte order of the writer.
+
+        const char log_magic[8] = {'M', 'O', 'T', 'D', 'L', 'O', 'G', 1}; // The last byte is the format version.
+
+        constexpr std::size_t file_header_size = sizeof(log_magic);
+        constexpr std::size_t record_header_size = 40; // u32 delta, u8 flags, u8 unused, u16 boxes, u32 processing time, 7 x u32 stage times.
+        constexpr std::size_t box_size = 8;            // 4 x u16: tl_x, tl_y, br_x, br_y.
+        constexpr std::size_t index_entry_size = 16;   // u64 timestamp, u64 offset of the record in the log.
+
+        constexpr unsigned char flag_skipped = 1;
+
+        template <typename T> inline void put_(unsigned char *&dst, const T value)
+        {
+            std::memcpy(dst, &value, sizeof(T));
+            dst += sizeof(T);
+        }
+
+        template <typename T> inline T get_(const unsigned char *&src)
+        {
+            T value;
+            std::memcpy(&value, src, sizeof(T));
+            src += sizeof(T);
+            return value;
+        }
+
+        inline std::uint32_t saturate_u32_(const unsigned long long value)
+        {
+            return std::min<unsigned long long>(value, std::numeric_limits<std::uint32_t>::max());
+        }
+
+        /**
+         * @brief Decodes the record starting at rec into det. The timestamp is not touched, since it depends on the previous records.
+         * @return Bytes taken by the record, or 0 if the record is not complete within size bytes.
+         */
+        std::size_t decode_record_(const unsigned char *rec, const std::size_t size, std::uint32_t &delta, Detection &det)
+        {
+            if(size < record_header_size) return 0;
+
+            const unsigned char *src = rec;
+            delta = get_<std::uint32_t>(src);
+            unsigned char flags = get_<unsigned char>(src);
+            get_<unsigned char>(src);
+            std::uint16_t boxes = get_<std::uint16_t>(src);
+
+            std::size_t record_size = record_header_size + boxes*box_size;
+            if(size < record_size) return 0;
+
+            det.skipped = flags & flag_skipped;
+            det.processing_time = get_<std::uint32_t>(src);
+            det.stage_times.downsample = get_<std::uint32_t>(src);
+            det.stage_times.blur = get_<std::uint32_t>(src);
+            det.stage_times.subtraction = get_<std::uint32_t>(src);
+            det.stage_times.threshold = get_<std::uint32_t>(src);
+            det.stage_times.dilation = get_<std::uint32_t>(src);
+            det.stage_times.contours = get_<std::uint32_t>(src);
+            det.stage_times.filtering = get_<std::uint32_t>(src);
+
+            det.detection_contours.clear();
+            for(std::size_t i = 0; i < boxes; ++i)
+            {
+                std::size_t tl_x = get_<std::uint16_t>(src), tl_y = get_<std::uint16_t>(src);
+                std::size_t br_x = get_<std::uint16_t>(src), br_y = get_<std::uint16_t>(src);
+                det.detection_contours.push_back({tl_x, tl_y, br_x, br_y});
+            }
+            det.has_detections = boxes > 0;
+
+            return record_size;
+        }
+
+        /**
+         * @brief Maps a whole file read only. Returns nullptr for empty files.
+         */
+        const unsigned char* map_file_(const std::string &path, std::size_t &size)
+        {
+            int fd = open(path.c_str(), O_RDONLY);
+            if(fd < 0) throw std::runtime_error("ERROR map_file_: Could not open " + path);
+
+            struct stat file_stat;
+            if(fstat(fd, &file_stat) != 0)
+            {
+                close(fd);
+                throw std::runtime_error("ERROR map_file_: Could not read the size of " + path);
+            }
+            size = file_stat.st_size;
+
+            void *map = nullptr;
+            if(size > 0) map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd); // The mapping keeps the file open.
+
+            if(map == MAP_FAILED) throw std::runtime_error("ERROR map_file_: Could not map " + path);
+            return (const unsigned char *)map;
+        }
+    } // namespace
+
+
+    // ------------------------------------------------------------------------------------------------------------- //
+    // Detection_log_writer
+
+
+    Detection_log_writer::Detection_log_writer(const std::string &path, const std::size_t index_interval):
+        index_interval_(index_interval)
+    {
+        namespace fs = std::filesystem;
+
+        if(index_interval_ == 0) throw std::invalid_argument("ERROR Constructor: index_interval must be >0.");
+
+        const std::string index_path = path + ".idx";
+        std::vector<unsigned char> rebuilt_index;
+        std::error_code ec;
+        std::size_t log_size = fs::exists(path) ? fs::file_size(path, ec) : 0;
+        std::size_t index_size = fs::exists(index_path) ? fs::file_size(index_path, ec) : 0;
+
+        if(log_size > 0)
+        {
+            // Recover the state of the log: find the last index entry inside the log and walk the records from there
+            // to learn the last timestamp and where the last complete record ends.
+            std::ifstream log_in(path, std::ios::binary), index_in(index_path, std::ios::binary);
+
+            char magic[file_header_size] = {};
+            log_in.read(magic, file_header_size);
+            if(!log_in || std::memcmp(magic, log_magic, file_header_size) != 0) throw std::invalid_argument("ERROR Constructor: " + path + " is not a detection log.");
+
+            std::size_t entries = index_size / index_entry_size;
+            offset_ = file_header_size;
+            while(entries > 0)
+            {
+                unsigned char entry[index_entry_size];
+                index_in.seekg((entries-1) * index_entry_size);
+                index_in.read((char *)entry, index_entry_size);
+
+                const unsigned char *src = entry;
+                std::uint64_t entry_timestamp = get_<std::uint64_t>(src);
+                std::uint64_t entry_offset = get_<std::uint64_t>(src);
+
+                if(entry_offset >= file_header_size && entry_offset < log_size && walk_records_(log_in, entry_offset, log_size, entry_timestamp, nullptr) > 0) break;
+                --entries; // Index entry written before its record was complete.
+            }
+
+            // Without any usable index entry, the records are still there: walk them from the start and rebuild the
+            // index instead of dropping them. The timestamp of the first record is only stored in the index, so the
+            // rebuilt timestamps start at 0, keeping the spacing between records.
+            if(!has_records_) walk_records_(log_in, file_header_size, log_size, 0, &rebuilt_index);
+
+            log_in.close();
+            index_in.close();
+
+            // Drop any partial record and index entry left by a crash.
+            if(offset_ < log_size) fs::resize_file(path, offset_);
+            if(entries * index_entry_size < index_size) fs::resize_file(index_path, entries * index_entry_size);
+        }
+        else if(index_size > 0) fs::resize_file(index_path, 0); // An index without log is meaningless.
+
+        log_.open(path, std::ios::binary | std::ios::app);
+        index_.open(index_path, std::ios::binary | std::ios::app);
+        if(!log_ || !index_) throw std::runtime_error("ERROR Constructor: Could not open " + path + " for writing.");
+
+        if(log_size == 0)
+        {
+            log_.write(log_magic, file_header_size);
+            offset_ = file_header_size;
+        }
+        else if(!rebuilt_index.empty())
+        {
+            index_.write((const char *)rebuilt_index.data(), rebuilt_index.size());
+            index_.flush();
+        }
+    }
+
+    std::size_t Detection_log_writer::walk_records_(std::ifstream &log_in, const std::size_t start, const std::size_t log_size, const unsigned long long start_timestamp, std::vector<unsigned char> *rebuilt_index)
+    {
+        std::vector<unsigned char> tail(log_size - start);
+        log_in.clear();
+        log_in.seekg(start);
+        log_in.read((char *)tail.data(), tail.size());
+
+        std::size_t pos = 0, records = 0;
+        std::uint32_t delta;
+        Detection det;
+        last_timestamp_ = start_timestamp;
+        records_since_index_ = 0;
+        while(std::size_t record_size = decode_record_(tail.data() + pos, tail.size() - pos, delta, det))
+        {
+            if(pos > 0) last_timestamp_ += delta;
+
+            // Index the records as append would have.
+            if(rebuilt_index != nullptr && (records == 0 || records_since_index_ >= index_interval_))
+            {
+                std::size_t entry_pos = rebuilt_index->size();
+                rebuilt_index->resize(entry_pos + index_entry_size);
+                unsigned char *dst = rebuilt_index->data() + entry_pos;
+                put_<std::uint64_t>(dst, last_timestamp_);
+                put_<std::uint64_t>(dst, start + pos);
+                records_since_index_ = 0;
+            }
+
+            pos += record_size;
+            ++records;
+            ++records_since_index_;
+        }
+
+        if(records > 0)
+        {
+            has_records_ = true;
+            offset_ = start + pos;
+        }
+        return records;
+    }
+
+    void Detection_log_writer::append(const Detection &det)
+    {
+        if(has_records_ && det.timestamp < last_timestamp_) throw std::invalid_argument("ERROR append: Appended timestamps must be chronologically ordered.");
+        if(det.detection_contours.size() > std::numeric_limits<std::uint16_t>::max()) throw std::invalid_argument("ERROR append: Too many contours for a single record.");
+        // Every check is done before the index or the state of the writer change, so a rejected record leaves no trace.
+        for(const Contour &cont : det.detection_contours)
+            if(std::max({cont.bb_tl_x, cont.bb_tl_y, cont.bb_br_x, cont.bb_br_y}) > std::numeric_limits<std::uint16_t>::max())
+                throw std::invalid_argument("ERROR append: Contour coordinates must fit in 16b.");
+
+        unsigned long long delta = has_records_ ? det.timestamp - last_timestamp_ : 0;
+
+        // Index the record if it is due, or if its timestamp cannot be expressed as a delta.
+        // Readers take the timestamp of indexed records from the index, their delta is only kept to rebuild a lost index.
+        if(!has_records_ || records_since_index_ >= index_interval_ || delta > std::numeric_limits<std::uint32_t>::max())
+        {
+            unsigned char entry[index_entry_size], *dst = entry;
+            put_<std::uint64_t>(dst, det.timestamp);
+            put_<std::uint64_t>(dst, offset_);
+
+            // The index is flushed before the record is written, so a record that needs its entry never exists without it.
+            index_.write((const char *)entry, index_entry_size);
+            index_.flush();
+
+            records_since_index_ = 0;
+            if(delta > std::numeric_limits<std::uint32_t>::max()) delta = 0;
+        }
+
+        std::vector<unsigned char> record(record_header_size + det.detection_contours.size()*box_size);
+        unsigned char *dst = record.data();
+
+        put_<std::uint32_t>(dst, delta);
+        put_<unsigned char>(dst, det.skipped ? flag_skipped : 0);
+        put_<unsigned char>(dst, 0);
+        put_<std::uint16_t>(dst, det.detection_contours.size());
+        put_<std::uint32_t>(dst, saturate_u32_(det.processing_time));
+        put_<std::uint32_t>(dst, det.stage_times.downsample);
+        put_<std::uint32_t>(dst, det.stage_times.blur);
+        put_<std::uint32_t>(dst, det.stage_times.subtraction);
+        put_<std::uint32_t>(dst, det.stage_times.threshold);
+        put_<std::uint32_t>(dst, det.stage_times.dilation);
+        put_<std::uint32_t>(dst, det.stage_times.contours);
+        put_<std::uint32_t>(dst, det.stage_times.filtering);
+
+        for(const Contour &cont : det.detection_contours)
+        {
+            put_<std::uint16_t>(dst, cont.bb_tl_x);
+            put_<std::uint16_t>(dst, cont.bb_tl_y);
+            put_<std::uint16_t>(dst, cont.bb_br_x);
+            put_<std::uint16_t>(dst, cont.bb_br_y);
+        }
+
+        log_.write((const char *)record.data(), record.size());
+
+        offset_ += record.size();
+        ++records_since_index_;
+        last_timestamp_ = det.timestamp;
+        has_records_ = true;
+    }
+
+    void Detection_log_writer::flush()
+    {
+        log_.flush();
+        index_.flush();
+    }
+
+
+    // ------------------------------------------------------------------------------------------------------------- //
+    // Detection_log_reader
+
+
+    Detection_log_reader::Detection_log_reader(const std::string &path)
+    {
+        log_ = map_file_(path, log_size_);
+        if(log_size_ < file_header_size || std::memcmp(log_, log_magic, file_header_size) != 0)
+        {
+            if(log_ != nullptr) munmap((void *)log_, log_size_);
+            throw std::invalid_argument("ERROR Constructor: " + path + " is not a detection log.");
+        }
+
+        try { index_ = map_file_(path + ".idx", index_size_); }
+        catch(...)
+        {
+            munmap((void *)log_, log_size_);
+            throw;
+        }
+        index_entries_ = index_size_ / index_entry_size;
+        madvise((void *)log_, log_size_, MADV_RANDOM); // Queries only touch a few pages around the range.
+    }
+
+    Detection_log_reader::~Detection_log_reader()
+    {
+        if(log_ != nullptr) munmap((void *)log_, log_size_);
+        if(index_ != nullptr) munmap((void *)index_, index_size_);
+    }
+
+    std::vector<Detection> Detection_log_reader::query(const unsigned long long from, const unsigned long long to, const bool only_detections) const
+    {
+        std::vector<Detection> results;
+        if(from > to) return results;
+
+        auto entry_timestamp = [this](const std::size_t entry){ const unsigned char *src = index_ + entry*index_entry_size; return get_<std::uint64_t>(src); };
+        auto entry_offset = [this](const std::size_t entry){ const unsigned char *src = index_ + entry*index_entry_size + 8; return get_<std::uint64_t>(src); };
+
+        // Binary search the first index entry at or after "from" and start from the one before it. Timestamps may repeat,
+        // so records at "from" can sit before an entry with that same timestamp, but never before the previous entry.
+        std::size_t lo = 0, hi = index_entries_;
+        while(lo < hi)
+        {
+            std::size_t mid = (lo + hi) / 2;
+            if(entry_timestamp(mid) < from) lo = mid + 1;
+            else hi = mid;
+        }
+        std::size_t entry = lo > 0 ? lo - 1 : 0;
+
+        // Walk the records forward, adding up the deltas, until the end of the range or the log.
+        unsigned long long timestamp = 0;
+        std::size_t pos = entry < index_entries_ ? entry_offset(entry) : log_size_;
+        std::uint32_t delta;
+        Detection det;
+
+        while(pos < log_size_)
+        {
+            std::size_t record_size = decode_record_(log_ + pos, log_size_ - pos, delta, det);
+            if(record_size == 0) break; // Record still being written.
+
+            // Indexed records take their timestamp from the index.
+            while(entry < index_entries_ && entry_offset(entry) < pos) ++entry;
+            if(entry < index_entries_ && entry_offset(entry) == pos) timestamp = entry_timestamp(entry++);
+            else timestamp += delta;
+
+            if(timestamp > to) break;
+            if(timestamp >= from && (!only_detections || det.has_detections))
+            {
+                det.timestamp = timestamp;
+                results.push_back(det);
+            }
+
+            pos += record_size;
+        }
+
+        return results;
+    }
+
+} // namespace motdet
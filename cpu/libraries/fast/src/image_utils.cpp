@@ -25,42 +25,46 @@ namespace motdet
                 return g;
             }
 
-            void vline_blur(const Image<unsigned short> &in, Image<unsigned short> &out)
+
+            void vline_blur(Image_view<const unsigned short> in, Image_view<unsigned short> out)
             {
-                std::size_t current_pos;
                 std::size_t height = in.get_height(), width = in.get_width();
 
                 for(std::size_t i = 0; i < height; ++i)
                 {
-                    for(std::size_t j = 0; j < width; ++j)
+                    // Rows of the kernel, clamped to the image.
+                    const unsigned short *in_rows[5];
+                    for(signed char ki = -2; ki <= 2; ++ki)
                     {
-                        current_pos = i * width + j;
-                        unsigned long long sum = 0;
+                        int real_ki = i + ki;
 
-                        for(signed char ki = -2; ki <= 2; ++ki)
-                        {
-                            int real_ki = i + ki;
+                        if(real_ki < 0) real_ki = 0;
+                        else if (real_ki >= height) real_ki = height-1;
 
-                            if(real_ki < 0) real_ki = 0;
-                            else if (real_ki >= height) real_ki = height-1;
+                        in_rows[ki + 2] = in.row(real_ki);
+                    }
 
-                            sum += in[real_ki*width + j] * gaussian_kernel_5_[ki + 2];
-                        }
-                        out[current_pos] = sum / 255;
+                    unsigned short *out_row = out.row(i);
+                    for(std::size_t j = 0; j < width; ++j)
+                    {
+                        unsigned long long sum = 0;
+                        for(std::size_t k = 0; k < 5; ++k) sum += in_rows[k][j] * gaussian_kernel_5_[k];
+                        out_row[j] = sum / 255;
                     }
                 }
             }
 
-            void hline_blur(const Image<unsigned short> &in, Image<unsigned short> &out)
+            void hline_blur(Image_view<const unsigned short> in, Image_view<unsigned short> out)
             {
-                std::size_t current_pos;
                 std::size_t height = in.get_height(), width = in.get_width();
 
                 for(std::size_t i = 0; i < height; ++i)
                 {
+                    const unsigned short *in_row = in.row(i);
+                    unsigned short *out_row = out.row(i);
+
                     for(std::size_t j = 0; j < width; ++j)
                     {
-                        current_pos = i * width + j;
                         unsigned long long sum = 0;
 
                         for(int kj = -2; kj <= 2; ++kj)
@@ -70,64 +74,66 @@ namespace motdet
                             if(real_kj < 0) real_kj = 0;
                             else if (real_kj >= width) real_kj = width-1;
 
-                            sum += in[i*width + real_kj] * gaussian_kernel_5_[kj + 2];
+                            sum += in_row[real_kj] * gaussian_kernel_5_[kj + 2];
                         }
                         // The kernel has been fully extracted, time to execute kernel operation.
-                        out[current_pos] = sum/255;
+                        out_row[j] = sum/255;
                     }
                 }
             }
 
-            void vline_dilation(const Image<unsigned char> &in, Image<unsigned char> &out)
+            void vline_dilation(Image_view<const unsigned char> in, Image_view<unsigned char> out)
             {
-                std::size_t current_pos;
                 std::size_t height = in.get_height(), width = in.get_width();
 
                 for(std::size_t i = 0; i < height; ++i)
                 {
+                    const unsigned char *in_row = in.row(i);
+                    const unsigned char *in_prev = i != 0 ? in.row(i-1) : nullptr;
+                    const unsigned char *in_next = i != height-1 ? in.row(i+1) : nullptr;
+                    unsigned char *out_row = out.row(i);
+
                     for(std::size_t j = 0; j < width; ++j)
                     {
-                        current_pos = i * width + j;
-
-                        if(in[current_pos] == 0)
+                        if(in_row[j] == 0)
                         {
-                            if(i != 0 && in[current_pos - width] == 1) { out[current_pos] = 1; continue; }
-                            if(i != height-1 && in[current_pos + width] == 1) { out[current_pos] = 1; continue; }
-                            out[current_pos] = 0;
+                            if(in_prev && in_prev[j] == 1) { out_row[j] = 1; continue; }
+                            if(in_next && in_next[j] == 1) { out_row[j] = 1; continue; }
+                            out_row[j] = 0;
                         }
-                        else out[current_pos] = 1;
+                        else out_row[j] = 1;
                     }
                 }
             }
 
-            void hline_dilation(const Image<unsigned char> &in, Image<unsigned char> &out)
+            void hline_dilation(Image_view<const unsigned char> in, Image_view<unsigned char> out)
             {
-                std::size_t current_pos;
                 std::size_t height = in.get_height(), width = in.get_width();
 
                 for(std::size_t i = 0; i < height; ++i)
                 {
+                    const unsigned char *in_row = in.row(i);
+                    unsigned char *out_row = out.row(i);
+
                     for(std::size_t j = 0; j < width; ++j)
                     {
-                        current_pos = i * width + j;
-
-                        if(in[current_pos] == 0)
+                        if(in_row[j] == 0)
                         {
-                            if(j != 0 && in[current_pos - 1] == 1) { out[current_pos] = 1; continue; }
-                            if(j != width-1 && in[current_pos + 1] == 1) { out[current_pos] = 1; continue; }
-                            out[current_pos] = 0;
+                            if(j != 0 && in_row[j - 1] == 1) { out_row[j] = 1; continue; }
+                            if(j != width-1 && in_row[j + 1] == 1) { out_row[j] = 1; continue; }
+                            out_row[j] = 0;
                         }
-                        else out[current_pos] = 1;
+                        else out_row[j] = 1;
                     }
                 }
             }
 
         } // namespace detail
 
-        void gaussian_blur_filter(const Image<unsigned short> &in, Image<unsigned short> &out)
+        void gaussian_blur_filter(Image_view<const unsigned short> in, Image_view<unsigned short> out)
         {
             std::size_t height = in.get_height(), width = in.get_width();
-            Image<unsigned short> half_blurred(width, height, {});
+            Image<unsigned short> half_blurred(width, height, uninitialized);
 
             // An NxN gaussian blur can be decomposed into 2 1-dimensional kernels, N vertical and N horizontal.
             // Using float as the intermediate pixel type to avoid detail loss between steps.
@@ -136,24 +142,69 @@ namespace motdet
             detail::hline_blur(    half_blurred, out);
         }
 
-        void double_threshold(const Image<unsigned short> &in, Image<unsigned char> &out, const unsigned short low_threshold, const unsigned short high_threshold)
+        void median_filter(Image_view<const unsigned short> in, Image_view<unsigned short> out)
         {
-            std::size_t total = in.get_total();
-            unsigned short val;
+            std::size_t height = in.get_height(), width = in.get_width();
+
+            // Minimum, median and maximum of the 3 pixels of each column around the current row, with the border columns
+            // replicated at both ends.
+            std::vector<unsigned short> col_min(width + 2), col_med(width + 2), col_max(width + 2);
+
+            auto median_3 = [](const unsigned short a, const unsigned short b, const unsigned short c)
+            {
+                return std::max(std::min(a, b), std::min(std::max(a, b), c));
+            };
 
-            for(int i = 0; i < total; ++i)
+            for(std::size_t i = 0; i < height; ++i)
             {
-                val = in[i];
-                if     (val >= high_threshold) out[i] = 1; // Strong
-                else if(val < low_threshold)   out[i] = 0; // Culled
-                else                           out[i] = 2; // Weak
+                const unsigned short *up = in.row(i == 0 ? 0 : i-1), *center = in.row(i), *down = in.row(i == height-1 ? height-1 : i+1);
+                unsigned short *out_row = out.row(i);
+
+                for(std::size_t j = 0; j < width; ++j)
+                {
+                    unsigned short low = std::min(up[j], center[j]), high = std::max(up[j], center[j]);
+                    col_min[j+1] = std::min(low, down[j]);
+                    col_med[j+1] = std::max(low, std::min(high, down[j]));
+                    col_max[j+1] = std::max(high, down[j]);
+                }
+                col_min[0] = col_min[1]; col_min[width+1] = col_min[width];
+                col_med[0] = col_med[1]; col_med[width+1] = col_med[width];
+                col_max[0] = col_max[1]; col_max[width+1] = col_max[width];
+
+                // The median of the 9 pixels is the median of the biggest minimum, the median of medians and the smallest maximum.
+                for(std::size_t j = 0; j < width; ++j)
+                {
+                    unsigned short max_of_min = std::max(std::max(col_min[j], col_min[j+1]), col_min[j+2]);
+                    unsigned short med_of_med = median_3(col_med[j], col_med[j+1], col_med[j+2]);
+                    unsigned short min_of_max = std::min(std::min(col_max[j], col_max[j+1]), col_max[j+2]);
+                    out_row[j] = median_3(max_of_min, med_of_med, min_of_max);
+                }
             }
         }
 
-        void hysteresis(const Image<unsigned char> &in, Image<unsigned char> &out)
+        void double_threshold(Image_view<const unsigned short> in, Image_view<unsigned char> out, const unsigned short low_threshold, const unsigned short high_threshold)
         {
-            std::size_t stack_top = 0, current_pos, k_pos;
-            std::stack<std::size_t> strong_pixel_stack;
+            std::size_t height = in.get_height(), width = in.get_width();
+
+            for(std::size_t i = 0; i < height; ++i)
+            {
+                const unsigned short *in_row = in.row(i);
+                unsigned char *out_row = out.row(i);
+
+                for(std::size_t j = 0; j < width; ++j)
+                {
+                    unsigned short val = in_row[j];
+                    if     (val >= high_threshold) out_row[j] = 1; // Strong
+                    else if(val < low_threshold)   out_row[j] = 0; // Culled
+                    else                           out_row[j] = 2; // Weak
+                }
+            }
+        }
+
+        void hysteresis(Image_view<const unsigned char> in, Image_view<unsigned char> out)
+        {
+            // Pixels are tracked by their row and column, since the input and output can have different strides.
+            std::stack<std::pair<std::size_t, std::size_t>> strong_pixel_stack;
             std::size_t height = in.get_height(), width = in.get_width();
 
             Image<unsigned char> visited_map(width, height, 0); // We need a way to check if a pixel has already been processed.
@@ -161,70 +212,128 @@ namespace motdet
             // First iterate over image to set borders to 0 and collect all the strong edges into a stack.
             for(std::size_t i = 0; i < height; ++i)
             {
+                const unsigned char *in_row = in.row(i);
+                unsigned char *out_row = out.row(i), *visited_row = visited_map.row(i);
+
                 for(std::size_t j = 0; j < width; ++j)
                 {
-                    current_pos = i * width + j;
-
                     // If edge of image, set to Culled and mark as visited.
                     if(j == 0 || j == width-1 || i == 0 || i == height-1)
                     {
-                        out[current_pos] = 0;
-                        visited_map[current_pos] = 1;
+                        out_row[j] = 0;
+                        visited_row[j] = 1;
                     }
                     // If current position is a strong edge, add to the stack to check later
-                    else if(in[current_pos] == 1) strong_pixel_stack.push(current_pos);
+                    else if(in_row[j] == 1) strong_pixel_stack.emplace(i, j);
                 }
             }
 
             // Once all the strong edges are collected, analyze them for neighboring weak edges that can be set as strong.
             while(!strong_pixel_stack.empty())
             {
-                current_pos = strong_pixel_stack.top();
+                auto [i, j] = strong_pixel_stack.top();
                 strong_pixel_stack.pop();
 
-                out[current_pos] = 1;
+                out.row(i)[j] = 1;
 
                 for(signed char ki = -1; ki < 2; ++ki)
                 {
+                    const unsigned char *in_row = in.row(i + ki);
+                    unsigned char *visited_row = visited_map.row(i + ki);
+
                     for(signed char kj = -1; kj < 2; ++kj)
                     {
-                        k_pos = current_pos + width*ki + kj;
-                        if(!visited_map[k_pos] && in[k_pos] == 2) strong_pixel_stack.push(k_pos);
-                        visited_map[k_pos] = true;
+                        std::size_t k_j = j + kj;
+                        if(!visited_row[k_j] && in_row[k_j] == 2) strong_pixel_stack.emplace(i + ki, k_j);
+                        visited_row[k_j] = true;
                     }
                 }
             }
         }
 
-        void image_interpolation_and_sub(const Image<unsigned short> &from, const Image<unsigned short> &to, Image<unsigned short> &interpolated, Image<unsigned short> &subbed, const float ratio)
+        void image_interpolation_and_sub(Image_view<const unsigned short> from, Image_view<const unsigned short> to, Image_view<unsigned short> interpolated, Image_view<unsigned short> subbed, const float ratio)
         {
-            std::size_t total = interpolated.get_total();
+            std::size_t height = interpolated.get_height(), width = interpolated.get_width();
 
-            for(std::size_t i = 0; i < total; ++i)
+            for(std::size_t i = 0; i < height; ++i)
             {
-                unsigned short from_pix = from[i];
-                unsigned short to_pix = to[i];
-                int sub = to_pix - from_pix;
+                const unsigned short *from_row = from.row(i), *to_row = to.row(i);
+                unsigned short *interpolated_row = interpolated.row(i), *subbed_row = subbed.row(i);
 
-                subbed[i] = std::abs(sub);
-                interpolated[i] = from_pix + ratio * sub; // Simplified from equation: from[i]*(1-ratio) + to[i]*ratio
+                for(std::size_t j = 0; j < width; ++j)
+                {
+                    unsigned short from_pix = from_row[j];
+                    unsigned short to_pix = to_row[j];
+                    int sub = to_pix - from_pix;
+
+                    subbed_row[j] = std::abs(sub);
+                    interpolated_row[j] = from_pix + ratio * sub; // Simplified from equation: from[i]*(1-ratio) + to[i]*ratio
+                }
             }
         }
 
+        void image_interpolation(Image_view<unsigned short> from, Image_view<const unsigned short> to, const float ratio)
+        {
+            std::size_t height = from.get_height(), width = from.get_width();
+
+            for(std::size_t i = 0; i < height; ++i)
+            {
+                unsigned short *from_row = from.row(i);
+                const unsigned short *to_row = to.row(i);
+
+                for(std::size_t j = 0; j < width; ++j)
+                {
+                    unsigned short from_pix = from_row[j];
+                    int sub = to_row[j] - from_pix;
+
+                    from_row[j] = from_pix + ratio * sub;
+                }
+            }
+        }
+
+        void image_subtraction(Image_view<const unsigned short> in1, Image_view<const unsigned short> in2, Image_view<unsigned short> out)
+        {
+            std::size_t height = out.get_height(), width = out.get_width();
+
+            for(std::size_t i = 0; i < height; ++i)
+            {
+                const unsigned short *in1_row = in1.row(i), *in2_row = in2.row(i);
+                unsigned short *out_row = out.row(i);
+
+                for(std::size_t j = 0; j < width; ++j)
+                {
+                    int sub = in1_row[j] - in2_row[j];
+                    out_row[j] = std::abs(sub);
+                }
+            }
+        }
+
+        void crop(Image_view<const unsigned short> in, Image_view<unsigned short> out, const std::size_t x, const std::size_t y)
+        {
+            std::size_t out_height = out.get_height(), out_width = out.get_width();
+
+            for(std::size_t i = 0; i < out_height; ++i)
+            {
+                const unsigned short *in_row = in.row(y + i) + x;
+                unsigned short *out_row = out.row(i);
+
+                for(std::size_t j = 0; j < out_width; ++j) out_row[j] = in_row[j];
+            }
+        }
 
-        void dilation(const Image<unsigned char> &in, Image<unsigned char> &out)
+        void dilation(Image_view<const unsigned char> in, Image_view<unsigned char> out)
         {
             std::size_t height = in.get_height(), width = in.get_width();
-            Image<unsigned char> half_dilated(width, height, {});
+            Image<unsigned char> half_dilated(width, height, uninitialized);
 
             detail::vline_dilation(in, half_dilated);
             detail::hline_dilation(    half_dilated, out);
         }
 
-        void downsample(const Image<unsigned short> &in, Image<unsigned short> &out, std::size_t factor)
+        void downsample(Image_view<const unsigned short> in, Image_view<unsigned short> out, std::size_t factor)
         {
-            std::size_t in_height = in.get_height(), in_width = in.get_width();
-            std::size_t out_height = out.get_height(), out_width = out.get_width();
+            std::size_t in_height = in.get_height(), in_width = in.get_width(), in_stride = in.get_stride();
+            std::size_t out_height = out.get_height(), out_width = out.get_width(), out_stride = out.get_stride();
 
             std::size_t excess_height = in_height%factor, excess_width = in_width%factor;
             std::size_t iter_height = out_height, iter_width = out_width;
@@ -251,36 +360,36 @@ namespace motdet
                 for(std::size_t j = 0; j < iter_width; ++j)
                 {
                     std::size_t sampler_j = j*factor;
-                    std::size_t sampler_pos = sampler_i*in_width + sampler_j;
+                    std::size_t sampler_pos = sampler_i*in_stride + sampler_j;
                     sampler_accumulator = 0;
 
                     for(std::size_t box_i = 0; box_i < factor; ++box_i)
                     {
-                        std::size_t box_i_dis = box_i*in_width;
+                        std::size_t box_i_dis = box_i*in_stride;
                         for(std::size_t box_j = 0; box_j < factor; ++box_j)
                         {
                             sampler_accumulator += in[sampler_pos + box_i_dis + box_j];
                         }
                     }
-                    out[i*out_width + j] = sampler_accumulator / sampler_divisor;
+                    out[i*out_stride + j] = sampler_accumulator / sampler_divisor;
                 }
 
                 if(excess_width)
                 {
                     // Now process the excess width for the corresponding sampler row
 
-                    std::size_t sampler_pos = (sampler_i+1)*in_width - excess_width;
+                    std::size_t sampler_pos = sampler_i*in_stride + in_width - excess_width;
                     sampler_accumulator = 0;
 
                     for(std::size_t box_i = 0; box_i < factor; ++box_i)
                     {
-                        std::size_t box_i_dis = box_i*in_width;
+                        std::size_t box_i_dis = box_i*in_stride;
                         for(std::size_t box_j = 0; box_j < excess_width; ++box_j)
                         {
                             sampler_accumulator += in[sampler_pos + box_i_dis + box_j];
                         }
                     }
-                    out[(i+1)*out_width - 1] = sampler_accumulator / sampler_divisor_excessw;
+                    out[i*out_stride + out_width - 1] = sampler_accumulator / sampler_divisor_excessw;
                 }
             }
 
@@ -288,7 +397,7 @@ namespace motdet
             {
                 // Now process the excess height of the image, the ramaining excess bottom
 
-                std::size_t sampler_i = (in_height-excess_width+1)*in_width;
+                std::size_t sampler_i = (in_height-excess_height)*in_stride;
                 for(std::size_t j = 0; j < iter_width; ++j)
                 {
                     std::size_t sampler_pos = sampler_i + j*factor;
@@ -296,31 +405,61 @@ namespace motdet
 
                     for(std::size_t box_i = 0; box_i < excess_height; ++box_i)
                     {
-                        std::size_t box_i_dis = box_i*in_width;
+                        std::size_t box_i_dis = box_i*in_stride;
                         for(std::size_t box_j = 0; box_j < factor; ++box_j)
                         {
                             sampler_accumulator += in[sampler_pos + box_i_dis + box_j];
                         }
                     }
-                    out[(out_height-1)*out_width + j] = sampler_accumulator / sampler_divisor_excessh;
+                    out[(out_height-1)*out_stride + j] = sampler_accumulator / sampler_divisor_excessh;
                 }
 
                 if(excess_width)
                 {
                     // Process the last excess corner at the bottom right
-                    std::size_t sampler_pos = ((in_height-excess_width+1)*in_width) + in_width-excess_width;
+                    std::size_t sampler_pos = sampler_i + in_width-excess_width;
                     sampler_accumulator = 0;
 
                     for(std::size_t box_i = 0; box_i < excess_height; ++box_i)
                     {
-                        std::size_t box_i_dis = box_i*in_width;
+                        std::size_t box_i_dis = box_i*in_stride;
                         for(std::size_t box_j = 0; box_j < excess_width; ++box_j)
                         {
                             sampler_accumulator += in[sampler_pos + box_i_dis + box_j];
                         }
                     }
 
-                    out[(out_height-1)*out_width + out_width - 1] = sampler_accumulator / sampler_divisor_excesswh;
+                    out[(out_height-1)*out_stride + out_width - 1] = sampler_accumulator / sampler_divisor_excesswh;
+                }
+            }
+        }
+
+        void resize(Image_view<const unsigned short> in, Image_view<unsigned short> out)
+        {
+            std::size_t in_height = in.get_height(), in_width = in.get_width();
+            std::size_t out_height = out.get_height(), out_width = out.get_width();
+
+            float scale_y = (float)in_height / out_height, scale_x = (float)in_width / out_width;
+
+            // Map the center of each output pixel onto the input, and interpolate the 4 input pixels around it.
+            for(std::size_t i = 0; i < out_height; ++i)
+            {
+                float src_y = std::clamp((i + 0.5f) * scale_y - 0.5f, 0.0f, (float)(in_height - 1));
+                std::size_t y0 = src_y, y1 = std::min(y0 + 1, in_height - 1);
+                float wy = src_y - y0;
+
+                const unsigned short *in_row0 = in.row(y0), *in_row1 = in.row(y1);
+                unsigned short *out_row = out.row(i);
+
+                for(std::size_t j = 0; j < out_width; ++j)
+                {
+                    float src_x = std::clamp((j + 0.5f) * scale_x - 0.5f, 0.0f, (float)(in_width - 1));
+                    std::size_t x0 = src_x, x1 = std::min(x0 + 1, in_width - 1);
+                    float wx = src_x - x0;
+
+                    float top = in_row0[x0] * (1 - wx) + in_row0[x1] * wx;
+                    float bottom = in_row1[x0] * (1 - wx) + in_row1[x1] * wx;
+                    out_row[j] = top * (1 - wy) + bottom * wy + 0.5f;
                 }
             }
         }
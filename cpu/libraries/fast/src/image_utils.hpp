@@ -9,6 +9,9 @@
 #include <functional> // std::function
 #include <cmath>      // std::atan2 std::abs
 #include <stack>      // std::stack
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+#include <algorithm>  // std::clamp std::min
 
 namespace motdet
 {
@@ -31,28 +34,28 @@ namespace motdet
              * @param in Grayscale image to be blurred.
              * @param out Blurred image.
              */
-            void vline_blur(const Image<unsigned short> &in, Image<unsigned short> &out);
+            void vline_blur(Image_view<const unsigned short> in, Image_view<unsigned short> out);
 
             /**
              * @brief Blur a grayscale image horizontally with a 5-length kernel. After this is applied to an image, a vline blur should be applied to complete the process.
              * @param in Grayscale image to be blurred.
              * @param out Blurred image.
              */
-            void hline_blur(const Image<unsigned short> &in, Image<unsigned short> &out);
+            void hline_blur(Image_view<const unsigned short> in, Image_view<unsigned short> out);
 
             /**
              * @brief Dilate a binary image vertically with a 3-length kernel. After this is applied to an image, an hline dilation should be applied to complete the process.
              * @param in Binary image to be dilated.
              * @param out Dilated image.
              */
-            void vline_dilation(const Image<unsigned char> &in, Image<unsigned char> &out);
+            void vline_dilation(Image_view<const unsigned char> in, Image_view<unsigned char> out);
 
             /**
              * @brief Dilate a binary image horizontally with a 3-length kernel. After this is applied to an image, an hline dilation should be applied to complete the process.
              * @param in Binary image to be dilated.
              * @param out Dilated image.
              */
-            void hline_dilation(const Image<unsigned char> &in, Image<unsigned char> &out);
+            void hline_dilation(Image_view<const unsigned char> in, Image_view<unsigned char> out);
 
 
         } // namespace detail
@@ -62,7 +65,17 @@ namespace motdet
          * @param in Grayscale image to blur.
          * @param out Grayscale blurred image.
          */
-        void gaussian_blur_filter(const Image<unsigned short> &in, Image<unsigned short> &out);
+        void gaussian_blur_filter(Image_view<const unsigned short> in, Image_view<unsigned short> out);
+
+        /**
+         * @brief Apply a 3x3 median filter to an image. Removes salt and pepper noise, such as the one of IR night footage.
+         * @details The 3 pixels of every column are sorted once and shared by the 3 output pixels that contain them, and
+         * the median of the 3 sorted columns is found with the 3 minimums, 3 medians and 3 maximums. Each step is a min/max
+         * over whole rows, which the compiler turns into vector instructions. The border pixels are replicated.
+         * @param in Grayscale image to filter.
+         * @param out Grayscale image with the noise removed.
+         */
+        void median_filter(Image_view<const unsigned short> in, Image_view<unsigned short> out);
 
         /**
          * @brief Collapses all the values in a grayscale image to the states Culled 0, Strong 1 and Weak 2 depending on 2 thresholds.
@@ -71,7 +84,7 @@ namespace motdet
          * @param low_threshold Any value below this threshold is transformed to Culled.
          * @param high_threshold Any value equal or above this threshold is transformed to Strong. REQ: high_threshold > low_threshold.
          */
-        void double_threshold(const Image<unsigned short> &in, Image<unsigned char> &out, const unsigned short low_threshold, const unsigned short high_threshold);
+        void double_threshold(Image_view<const unsigned short> in, Image_view<unsigned char> out, const unsigned short low_threshold, const unsigned short high_threshold);
 
         /**
          * @brief Takes the output of a double threshold function and turns Weak pixel into either Strong or Culled.
@@ -79,7 +92,7 @@ namespace motdet
          * @param in Images with 3 possible values: Culled 0, Strong 1, Weak 2.
          * @param out Image with 2 possible values: Culled 0, Strong 1.
          */
-        void hysteresis(const Image<unsigned char> &in, Image<unsigned char> &out);
+        void hysteresis(Image_view<const unsigned char> in, Image_view<unsigned char> out);
 
         /**
          * @brief Creates an intermediate image between 2 given images. If ratio is 1 it will be equivalent to "to", and 0 will be equivalent to "from".
@@ -88,14 +101,39 @@ namespace motdet
          * @param out Image with interpolated pixels.
          * @param ratio Selector for which input image has more relevance. [0-1]
          */
-        void image_interpolation_and_sub(const Image<unsigned short> &from, const Image<unsigned short> &to, Image<unsigned short> &interpolated, Image<unsigned short> &subbed, const float ratio);
+        void image_interpolation_and_sub(Image_view<const unsigned short> from, Image_view<const unsigned short> to, Image_view<unsigned short> interpolated, Image_view<unsigned short> subbed, const float ratio);
+
+        /**
+         * @brief Updates an image in place, moving it towards another image by a given ratio.
+         * @param from Image that will be moved towards "to". Its result is equivalent to "to" if ratio is 1, and left untouched if 0.
+         * @param to Image with the target values.
+         * @param ratio Selector for which input image has more relevance. [0-1]
+         */
+        void image_interpolation(Image_view<unsigned short> from, Image_view<const unsigned short> to, const float ratio);
+
+        /**
+         * @brief Gets the absolute difference between 2 images (always positive).
+         * @param in1 Grayscale image 1 to subtract.
+         * @param in2 Grayscale image 2 to subtract.
+         * @param out Subtracted grayscale image.
+         */
+        void image_subtraction(Image_view<const unsigned short> in1, Image_view<const unsigned short> in2, Image_view<unsigned short> out);
+
+        /**
+         * @brief Copies a rectangular region of an image. The size of the region is given by the size of the output image.
+         * @param in Image to copy the region from.
+         * @param out Image where the region is copied to. Its top left corner plus its size must fit within "in".
+         * @param x Column of "in" where the region starts.
+         * @param y Row of "in" where the region starts.
+         */
+        void crop(Image_view<const unsigned short> in, Image_view<unsigned short> out, const std::size_t x, const std::size_t y);
 
         /**
          * @brief Takes a binary image (0 or 1) and dilates the 1-pixels.
          * @param in Binary image to process.
          * @param out Dilated binary image.
          */
-        void dilation(const Image<unsigned char> &in, Image<unsigned char> &out);
+        void dilation(Image_view<const unsigned char> in, Image_view<unsigned char> out);
 
         /**
          * @brief Resizes to a lower resolution by a given factor. Ignores floating point precision.
@@ -103,7 +141,14 @@ namespace motdet
          * @param out Resized image. Resolution must be ceil(in.w/factor) by ceil(in.h/factor)
          * @param factor Factor to resize the image, must be > 0.
          */
-        void downsample(const Image<unsigned short> &in, Image<unsigned short> &out, std::size_t factor);
+        void downsample(Image_view<const unsigned short> in, Image_view<unsigned short> out, std::size_t factor);
+
+        /**
+         * @brief Resizes to any resolution with bilinear interpolation. Slower than downsample, meant for rare resolution changes.
+         * @param in Image to resize.
+         * @param out Resized image. Its resolution is the target resolution.
+         */
+        void resize(Image_view<const unsigned short> in, Image_view<unsigned short> out);
 
     } // namespace imgutil
 } // namespace motdet
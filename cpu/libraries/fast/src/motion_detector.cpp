@@ -1,27 +1,91 @@
 #include "motion_detector.hpp"
+#include "box_tracker.hpp"
 
 #include <iostream>
 
 #include <chrono>
 #include <stdexcept>
 #include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+
+#include <fcntl.h>    // open
+#include <unistd.h>   // close, fsync
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#if defined(__linux__)
+#include <sched.h>    // sched_getaffinity
+#include <pthread.h>  // pthread_setaffinity_np
+#endif
 
 #include "image_utils.hpp"
 #include "contour_detector.hpp"
+#include "spsc_ring.hpp"
 
 namespace motdet
 {
+    namespace // Anonymous namespace
+    {
+        /**
+         * @brief Stores the time elapsed since its construction, or since the last restart, in a field of Stage_times when
+         * destroyed, in microseconds.
+         */
+        class Stage_timer_
+        {
+        public:
+            Stage_timer_(unsigned int &stage): stage_(&stage), start_(std::chrono::high_resolution_clock::now()) {}
+            ~Stage_timer_() { stop_(); }
+
+            /**
+             * @brief Stores the time of the current stage and starts measuring the given one.
+             */
+            void restart(unsigned int &next_stage)
+            {
+                stop_();
+                stage_ = &next_stage;
+            }
+
+        private:
+            void stop_()
+            {
+                auto now = std::chrono::high_resolution_clock::now();
+                *stage_ = std::chrono::duration_cast<std::chrono::microseconds>(now - start_).count();
+                start_ = now;
+            }
+
+            unsigned int *stage_;
+            std::chrono::high_resolution_clock::time_point start_;
+        };
+    } // Anonymous namespace
+
+    struct Motion_detector::Frame_work_
+    {
+        Motdet_task_ *task;
+        std::shared_ptr<const Config_snapshot_> snapshot;
+        std::chrono::high_resolution_clock::time_point start;
+        bool has_reference = true; /**< False if the frame became the reference, so there is nothing to compare. */
+
+        // Each image is released by the stage that consumes it.
+        Image<unsigned short> refined_in, downsampled_in, blur_image, sub_image;
+        Image<unsigned char> cnt_image, dil_image;
+    };
+
+    class Motion_detector::Stage_ring_ : public Spsc_ring<std::unique_ptr<Frame_work_>>
+    {
+        using Spsc_ring::Spsc_ring;
+    };
+
     // Motion_detector implementation
 
-    Motion_detector::Motion_detector(const std::size_t width, const std::size_t height, const std::size_t threads, const std::size_t queue_size, const unsigned int downsample_factor, const float frame_update_ratio):
+    Motion_detector::Motion_detector(const std::size_t width, const std::size_t height, const std::size_t threads, const std::size_t queue_size, const unsigned int downsample_factor, const float frame_update_ratio, const std::string &reference_checkpoint):
         w_(width),
         h_(height),
         total_(width*height),
         threads_(threads),
         queue_size_(queue_size),
-        downsample_factor_(downsample_factor),
-        frame_update_ratio_(frame_update_ratio),
-        min_cont_area_(total_*0.002+5),
         last_submitted_time_(0)
     {
         if (threads    == 0)        throw std::invalid_argument("ERROR Constructor: threads must be at least 1.");
@@ -30,22 +94,87 @@ namespace motdet
         if (width      < 10)        throw std::invalid_argument("ERROR Constructor: width must be at least 10.");
         if (height     < 10)        throw std::invalid_argument("ERROR Constructor: height must be at least 10.");
 
-        // The size requirements for the downsampled image are given by the function in image_utils.
-        downsampled_w_ = std::ceil((float)w_ / downsample_factor);
-        downsampled_h_ = std::ceil((float)h_ / downsample_factor);
+        Detector_config config;
+        config.downsample_factor = downsample_factor;
+        config.frame_update_ratio = frame_update_ratio;
+        config.min_contour_area = total_*0.002+5;
+        config_ = make_config_snapshot_(config, 0);
 
-        reference_ = Image<unsigned short>(downsampled_w_, downsampled_h_, {});
+        reference_ = Image<unsigned short>(config_->downsampled_w, config_->downsampled_h, {});
+        reference_factor_ = downsample_factor;
+
+        // Warm start from a previous run. It is applied by the first frame enqueued, so that the refine factor and the
+        // contour callback can still be set, and the refined reference of the checkpoint is restored with them.
+        if(!reference_checkpoint.empty() && std::filesystem::exists(reference_checkpoint)) pending_checkpoint_ = read_checkpoint_(reference_checkpoint);
 
         // Create all the motion detector slaves.
-        for(std::size_t i = 0; i < threads; ++i) workers_container_.push_back(std::thread(&Motion_detector::detect_motion_, this, i));
+        start_workers_();
     }
 
     Motion_detector::~Motion_detector()
     {
         // The destructor will wait for all threads to die before destroying itself. Leaving a thread unhandled causes error unless it is a daemon.
-        keep_workers_alive_ = false;
+        stop_workers_();
+    }
+
+    void Motion_detector::start_workers_()
+    {
+        keep_workers_alive_ = true;
+        if(executor_ == Executor::frame_parallel)
+        {
+            for(std::size_t i = 0; i < threads_; ++i) workers_container_.push_back(std::thread(&Motion_detector::detect_motion_, this, i));
+        }
+        else
+        {
+            // No more frames than the task queue holds can be in flight, so a stage never waits for space in the next ring.
+            for(std::size_t s = 0; s + 1 < pipeline_stage_count_; ++s) stage_rings_.push_back(std::make_unique<Stage_ring_>(queue_size_));
+            for(std::size_t s = 0; s < pipeline_stage_count_; ++s) workers_container_.push_back(std::thread(&Motion_detector::stage_worker_, this, s));
+        }
+
+    #if defined(__linux__)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if(pin_threads_ && sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+        {
+            std::vector<int> cpus;
+            for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu) if(CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+
+            for(std::size_t t = 0; t < workers_container_.size() && !cpus.empty(); ++t)
+            {
+                cpu_set_t pinned;
+                CPU_ZERO(&pinned);
+                CPU_SET(cpus[t % cpus.size()], &pinned);
+                pthread_setaffinity_np(workers_container_[t].native_handle(), sizeof(pinned), &pinned);
+            }
+        }
+    #endif
+    }
+
+    void Motion_detector::stop_workers_()
+    {
+        {
+            std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+            keep_workers_alive_ = false;
+        }
         no_processable_frame_.notify_all();
+        for(std::unique_ptr<Stage_ring_> &ring : stage_rings_) ring->close();
+
         for(std::thread &t : workers_container_) t.join();
+        workers_container_.clear();
+        stage_rings_.clear();
+    }
+
+    void Motion_detector::set_executor(const Executor executor, const bool pin_threads)
+    {
+        {
+            std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+            if(task_queue_.size() > 0) throw std::runtime_error("ERROR set_executor: Frames are enqueued.");
+        }
+
+        stop_workers_();
+        executor_ = executor;
+        pin_threads_ = pin_threads;
+        start_workers_();
     }
 
     void Motion_detector::enqueue_frame(std::unique_ptr<Image<unsigned short>> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep)
@@ -58,6 +187,13 @@ namespace motdet
         if(timestamp_millis < last_submitted_time_) throw std::invalid_argument("ERROR Enqueue: Submitted timestamps must be chronologically ordered.");
         last_submitted_time_ = timestamp_millis;
 
+        // The checkpoint given to the constructor becomes the reference now that the detector is configured.
+        if(pending_checkpoint_)
+        {
+            apply_checkpoint_(*pending_checkpoint_);
+            pending_checkpoint_.reset();
+        }
+
         if(blocking)
         {
             // Blocking mode, sleep until queue is not full.
@@ -74,12 +210,137 @@ namespace motdet
         new_task.timestamp = timestamp_millis;
         new_task.image = std::move(in); // Need to move smart pointer with move to represent ownership transfer
         new_task.data_keep = data_keep; // Store the extra metadata but nothing will be done with it.
+        new_task.config = config_;      // The frame is processed with the configuration current right now, even if it changes later.
+
+        // If the scene has been idle for a while, only let through 1 of every idle_decimation_ frames.
+        // The idle counter is updated in the result path, so the results mutex is needed to read it.
+        std::unique_lock<std::mutex> results_locker(results_mutex_);
+        bool idle = idle_decimation_ > 1 && idle_frames_ >= idle_frames_threshold_;
+        results_locker.unlock();
+
+        if(idle && frames_since_processed_ + 1 < idle_decimation_)
+        {
+            ++frames_since_processed_;
+            new_task.skipped = true;
+            new_task.state = Motdet_task_::task_state::done;
+
+            // No worker will pick this task, so submit it right away if all the older tasks are done.
+            task_queue_.push_back(std::move(new_task));
+            results_locker.lock();
+            submit_done_tasks_();
+            results_locker.unlock();
+            locker.unlock();
+
+            tasks_full_cond_.notify_all();
+            results_empty_cond_.notify_all();
+            return;
+        }
+
+        // The reference must adapt as if the skipped frames had been processed: r' = 1 - (1-r)^n
+        new_task.update_ratio = 1 - std::pow(1 - new_task.config->config.frame_update_ratio, frames_since_processed_ + 1);
+        frames_since_processed_ = 0;
 
         task_queue_.push_back(std::move(new_task));
         locker.unlock();  // Release the lock and notfy one of the worker threads that there is a new available job to process.
         no_processable_frame_.notify_one();
     }
 
+    void Motion_detector::set_idle_decimation(const std::size_t idle_frames, const std::size_t decimation)
+    {
+        if(decimation == 0) throw std::invalid_argument("ERROR set_idle_decimation: decimation must be at least 1.");
+
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        std::unique_lock<std::mutex> results_locker(results_mutex_);
+        idle_frames_threshold_ = idle_frames;
+        idle_decimation_ = decimation;
+    }
+
+    Detector_config Motion_detector::get_config() const
+    {
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        return config_->config;
+    }
+
+    std::size_t Motion_detector::get_config_epoch() const
+    {
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        return config_->epoch;
+    }
+
+    std::size_t Motion_detector::set_config(const Detector_config &config)
+    {
+        if(config.downsample_factor == 0) throw std::invalid_argument("ERROR set_config: downsample_factor must be at least 1.");
+        if(config.low_threshold > config.high_threshold) throw std::invalid_argument("ERROR set_config: low_threshold cannot be greater than high_threshold.");
+        if(!(config.frame_update_ratio > 0 && config.frame_update_ratio <= 1)) throw std::invalid_argument("ERROR set_config: frame_update_ratio must be in (0, 1].");
+        if(!(config.merge_iou >= 0 && config.merge_iou < 1)) throw std::invalid_argument("ERROR set_config: merge_iou must be in [0, 1).");
+
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        if(refine_factor_ > 0 && (refine_factor_ >= config.downsample_factor || config.downsample_factor % refine_factor_ != 0))
+            throw std::invalid_argument("ERROR set_config: The refine factor must be smaller than downsample_factor and divide it.");
+
+        // Frames already enqueued keep a pointer to the old snapshot, so swapping it does not affect them.
+        config_ = make_config_snapshot_(config, config_->epoch + 1);
+        return config_->epoch;
+    }
+
+    std::shared_ptr<const Motion_detector::Config_snapshot_> Motion_detector::make_config_snapshot_(const Detector_config &config, const std::size_t epoch) const
+    {
+        auto snapshot = std::make_shared<Config_snapshot_>();
+        snapshot->config = config;
+        snapshot->epoch = epoch;
+
+        // The size requirements for the downsampled image are given by the function in image_utils.
+        snapshot->downsampled_w = std::ceil((float)w_ / config.downsample_factor);
+        snapshot->downsampled_h = std::ceil((float)h_ / config.downsample_factor);
+        return snapshot;
+    }
+
+    float Motion_detector::get_processing_rate() const
+    {
+        std::unique_lock<std::mutex> locker(results_mutex_);
+        if(processed_history_.size() == 0) return 1;
+
+        std::size_t processed = 0;
+        for(bool was_processed : processed_history_) if(was_processed) ++processed;
+        return (float)processed / processed_history_.size();
+    }
+
+    void Motion_detector::submit_done_tasks_()
+    {
+        // Submit the tasks to the result queue until a task with a state different from finished is found.
+        // This assures that the results are outputted in chronological order, not processing order.
+        std::deque<Motdet_task_>::iterator to_submit = task_queue_.begin();
+        while (to_submit != task_queue_.end() && to_submit->state == Motdet_task_::task_state::done)
+        {
+            // For each finished task, create a new Detection struct and submit it to the results.
+            Detection det;
+            det.timestamp = to_submit->timestamp;
+            det.processing_time = to_submit->processing_time;
+            det.stage_times = to_submit->stage_times;
+            det.skipped = to_submit->skipped;
+            det.data_keep = to_submit->data_keep;
+
+            if(det.skipped) det.detection_contours = last_result_conts_;
+            else
+            {
+                if(tracker_) tracker_->update(to_submit->result_conts, to_submit->timestamp);
+                det.detection_contours = std::move(to_submit->result_conts);
+                last_result_conts_ = det.detection_contours;
+
+                // Keep track of how long the scene has been idle.
+                if(det.detection_contours.size() > 0) idle_frames_ = 0;
+                else ++idle_frames_;
+            }
+            det.has_detections = det.detection_contours.size() > 0;
+
+            processed_history_.push_back(!det.skipped);
+            if(processed_history_.size() > processing_rate_window_) processed_history_.pop_front();
+
+            result_queue_.push_back(det);
+            to_submit = task_queue_.erase(to_submit); // This updates the iterator to the next element automatically.
+        }
+    }
+
     Detection Motion_detector::get_detection(bool blocking)
     {
         // Lock mutex for checks
@@ -103,133 +364,568 @@ namespace motdet
         return result;
     }
 
-    void Motion_detector::detect_motion_(std::size_t thread_id)
+    void Motion_detector::set_refine_factor(const unsigned int refine_factor)
     {
-        while(keep_workers_alive_)
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        unsigned int downsample_factor = config_->config.downsample_factor;
+        if(refine_factor > 0 && (refine_factor >= downsample_factor || downsample_factor % refine_factor != 0))
+            throw std::invalid_argument("ERROR set_refine_factor: refine_factor must be smaller than downsample_factor and divide it.");
+
+        std::unique_lock<std::mutex> reference_locker(reference_mutex_);
+        if(has_reference_ || task_queue_.size() > 0) throw std::runtime_error("ERROR set_refine_factor: Frames have already been enqueued.");
+        if(refine_factor > 0 && pending_checkpoint_ && pending_checkpoint_->refine_factor != refine_factor)
+            throw std::invalid_argument("ERROR set_refine_factor: The checkpoint given to the constructor was saved with a different refine_factor.");
+
+        refine_factor_ = refine_factor;
+        if(refine_factor_ > 0)
         {
-            // Grab a new task to process. It will need to grab the mutex to do so.
+            refined_w_ = std::ceil((float)w_ / refine_factor_);
+            refined_h_ = std::ceil((float)h_ / refine_factor_);
+        }
+    }
 
-            std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
-            no_processable_frame_.wait(tasks_locker, [this](){ return processable_frame_check_() || !keep_workers_alive_; });
-            if(!keep_workers_alive_) break;
+    void Motion_detector::set_tracking(const bool enabled, const float min_iou, const std::size_t max_missed_frames)
+    {
+        std::unique_ptr<Box_tracker> tracker;
+        if(enabled) tracker = std::make_unique<Box_tracker>(min_iou, max_missed_frames);
 
-            // If the thread reached this point, there is at least 1 task that can be processed in the queue and it got "permission" to process it.
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        std::unique_lock<std::mutex> results_locker(results_mutex_);
+        tracker_ = std::move(tracker);
+    }
 
-            std::deque<Motdet_task_>::iterator to_process = task_queue_.begin();
-            while (to_process != task_queue_.end() && to_process->state != Motdet_task_::task_state::waiting) to_process++;
-            if(to_process == task_queue_.end()) throw std::runtime_error("ERROR detect_motion_: No processable frame found but expected one.");
+    void Motion_detector::set_contour_callback(std::function<void(unsigned long long, const Contour &)> callback)
+    {
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        std::unique_lock<std::mutex> reference_locker(reference_mutex_);
+        if(has_reference_ || task_queue_.size() > 0) throw std::runtime_error("ERROR set_contour_callback: Frames have already been enqueued.");
 
-            // Successfully got the frame, now mark it so that other threads do not start processing it as well.
-            to_process->state = Motdet_task_::task_state::processing;
-            tasks_locker.unlock();
+        contour_callback_ = std::move(callback);
+    }
 
-            // It is assured by program logic that this frame will not be edited by another thread now. Begin processing.
-            auto processing_time_start = std::chrono::high_resolution_clock::now();
+    namespace
+    {
+        // Layout of the reference checkpoints: magic, u32 width, u32 height, u32 downsample factor, u32 refine factor,
+        // u64 idle frames, the reference and then the refined reference if the refine factor is not 0. Native byte order.
+        const char checkpoint_magic[8] = {'M', 'O', 'T', 'D', 'R', 'E', 'F', 1}; // The last byte is the format version.
+        constexpr std::size_t checkpoint_header_size = 32;
 
-            // Get the input image and downsample it, if needed.
-            Image<unsigned short> in(std::move(*to_process->image.get()));
-            Image<unsigned short> downsampled_in(downsampled_w_, downsampled_h_, 0), blur_image(downsampled_w_, downsampled_h_, 0);
+        // Flushes a file or a directory to the disk. Returns false if it could not be opened or flushed.
+        bool fsync_path(const std::string &path, const int flags)
+        {
+            int fd = open(path.c_str(), flags);
+            if(fd < 0) return false;
+            bool synced = fsync(fd) == 0;
+            return close(fd) == 0 && synced;
+        }
+    }
 
-            if(downsample_factor_ > 1) imgutil::downsample(in, downsampled_in, downsample_factor_);
-            else downsampled_in = std::move(in);
+    void Motion_detector::save_reference(const std::string &path) const
+    {
+        std::vector<unsigned short> reference, refined_reference;
+        std::uint64_t idle_frames;
+        unsigned int reference_factor;
 
-            // Blur the image to remove any noise that can result in false positives.
-            if(!keep_workers_alive_) break;
-            imgutil::gaussian_blur_filter(downsampled_in, blur_image);
+        // Copy everything out at once so the workers are not blocked while writing to disk.
+        {
+            std::unique_lock<std::mutex> reference_locker(reference_mutex_);
+            if(!has_reference_) throw std::runtime_error("ERROR save_reference: There is no reference yet.");
+            reference.assign(reference_.get_data().begin(), reference_.get_data().end());
+            reference_factor = reference_factor_;
+            if(refine_factor_ > 0) refined_reference.assign(refined_reference_.get_data().begin(), refined_reference_.get_data().end());
+        }
+        {
+            std::unique_lock<std::mutex> results_locker(results_mutex_);
+            idle_frames = idle_frames_;
+        }
 
-            // If the motion detector has a reference frame, compare with it to check for motion. If not, make a new reference.
-            if(has_reference_)
+        unsigned char header[checkpoint_header_size] = {};
+        std::uint32_t dims[4] = {(std::uint32_t)w_, (std::uint32_t)h_, reference_factor, refine_factor_};
+        std::memcpy(header, checkpoint_magic, sizeof(checkpoint_magic));
+        std::memcpy(header + sizeof(checkpoint_magic), dims, sizeof(dims));
+        std::memcpy(header + sizeof(checkpoint_magic) + sizeof(dims), &idle_frames, sizeof(idle_frames));
+
+        // The previous checkpoint is only replaced once the new one is complete on the disk: the last write may only
+        // fail when the stream is closed, and the rename may reach the disk before the data otherwise.
+        const std::string tmp_path = path + ".tmp";
+        std::error_code ec;
+        {
+            std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+            out.write((const char *)header, checkpoint_header_size);
+            out.write((const char *)reference.data(), reference.size() * sizeof(unsigned short));
+            out.write((const char *)refined_reference.data(), refined_reference.size() * sizeof(unsigned short));
+            out.close();
+            if(!out || !fsync_path(tmp_path, O_WRONLY))
             {
-                // Define all the container images for intermediate processing steps.
-                Image<unsigned short> sub_image(downsampled_w_, downsampled_h_, 0), new_ref_image(downsampled_w_, downsampled_h_, 0);
-                Image<unsigned char> thr_image(downsampled_w_, downsampled_h_, 0), cnt_image(downsampled_w_, downsampled_h_, 0);
-                Image<unsigned char> dil_image(downsampled_w_, downsampled_h_, 0);
-
-                // Interpolate the blurred image and the reference frame to obtain a new reference.
-                // Interpolation is done so that the reference can adapt to changing environment.
-                if(!keep_workers_alive_) break;
-                std::unique_lock<std::mutex> reference_locker(reference_mutex_);
-                imgutil::image_interpolation_and_sub(reference_, blur_image, new_ref_image, sub_image, frame_update_ratio_);
-                reference_ = std::move(new_ref_image);
-                reference_locker.unlock();
+                std::filesystem::remove(tmp_path, ec);
+                throw std::runtime_error("ERROR save_reference: Could not write " + tmp_path);
+            }
+        }
 
-                // Threshold the image so that any value below a certain number is ignored.
-                // Using double threshold along with hysteresis for better results over single threshold.
-                if(!keep_workers_alive_) break;
-                imgutil::double_threshold(sub_image, thr_image, 5000, 22500);
-                imgutil::hysteresis(thr_image, cnt_image);
+        std::filesystem::rename(tmp_path, path, ec);
+        if(ec) throw std::runtime_error("ERROR save_reference: Could not replace " + path);
 
-                // Dilate the image so that the contours are better defined and with less holes.
-                if(!keep_workers_alive_) break;
-                imgutil::dilation(cnt_image, dil_image);
+        // Makes the rename itself durable.
+        std::string parent = std::filesystem::path(path).parent_path().string();
+        if(!fsync_path(parent.empty() ? "." : parent, O_RDONLY | O_DIRECTORY))
+            throw std::runtime_error("ERROR save_reference: Could not flush the directory of " + path);
+    }
 
-                // Detect contours in the image. Any contour detected here is "movement".
-                if(!keep_workers_alive_) break;
-                std::vector<Contour> raw_contours = imgutil::contour_detection(dil_image, true);
+    void Motion_detector::load_reference(const std::string &path)
+    {
+        std::unique_ptr<Reference_checkpoint_> checkpoint = read_checkpoint_(path);
+        if(refine_factor_ > 0 && checkpoint->refine_factor != refine_factor_)
+            throw std::invalid_argument("ERROR load_reference: The checkpoint was saved with a different refine_factor.");
+
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        if(task_queue_.size() > 0) throw std::runtime_error("ERROR load_reference: Frames are enqueued.");
+
+        // Replaces the one given to the constructor, if it has not been used yet.
+        pending_checkpoint_.reset();
+        apply_checkpoint_(*checkpoint);
+    }
 
-                // Go over the detected contours and discard any contour that is too small to be relevant.
-                // Also scale the bounding box of the contour back to the original size before downscaling.
-                if(!keep_workers_alive_) break;
-                for(Contour &raw_cont : raw_contours)
+    std::unique_ptr<Motion_detector::Reference_checkpoint_> Motion_detector::read_checkpoint_(const std::string &path) const
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) throw std::runtime_error("ERROR load_reference: Could not open " + path);
+
+        struct stat file_stat;
+        if(fstat(fd, &file_stat) != 0)
+        {
+            close(fd);
+            throw std::runtime_error("ERROR load_reference: Could not read the size of " + path);
+        }
+        std::size_t size = file_stat.st_size;
+
+        void *map = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd); // The mapping keeps the file open.
+        if(map == MAP_FAILED) throw std::invalid_argument("ERROR load_reference: " + path + " is empty or could not be mapped.");
+
+        // Unmaps the checkpoint no matter how the function exits.
+        std::unique_ptr<void, std::function<void(void *)>> map_guard(map, [size](void *ptr){ munmap(ptr, size); });
+        const unsigned char *data = (const unsigned char *)map;
+
+        std::uint32_t dims[4];
+        std::uint64_t idle_frames;
+        if(size < checkpoint_header_size || std::memcmp(data, checkpoint_magic, sizeof(checkpoint_magic)) != 0)
+            throw std::invalid_argument("ERROR load_reference: " + path + " is not a reference checkpoint.");
+        std::memcpy(dims, data + sizeof(checkpoint_magic), sizeof(dims));
+        std::memcpy(&idle_frames, data + sizeof(checkpoint_magic) + sizeof(dims), sizeof(idle_frames));
+
+        if(dims[0] != w_ || dims[1] != h_ || dims[2] == 0)
+            throw std::invalid_argument("ERROR load_reference: The checkpoint was saved with a different resolution.");
+
+        std::size_t saved_refined_total = dims[3] > 0 ? (std::size_t)std::ceil((float)w_ / dims[3]) * (std::size_t)std::ceil((float)h_ / dims[3]) : 0;
+        // The reference may have been saved with another downsample factor, it is resampled by the first frame processed.
+        std::size_t reference_w = std::ceil((float)w_ / dims[2]), reference_h = std::ceil((float)h_ / dims[2]);
+        std::size_t reference_total = reference_w * reference_h;
+        if(size != checkpoint_header_size + (reference_total + saved_refined_total) * sizeof(unsigned short))
+            throw std::invalid_argument("ERROR load_reference: The checkpoint is truncated.");
+
+        // The refined reference is kept too, the refine factor may still be set before it is applied.
+        auto checkpoint = std::make_unique<Reference_checkpoint_>();
+        const unsigned short *saved_reference = (const unsigned short *)(data + checkpoint_header_size);
+        checkpoint->reference_factor = dims[2];
+        checkpoint->refine_factor = dims[3];
+        checkpoint->idle_frames = idle_frames;
+        checkpoint->reference_w = reference_w;
+        checkpoint->reference.assign(saved_reference, saved_reference + reference_total);
+        checkpoint->refined_reference.assign(saved_reference + reference_total, saved_reference + reference_total + saved_refined_total);
+        return checkpoint;
+    }
+
+    void Motion_detector::apply_checkpoint_(Reference_checkpoint_ &checkpoint)
+    {
+        {
+            std::unique_lock<std::mutex> reference_locker(reference_mutex_);
+            reference_.set_data(std::move(checkpoint.reference), checkpoint.reference_w);
+            if(refine_factor_ > 0) refined_reference_.set_data(std::move(checkpoint.refined_reference), refined_w_);
+            reference_factor_ = checkpoint.reference_factor;
+            reference_epoch_ = config_->epoch;
+            has_reference_ = true;
+        }
+        {
+            std::unique_lock<std::mutex> results_locker(results_mutex_);
+            idle_frames_ = checkpoint.idle_frames;
+        }
+    }
+
+    std::vector<Contour> Motion_detector::refine_contours_(const std::vector<Contour> &coarse_contours, const Image<unsigned short> &refined_in, const float update_ratio, const Detector_config &config)
+    {
+        std::vector<Contour> refined_contours;
+        std::size_t level_ratio = config.downsample_factor / refine_factor_;
+
+        // Turn every coarse contour into a region of the refined image. The margin covers the pixels lost in the borders
+        // by the blur, hysteresis and contour detection, plus the precision lost by the coarse image.
+        std::size_t margin = level_ratio + 4;
+        std::vector<Contour> regions;
+        for(const Contour &cont : coarse_contours)
+        {
+            regions.push_back({
+                cont.bb_tl_x * level_ratio > margin ? cont.bb_tl_x * level_ratio - margin : 0,
+                cont.bb_tl_y * level_ratio > margin ? cont.bb_tl_y * level_ratio - margin : 0,
+                std::min((cont.bb_br_x + 1) * level_ratio + margin, refined_w_ - 1),
+                std::min((cont.bb_br_y + 1) * level_ratio + margin, refined_h_ - 1)
+            });
+        }
+
+        // Merge overlapping regions so that the same movement is not detected twice. Repeat until no merge happens,
+        // since a merged region can grow to overlap regions that were already checked.
+        bool merged = true;
+        while(merged)
+        {
+            merged = false;
+            for(std::size_t a = 0; a < regions.size() && !merged; ++a)
+            {
+                for(std::size_t b = a + 1; b < regions.size(); ++b)
                 {
-                    unsigned int cont_area = (raw_cont.bb_br_x - raw_cont.bb_tl_x) * (raw_cont.bb_br_y - raw_cont.bb_tl_y) * downsample_factor_;
-
-                    if(cont_area > min_cont_area_)
-                    {
-                        to_process->result_conts.push_back({
-                            raw_cont.bb_tl_x * downsample_factor_,
-                            raw_cont.bb_tl_y * downsample_factor_,
-                            raw_cont.bb_br_x * downsample_factor_,
-                            raw_cont.bb_br_y * downsample_factor_
-                        });
-                    }
+                    Contour &ra = regions[a], &rb = regions[b];
+                    if(ra.bb_tl_x > rb.bb_br_x || rb.bb_tl_x > ra.bb_br_x || ra.bb_tl_y > rb.bb_br_y || rb.bb_tl_y > ra.bb_br_y) continue;
+
+                    ra.bb_tl_x = std::min(ra.bb_tl_x, rb.bb_tl_x);
+                    ra.bb_tl_y = std::min(ra.bb_tl_y, rb.bb_tl_y);
+                    ra.bb_br_x = std::max(ra.bb_br_x, rb.bb_br_x);
+                    ra.bb_br_y = std::max(ra.bb_br_y, rb.bb_br_y);
+                    regions.erase(regions.begin() + b);
+                    merged = true;
+                    break;
                 }
             }
-            else
+        }
+
+        // Grab the reference for every region before updating it with the current frame.
+        std::vector<Image<unsigned short>> region_references;
+        std::unique_lock<std::mutex> reference_locker(reference_mutex_);
+        for(const Contour &region : regions)
+        {
+            Image<unsigned short> region_reference(region.bb_br_x - region.bb_tl_x + 1, region.bb_br_y - region.bb_tl_y + 1, uninitialized);
+            imgutil::crop(refined_reference_, region_reference, region.bb_tl_x, region.bb_tl_y);
+            region_references.push_back(std::move(region_reference));
+        }
+        imgutil::image_interpolation(refined_reference_, refined_in, update_ratio);
+        reference_locker.unlock();
+
+        for(std::size_t r = 0; r < regions.size(); ++r)
+        {
+            const Contour &region = regions[r];
+            std::size_t region_w = region_references[r].get_width(), region_h = region_references[r].get_height();
+
+            // Only the contour image needs to start zeroed, every other step overwrites its whole output.
+            Image<unsigned short> blur_in(region_w, region_h, uninitialized), blur_ref(region_w, region_h, uninitialized);
+            Image<unsigned short> sub_image(region_w, region_h, uninitialized);
+            Image<unsigned char> thr_image(region_w, region_h, uninitialized), cnt_image(region_w, region_h, 0), dil_image(region_w, region_h, uninitialized);
+
+            // The blur is linear, so blurring the unblurred reference gives the same result as keeping a blurred one.
+            // The input is not updated by other threads, so the region is read in place instead of cropping it.
+            // The reference averages many frames, so it does not need to be denoised.
+            Image_view<const unsigned short> region_in = refined_in.view().sub_view(region.bb_tl_x, region.bb_tl_y, region_w, region_h);
+            if(config.denoise)
             {
-                std::unique_lock<std::mutex> reference_locker(reference_mutex_);
+                Image<unsigned short> denoised_in(region_w, region_h, uninitialized);
+                imgutil::median_filter(region_in, denoised_in);
+                imgutil::gaussian_blur_filter(denoised_in, blur_in);
+            }
+            else imgutil::gaussian_blur_filter(region_in, blur_in);
+            imgutil::gaussian_blur_filter(region_references[r], blur_ref);
+            imgutil::image_subtraction(blur_in, blur_ref, sub_image);
+
+            imgutil::double_threshold(sub_image, thr_image, config.low_threshold, config.high_threshold);
+            imgutil::hysteresis(thr_image, cnt_image);
+            imgutil::dilation(cnt_image, dil_image);
 
-                has_reference_ = true;
-                reference_ = std::move(blur_image);
+            for(Contour &raw_cont : imgutil::contour_detection(dil_image, true))
+            {
+                unsigned int cont_area = (raw_cont.bb_br_x - raw_cont.bb_tl_x) * (raw_cont.bb_br_y - raw_cont.bb_tl_y) * refine_factor_;
 
+                if(cont_area > config.min_contour_area)
+                {
+                    refined_contours.push_back({
+                        (region.bb_tl_x + raw_cont.bb_tl_x) * refine_factor_,
+                        (region.bb_tl_y + raw_cont.bb_tl_y) * refine_factor_,
+                        (region.bb_tl_x + raw_cont.bb_br_x) * refine_factor_,
+                        (region.bb_tl_y + raw_cont.bb_br_y) * refine_factor_
+                    });
+                }
+            }
+        }
+
+        return refined_contours;
+    }
+
+    std::unique_ptr<Motion_detector::Frame_work_> Motion_detector::take_task_()
+    {
+        // Grab a new task to process. It will need to grab the mutex to do so.
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        no_processable_frame_.wait(tasks_locker, [this](){ return processable_frame_check_() || !keep_workers_alive_; });
+        if(!keep_workers_alive_) return nullptr;
+
+        // If the thread reached this point, there is at least 1 task that can be processed in the queue and it got "permission" to process it.
+
+        std::deque<Motdet_task_>::iterator to_process = task_queue_.begin();
+        while (to_process != task_queue_.end() && to_process->state != Motdet_task_::task_state::waiting) to_process++;
+        if(to_process == task_queue_.end()) throw std::runtime_error("ERROR take_task_: No processable frame found but expected one.");
+
+        // Successfully got the frame, now mark it so that other threads do not start processing it as well.
+        // Tasks are only erased from the front once done, so the pointer stays valid while the frame is processed.
+        to_process->state = Motdet_task_::task_state::processing;
+
+        auto work = std::make_unique<Frame_work_>();
+        work->task = &*to_process;
+        work->snapshot = to_process->config;
+        work->start = std::chrono::high_resolution_clock::now();
+        return work;
+    }
+
+    void Motion_detector::downsample_stage_(Frame_work_ &work)
+    {
+        // The whole frame is processed with the configuration it was enqueued with.
+        const Detector_config &config = work.snapshot->config;
+        const std::size_t downsampled_w = work.snapshot->downsampled_w, downsampled_h = work.snapshot->downsampled_h;
+        Stage_timer_ timer(work.task->stage_times.downsample);
+
+        // Get the input image and downsample it, if needed.
+        Image<unsigned short> in(std::move(*work.task->image.get()));
+        work.downsampled_in = Image<unsigned short>(downsampled_w, downsampled_h, uninitialized);
+
+        // When refining, the input is first downsampled to the refine resolution, and that result is then downsampled
+        // again to get the coarse image. This way the full resolution frame is only traversed once.
+        if(refine_factor_ > 0)
+        {
+            if(refine_factor_ > 1)
+            {
+                work.refined_in = Image<unsigned short>(refined_w_, refined_h_, uninitialized);
+                imgutil::downsample(in, work.refined_in, refine_factor_);
+            }
+            else work.refined_in = std::move(in);
+
+            imgutil::downsample(work.refined_in, work.downsampled_in, config.downsample_factor / refine_factor_);
+        }
+        else if(config.downsample_factor > 1) imgutil::downsample(in, work.downsampled_in, config.downsample_factor);
+        else work.downsampled_in = std::move(in);
+    }
+
+    void Motion_detector::blur_stage_(Frame_work_ &work)
+    {
+        const Detector_config &config = work.snapshot->config;
+        const std::size_t downsampled_w = work.snapshot->downsampled_w, downsampled_h = work.snapshot->downsampled_h;
+        Stage_timer_ timer(work.task->stage_times.blur);
+
+        // Blur the image to remove any noise that can result in false positives.
+        // Impulse noise is removed first if requested, since the blur would only spread it.
+        if(config.denoise)
+        {
+            Image<unsigned short> denoised_in(downsampled_w, downsampled_h, uninitialized);
+            imgutil::median_filter(work.downsampled_in, denoised_in);
+            work.downsampled_in = std::move(denoised_in);
+        }
+        work.blur_image = Image<unsigned short>(downsampled_w, downsampled_h, uninitialized);
+        imgutil::gaussian_blur_filter(work.downsampled_in, work.blur_image);
+        work.downsampled_in = Image<unsigned short>();
+    }
+
+    void Motion_detector::reference_stage_(Frame_work_ &work)
+    {
+        const Detector_config &config = work.snapshot->config;
+        const std::size_t downsampled_w = work.snapshot->downsampled_w, downsampled_h = work.snapshot->downsampled_h;
+        Stage_timer_ timer(work.task->stage_times.subtraction);
+
+        std::unique_lock<std::mutex> reference_locker(reference_mutex_);
+
+        // If the motion detector has no reference frame, make a new one. There is nothing to compare this frame with.
+        if(!has_reference_)
+        {
+            has_reference_ = true;
+            reference_ = std::move(work.blur_image);
+            reference_factor_ = config.downsample_factor;
+            reference_epoch_ = work.snapshot->epoch;
+            if(refine_factor_ > 0) refined_reference_ = work.refined_in;
+
+            work.has_reference = false;
+            return;
+        }
+
+        // Interpolate the blurred image and the reference frame to obtain a new reference.
+        // Interpolation is done so that the reference can adapt to changing environment.
+        Image<unsigned short> new_ref_image(downsampled_w, downsampled_h, uninitialized);
+        work.sub_image = Image<unsigned short>(downsampled_w, downsampled_h, uninitialized);
+        if(reference_.get_width() != downsampled_w || reference_.get_height() != downsampled_h)
+        {
+            // The downsample factor changed. Resample the reference instead of learning it again from scratch.
+            Image<unsigned short> resampled_ref(downsampled_w, downsampled_h, uninitialized);
+            imgutil::resize(reference_, resampled_ref);
+
+            if(work.snapshot->epoch >= reference_epoch_)
+            {
+                reference_ = std::move(resampled_ref);
+                reference_factor_ = config.downsample_factor;
+                reference_epoch_ = work.snapshot->epoch;
+            }
+            else
+            {
+                // Frame enqueued before the reference moved to a newer factor, compare it against a copy but leave
+                // the reference alone.
                 reference_locker.unlock();
+                imgutil::image_interpolation_and_sub(resampled_ref, work.blur_image, new_ref_image, work.sub_image, work.task->update_ratio);
             }
-            // Processing has ended here, the only thing missing is submitting the result.
-            to_process->state = Motdet_task_::task_state::done;
+        }
 
-            // Record the time it took the frame to be processed.
-            if(!keep_workers_alive_) break;
-            auto processing_time_end = std::chrono::high_resolution_clock::now();
-            to_process->processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(processing_time_end - processing_time_start).count();
+        if(reference_locker.owns_lock())
+        {
+            imgutil::image_interpolation_and_sub(reference_, work.blur_image, new_ref_image, work.sub_image, work.task->update_ratio);
+            reference_ = std::move(new_ref_image);
+            reference_epoch_ = std::max(reference_epoch_, work.snapshot->epoch);
+        }
+        work.blur_image = Image<unsigned short>();
+    }
 
-            // Now that this frame is finished, check from oldest to newest the state of the different tasks.
-            // Submit the tasks to the result queue until a task with a state different from finished is found.
-            // This assures that the results are outputted in chronological order, not processing order.
-            // Note it might cause a thread to not submit any results, since the frame it jsut processed it too new.
+    void Motion_detector::threshold_stage_(Frame_work_ &work)
+    {
+        const Detector_config &config = work.snapshot->config;
+        const std::size_t downsampled_w = work.snapshot->downsampled_w, downsampled_h = work.snapshot->downsampled_h;
+        Stage_timer_ timer(work.task->stage_times.threshold);
+
+        // Threshold the image so that any value below a certain number is ignored.
+        // Using double threshold along with hysteresis for better results over single threshold.
+        // Only the contour image needs to start zeroed, every other step overwrites its whole output.
+        Image<unsigned char> thr_image(downsampled_w, downsampled_h, uninitialized);
+        work.cnt_image = Image<unsigned char>(downsampled_w, downsampled_h, 0);
+        imgutil::double_threshold(work.sub_image, thr_image, config.low_threshold, config.high_threshold);
+        imgutil::hysteresis(thr_image, work.cnt_image);
+        work.sub_image = Image<unsigned short>();
+    }
 
-            // Lock both the tasks queue and the results queue.
-            tasks_locker.lock();
-            std::unique_lock<std::mutex> results_locker(results_mutex_);
+    void Motion_detector::dilation_stage_(Frame_work_ &work)
+    {
+        Stage_timer_ timer(work.task->stage_times.dilation);
 
-            std::deque<Motdet_task_>::iterator to_submit = task_queue_.begin();
-            while (to_submit != task_queue_.end() && to_submit->state == Motdet_task_::task_state::done)
+        // Dilate the image so that the contours are better defined and with less holes.
+        work.dil_image = Image<unsigned char>(work.snapshot->downsampled_w, work.snapshot->downsampled_h, uninitialized);
+        imgutil::dilation(work.cnt_image, work.dil_image);
+        work.cnt_image = Image<unsigned char>();
+    }
+
+    void Motion_detector::contour_stage_(Frame_work_ &work)
+    {
+        const Detector_config &config = work.snapshot->config;
+        Motdet_task_ &task = *work.task;
+        Stage_timer_ timer(task.stage_times.contours);
+
+        // Discards any contour that is too small to be relevant, and scales the bounding box of the rest back to
+        // the original size before downscaling.
+        std::vector<Contour> &result_conts = task.result_conts;
+        auto filter_contour = [&config, &result_conts](const Contour &raw_cont)
+        {
+            unsigned int cont_area = (raw_cont.bb_br_x - raw_cont.bb_tl_x) * (raw_cont.bb_br_y - raw_cont.bb_tl_y) * config.downsample_factor;
+            if(cont_area <= config.min_contour_area) return false;
+
+            result_conts.push_back({
+                raw_cont.bb_tl_x * config.downsample_factor,
+                raw_cont.bb_tl_y * config.downsample_factor,
+                raw_cont.bb_br_x * config.downsample_factor,
+                raw_cont.bb_br_y * config.downsample_factor
+            });
+            return true;
+        };
+
+        // Detect contours in the image. Any contour detected here is "movement".
+        // With a contour callback, every component is filtered and reported as soon as it is closed instead.
+        if(contour_callback_ && refine_factor_ == 0)
+        {
+            unsigned long long timestamp = task.timestamp;
+            imgutil::streaming_contour_detection(work.dil_image, [&](const Contour &raw_cont)
             {
-                // For each finished task, create a new Detection struct and submit it to the results.
-                Detection det;
-                det.timestamp = to_submit->timestamp;
-                det.processing_time = to_submit->processing_time;
-                det.detection_contours = std::move(to_submit->result_conts);
-                det.has_detections = det.detection_contours.size() > 0;
-                det.data_keep = to_submit->data_keep;
+                if(filter_contour(raw_cont)) contour_callback_(timestamp, result_conts.back());
+            });
+            timer.restart(task.stage_times.filtering);
+        }
+        else
+        {
+            std::vector<Contour> raw_contours = imgutil::contour_detection(work.dil_image, true);
+            timer.restart(task.stage_times.filtering);
 
-                result_queue_.push_back(det);
-                to_submit = task_queue_.erase(to_submit); // This updates the iterator to the next element automatically.
+            // When refining, the coarse contours only tell where to look again at a finer resolution.
+            if(refine_factor_ > 0)
+            {
+                result_conts = refine_contours_(raw_contours, work.refined_in, task.update_ratio, config);
+                if(contour_callback_) for(const Contour &cont : result_conts) contour_callback_(task.timestamp, cont);
             }
+            else for(const Contour &raw_cont : raw_contours) filter_contour(raw_cont);
+        }
 
-            results_locker.unlock();
-            tasks_locker.unlock();
-            tasks_full_cond_.notify_all(); // Notifying all because we might have submitted more than 1 frame.
-            results_empty_cond_.notify_all();
+        // Collapse the fragments of a same object into a single box.
+        imgutil::merge_contours(result_conts, config.contour_merge, config.merge_gap, config.merge_iou);
+    }
+
+    void Motion_detector::finish_task_(Frame_work_ &work)
+    {
+        // Processing has ended here, the only thing missing is submitting the result.
+        // Record the time it took the frame to be processed.
+        auto processing_time_end = std::chrono::high_resolution_clock::now();
+        work.task->processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(processing_time_end - work.start).count();
+
+        // Now that this frame is finished, check from oldest to newest the state of the different tasks.
+        // Note it might cause a thread to not submit any results, since the frame it jsut processed it too new.
+
+        // Lock both the tasks queue and the results queue.
+        std::unique_lock<std::mutex> tasks_locker(tasks_mutex_);
+        std::unique_lock<std::mutex> results_locker(results_mutex_);
+
+        work.task->state = Motdet_task_::task_state::done;
+        submit_done_tasks_();
+
+        results_locker.unlock();
+        tasks_locker.unlock();
+        tasks_full_cond_.notify_all(); // Notifying all because we might have submitted more than 1 frame.
+        results_empty_cond_.notify_all();
+    }
+
+    void Motion_detector::run_stage_(Frame_work_ &work, const std::size_t stage)
+    {
+        // Frames that became the reference have nothing else to be done.
+        if(stage > reference_stage_index_ && !work.has_reference) return;
+
+        switch(stage)
+        {
+            case 0: downsample_stage_(work); break;
+            case 1: blur_stage_(work); break;
+            case 2: reference_stage_(work); break;
+            case 3: threshold_stage_(work); break;
+            case 4: dilation_stage_(work); break;
+            case 5: contour_stage_(work); break;
+        }
+    }
+
+    void Motion_detector::detect_motion_(std::size_t thread_id)
+    {
+        // Every worker takes the oldest waiting frame and runs all the stages on it.
+        while(std::unique_ptr<Frame_work_> work = take_task_())
+        {
+            for(std::size_t stage = 0; stage < pipeline_stage_count_; ++stage)
+            {
+                if(!keep_workers_alive_) return;
+                run_stage_(*work, stage);
+            }
+            if(!keep_workers_alive_) return;
+            finish_task_(*work);
+        }
+    }
+
+    void Motion_detector::stage_worker_(const std::size_t stage)
+    {
+        // The first stage takes the frames in the order they were enqueued, the rest receive them from the previous stage,
+        // so every stage sees the frames in order.
+        while(true)
+        {
+            std::unique_ptr<Frame_work_> work;
+            if(stage == 0) work = take_task_();
+            else stage_rings_[stage - 1]->pop(work);
+            if(!work) return;
+
+            run_stage_(*work, stage);
+
+            if(stage + 1 == pipeline_stage_count_) finish_task_(*work);
+            else if(!stage_rings_[stage]->push(std::move(work))) return;
         }
     }
 
@@ -255,4 +951,9 @@ namespace motdet
         }
     }
 
+    void luma_to_bw(const unsigned char *in, const std::size_t n_pix, Image<unsigned short> &out)
+    {
+        for(std::size_t i = 0; i < n_pix; ++i) out[i] = in[i] * 255;
+    }
+
 } // namespace motdet
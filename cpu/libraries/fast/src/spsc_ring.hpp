@@ -0,0 +1,134 @@
+#ifndef __MOTDET_SPSC_RING_HPP__
+#define __MOTDET_SPSC_RING_HPP__
+
+#include <cstddef>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+namespace motdet
+{
+
+    /**
+     * @brief Bounded FIFO between one producer thread and one consumer thread. Lock free while values keep flowing.
+     * @details A side that has to wait spins for a short while, since the other side usually answers within a few
+     * microseconds when frames are flowing, and then sleeps until woken, so an idle detector does not burn CPU.
+     * @tparam T Type of the values. Must be default constructible and movable.
+     */
+    template <typename T> class Spsc_ring
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param capacity Values the ring can hold. >0.
+         */
+        explicit Spsc_ring(const std::size_t capacity):
+            slots_(capacity + 1),
+            buffer_(slots_)
+        {}
+
+        Spsc_ring(const Spsc_ring &other) = delete;
+        Spsc_ring& operator=(const Spsc_ring &other) = delete;
+
+        // General Methods
+
+        /**
+         * @brief Appends a value, waiting while the ring is full.
+         * @return false if the ring was closed, the value is then dropped.
+         */
+        bool push(T val)
+        {
+            std::size_t tail = tail_.load(std::memory_order_relaxed), next = next_(tail);
+            if(!wait_(not_full_, [&](){ return next != head_.load(); })) return false;
+
+            buffer_[tail] = std::move(val);
+            tail_.store(next);
+            wake_(not_empty_);
+            return true;
+        }
+
+        /**
+         * @brief Takes the oldest value, waiting while the ring is empty.
+         * @return false if the ring was closed, val is then left untouched.
+         */
+        bool pop(T &val)
+        {
+            std::size_t head = head_.load(std::memory_order_relaxed);
+            if(!wait_(not_empty_, [&](){ return head != tail_.load(); })) return false;
+
+            val = std::move(buffer_[head]);
+            head_.store(next_(head));
+            wake_(not_full_);
+            return true;
+        }
+
+        /**
+         * @brief Makes every current and future push and pop return false right away.
+         */
+        void close()
+        {
+            closed_ = true;
+            for(Waiter_ *waiter : {&not_full_, &not_empty_})
+            {
+                std::unique_lock<std::mutex> locker(waiter->mutex);
+                waiter->cond.notify_all();
+            }
+        }
+
+    private:
+        struct Waiter_
+        {
+            std::mutex mutex;
+            std::condition_variable cond;
+            std::atomic<bool> sleeping{false};
+        };
+
+        std::size_t next_(const std::size_t idx) const { return idx + 1 == slots_ ? 0 : idx + 1; }
+
+        /**
+         * @brief Waits until ready() or the ring is closed.
+         * @return false if the ring was closed.
+         */
+        template <typename READY>
+        bool wait_(Waiter_ &waiter, READY ready)
+        {
+            for(std::size_t attempt = 0; ; ++attempt)
+            {
+                if(closed_) return false;
+                if(ready()) return true;
+
+                if(attempt < 64) continue;
+                if(attempt < 256) { std::this_thread::yield(); continue; }
+
+                // Announce the sleep before checking again, the other side checks the flag after publishing its change,
+                // so either this check sees the change or the other side sees the flag and wakes this one.
+                std::unique_lock<std::mutex> locker(waiter.mutex);
+                waiter.sleeping = true;
+                waiter.cond.wait_for(locker, std::chrono::milliseconds(100), [&](){ return closed_ || ready(); });
+                waiter.sleeping = false;
+            }
+        }
+
+        void wake_(Waiter_ &waiter)
+        {
+            if(!waiter.sleeping) return;
+            std::unique_lock<std::mutex> locker(waiter.mutex);
+            waiter.cond.notify_one();
+        }
+
+        std::size_t slots_; /**< Capacity + 1, one slot is always left empty to tell a full ring from an empty one. */
+        std::vector<T> buffer_;
+        std::atomic<bool> closed_{false};
+
+        // The producer only writes tail_ and the consumer only writes head_. Kept in separate cache lines.
+        alignas(64) std::atomic<std::size_t> head_{0};
+        alignas(64) std::atomic<std::size_t> tail_{0};
+        Waiter_ not_full_, not_empty_;
+    };
+
+} // namespace motdet
+
+#endif // __MOTDET_SPSC_RING_HPP__
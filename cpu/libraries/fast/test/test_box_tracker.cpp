@@ -0,0 +1,148 @@
+#include "test_box_tracker.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+
+namespace test
+{
+    namespace box_tracker
+    {
+        void test_all()
+        {
+            std::cout << "Testing module box_tracker..." << std::endl;
+
+            log_test_result(test_box_tracker(), "Box_tracker");
+            log_test_result(test_motion_detector_tracking(), "Motion_detector tracking");
+
+            std::cout << "Finished tests for module box_tracker." << std::endl << std::endl;
+        }
+
+        bool test_box_tracker()
+        {
+            // Check 1: Two objects crossing each other at 0.2 px/ms, 10 px wide. After the first 10 ms the frames are 40 ms apart,
+            // so consecutive boxes only overlap by 1/9. The prediction keeps them matched, even while they cross.
+
+            motdet::Box_tracker tracker0(0.3, 1);
+
+            bool test_ids = true;
+            for(unsigned long long t : {0, 10, 50, 90, 130, 170, 210, 250})
+            {
+                std::size_t shift = t / 5;
+                std::vector<motdet::Contour> conts = {{100 + shift, 50, 109 + shift, 59}, {180 - shift, 52, 189 - shift, 61}};
+
+                tracker0.update(conts, t);
+                test_ids = test_ids && conts[0].track_id == 1 && conts[1].track_id == 2;
+            }
+            CHECK_TRUE(test_ids);
+
+            // Check 2: An object missing for a frame keeps its ID, one missing for longer than max_missed_frames gets a new one.
+
+            motdet::Box_tracker tracker1(0.3, 1);
+            std::vector<motdet::Contour> conts1 = {{10, 10, 30, 30}}, empty;
+            tracker1.update(conts1, 0);
+            tracker1.update(empty, 40);
+            conts1 = {{11, 10, 31, 30}};
+            tracker1.update(conts1, 80);
+            bool test_coast = conts1[0].track_id == 1;
+            CHECK_TRUE(test_coast);
+
+            tracker1.update(empty, 120);
+            tracker1.update(empty, 160);
+            bool test_dropped = tracker1.get_track_count() == 0;
+            conts1 = {{11, 10, 31, 30}};
+            tracker1.update(conts1, 200);
+            test_dropped = test_dropped && conts1[0].track_id == 2;
+            CHECK_TRUE(test_dropped);
+
+            // Check 3: Two boxes competing for a track, the one overlapping it the most continues it.
+
+            motdet::Box_tracker tracker2;
+            std::vector<motdet::Contour> conts2 = {{0, 0, 19, 19}};
+            tracker2.update(conts2, 0);
+            conts2 = {{10, 0, 29, 19}, {2, 0, 21, 19}};
+            tracker2.update(conts2, 0);
+            bool test_greedy = conts2[0].track_id == 2 && conts2[1].track_id == 1;
+            CHECK_TRUE(test_greedy);
+
+            // Check exceptions
+
+            bool test_exc0 = false;
+            try
+            {
+                motdet::Box_tracker tracker_exc(1);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc0 = true;
+            }
+            CHECK_TRUE(test_exc0);
+
+            bool test_exc1 = false;
+            try
+            {
+                tracker2.update(conts2, 0);
+                tracker2.update(conts2, 100);
+                tracker2.update(conts2, 99);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc1 = true;
+            }
+            CHECK_TRUE(test_exc1);
+
+            return test_ids && test_coast && test_dropped && test_greedy && test_exc0 && test_exc1;
+        }
+
+        bool test_motion_detector_tracking()
+        {
+            // A square moving 3 px per frame keeps its ID for the whole sequence.
+            auto make_frame = [](std::size_t f)
+            {
+                auto img = std::make_unique<motdet::Image<unsigned short>>(64, 64, 0);
+                if(f > 0)
+                    for(std::size_t i = 20; i < 32; ++i)
+                        for(std::size_t j = 5 + f*3; j < 17 + f*3; ++j) (*img)[i*64 + j] = 65535;
+                return img;
+            };
+
+            motdet::Motion_detector motdet0(64, 64, 2, 4, 1);
+            motdet0.set_tracking(true);
+
+            // The first frame processed becomes the reference, so the empty one is waited for before the others are
+            // enqueued to both threads.
+            motdet0.enqueue_frame(make_frame(0), 0, true);
+            std::vector<motdet::Detection> dets = { motdet0.get_detection(true) };
+            for(std::size_t f = 1; f < 10; ++f)
+            {
+                motdet0.enqueue_frame(make_frame(f), f*40, true);
+                if(motdet0.get_task_queue_size() == motdet0.get_max_task_queue_size()) dets.push_back(motdet0.get_detection(true));
+            }
+            while(dets.size() < 10) dets.push_back(motdet0.get_detection(true));
+
+            bool test_tracked = true;
+            for(std::size_t f = 1; f < 10; ++f)
+                test_tracked = test_tracked && dets[f].detection_contours.size() == 1 && dets[f].detection_contours[0].track_id == 1;
+            CHECK_TRUE(test_tracked);
+
+            // Disabled again, the IDs are 0.
+            motdet0.set_tracking(false);
+            motdet0.enqueue_frame(make_frame(1), 400, true);
+            motdet::Detection det0 = motdet0.get_detection(true);
+            bool test_untracked = det0.has_detections && det0.detection_contours[0].track_id == 0;
+            CHECK_TRUE(test_untracked);
+
+            bool test_exc0 = false;
+            try
+            {
+                motdet0.set_tracking(true, -0.1);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc0 = true;
+            }
+            CHECK_TRUE(test_exc0);
+
+            return test_tracked && test_untracked && test_exc0;
+        }
+    } // namespace box_tracker
+} // namespace test
@@ -0,0 +1,18 @@
+#ifndef __TEST_MOTDET_BOX_TRACKER_HPP__
+#define __TEST_MOTDET_BOX_TRACKER_HPP__
+
+#include "motion_detector.hpp"
+#include "box_tracker.hpp"
+
+namespace test
+{
+    namespace box_tracker
+    {
+        void test_all();
+
+        bool test_box_tracker();
+        bool test_motion_detector_tracking();
+    } // namespace box_tracker
+} // namespace test
+
+#endif // __TEST_MOTDET_BOX_TRACKER_HPP__
@@ -12,6 +12,8 @@ namespace test
             std::cout << "Testing module contour_detector..." << std::endl;
 
             log_test_result(test_contour_detection(), "contour_detection");
+            log_test_result(test_streaming_contour_detection(), "streaming_contour_detection");
+            log_test_result(test_merge_contours(), "merge_contours");
 
             std::cout << "Finished tests for module contour_detector." << std::endl << std::endl;
         }
@@ -202,5 +204,146 @@ namespace test
 
             return test_img0 && test_img1;
         }
+
+        bool test_streaming_contour_detection()
+        {
+            auto same_box = [](const motdet::Contour &cont, std::size_t tl_x, std::size_t tl_y, std::size_t br_x, std::size_t br_y)
+            {
+                return cont.bb_tl_x == tl_x && cont.bb_tl_y == tl_y && cont.bb_br_x == br_x && cont.bb_br_y == br_y;
+            };
+
+            // Check 1: Same image as the first check of contour_detection. Holes are not reported, and the inner object is
+            // reported first since it is the first one to be closed.
+
+            std::vector<unsigned char> data0_in = {
+               0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   0,
+               0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   0,   1,   1,   0,
+               0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,   0,   1,   1,   0,
+               0,   1,   1,   1,   1,   1,   0,   0,   0,   1,   1,   0,   1,   1,   0,
+               0,   1,   1,   1,   1,   0,   0,   0,   0,   1,   1,   0,   1,   1,   0,
+               0,   1,   1,   1,   0,   0,   1,   0,   0,   1,   1,   0,   1,   1,   0,
+               0,   1,   1,   1,   0,   1,   1,   0,   0,   1,   1,   0,   1,   1,   0,
+               0,   1,   1,   1,   0,   1,   1,   0,   1,   1,   1,   0,   1,   1,   0,
+               0,   1,   1,   1,   0,   1,   1,   0,   1,   1,   1,   0,   0,   1,   0,
+               0,   1,   1,   1,   0,   0,   0,   0,   1,   1,   1,   0,   0,   1,   0,
+               0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   0,   0,   1,   0,
+               0,   0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   0,   0,   0,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0
+            };
+
+            motdet::Image<unsigned char> img0(data0_in, 15);
+            std::vector<motdet::Contour> img0_contours;
+            std::size_t img0_count = motdet::imgutil::streaming_contour_detection(img0, [&img0_contours](const motdet::Contour &cont){ img0_contours.push_back(cont); });
+
+            bool test_img0_input = test_compare_vectors<unsigned char, unsigned char>(img0.get_data(), data0_in);
+            CHECK_TRUE(test_img0_input);
+
+            bool test_img0_conts = img0_count == 3 && img0_contours.size() == 3;
+            CHECK_TRUE(test_img0_conts);
+
+            if(test_img0_conts)
+            {
+                test_img0_conts = same_box(img0_contours[0], 5, 7, 6, 10) && same_box(img0_contours[1], 12, 1, 13, 12) && same_box(img0_contours[2], 1, 3, 10, 13);
+                CHECK_TRUE(test_img0_conts);
+            }
+
+            bool test_img0 = test_img0_input && test_img0_conts;
+
+            // Check 2: Arms that only join further down, diagonal neighbours and pixels on the borders.
+
+            std::vector<unsigned char> data1_in = {
+               1,   0,   1,   0,   0,   0,
+               1,   0,   1,   0,   0,   1,
+               1,   1,   1,   0,   1,   0,
+               0,   0,   0,   0,   0,   0,
+               1,   1,   0,   0,   0,   0
+            };
+
+            motdet::Image<unsigned char> img1(data1_in, 6);
+            std::vector<motdet::Contour> img1_contours;
+            motdet::imgutil::streaming_contour_detection(img1, [&img1_contours](const motdet::Contour &cont){ img1_contours.push_back(cont); });
+
+            bool test_img1 = img1_contours.size() == 3;
+            CHECK_TRUE(test_img1);
+
+            if(test_img1)
+            {
+                test_img1 = same_box(img1_contours[0], 0, 0, 2, 2) && same_box(img1_contours[1], 4, 1, 5, 2) && same_box(img1_contours[2], 0, 4, 1, 4);
+                CHECK_TRUE(test_img1);
+            }
+
+            // Check 3: Empty image.
+
+            motdet::Image<unsigned char> img2(7, 3, 0);
+            bool test_img2 = motdet::imgutil::streaming_contour_detection(img2, [](const motdet::Contour &cont){}) == 0;
+            CHECK_TRUE(test_img2);
+
+            return test_img0 && test_img1 && test_img2;
+        }
+
+        bool test_merge_contours()
+        {
+            auto same_box = [](const motdet::Contour &cont, std::size_t tl_x, std::size_t tl_y, std::size_t br_x, std::size_t br_y)
+            {
+                return cont.bb_tl_x == tl_x && cont.bb_tl_y == tl_y && cont.bb_br_x == br_x && cont.bb_br_y == br_y;
+            };
+
+            // Check 1: Gap. B is 3 px from A and D 2 px from B, C is far from everything.
+
+            const std::vector<motdet::Contour> conts0 = {{0, 0, 10, 10}, {100, 100, 110, 110}, {13, 0, 20, 10}, {22, 5, 30, 8}};
+
+            std::vector<motdet::Contour> merged0 = conts0;
+            motdet::imgutil::merge_contours(merged0, motdet::Contour_merge::gap, 1, 0);
+            bool test_gap0 = merged0.size() == 4;
+            CHECK_TRUE(test_gap0);
+
+            merged0 = conts0;
+            motdet::imgutil::merge_contours(merged0, motdet::Contour_merge::gap, 2, 0);
+            bool test_gap1 = merged0.size() == 3 && same_box(merged0[0], 0, 0, 10, 10) && same_box(merged0[2], 13, 0, 30, 10);
+            CHECK_TRUE(test_gap1);
+
+            merged0 = conts0;
+            motdet::imgutil::merge_contours(merged0, motdet::Contour_merge::gap, 3, 0);
+            bool test_gap2 = merged0.size() == 2 && same_box(merged0[0], 0, 0, 30, 10) && same_box(merged0[1], 100, 100, 110, 110);
+            CHECK_TRUE(test_gap2);
+
+            merged0 = conts0;
+            motdet::imgutil::merge_contours(merged0, motdet::Contour_merge::none, 100, 0);
+            bool test_none = merged0.size() == 4;
+            CHECK_TRUE(test_none);
+
+            // Check 2: A long chain of fragments spread over many cells.
+
+            std::vector<motdet::Contour> conts1;
+            for(std::size_t k = 0; k < 200; ++k) conts1.push_back({(199 - k)*5, 40, (199 - k)*5 + 3, 42});
+            conts1.push_back({500, 60, 503, 62});
+            motdet::imgutil::merge_contours(conts1, motdet::Contour_merge::gap, 2, 0);
+            bool test_chain = conts1.size() == 2 && same_box(conts1[0], 0, 40, 998, 42) && same_box(conts1[1], 500, 60, 503, 62);
+            CHECK_TRUE(test_chain);
+
+            // Check 3: IoU. A and B overlap by 1/3, C overlaps each of them by 1/4 but their union by 1/3, so it is only merged
+            // in the second pass.
+
+            const std::vector<motdet::Contour> conts2 = {{0, 0, 9, 9}, {5, 0, 14, 9}, {0, 5, 14, 14}};
+
+            std::vector<motdet::Contour> merged2 = conts2;
+            motdet::imgutil::merge_contours(merged2, motdet::Contour_merge::iou, 0, 0.4);
+            bool test_iou0 = merged2.size() == 3;
+            CHECK_TRUE(test_iou0);
+
+            merged2 = conts2;
+            motdet::imgutil::merge_contours(merged2, motdet::Contour_merge::iou, 0, 0.3);
+            bool test_iou1 = merged2.size() == 1 && same_box(merged2[0], 0, 0, 14, 14);
+            CHECK_TRUE(test_iou1);
+
+            std::vector<motdet::Contour> merged3 = {{0, 0, 9, 9}, {10, 0, 19, 9}};
+            motdet::imgutil::merge_contours(merged3, motdet::Contour_merge::iou, 0, 0);
+            bool test_iou2 = merged3.size() == 2;
+            CHECK_TRUE(test_iou2);
+
+            return test_gap0 && test_gap1 && test_gap2 && test_none && test_chain && test_iou0 && test_iou1 && test_iou2;
+        }
     } // namespace contour_detector
 } // namespace test
@@ -11,6 +11,8 @@ namespace test
         void test_all();
 
         bool test_contour_detection();
+        bool test_streaming_contour_detection();
+        bool test_merge_contours();
     } // namespace contour_detector
 } // namespace test
 
@@ -0,0 +1,257 @@
+#include "test_detection_log.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+
+namespace test
+{
+    namespace detection_log
+    {
+        // Frame i of the synthetic logs. Every 10th frame has motion, and a jump that does not fit a 32b delta is placed at frame 500.
+        motdet::Detection make_detection_(const std::size_t i)
+        {
+            motdet::Detection det;
+            det.timestamp = i * 40 + (i >= 500 ? 5000000000ULL : 0);
+            det.processing_time = i % 7;
+            det.stage_times.blur = i;
+            det.stage_times.filtering = 2*i;
+            det.skipped = i % 3 == 0;
+            if(i % 10 == 0) det.detection_contours = {{i % 100, 1, i % 100 + 5, 9}, {0, 0, 1919, 1079}};
+            det.has_detections = det.detection_contours.size() > 0;
+            return det;
+        }
+
+        bool equal_(const motdet::Detection &det, const std::size_t i)
+        {
+            motdet::Detection expected = make_detection_(i);
+            if(det.timestamp != expected.timestamp || det.processing_time != expected.processing_time) return false;
+            if(det.stage_times.blur != expected.stage_times.blur || det.stage_times.filtering != expected.stage_times.filtering) return false;
+            if(det.skipped != expected.skipped || det.has_detections != expected.has_detections) return false;
+            if(det.detection_contours.size() != expected.detection_contours.size()) return false;
+            for(std::size_t c = 0; c < det.detection_contours.size(); ++c)
+            {
+                const motdet::Contour &a = det.detection_contours[c], &b = expected.detection_contours[c];
+                if(a.bb_tl_x != b.bb_tl_x || a.bb_tl_y != b.bb_tl_y || a.bb_br_x != b.bb_br_x || a.bb_br_y != b.bb_br_y) return false;
+            }
+            return true;
+        }
+
+        bool equal_range_(const std::vector<motdet::Detection> &dets, const std::size_t first, const std::size_t step)
+        {
+            for(std::size_t r = 0; r < dets.size(); ++r) if(!equal_(dets[r], first + r*step)) return false;
+            return true;
+        }
+
+        void test_all()
+        {
+            std::cout << "Testing module detection_log..." << std::endl;
+
+            log_test_result(test_detection_log_query(), "Detection log query");
+            log_test_result(test_detection_log_reopen(), "Detection log reopen");
+
+            std::cout << "Finished tests for module detection_log." << std::endl << std::endl;
+        }
+
+        bool test_detection_log_query()
+        {
+            std::string path = (std::filesystem::temp_directory_path() / "motdet_test_query.log").string();
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".idx");
+
+            {
+                motdet::Detection_log_writer writer(path, 16);
+                for(std::size_t i = 0; i < 1000; ++i) writer.append(make_detection_(i));
+            }
+
+            motdet::Detection_log_reader reader(path);
+
+            // Check 1: Only detections, starting between index entries.
+
+            std::vector<motdet::Detection> res0 = reader.query(4001, 8000);
+            bool test_res0 = res0.size() == 10 && equal_range_(res0, 110, 10);
+            CHECK_TRUE(test_res0);
+
+            // Check 2: Every frame, inclusive bounds.
+
+            std::vector<motdet::Detection> res1 = reader.query(40*37, 40*53, false);
+            bool test_res1 = res1.size() == 17 && equal_range_(res1, 37, 1);
+            CHECK_TRUE(test_res1);
+
+            // Check 3: Range across the jump in timestamps.
+
+            std::vector<motdet::Detection> res2 = reader.query(40*495, 5000000000ULL + 40*505, false);
+            bool test_res2 = res2.size() == 11 && equal_range_(res2, 495, 1);
+            CHECK_TRUE(test_res2);
+
+            // Check 4: Ranges outside the log, and empty ranges.
+
+            bool test_res3 = reader.query(5000000000ULL + 40*1000, 5000000000ULL + 40*2000).empty() && reader.query(100, 50).empty() &&
+                             reader.query(1, 39, false).empty();
+            CHECK_TRUE(test_res3);
+
+            // Check 5: Whole log.
+
+            std::vector<motdet::Detection> res4 = reader.query(0, -1ULL, false);
+            bool test_res4 = res4.size() == 1000 && equal_range_(res4, 0, 1);
+            CHECK_TRUE(test_res4);
+
+            // Check 6: Repeated timestamps across an index entry. The records at "from" before the entry are not skipped.
+
+            std::string dup_path = path + ".dup";
+            std::filesystem::remove(dup_path);
+            std::filesystem::remove(dup_path + ".idx");
+            {
+                motdet::Detection_log_writer writer(dup_path, 2);
+                for(unsigned long long timestamp : {10, 20, 20, 20, 30})
+                {
+                    motdet::Detection det = make_detection_(1);
+                    det.timestamp = timestamp;
+                    writer.append(det);
+                }
+            }
+            std::vector<motdet::Detection> res5;
+            {
+                motdet::Detection_log_reader dup_reader(dup_path);
+                res5 = dup_reader.query(20, 20, false);
+            }
+            bool test_res5 = res5.size() == 3 && res5[0].timestamp == 20 && res5[2].timestamp == 20;
+            CHECK_TRUE(test_res5);
+            std::filesystem::remove(dup_path);
+            std::filesystem::remove(dup_path + ".idx");
+
+            // Check exceptions
+
+            bool test_exc0 = false;
+            try
+            {
+                motdet::Detection_log_writer writer(path, 0);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc0 = true;
+            }
+            CHECK_TRUE(test_exc0);
+
+            bool test_exc1 = false;
+            try
+            {
+                motdet::Detection_log_writer writer(path);
+                writer.append(make_detection_(10));
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc1 = true;
+            }
+            CHECK_TRUE(test_exc1);
+
+            // A rejected record leaves no trace: the records appended after it keep their own timestamps.
+
+            std::string rejected_path = path + ".rejected";
+            std::filesystem::remove(rejected_path);
+            std::filesystem::remove(rejected_path + ".idx");
+            bool test_exc_box = false;
+            {
+                motdet::Detection_log_writer writer(rejected_path, 1);
+                motdet::Detection det = make_detection_(0);
+                det.timestamp = 5000;
+                det.detection_contours = {{70000, 0, 70001, 1}};
+                try{ writer.append(det); }
+                catch(const std::invalid_argument &e){ test_exc_box = true; }
+
+                for(std::size_t i = 1; i <= 3; ++i) writer.append(make_detection_(i));
+            }
+            std::vector<motdet::Detection> res_rejected;
+            {
+                motdet::Detection_log_reader rejected_reader(rejected_path);
+                res_rejected = rejected_reader.query(0, -1ULL, false);
+            }
+            test_exc_box = test_exc_box && res_rejected.size() == 3 && equal_range_(res_rejected, 1, 1);
+            CHECK_TRUE(test_exc_box);
+            std::filesystem::remove(rejected_path);
+            std::filesystem::remove(rejected_path + ".idx");
+
+            bool test_exc2 = false;
+            try
+            {
+                motdet::Detection_log_reader not_a_log(path + ".idx");
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc2 = true;
+            }
+            CHECK_TRUE(test_exc2);
+
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".idx");
+
+            return test_res0 && test_res1 && test_res2 && test_res3 && test_res4 && test_res5 && test_exc0 && test_exc1 && test_exc_box && test_exc2;
+        }
+
+        bool test_detection_log_reopen()
+        {
+            std::string path = (std::filesystem::temp_directory_path() / "motdet_test_reopen.log").string();
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".idx");
+
+            // Write the log in three sessions. The second one is left with half a record at the end, as if it crashed.
+
+            {
+                motdet::Detection_log_writer writer(path, 8);
+                for(std::size_t i = 0; i < 300; ++i) writer.append(make_detection_(i));
+            }
+            {
+                motdet::Detection_log_writer writer(path, 8);
+                for(std::size_t i = 300; i < 600; ++i) writer.append(make_detection_(i));
+            }
+            {
+                std::ofstream garbage(path, std::ios::binary | std::ios::app);
+                garbage << "half a record";
+            }
+            {
+                motdet::Detection_log_writer writer(path, 8);
+                for(std::size_t i = 600; i < 1000; ++i) writer.append(make_detection_(i));
+            }
+
+            motdet::Detection_log_reader reader(path);
+
+            std::vector<motdet::Detection> res0 = reader.query(0, -1ULL, false);
+            bool test_res0 = res0.size() == 1000 && equal_range_(res0, 0, 1);
+            CHECK_TRUE(test_res0);
+
+            std::vector<motdet::Detection> res1 = reader.query(5000000000ULL + 40*590, 5000000000ULL + 40*610);
+            bool test_res1 = res1.size() == 3 && equal_range_(res1, 590, 10);
+            CHECK_TRUE(test_res1);
+
+            // Check 3: Without the index, the records are kept and the index is rebuilt. The log starts at timestamp 0, so
+            // the rebuilt timestamps are the original ones.
+
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".idx");
+            {
+                motdet::Detection_log_writer writer(path, 8);
+                for(std::size_t i = 0; i < 300; ++i) writer.append(make_detection_(i));
+            }
+            std::filesystem::remove(path + ".idx");
+            {
+                motdet::Detection_log_writer writer(path, 8);
+                for(std::size_t i = 300; i < 400; ++i) writer.append(make_detection_(i));
+            }
+
+            std::vector<motdet::Detection> res2, res3;
+            {
+                motdet::Detection_log_reader rebuilt_reader(path);
+                res2 = rebuilt_reader.query(0, -1ULL, false);
+                res3 = rebuilt_reader.query(40*250, 40*350);
+            }
+            bool test_rebuilt = res2.size() == 400 && equal_range_(res2, 0, 1) && res3.size() == 11 && equal_range_(res3, 250, 10);
+            CHECK_TRUE(test_rebuilt);
+
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".idx");
+
+            return test_res0 && test_res1 && test_rebuilt;
+        }
+    } // namespace detection_log
+} // namespace test
@@ -0,0 +1,18 @@
+#ifndef __TEST_MOTDET_DETECTION_LOG_HPP__
+#define __TEST_MOTDET_DETECTION_LOG_HPP__
+
+#include "motion_detector.hpp"
+#include "detection_log.hpp"
+
+namespace test
+{
+    namespace detection_log
+    {
+        void test_all();
+
+        bool test_detection_log_query();
+        bool test_detection_log_reopen();
+    } // namespace detection_log
+} // namespace test
+
+#endif // __TEST_MOTDET_DETECTION_LOG_HPP__
@@ -12,11 +12,14 @@ namespace test
          std::cout << "Testing module image_utils..." << std::endl;
 
          log_test_result(test_gaussian_blur_filter(), "gaussian_blur_filter");
+         log_test_result(test_median_filter(), "median_filter");
          log_test_result(test_double_threshold(), "double_threshold");
          log_test_result(test_hysteresis(), "hysteresis");
          log_test_result(test_image_interpolation_and_sub(), "image_interpolation_and_sub");
          log_test_result(test_dilation(), "dilation");
          log_test_result(test_downsample(), "downsample");
+         log_test_result(test_resize(), "resize");
+         log_test_result(test_image_views(), "image views");
 
          std::cout << "Finished tests for module image_utils." << std::endl << std::endl;
       }
@@ -114,6 +117,45 @@ namespace test
          return test_img0 && test_img1 && test_img2;
       }
 
+      bool test_median_filter()
+      {
+         // Check 0: Impulses are removed, edges are kept
+
+         std::vector<unsigned short> data0_in = {
+              0,   0,   0, 900, 900, 900,
+              0, 500,   0, 900, 900, 900,
+              0,   0,   0, 900,   0, 900,
+              0,   0,   0, 900, 900, 900,
+            500, 500,   0, 900, 900, 900
+         };
+
+         std::vector<unsigned short> data0_expected = {
+              0,   0,   0, 900, 900, 900,
+              0,   0,   0, 900, 900, 900,
+              0,   0,   0, 900, 900, 900,
+              0,   0,   0, 900, 900, 900,
+            500,   0, 500, 900, 900, 900
+         };
+
+         motdet::Image<unsigned short> img0_in(data0_in, 6), img0_out(6, 5, 0), img0_expected(data0_expected, 6);
+
+         motdet::imgutil::median_filter(img0_in, img0_out);
+
+         bool test_img0 = test_compare_vectors(img0_out.get_data(), img0_expected.get_data());
+         CHECK_TRUE(test_img0);
+
+         // Check 1: Single pixel, its own median
+
+         motdet::Image<unsigned short> img1_in(1, 1, 7), img1_out(1, 1, 0);
+
+         motdet::imgutil::median_filter(img1_in, img1_out);
+
+         bool test_img1 = img1_out[0] == 7;
+         CHECK_TRUE(test_img1);
+
+         return test_img0 && test_img1;
+      }
+
       bool test_double_threshold()
       {
          std::vector<unsigned short> data0_in = {
@@ -329,7 +371,146 @@ namespace test
          bool test_img0 = test_compare_vectors<unsigned short, unsigned short>(img0_out.get_data(),img0_expected.get_data());
          CHECK_TRUE(test_img0);
 
-         return test_img0;
+         // Check 2: The excess rows at the bottom are the last ones of the image, whatever the excess columns.
+
+         std::vector<unsigned short> data1_in = {
+            0,   3,   6,   9,  12,  15,  18,  21,
+            8,  11,  14,  17,  20,  23,  26,  29,
+           16,  19,  22,  25,  28,  31,  34,  37,
+           24,  27,  30,  33,  36,  39,  42,  45,
+           32,  35,  38,  41,  44,  47,   0,   3,
+           40,  43,  46,  49,   2,   5,   8,  11,
+           88,  41,  44,  47,  50,  53,  56,  59,
+           46,  49,  52,  55,  58,  61,  64,  67
+         };
+
+         std::vector<unsigned short> data1_expected = {
+           11,  20,  27,
+           35,  32,  18,
+           53,  54,  61
+         };
+
+         motdet::Image<unsigned short> img1_in(data1_in, 8), img1_out(3, 3, 0), img1_expected(data1_expected, 3);
+
+         motdet::imgutil::downsample(img1_in, img1_out, 3);
+
+         bool test_img1 = test_compare_vectors<unsigned short, unsigned short>(img1_out.get_data(),img1_expected.get_data());
+         CHECK_TRUE(test_img1);
+
+         return test_img0 && test_img1;
+      }
+
+      bool test_resize()
+      {
+         // Check 1: Upscale
+
+         std::vector<unsigned short> data0_in = {
+              0, 100,
+            200, 300
+         };
+
+         std::vector<unsigned short> data0_expected = {
+              0,  25,  75, 100,
+             50,  75, 125, 150,
+            150, 175, 225, 250,
+            200, 225, 275, 300
+         };
+
+         motdet::Image<unsigned short> img0_in(data0_in, 2), img0_out(4, 4, 0), img0_expected(data0_expected, 4);
+
+         motdet::imgutil::resize(img0_in, img0_out);
+
+         bool test_img0 = test_compare_vectors<unsigned short, unsigned short>(img0_out.get_data(),img0_expected.get_data());
+         CHECK_TRUE(test_img0);
+
+         // Check 2: Same resolution is a copy
+
+         motdet::Image<unsigned short> img1_out(4, 4, 0);
+
+         motdet::imgutil::resize(img0_expected, img1_out);
+
+         bool test_img1 = test_compare_vectors<unsigned short, unsigned short>(img1_out.get_data(),img0_expected.get_data());
+         CHECK_TRUE(test_img1);
+
+         return test_img0 && test_img1;
+      }
+
+      bool test_image_views()
+      {
+         // Check 1: Downsample a region of a bigger image into an image with padded rows
+
+         std::vector<unsigned short> data0_in = {
+            0,   0,   0,   0,   0,   0,   0,   6,
+            0,   0,   0,   0,   0,   0,   0,   0,
+            0,   0,  40,  50,  50,  40,   0,   0,
+            0,  40,  50,  60,  60,  50,  50,   0,
+            0,  50,  60,  70,  70,  60,  50,   0,
+            0,  50,  60,  70,  70,  60,  50,   0,
+            0,  50,  70,  50,  60,  50,   0,   0,
+         };
+
+         std::vector<unsigned short> data0_expected = {
+            4,  15,   1,
+           34,  63,  25,
+           40,  53,   0
+         };
+
+         // Surround the input with a border that must never be read.
+         motdet::Image<unsigned short> img0_big(10, 9, 999);
+         for(std::size_t i = 0; i < 7; ++i)
+         {
+            for(std::size_t j = 0; j < 8; ++j) img0_big.row(i + 1)[j + 1] = data0_in[i*8 + j];
+         }
+         motdet::Image_view<const unsigned short> img0_in = img0_big.view().sub_view(1, 1, 8, 7);
+         motdet::Image<unsigned short> img0_out(3, 3, 0, 5);
+
+         motdet::imgutil::downsample(img0_in, img0_out, 3);
+
+         bool test_img0 = true;
+         for(std::size_t i = 0; i < 3; ++i)
+         {
+            std::vector<unsigned short> out_row(img0_out.row(i), img0_out.row(i) + 3);
+            std::vector<unsigned short> expected_row(data0_expected.begin() + i*3, data0_expected.begin() + (i+1)*3);
+            test_img0 = test_compare_vectors(out_row, expected_row) && test_img0;
+         }
+         bool test_img0_padding = img0_out.get_data()[3] == 0 && img0_out.get_data()[4] == 0;
+         CHECK_TRUE(test_img0);
+         CHECK_TRUE(test_img0_padding);
+
+         // Check 2: Blurring a region in place is the same as blurring a copy of it
+
+         motdet::Image<unsigned short> img1_cropped(8, 7, 0), img1_out_cropped(8, 7, 0), img1_out_view(8, 7, 0);
+
+         motdet::imgutil::crop(img0_big, img1_cropped, 1, 1);
+         motdet::imgutil::gaussian_blur_filter(img1_cropped, img1_out_cropped);
+         motdet::imgutil::gaussian_blur_filter(img0_in, img1_out_view);
+
+         bool test_img1 = test_compare_vectors(img1_out_view.get_data(), img1_out_cropped.get_data());
+         CHECK_TRUE(test_img1);
+
+         // Check 3: Threshold, hysteresis and dilation between images with different strides
+
+         motdet::Image<unsigned char> img2_thr(8, 7, 0), img2_cnt(8, 7, 0), img2_dil(8, 7, 0);
+         motdet::Image<unsigned char> img2_thr_pad(8, 7, 0, 9), img2_cnt_pad(8, 7, 0, 16), img2_dil_pad(8, 7, 0, 11);
+
+         motdet::imgutil::double_threshold(img1_cropped, img2_thr, 30, 55);
+         motdet::imgutil::hysteresis(img2_thr, img2_cnt);
+         motdet::imgutil::dilation(img2_cnt, img2_dil);
+
+         motdet::imgutil::double_threshold(img0_in, img2_thr_pad, 30, 55);
+         motdet::imgutil::hysteresis(img2_thr_pad, img2_cnt_pad);
+         motdet::imgutil::dilation(img2_cnt_pad, img2_dil_pad);
+
+         bool test_img2 = true;
+         for(std::size_t i = 0; i < 7; ++i)
+         {
+            std::vector<unsigned char> out_row(img2_dil_pad.row(i), img2_dil_pad.row(i) + 8);
+            std::vector<unsigned char> expected_row(img2_dil.row(i), img2_dil.row(i) + 8);
+            test_img2 = test_compare_vectors(out_row, expected_row) && test_img2;
+         }
+         CHECK_TRUE(test_img2);
+
+         return test_img0 && test_img0_padding && test_img1 && test_img2;
       }
 
    } // namespace test
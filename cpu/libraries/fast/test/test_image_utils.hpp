@@ -11,11 +11,14 @@ namespace test
         void test_all();
 
         bool test_gaussian_blur_filter();
+        bool test_median_filter();
         bool test_double_threshold();
         bool test_hysteresis();
         bool test_image_interpolation_and_sub();
         bool test_dilation();
         bool test_downsample();
+        bool test_resize();
+        bool test_image_views();
     } // namespace image_utils
 } // namespace test
 
@@ -3,6 +3,8 @@
 #include "test_image_utils.hpp"
 #include "test_motion_detector.hpp"
 #include "test_contour_detector.hpp"
+#include "test_detection_log.hpp"
+#include "test_box_tracker.hpp"
 
 int main()
 {
@@ -11,6 +13,8 @@ int main()
     test::image_utils::test_all();
     test::motion_detector::test_all();
     test::contour_detector::test_all();
+    test::detection_log::test_all();
+    test::box_tracker::test_all();
 
     std::cout << "Finished all module tests." << std::endl;
 
@@ -2,6 +2,12 @@
 #include "test_utils.hpp"
 
 #include <iostream>
+#include <cmath>
+#include <filesystem>
+#include <cstdint>
+#include <algorithm>
+#include <csignal>
+#include <sys/resource.h> // setrlimit
 
 namespace test
 {
@@ -15,13 +21,24 @@ namespace test
             log_test_result(test_image_assignment(), "Image operator=");
             log_test_result(test_image_indexing(), "Image operator[]");
             log_test_result(test_image_getset(), "Image getter and setter");
+            log_test_result(test_image_storage(), "Image storage");
+            log_test_result(test_image_view(), "Image_view");
 
             log_test_result(test_motion_detector_constructor(), "Motion_detector constructor");
             log_test_result(test_motion_detector_getset(), "Motion_detector getter and setter");
             log_test_result(test_motion_detector_detect_motion(), "Motion_detector detect_motion");
+            log_test_result(test_motion_detector_refine(), "Motion_detector refine");
+            log_test_result(test_motion_detector_idle_decimation(), "Motion_detector idle decimation");
+            log_test_result(test_motion_detector_checkpoint(), "Motion_detector checkpoint");
+            log_test_result(test_motion_detector_config(), "Motion_detector config");
+            log_test_result(test_motion_detector_denoise(), "Motion_detector denoise");
+            log_test_result(test_motion_detector_contour_callback(), "Motion_detector contour callback");
+            log_test_result(test_motion_detector_contour_merge(), "Motion_detector contour merge");
+            log_test_result(test_motion_detector_stage_pipeline(), "Motion_detector stage pipeline");
 
             log_test_result(test_rgb_to_bw(), "RGB to BW");
             log_test_result(test_uchar_to_bw(), "uchar to BW");
+            log_test_result(test_luma_to_bw(), "luma to BW");
 
             std::cout << "Finished tests for module motion_detector." << std::endl << std::endl;
         }
@@ -270,21 +287,31 @@ namespace test
             bool test_img0_height = img0.get_height() == 2;
             CHECK_TRUE(test_img0_height);
 
-            bool test_img0_get_data = img0.get_data() == data0_in_0;
+            bool test_img0_get_data = test_compare_vectors(img0.get_data(), data0_in_0);
             CHECK_TRUE(test_img0_get_data);
 
             img0.set_data(data0_in_1, 9);
-            bool test_img0_set_data = img0.get_data() == data0_in_1;
+            bool test_img0_set_data = test_compare_vectors(img0.get_data(), data0_in_1);
             CHECK_TRUE(test_img0_set_data);
 
             std::vector<unsigned char> data0_in_0_copy = data0_in_0;
             img0.set_data(std::move(data0_in_0), 10);
-            bool test_img0_set_data_move = img0.get_data() == data0_in_0_copy;
+            bool test_img0_set_data_move = test_compare_vectors(img0.get_data(), data0_in_0_copy);
             CHECK_TRUE(test_img0_set_data_move);
             bool test_img0_set_data_move_successful = data0_in_0.size() == 0;
             CHECK_TRUE(test_img0_set_data_move_successful);
 
-            bool test_img0 = test_img0_size && test_img0_width && test_img0_height && test_img0_get_data && test_img0_set_data && test_img0_set_data_move && test_img0_set_data_move_successful;
+            // A buffer of the image allocator is adopted as is, without copying the pixels.
+            motdet::Image<unsigned char>::Buffer buffer0 = motdet::Image<unsigned char>::make_buffer(9, 2);
+            std::copy(data0_in_1.begin(), data0_in_1.end(), buffer0.begin());
+            const unsigned char *buffer0_pixels = buffer0.data();
+            img0.set_data(std::move(buffer0), 9);
+            bool test_img0_set_data_buffer = img0.data() == buffer0_pixels && buffer0.empty() && img0.get_width() == 9 && img0.get_height() == 2 &&
+                                             test_compare_vectors(img0.get_data(), data0_in_1) && reinterpret_cast<std::uintptr_t>(buffer0_pixels) % 64 == 0;
+            CHECK_TRUE(test_img0_set_data_buffer);
+
+            bool test_img0 = test_img0_size && test_img0_width && test_img0_height && test_img0_get_data && test_img0_set_data && test_img0_set_data_move && test_img0_set_data_move_successful &&
+                             test_img0_set_data_buffer;
 
             // Test exceptions
 
@@ -314,12 +341,141 @@ namespace test
 
             bool test_exc1 = test_exc1_throw && test_exc1_move;
 
-            bool test_exc = test_exc0 && test_exc1;
+            bool test_exc2_throw = false;
+            motdet::Image<unsigned char>::Buffer buffer1 = motdet::Image<unsigned char>::make_buffer(9, 2);
+            try
+            {
+                img0.set_data(std::move(buffer1), 8);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc2_throw = true;
+            }
+            CHECK_TRUE(test_exc2_throw);
+            bool test_exc2_move = buffer1.size() == 18 && img0.get_width() == 9;
+            CHECK_TRUE(test_exc2_move);
+
+            bool test_exc2 = test_exc2_throw && test_exc2_move;
+
+            bool test_exc = test_exc0 && test_exc1 && test_exc2;
 
             return test_img0 && test_exc;
         }
 
 
+        bool test_image_storage()
+        {
+            // Buffers are aligned for SIMD loads, and big ones to huge pages.
+            motdet::Image<unsigned short> img0(13, 7, 0);
+            bool test_img0_align = reinterpret_cast<std::uintptr_t>(img0.data()) % 64 == 0;
+            CHECK_TRUE(test_img0_align);
+
+            motdet::Image<unsigned char> img1(2048, 1024, motdet::uninitialized);
+            bool test_img1_align = reinterpret_cast<std::uintptr_t>(img1.data()) % motdet::Aligned_allocator<unsigned char>::huge_page_size == 0;
+            CHECK_TRUE(test_img1_align);
+            bool test_img1_size = img1.get_total() == 2048*1024 && img1.get_stride() == 2048;
+            CHECK_TRUE(test_img1_size);
+            bool test_img1 = test_img1_align && test_img1_size;
+
+            // Padded rows.
+            motdet::Image<unsigned short> img2(5, 3, 7, 8);
+            bool test_img2_dims = img2.get_width() == 5 && img2.get_height() == 3 && img2.get_total() == 15 && img2.get_stride() == 8;
+            CHECK_TRUE(test_img2_dims);
+            img2.row(2)[4] = 1;
+            bool test_img2_row = img2.row(1) == img2.data() + 8 && img2.get_data()[2*8 + 4] == 1 && img2.get_data().size() == 24;
+            CHECK_TRUE(test_img2_row);
+
+            // Setting new data removes the padding.
+            img2.set_data(std::vector<unsigned short>(6, 2), 3);
+            bool test_img2_set = img2.get_stride() == 3 && img2.get_data().size() == 6 && img2.row(1)[0] == 2;
+            CHECK_TRUE(test_img2_set);
+            bool test_img2 = test_img2_dims && test_img2_row && test_img2_set;
+
+            bool test_exc0 = false;
+            try
+            {
+                motdet::Image<unsigned short> img_exc(5, 3, 0, 4);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc0 = true;
+            }
+            CHECK_TRUE(test_exc0);
+
+            bool test_exc1 = false;
+            try
+            {
+                motdet::Image<unsigned short> img_exc(0, 3, motdet::uninitialized);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc1 = true;
+            }
+            CHECK_TRUE(test_exc1);
+
+            bool test_exc = test_exc0 && test_exc1;
+
+            return test_img0_align && test_img1 && test_img2 && test_exc;
+        }
+
+        bool test_image_view()
+        {
+            // View of an external buffer with padded rows.
+            std::vector<unsigned short> data0 = {
+                1,   2,   3,   0,
+                4,   5,   6,   0,
+                7,   8,   9,   0
+            };
+            motdet::Image_view<unsigned short> view0(data0.data(), 3, 3, 4);
+
+            bool test_view0_dims = view0.get_width() == 3 && view0.get_height() == 3 && view0.get_total() == 9 && view0.get_stride() == 4;
+            CHECK_TRUE(test_view0_dims);
+            bool test_view0_access = view0.row(2)[1] == 8 && view0[1*4 + 2] == 6;
+            CHECK_TRUE(test_view0_access);
+            bool test_view0 = test_view0_dims && test_view0_access;
+
+            // Regions share the pixels and the stride.
+            motdet::Image_view<unsigned short> view1 = view0.sub_view(1, 1, 2, 2);
+            view1.row(1)[1] = 90;
+            bool test_view1 = view1.get_width() == 2 && view1.get_stride() == 4 && view1[0] == 5 && data0[2*4 + 2] == 90;
+            CHECK_TRUE(test_view1);
+
+            // Images convert implicitly, to read-only views when const.
+            motdet::Image<unsigned short> img2(4, 2, 3, 6);
+            motdet::Image_view<unsigned short> view2 = img2;
+            const motdet::Image<unsigned short> &img2_const = img2;
+            motdet::Image_view<const unsigned short> view2_const = img2_const;
+            motdet::Image_view<const unsigned short> view2_from_view = view2;
+            bool test_view2 = view2.data() == img2.data() && view2.get_stride() == 6 && view2_const.row(1) == img2.row(1) && view2_from_view.row(1)[3] == 3;
+            CHECK_TRUE(test_view2);
+
+            bool test_exc0 = false;
+            try
+            {
+                motdet::Image_view<unsigned short> view_exc(data0.data(), 3, 3, 2);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc0 = true;
+            }
+            CHECK_TRUE(test_exc0);
+
+            bool test_exc1 = false;
+            try
+            {
+                view0.sub_view(2, 1, 2, 2);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc1 = true;
+            }
+            CHECK_TRUE(test_exc1);
+
+            bool test_exc = test_exc0 && test_exc1;
+
+            return test_view0 && test_view1 && test_view2 && test_exc;
+        }
+
         bool test_motion_detector_constructor()
         {
             motdet::Motion_detector motdet0(10, 15);
@@ -602,6 +758,594 @@ namespace test
             return test_motdet0_detection && test_exc;
         }
 
+        bool test_motion_detector_refine()
+        {
+            // A small square appears in a flat background. The coarse level only sees it as a blob of a few pixels,
+            // but the refined contour must be close to the real position of the square.
+            motdet::Motion_detector motdet0(64, 64, 1, 2, 4);
+            motdet0.set_refine_factor(1);
+
+            bool test_motdet0_refine_factor = motdet0.get_refine_factor() == 1;
+            CHECK_TRUE(test_motdet0_refine_factor);
+
+            auto img0_in0 = std::make_unique<motdet::Image<unsigned short>>(64, 64, 13000);
+            auto img0_in1 = std::make_unique<motdet::Image<unsigned short>>(64, 64, 13000);
+            for(std::size_t i = 26; i < 37; ++i)
+                for(std::size_t j = 21; j < 32; ++j) (*img0_in1)[i*64 + j] = 63000;
+
+            motdet0.enqueue_frame(std::move(img0_in0), 0, true);
+            motdet0.enqueue_frame(std::move(img0_in1), 1, true);
+
+            motdet::Detection cnt0_out0 = motdet0.get_detection(true);
+            bool test_motdet0_detection0 = !cnt0_out0.has_detections;
+            CHECK_TRUE(test_motdet0_detection0);
+
+            motdet::Detection cnt0_out1 = motdet0.get_detection(true);
+            bool test_motdet0_detection1 = cnt0_out1.detection_contours.size() == 1;
+            CHECK_TRUE(test_motdet0_detection1);
+
+            bool test_motdet0_precision = false;
+            if(test_motdet0_detection1)
+            {
+                const motdet::Contour &cont = cnt0_out1.detection_contours[0];
+                test_motdet0_precision =
+                    cont.bb_tl_x >= 16 && cont.bb_tl_x <= 21 && cont.bb_br_x >= 31 && cont.bb_br_x <= 36 &&
+                    cont.bb_tl_y >= 21 && cont.bb_tl_y <= 26 && cont.bb_br_y >= 36 && cont.bb_br_y <= 41;
+            }
+            CHECK_TRUE(test_motdet0_precision);
+
+            bool test_motdet0 = test_motdet0_refine_factor && test_motdet0_detection0 && test_motdet0_detection1 && test_motdet0_precision;
+
+            // Check exceptions
+
+            bool test_exc0 = false;
+            try
+            {
+                motdet::Motion_detector motdetexc(64, 64, 1, 2, 4);
+                motdetexc.set_refine_factor(3);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc0 = true;
+            }
+            CHECK_TRUE(test_exc0);
+
+            bool test_exc1 = false;
+            try
+            {
+                motdet::Motion_detector motdetexc(64, 64, 1, 2, 4);
+                motdetexc.set_refine_factor(4);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc1 = true;
+            }
+            CHECK_TRUE(test_exc1);
+
+            bool test_exc2 = false;
+            try
+            {
+                motdet::Motion_detector motdetexc(64, 64, 1, 2, 4);
+                motdetexc.enqueue_frame(std::make_unique<motdet::Image<unsigned short>>(64, 64, 0), 0, true);
+                motdetexc.get_detection(true);
+                motdetexc.set_refine_factor(2);
+            }
+            catch(const std::runtime_error &e)
+            {
+                test_exc2 = true;
+            }
+            CHECK_TRUE(test_exc2);
+
+            bool test_exc = test_exc0 && test_exc1 && test_exc2;
+
+            return test_motdet0 && test_exc;
+        }
+
+        bool test_motion_detector_idle_decimation()
+        {
+            // After 2 idle frames, only 1 in 3 frames is processed. Frames are sent one by one so that the result is deterministic.
+            motdet::Motion_detector motdet0(15, 15, 1, 2);
+            motdet0.set_idle_decimation(2, 3);
+
+            std::vector<bool> expected_skipped = { false, false, true, true, false, true, true, false, true, true, false, false };
+            std::vector<bool> skipped;
+            bool motion_detected = false;
+
+            for(std::size_t i = 0; i < expected_skipped.size(); ++i)
+            {
+                // Movement starts at frame 8, which will be skipped until frame 10 is processed.
+                auto img = std::make_unique<motdet::Image<unsigned short>>(15, 15, 13000);
+                if(i >= 8) for(std::size_t k = 4; k < 11; ++k) for(std::size_t l = 4; l < 11; ++l) (*img)[k*15 + l] = 63000;
+
+                motdet0.enqueue_frame(std::move(img), i, true);
+                motdet::Detection det = motdet0.get_detection(true);
+
+                skipped.push_back(det.skipped);
+                if(i == 10) motion_detected = det.has_detections;
+            }
+
+            bool test_motdet0_skipped = skipped == expected_skipped;
+            CHECK_TRUE(test_motdet0_skipped);
+            bool test_motdet0_motion = motion_detected;
+            CHECK_TRUE(test_motdet0_motion);
+            bool test_motdet0_rate = std::abs(motdet0.get_processing_rate() - 6.0/12.0) < 0.001;
+            CHECK_TRUE(test_motdet0_rate);
+
+            bool test_motdet0 = test_motdet0_skipped && test_motdet0_motion && test_motdet0_rate;
+
+            // Check exceptions
+
+            bool test_exc0 = false;
+            try
+            {
+                motdet::Motion_detector motdetexc(15, 15, 1, 2);
+                motdetexc.set_idle_decimation(2, 0);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc0 = true;
+            }
+            CHECK_TRUE(test_exc0);
+
+            return test_motdet0 && test_exc0;
+        }
+
+        bool test_motion_detector_checkpoint()
+        {
+            std::string path = (std::filesystem::temp_directory_path() / "motdet_test_reference.ckpt").string();
+            std::filesystem::remove(path);
+
+            // Build a reference of an empty scene and save it.
+            {
+                motdet::Motion_detector motdet0(64, 64, 1, 2, 4);
+                for(unsigned long long t = 0; t < 3; ++t)
+                {
+                    motdet0.enqueue_frame(std::make_unique<motdet::Image<unsigned short>>(64, 64, 13000), t, true);
+                    motdet0.get_detection(true);
+                }
+                motdet0.save_reference(path);
+            }
+
+            // The first frame already has someone in it. A cold detector takes it as the reference, a warm one detects it.
+            auto make_frame = []()
+            {
+                auto img = std::make_unique<motdet::Image<unsigned short>>(64, 64, 13000);
+                for(std::size_t i = 26; i < 37; ++i)
+                    for(std::size_t j = 21; j < 32; ++j) (*img)[i*64 + j] = 63000;
+                return img;
+            };
+
+            motdet::Motion_detector motdet_cold(64, 64, 1, 2, 4);
+            motdet_cold.enqueue_frame(make_frame(), 0, true);
+            bool test_cold = !motdet_cold.get_detection(true).has_detections;
+            CHECK_TRUE(test_cold);
+
+            motdet::Motion_detector motdet_warm(64, 64, 1, 2, 4, 0.0067, path);
+            motdet_warm.enqueue_frame(make_frame(), 0, true);
+            bool test_warm = motdet_warm.get_detection(true).detection_contours.size() == 1;
+            CHECK_TRUE(test_warm);
+
+            // Same when loading explicitly, with refinement enabled on both sides.
+            {
+                motdet::Motion_detector motdet1(64, 64, 1, 2, 4);
+                motdet1.set_refine_factor(2);
+                motdet1.enqueue_frame(std::make_unique<motdet::Image<unsigned short>>(64, 64, 13000), 0, true);
+                motdet1.get_detection(true);
+                motdet1.save_reference(path);
+            }
+            motdet::Motion_detector motdet_refine(64, 64, 1, 2, 4);
+            motdet_refine.set_refine_factor(2);
+            motdet_refine.load_reference(path);
+            motdet_refine.enqueue_frame(make_frame(), 0, true);
+            std::vector<motdet::Contour> refined_conts = motdet_refine.get_detection(true).detection_contours;
+            bool test_refine = refined_conts.size() == 1;
+            CHECK_TRUE(test_refine);
+
+            // The checkpoint of the constructor waits for the first frame, so refinement and the contour callback can still
+            // be set, and its refined reference gives the same boxes as loading it explicitly.
+            motdet::Motion_detector motdet_refine_warm(64, 64, 1, 2, 4, 0.0067, path);
+            std::size_t streamed = 0;
+            motdet_refine_warm.set_refine_factor(2);
+            motdet_refine_warm.set_contour_callback([&streamed](unsigned long long, const motdet::Contour &){ ++streamed; });
+            motdet_refine_warm.enqueue_frame(make_frame(), 0, true);
+            std::vector<motdet::Contour> warm_conts = motdet_refine_warm.get_detection(true).detection_contours;
+            bool test_refine_warm = warm_conts.size() == 1 && streamed == 1 &&
+                                    warm_conts[0].bb_tl_x == refined_conts[0].bb_tl_x && warm_conts[0].bb_tl_y == refined_conts[0].bb_tl_y &&
+                                    warm_conts[0].bb_br_x == refined_conts[0].bb_br_x && warm_conts[0].bb_br_y == refined_conts[0].bb_br_y;
+            CHECK_TRUE(test_refine_warm);
+
+            // A checkpoint saved with another downsample factor is resampled.
+            motdet_warm.save_reference(path);
+            motdet::Motion_detector motdet_resampled(64, 64, 1, 2, 2, 0.0067, path);
+            motdet_resampled.enqueue_frame(make_frame(), 0, true);
+            bool test_resampled = motdet_resampled.get_detection(true).detection_contours.size() == 1;
+            CHECK_TRUE(test_resampled);
+
+            // A missing checkpoint is a cold start.
+            std::filesystem::remove(path);
+            motdet::Motion_detector motdet_missing(64, 64, 1, 2, 4, 0.0067, path);
+            motdet_missing.enqueue_frame(make_frame(), 0, true);
+            bool test_missing = !motdet_missing.get_detection(true).has_detections;
+            CHECK_TRUE(test_missing);
+
+            // Check exceptions
+
+            bool test_exc0 = false;
+            try
+            {
+                motdet::Motion_detector motdetexc(64, 64, 1, 2, 4);
+                motdetexc.save_reference(path);
+            }
+            catch(const std::runtime_error &e)
+            {
+                test_exc0 = true;
+            }
+            CHECK_TRUE(test_exc0);
+
+            motdet_warm.save_reference(path);
+
+            bool test_exc1 = false;
+            try
+            {
+                motdet::Motion_detector motdetexc(80, 64, 1, 2, 4);
+                motdetexc.load_reference(path);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc1 = true;
+            }
+            CHECK_TRUE(test_exc1);
+
+            bool test_exc2 = false;
+            try
+            {
+                motdet::Motion_detector motdetexc(64, 64, 1, 2, 4);
+                motdetexc.set_refine_factor(2);
+                motdetexc.load_reference(path);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc2 = true;
+            }
+            CHECK_TRUE(test_exc2);
+
+            bool test_exc3 = false;
+            try
+            {
+                motdet::Motion_detector motdetexc(64, 64, 1, 2, 4, 0.0067, path);
+                motdetexc.set_refine_factor(2);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc3 = true;
+            }
+            CHECK_TRUE(test_exc3);
+
+            // A save that only fails when the stream is closed, as on a full disk, keeps the previous checkpoint. The
+            // checkpoint fits in the buffer of the stream, so nothing is written before the close.
+            bool test_exc4 = false;
+            {
+                struct rlimit old_limit, small_limit;
+                getrlimit(RLIMIT_FSIZE, &old_limit);
+                small_limit = old_limit;
+                small_limit.rlim_cur = 100;
+                auto old_handler = std::signal(SIGXFSZ, SIG_IGN);
+                setrlimit(RLIMIT_FSIZE, &small_limit);
+                try
+                {
+                    motdet_refine.save_reference(path);
+                }
+                catch(const std::runtime_error &e)
+                {
+                    test_exc4 = true;
+                }
+                setrlimit(RLIMIT_FSIZE, &old_limit);
+                std::signal(SIGXFSZ, old_handler);
+            }
+            try
+            {
+                motdet::Motion_detector motdet_kept(64, 64, 1, 2, 4);
+                motdet_kept.load_reference(path);
+            }
+            catch(const std::invalid_argument &e)
+            {
+                test_exc4 = false;
+            }
+            test_exc4 = test_exc4 && !std::filesystem::exists(path + ".tmp");
+            CHECK_TRUE(test_exc4);
+
+            std::filesystem::remove(path);
+
+            return test_cold && test_warm && test_refine && test_refine_warm && test_resampled && test_missing && test_exc0 && test_exc1 && test_exc2 && test_exc3 && test_exc4;
+        }
+
+        bool test_motion_detector_config()
+        {
+            auto make_frame = [](bool square)
+            {
+                auto img = std::make_unique<motdet::Image<unsigned short>>(64, 64, 13000);
+                if(square)
+                    for(std::size_t i = 26; i < 37; ++i)
+                        for(std::size_t j = 21; j < 32; ++j) (*img)[i*64 + j] = 63000;
+                return img;
+            };
+
+            motdet::Motion_detector motdet0(64, 64, 1, 2, 4);
+
+            motdet::Detector_config config0 = motdet0.get_config();
+            bool test_motdet0_defaults = config0.downsample_factor == 4 && config0.low_threshold == 5000 && config0.high_threshold == 22500 &&
+                                         config0.min_contour_area == 13 && std::abs(config0.frame_update_ratio - 0.0067) < 1e-6 &&
+                                         motdet0.get_config_epoch() == 0;
+            CHECK_TRUE(test_motdet0_defaults);
+
+            // Check 1: Thresholds apply to the frames enqueued after the swap, not to the ones already enqueued.
+
+            motdet::Detector_config config1 = config0;
+            config1.low_threshold = config1.high_threshold = 65535;
+
+            motdet0.enqueue_frame(make_frame(false), 0, true);
+            motdet0.enqueue_frame(make_frame(true), 1, true);
+            bool test_motdet0_epoch = motdet0.set_config(config1) == 1 && motdet0.get_config_epoch() == 1;
+            CHECK_TRUE(test_motdet0_epoch);
+            motdet0.enqueue_frame(make_frame(true), 2, true);
+
+            motdet0.get_detection(true);
+            bool test_motdet0_old = motdet0.get_detection(true).has_detections;
+            bool test_motdet0_new = !motdet0.get_detection(true).has_detections;
+            CHECK_TRUE(test_motdet0_old);
+            CHECK_TRUE(test_motdet0_new);
+
+            // Check 2: Changing the downsample factor keeps the reference, resampled.
+
+            motdet::Detector_config config2 = config0;
+            config2.downsample_factor = 2;
+            motdet0.set_config(config2);
+
+            motdet0.enqueue_frame(make_frame(false), 3, true);
+            bool test_motdet0_resampled_static = !motdet0.get_detection(true).has_detections;
+            CHECK_TRUE(test_motdet0_resampled_static);
+
+            motdet0.enqueue_frame(make_frame(true), 4, true);
+            motdet::Detection det0 = motdet0.get_detection(true);
+            bool test_motdet0_resampled_motion = det0.detection_contours.size() == 1;
+            CHECK_TRUE(test_motdet0_resampled_motion);
+            if(test_motdet0_resampled_motion)
+            {
+                const motdet::Contour &cont = det0.detection_contours[0];
+                test_motdet0_resampled_motion = cont.bb_tl_x <= 21 && cont.bb_br_x >= 31 && cont.bb_tl_y <= 26 && cont.bb_br_y >= 36 &&
+                                                cont.bb_tl_x >= 12 && cont.bb_br_x <= 40 && cont.bb_tl_y >= 17 && cont.bb_br_y <= 45;
+            }
+            CHECK_TRUE(test_motdet0_resampled_motion);
+
+            bool test_motdet0 = test_motdet0_defaults && test_motdet0_epoch && test_motdet0_old && test_motdet0_new &&
+                                test_motdet0_resampled_static && test_motdet0_resampled_motion;
+
+            // Check exceptions
+
+            motdet::Detector_config config_exc0 = config0, config_exc1 = config0, config_exc2 = config0, config_exc3 = config0, config_exc4 = config0;
+            config_exc0.downsample_factor = 0;
+            config_exc1.low_threshold = 30000;
+            config_exc2.frame_update_ratio = 0;
+            config_exc3.downsample_factor = 3;
+            config_exc4.merge_iou = 1;
+
+            bool test_exc = true;
+            for(const motdet::Detector_config &config_exc : {config_exc0, config_exc1, config_exc2, config_exc3, config_exc4})
+            {
+                bool thrown = false;
+                try
+                {
+                    motdet::Motion_detector motdetexc(64, 64, 1, 2, 4);
+                    motdetexc.set_refine_factor(2);
+                    motdetexc.set_config(config_exc);
+                }
+                catch(const std::invalid_argument &e)
+                {
+                    thrown = true;
+                }
+                CHECK_TRUE(thrown);
+                test_exc = test_exc && thrown;
+            }
+
+            return test_motdet0 && test_exc;
+        }
+
+        bool test_motion_detector_denoise()
+        {
+            // 2x2 impulses survive the blur as strong differences, but not the median filter. The square survives both.
+            auto make_frame = [](bool noise, bool square)
+            {
+                auto img = std::make_unique<motdet::Image<unsigned short>>(64, 64, 0);
+                if(noise)
+                    for(std::size_t k = 0; k < 6; ++k)
+                        for(std::size_t i = 0; i < 2; ++i)
+                            for(std::size_t j = 0; j < 2; ++j) (*img)[(5 + k*9 + i)*64 + 4 + k*10 + j] = 65535;
+                if(square)
+                    for(std::size_t i = 40; i < 51; ++i)
+                        for(std::size_t j = 10; j < 21; ++j) (*img)[i*64 + j] = 65535;
+                return img;
+            };
+
+            bool test_motdet = true;
+            for(bool denoise : {false, true})
+            {
+                motdet::Motion_detector motdet0(64, 64, 1, 3, 1);
+                motdet::Detector_config config0 = motdet0.get_config();
+                config0.denoise = denoise;
+                motdet0.set_config(config0);
+
+                motdet0.enqueue_frame(make_frame(false, false), 0, true);
+                motdet0.enqueue_frame(make_frame(true, false), 1, true);
+                motdet0.enqueue_frame(make_frame(true, true), 2, true);
+
+                motdet0.get_detection(true);
+                bool test_noise = motdet0.get_detection(true).has_detections != denoise;
+                CHECK_TRUE(test_noise);
+
+                motdet::Detection det0 = motdet0.get_detection(true);
+                bool test_square = det0.has_detections;
+                if(denoise) test_square = test_square && det0.detection_contours.size() == 1 && det0.detection_contours[0].bb_tl_y >= 30;
+                CHECK_TRUE(test_square);
+
+                test_motdet = test_motdet && test_noise && test_square;
+            }
+
+            return test_motdet;
+        }
+
+        bool test_motion_detector_contour_callback()
+        {
+            // Two objects, the top one is reported while the bottom one is still being labelled.
+            motdet::Motion_detector motdet0(64, 64, 1, 3, 1);
+
+            std::vector<std::pair<unsigned long long, motdet::Contour>> reported;
+            motdet0.set_contour_callback([&reported](unsigned long long timestamp, const motdet::Contour &cont){ reported.push_back({timestamp, cont}); });
+
+            auto img0 = std::make_unique<motdet::Image<unsigned short>>(64, 64, 0);
+            auto img1 = std::make_unique<motdet::Image<unsigned short>>(64, 64, 0);
+            for(std::size_t i = 10; i < 20; ++i)
+                for(std::size_t j = 30; j < 40; ++j) (*img1)[i*64 + j] = 65535;
+            for(std::size_t i = 40; i < 55; ++i)
+                for(std::size_t j = 5; j < 20; ++j) (*img1)[i*64 + j] = 65535;
+
+            motdet0.enqueue_frame(std::move(img0), 0, true);
+            motdet0.enqueue_frame(std::move(img1), 1, true);
+            motdet0.get_detection(true);
+            motdet::Detection det0 = motdet0.get_detection(true);
+
+            bool test_reported = det0.has_detections && reported.size() == 2 && det0.detection_contours.size() == 2;
+            CHECK_TRUE(test_reported);
+
+            if(test_reported)
+            {
+                for(std::size_t k = 0; k < 2; ++k)
+                {
+                    const motdet::Contour &cont = reported[k].second, &expected = det0.detection_contours[k];
+                    test_reported = test_reported && reported[k].first == 1 && cont.bb_tl_x == expected.bb_tl_x && cont.bb_tl_y == expected.bb_tl_y &&
+                                    cont.bb_br_x == expected.bb_br_x && cont.bb_br_y == expected.bb_br_y;
+                }
+                test_reported = test_reported && reported[0].second.bb_br_y < 30 && reported[1].second.bb_tl_y > 30;
+                CHECK_TRUE(test_reported);
+            }
+
+            // Check exceptions
+
+            bool test_exc0 = false;
+            try
+            {
+                motdet0.set_contour_callback({});
+            }
+            catch(const std::runtime_error &e)
+            {
+                test_exc0 = true;
+            }
+            CHECK_TRUE(test_exc0);
+
+            return test_reported && test_exc0;
+        }
+
+        bool test_motion_detector_contour_merge()
+        {
+            // Two halves of an object split by a thin vertical gap, and a separate object further down.
+            auto make_frame = [](bool objects)
+            {
+                auto img = std::make_unique<motdet::Image<unsigned short>>(64, 64, 0);
+                if(objects)
+                {
+                    for(std::size_t i = 10; i < 25; ++i)
+                        for(std::size_t j = 10; j < 40; ++j) if(j < 22 || j > 27) (*img)[i*64 + j] = 65535;
+                    for(std::size_t i = 45; i < 55; ++i)
+                        for(std::size_t j = 10; j < 20; ++j) (*img)[i*64 + j] = 65535;
+                }
+                return img;
+            };
+
+            bool test_merge = true;
+            for(motdet::Contour_merge merge : {motdet::Contour_merge::none, motdet::Contour_merge::gap})
+            {
+                motdet::Motion_detector motdet0(64, 64, 1, 2, 1);
+                motdet::Detector_config config0 = motdet0.get_config();
+                config0.contour_merge = merge;
+                config0.merge_gap = 6;
+                motdet0.set_config(config0);
+
+                motdet0.enqueue_frame(make_frame(false), 0, true);
+                motdet0.enqueue_frame(make_frame(true), 1, true);
+                motdet0.get_detection(true);
+                motdet::Detection det0 = motdet0.get_detection(true);
+
+                bool test_conts = det0.detection_contours.size() == (merge == motdet::Contour_merge::none ? 3 : 2);
+                CHECK_TRUE(test_conts);
+                if(test_conts && merge == motdet::Contour_merge::gap)
+                {
+                    const motdet::Contour &cont = det0.detection_contours[0];
+                    test_conts = cont.bb_tl_x <= 10 && cont.bb_br_x >= 39 && cont.bb_br_y < 45;
+                    CHECK_TRUE(test_conts);
+                }
+
+                test_merge = test_merge && test_conts;
+            }
+
+            return test_merge;
+        }
+
+        bool test_motion_detector_stage_pipeline()
+        {
+            // A square moving over a gradient, so every frame has something to detect and the reference keeps changing.
+            auto make_frame = [](std::size_t f)
+            {
+                auto img = std::make_unique<motdet::Image<unsigned short>>(64, 64, 0);
+                for(std::size_t i = 0; i < 64; ++i)
+                    for(std::size_t j = 0; j < 64; ++j) (*img)[i*64 + j] = i*512 + j*256;
+                for(std::size_t i = 20; i < 32; ++i)
+                    for(std::size_t j = 4 + f*3; j < 16 + f*3; ++j) (*img)[i*64 + j] = 65535;
+                return img;
+            };
+
+            auto run = [&](motdet::Motion_detector &motdet0)
+            {
+                std::vector<motdet::Detection> dets;
+                for(std::size_t f = 0; f < 12; ++f) motdet0.enqueue_frame(make_frame(f), f, true);
+                for(std::size_t f = 0; f < 12; ++f) dets.push_back(motdet0.get_detection(true));
+                return dets;
+            };
+
+            motdet::Motion_detector motdet0(64, 64, 1, 4, 1, 0.2), motdet1(64, 64, 1, 4, 1, 0.2);
+            motdet1.set_executor(motdet::Executor::stage_pipeline, true);
+            bool test_executor = motdet0.get_executor() == motdet::Executor::frame_parallel && motdet1.get_executor() == motdet::Executor::stage_pipeline;
+            CHECK_TRUE(test_executor);
+
+            std::vector<motdet::Detection> dets0 = run(motdet0), dets1 = run(motdet1);
+            bool test_same = dets0.size() == dets1.size();
+            for(std::size_t f = 0; test_same && f < dets0.size(); ++f)
+            {
+                const auto &conts0 = dets0[f].detection_contours, &conts1 = dets1[f].detection_contours;
+                test_same = dets0[f].timestamp == dets1[f].timestamp && dets0[f].has_detections == dets1[f].has_detections && conts0.size() == conts1.size();
+                for(std::size_t c = 0; test_same && c < conts0.size(); ++c)
+                {
+                    test_same = conts0[c].bb_tl_x == conts1[c].bb_tl_x && conts0[c].bb_tl_y == conts1[c].bb_tl_y &&
+                                conts0[c].bb_br_x == conts1[c].bb_br_x && conts0[c].bb_br_y == conts1[c].bb_br_y;
+                }
+            }
+            test_same = test_same && dets1.back().has_detections;
+            CHECK_TRUE(test_same);
+
+            // The executor cannot change while frames are in flight, and can change back once they are out.
+            bool test_busy = false;
+            motdet1.enqueue_frame(make_frame(12), 12, true);
+            try { motdet1.set_executor(motdet::Executor::frame_parallel); }
+            catch(const std::runtime_error &e) { test_busy = true; }
+            CHECK_TRUE(test_busy);
+
+            motdet1.get_detection(true);
+            motdet1.set_executor(motdet::Executor::frame_parallel);
+            motdet1.enqueue_frame(make_frame(13), 13, true);
+            bool test_back = motdet1.get_executor() == motdet::Executor::frame_parallel && motdet1.get_detection(true).timestamp == 13;
+            CHECK_TRUE(test_back);
+
+            return test_executor && test_same && test_busy && test_back;
+        }
+
         bool test_rgb_to_bw()
         {
             std::vector<motdet::rgb_pixel> data0_in = {
@@ -676,5 +1420,29 @@ namespace test
             return test_img0;
         }
 
+        bool test_luma_to_bw()
+        {
+            std::unique_ptr<unsigned char[]> data0_in(new unsigned char[9]{
+               0, 255,  16,
+             235, 128,   1,
+              64,   0, 200
+            });
+
+            std::vector<unsigned short> data0_expected = {
+                 0, 65025,  4080,
+             59925, 32640,   255,
+             16320,     0, 51000
+            };
+
+            motdet::Image<unsigned short> img0_out(3, 3, 0), img0_expected(data0_expected, 3);
+
+            motdet::luma_to_bw(data0_in.get(), 9, img0_out);
+
+            bool test_img0 = test_compare_vectors<unsigned short, unsigned short>(img0_out.get_data(),img0_expected.get_data());
+            CHECK_TRUE(test_img0);
+
+            return test_img0;
+        }
+
     } // namespace image_utils
 } // namespace test
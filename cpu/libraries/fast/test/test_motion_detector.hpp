@@ -13,13 +13,24 @@ namespace test
         bool test_image_assignment();
         bool test_image_indexing();
         bool test_image_getset();
+        bool test_image_storage();
+        bool test_image_view();
 
         bool test_motion_detector_constructor();
         bool test_motion_detector_getset();
         bool test_motion_detector_detect_motion();
+        bool test_motion_detector_refine();
+        bool test_motion_detector_idle_decimation();
+        bool test_motion_detector_checkpoint();
+        bool test_motion_detector_config();
+        bool test_motion_detector_denoise();
+        bool test_motion_detector_contour_callback();
+        bool test_motion_detector_contour_merge();
+        bool test_motion_detector_stage_pipeline();
 
         bool test_rgb_to_bw();
         bool test_uchar_to_bw();
+        bool test_luma_to_bw();
     } // namespace image_utils
 } // namespace test
 
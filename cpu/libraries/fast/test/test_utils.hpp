@@ -16,10 +16,10 @@ namespace test
         else std::cout << "> [FAIL] : " << func_name << std::endl;
     }
 
-    template<typename T1, typename T2>
-    bool test_compare_vectors(const std::vector<T1> &v1, const std::vector<T2> &v2)
+    template<typename T1, typename T2, typename A1, typename A2>
+    bool test_compare_vectors(const std::vector<T1, A1> &v1, const std::vector<T2, A2> &v2)
     {
-        if(&v1 == &v2) return true;
+        if((const void *)&v1 == (const void *)&v2) return true;
 
         if(v1.size() != v2.size()){
             std::cout << "Vector compare: Different sizes" << std::endl;
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+#include <motion_detector.hpp>
+#include <detection_log.hpp>
+#include <raw_video_reader.hpp> // Maps raw video files into memory, no decoding library required.
+
+namespace fs = std::filesystem; // Rename namespaces for convenience.
+namespace md = motdet;
+namespace rv = raw_video;
+
+using std::chrono::high_resolution_clock;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+
+/**
+ * @brief A run of consecutive frames of one input, processed by its own motion detector.
+ * @details The reference of each chunk is seeded by processing warm-up frames that precede it, whose results are discarded.
+ */
+struct Chunk
+{
+    std::size_t input;                   /**< Index of the input the chunk belongs to.                       */
+    std::size_t warmup_begin;            /**< First frame processed, only used to build the reference.       */
+    std::size_t begin, end;              /**< Frames [begin, end) whose results are kept.                    */
+    std::vector<md::Detection> results;  /**< Results of the frames with motion, in timestamp order.         */
+};
+
+/**
+ * @brief Runs a motion detector over the frames of a chunk, keeping the results of the frames with motion.
+ */
+void process_chunk(const rv::Raw_video_reader &reader, Chunk &chunk, const unsigned int reduction_factor)
+{
+    const std::size_t width = reader.get_width(), height = reader.get_height();
+
+    // A single thread per detector, the parallelism comes from running many chunks at once.
+    md::Motion_detector motion_detector(width, height, 1, 2, reduction_factor);
+
+    for(std::size_t i = chunk.warmup_begin; i < chunk.end; ++i)
+    {
+        auto grayscale_input_frame = std::make_unique<md::Image<unsigned short>>(width, height, 0);
+        const unsigned char *luma = reader.get_luma(i);
+
+        if(reader.get_bytes_per_sample() == 2) std::memcpy(&(*grayscale_input_frame)[0], luma, width*height*2);
+        else md::luma_to_bw(luma, width*height, *grayscale_input_frame.get());
+
+        // Archived footage is read only once, do not let it fill the page cache.
+        reader.release(i);
+        reader.prefetch(i+1);
+
+        motion_detector.enqueue_frame(std::move(grayscale_input_frame), reader.get_timestamp(i), true);
+        md::Detection detected_result = motion_detector.get_detection(true);
+
+        if(i >= chunk.begin && detected_result.has_detections)
+            chunk.results.push_back(std::move(detected_result));
+    }
+}
+
+/**
+ * @brief Writes the stitched results of an input, only the frames with motion, to a binary detection log.
+ */
+void write_log(const fs::path &path, const std::vector<Chunk*> &chunks)
+{
+    fs::remove(path);
+    fs::remove(path.string() + ".idx");
+
+    md::Detection_log_writer log(path.string());
+    for(const Chunk *chunk : chunks)
+        for(const md::Detection &det : chunk->results) log.append(det);
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 8)
+    {
+        std::cerr <<
+        "ERROR: Missing parameters" << std::endl <<
+        "Specify the following parameters: " << std::endl <<
+        " - output: Folder to write one .mdlog detection log per input in." << std::endl <<
+        " - format: 'y4m', 'nv12:WxH@fps' or 'gray16:WxH@fps'. Headerless formats need the resolution, fps is optional (30 by default)." << std::endl <<
+        " - threads : Amount of chunks processed in parallel." << std::endl <<
+        " - downscale factor : Resolution reductor for input video, 4 is fastest while still working. 1 is native resolution." << std::endl <<
+        " - chunk length : Frames per chunk." << std::endl <<
+        " - warm-up : Frames before each chunk processed only to build the reference." << std::endl <<
+        " - inputs : One or more paths to raw video files of the given format." << std::endl;
+
+        return 0;
+    }
+
+    fs::path out_dir(argv[1]);
+    if(!fs::exists(out_dir)) throw std::invalid_argument("The selected output directory is not accessible or does not exist.");
+
+    std::size_t width = 0, height = 0, chunk_length = 0, warmup = 0;
+    double fps = 30;
+    unsigned int threads = 1, reduction_factor = 1;
+    rv::Raw_format format = rv::parse_format(argv[2], width, height, fps);
+
+    try
+    {
+        threads = std::stoul(argv[3]);
+        reduction_factor = std::stoul(argv[4]);
+        chunk_length = std::stoul(argv[5]);
+        warmup = std::stoul(argv[6]);
+    }
+    catch(const std::exception &e) { throw std::invalid_argument("The threads, downscale factor, chunk length and warm-up must be numbers."); }
+    if(threads == 0) throw std::invalid_argument("The number of threads must be at least 1");
+    if(reduction_factor == 0) throw std::invalid_argument("The reduction factor must be at least 1");
+    if(chunk_length == 0) throw std::invalid_argument("The chunk length must be at least 1");
+
+    // Map every input and split them into chunks. Chunks of all the inputs share the same pool of threads.
+    std::vector<std::string> inputs(argv + 7, argv + argc);
+    std::vector<std::unique_ptr<rv::Raw_video_reader>> readers;
+    std::vector<Chunk> chunks;
+
+    for(std::size_t in = 0; in < inputs.size(); ++in)
+    {
+        readers.push_back(std::make_unique<rv::Raw_video_reader>(inputs[in], format, width, height, fps));
+
+        for(std::size_t begin = 0; begin < readers[in]->get_frame_count(); begin += chunk_length)
+        {
+            Chunk chunk;
+            chunk.input = in;
+            chunk.warmup_begin = begin > warmup ? begin - warmup : 0;
+            chunk.begin = begin;
+            chunk.end = std::min(begin + chunk_length, readers[in]->get_frame_count());
+            chunks.push_back(std::move(chunk));
+        }
+    }
+    std::cout << "Processing " << inputs.size() << " inputs split into " << chunks.size() << " chunks with " << threads << " threads..." << std::endl;
+
+    // Each thread takes the next chunk that nobody is working on until there are none left.
+    std::atomic<std::size_t> next_chunk(0);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+
+    auto batch_start = high_resolution_clock::now();
+    for(unsigned int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]
+        {
+            try
+            {
+                for(std::size_t c = next_chunk++; c < chunks.size(); c = next_chunk++)
+                    process_chunk(*readers[chunks[c].input], chunks[c], reduction_factor);
+            }
+            catch(...) { errors[t] = std::current_exception(); }
+        });
+    }
+    for(std::thread &worker : workers) worker.join();
+    for(std::exception_ptr &error : errors) if(error) std::rethrow_exception(error);
+    auto batch_end = high_resolution_clock::now();
+
+    // Stitch the chunks of each input back in timestamp order. Chunks were created in order, so it is enough to group them.
+    for(std::size_t in = 0; in < inputs.size(); ++in)
+    {
+        std::vector<Chunk*> input_chunks;
+        for(Chunk &chunk : chunks) if(chunk.input == in) input_chunks.push_back(&chunk);
+
+        fs::path log_path = out_dir / fs::path(inputs[in]).filename().replace_extension(".mdlog");
+        write_log(log_path, input_chunks);
+        std::cout << "Wrote " << log_path << std::endl;
+    }
+
+    std::size_t total_frames = 0;
+    for(auto &reader : readers) total_frames += reader->get_frame_count();
+    auto millis = duration_cast<milliseconds>(batch_end - batch_start).count();
+    std::cout << "Processed " << total_frames << " frames in " << millis << " millis";
+    if(millis > 0) std::cout << " (" << total_frames * 1000.0 / millis << " fps)";
+    std::cout << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include "raw_video_reader.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>    // open
+#include <unistd.h>   // close, sysconf
+#include <sys/mman.h> // mmap, madvise
+#include <sys/stat.h> // fstat
+
+namespace raw_video
+{
+
+    Raw_video_reader::Raw_video_reader(const std::string &path, const Raw_format format, const std::size_t width, const std::size_t height, const double fps):
+        format_(format),
+        w_(width),
+        h_(height),
+        fps_(fps)
+    {
+        if(format_ != Raw_format::y4m)
+        {
+            if(w_ == 0) throw std::invalid_argument("ERROR Constructor: width must be >0.");
+            if(h_ == 0) throw std::invalid_argument("ERROR Constructor: height must be >0.");
+        }
+        if(fps_ <= 0) throw std::invalid_argument("ERROR Constructor: fps must be >0.");
+
+        fd_ = open(path.c_str(), O_RDONLY);
+        if(fd_ < 0) throw std::runtime_error("ERROR Constructor: Could not open " + path);
+
+        struct stat file_stat;
+        if(fstat(fd_, &file_stat) != 0 || file_stat.st_size == 0)
+        {
+            close(fd_);
+            throw std::runtime_error("ERROR Constructor: Could not read the size of " + path + " or it is empty.");
+        }
+        map_size_ = file_stat.st_size;
+
+        void *map = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if(map == MAP_FAILED)
+        {
+            close(fd_);
+            throw std::runtime_error("ERROR Constructor: Could not map " + path);
+        }
+        map_ = (const unsigned char *)map;
+
+        // Frames are read in order most of the time, let the kernel read ahead as much as it wants.
+        madvise(map, map_size_, MADV_SEQUENTIAL);
+
+        try
+        {
+            switch(format_)
+            {
+                case Raw_format::y4m:    parse_y4m_header_(); break;
+                case Raw_format::nv12:   frame_size_ = w_*h_ + 2*((w_+1)/2)*((h_+1)/2); break;
+                case Raw_format::gray16: frame_size_ = w_*h_*2; break;
+            }
+        }
+        catch(...)
+        {
+            munmap(map, map_size_);
+            close(fd_);
+            throw;
+        }
+
+        frame_count_ = map_size_ > data_offset_ ? (map_size_ - data_offset_) / frame_size_ : 0;
+    }
+
+    Raw_video_reader::~Raw_video_reader()
+    {
+        munmap((void *)map_, map_size_);
+        close(fd_);
+    }
+
+    const unsigned char* Raw_video_reader::get_luma(const std::size_t idx) const
+    {
+        if(idx >= frame_count_) throw std::out_of_range("ERROR get_luma: Frame index out of range.");
+
+        const unsigned char *frame = map_ + data_offset_ + idx*frame_size_;
+
+        // Frame headers are assumed to have the same length as the first one, check it is actually a frame header.
+        if(frame_header_ > 0 && (std::memcmp(frame, "FRAME", 5) != 0 || frame[frame_header_-1] != '\n'))
+            throw std::runtime_error("ERROR get_luma: Malformed y4m frame header, frame parameters of variable length are not supported.");
+
+        return frame + frame_header_;
+    }
+
+    void Raw_video_reader::prefetch(const std::size_t idx) const
+    {
+        if(idx >= frame_count_) return;
+
+        // madvise requires page aligned addresses, round the start of the frame down to a page boundary.
+        static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+        std::size_t start = data_offset_ + idx*frame_size_;
+        std::size_t aligned_start = start - start % page_size;
+        madvise((void *)(map_ + aligned_start), start - aligned_start + frame_size_, MADV_WILLNEED);
+    }
+
+    void Raw_video_reader::release(const std::size_t idx) const
+    {
+        if(idx >= frame_count_) return;
+
+        // Only drop the pages that are completely within the frame, the ones at the edges are shared with its neighbours.
+        static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+        std::size_t start = data_offset_ + idx*frame_size_;
+        std::size_t end = start + frame_size_;
+        std::size_t aligned_start = (start + page_size - 1) / page_size * page_size;
+        std::size_t aligned_end = end / page_size * page_size;
+        if(aligned_end > aligned_start) madvise((void *)(map_ + aligned_start), aligned_end - aligned_start, MADV_DONTNEED);
+    }
+
+    void Raw_video_reader::parse_y4m_header_()
+    {
+        // The stream header is a single line of space separated parameters: YUV4MPEG2 W1920 H1080 F30:1 Ip A1:1 C420jpeg
+        const unsigned char *header_end = (const unsigned char *)std::memchr(map_, '\n', map_size_);
+        if(header_end == nullptr || map_size_ < 10 || std::memcmp(map_, "YUV4MPEG2 ", 10) != 0)
+            throw std::invalid_argument("ERROR Constructor: Not a y4m file.");
+
+        std::istringstream header(std::string((const char *)map_ + 10, (const char *)header_end));
+        std::string colorspace = "420", param;
+        w_ = h_ = 0;
+
+        while(header >> param)
+        {
+            switch(param[0])
+            {
+                case 'W': w_ = std::stoul(param.substr(1)); break;
+                case 'H': h_ = std::stoul(param.substr(1)); break;
+                case 'C': colorspace = param.substr(1); break;
+                case 'F':
+                {
+                    std::size_t sep = param.find(':');
+                    if(sep == std::string::npos) break;
+                    double num = std::stod(param.substr(1, sep-1)), den = std::stod(param.substr(sep+1));
+                    if(num > 0 && den > 0) fps_ = num / den;
+                    break;
+                }
+                default: break; // Interlacing, aspect ratio and extensions do not affect the luma plane.
+            }
+        }
+        if(w_ == 0 || h_ == 0) throw std::invalid_argument("ERROR Constructor: The y4m header has no valid resolution.");
+
+        // Size of the planes that follow the luma plane, they are skipped but needed to find the next frame.
+        std::size_t chroma_w = (w_+1)/2, chroma_h = (h_+1)/2;
+        std::size_t chroma_size;
+        if     (colorspace == "420" || colorspace == "420jpeg" || colorspace == "420paldv" || colorspace == "420mpeg2") chroma_size = 2*chroma_w*chroma_h;
+        else if(colorspace == "422")      chroma_size = 2*chroma_w*h_;
+        else if(colorspace == "444")      chroma_size = 2*w_*h_;
+        else if(colorspace == "444alpha") chroma_size = 3*w_*h_;
+        else if(colorspace == "411")      chroma_size = 2*((w_+3)/4)*h_;
+        else if(colorspace == "mono")     chroma_size = 0;
+        else throw std::invalid_argument("ERROR Constructor: Unsupported y4m colorspace C" + colorspace + ", only 8b samples are supported.");
+
+        data_offset_ = header_end - map_ + 1;
+
+        // Find the length of the first frame header, every other frame header is assumed to be equal.
+        const unsigned char *frame_end = data_offset_ < map_size_ ? (const unsigned char *)std::memchr(map_ + data_offset_, '\n', map_size_ - data_offset_) : nullptr;
+        if(frame_end == nullptr || std::memcmp(map_ + data_offset_, "FRAME", 5) != 0) throw std::invalid_argument("ERROR Constructor: The y4m file has no frames.");
+
+        frame_header_ = frame_end - (map_ + data_offset_) + 1;
+        frame_size_ = frame_header_ + w_*h_ + chroma_size;
+    }
+
+    Raw_format parse_format(const std::string &spec, std::size_t &width, std::size_t &height, double &fps)
+    {
+        std::size_t sep = spec.find(':');
+        std::string name = spec.substr(0, sep);
+        Raw_format format;
+
+        if(name == "y4m") return Raw_format::y4m;
+        else if(name == "nv12") format = Raw_format::nv12;
+        else if(name == "gray16") format = Raw_format::gray16;
+        else throw std::invalid_argument("ERROR parse_format: The format must be one of y4m, nv12 or gray16.");
+
+        std::size_t x = spec.find('x', sep), at = spec.find('@', sep);
+        if(sep == std::string::npos || x == std::string::npos) throw std::invalid_argument("ERROR parse_format: Headerless formats must specify the resolution as format:WxH.");
+
+        try
+        {
+            width = std::stoul(spec.substr(sep+1, x-sep-1));
+            height = std::stoul(spec.substr(x+1, at == std::string::npos ? std::string::npos : at-x-1));
+            if(at != std::string::npos) fps = std::stod(spec.substr(at+1));
+        }
+        catch(const std::exception &e) { throw std::invalid_argument("ERROR parse_format: The resolution and fps must be numbers."); }
+
+        return format;
+    }
+
+} // namespace raw_video
@@ -0,0 +1,150 @@
+#ifndef __MOTDET_RAW_VIDEO_READER_HPP__
+#define __MOTDET_RAW_VIDEO_READER_HPP__
+
+#include <cstddef>
+#include <string>
+
+namespace raw_video
+{
+
+    /**
+     * @brief Layouts of the raw video files that can be read.
+     */
+    enum class Raw_format : unsigned char
+    {
+        y4m,   /**< YUV4MPEG2 file with 8b samples. The header gives resolution and fps, the luma plane is the first of each frame. */
+        nv12,  /**< Headerless frames of a W*H luma plane followed by a W*H/2 interleaved chroma plane.                        */
+        gray16 /**< Headerless frames of W*H little endian 16b samples.                                                        */
+    };
+
+    /**
+     * @brief Reads raw video files by mapping them into memory. Frames are never copied, the luma plane of each frame
+     * is handed out as a pointer into the mapping.
+     * @details The whole file is mapped with a sequential access hint, so the kernel reads ahead aggressively, and pages
+     * can be prefetched or released frame by frame to keep the page cache usage of huge files bounded.
+     */
+    class Raw_video_reader
+    {
+    public:
+        /**
+         * @brief Open and map a raw video file.
+         * @param path Path to the video file.
+         * @param format Layout of the file.
+         * @param width Width of the frames. Ignored for y4m, where it is read from the header. >0 otherwise.
+         * @param height Height of the frames. Ignored for y4m, where it is read from the header. >0 otherwise.
+         * @param fps Frames per second, used to compute the timestamps. Ignored for y4m if the header specifies it.
+         * @throw invalid_argument if the resolution is invalid or the y4m header cannot be parsed or is not supported.
+         * @throw runtime_error if the file cannot be opened or mapped.
+         */
+        Raw_video_reader(const std::string &path, const Raw_format format, const std::size_t width = 0, const std::size_t height = 0, const double fps = 30);
+
+        Raw_video_reader() = delete;
+        Raw_video_reader(const Raw_video_reader &other) = delete;
+        Raw_video_reader(Raw_video_reader &&other) = delete;
+
+        ~Raw_video_reader();
+
+        // Operator Overload
+
+        Raw_video_reader& operator=(const Raw_video_reader &other) = delete;
+        Raw_video_reader& operator=(Raw_video_reader &&other) = delete;
+
+        // Getters and Setters
+
+        /**
+         * @brief Get the width
+         * @return std::size_t
+         */
+        inline std::size_t get_width() const { return w_; };
+
+        /**
+         * @brief Get the height
+         * @return std::size_t
+         */
+        inline std::size_t get_height() const { return h_; };
+
+        /**
+         * @brief Get the frames per second
+         * @return double
+         */
+        inline double get_fps() const { return fps_; };
+
+        /**
+         * @brief Get the layout of the file
+         * @return Raw_format
+         */
+        inline Raw_format get_format() const { return format_; };
+
+        /**
+         * @brief Get the amount of complete frames in the file. A truncated last frame is ignored.
+         * @return std::size_t
+         */
+        inline std::size_t get_frame_count() const { return frame_count_; };
+
+        /**
+         * @brief Get the size in bytes of each luma sample. 1 for y4m and nv12, 2 for gray16.
+         * @return std::size_t
+         */
+        inline std::size_t get_bytes_per_sample() const { return format_ == Raw_format::gray16 ? 2 : 1; };
+
+        // General Methods
+
+        /**
+         * @brief Get the luma plane of a frame. Points into the mapped file, so it is valid as long as the reader is alive.
+         * @param idx Index of the frame. <get_frame_count().
+         * @return Pointer to width*height samples of get_bytes_per_sample() bytes each.
+         * @throw out_of_range if idx is not a valid frame.
+         * @throw runtime_error if the y4m frame header is malformed.
+         */
+        const unsigned char* get_luma(const std::size_t idx) const;
+
+        /**
+         * @brief Get the timestamp of a frame in milliseconds, computed from the frame index and the fps.
+         * @param idx Index of the frame.
+         * @return unsigned long long
+         */
+        inline unsigned long long get_timestamp(const std::size_t idx) const { return idx * 1000 / fps_; };
+
+        /**
+         * @brief Hint the kernel to start reading a frame from disk, so that it is ready when it is needed.
+         * @param idx Index of the frame. Invalid indexes are ignored.
+         */
+        void prefetch(const std::size_t idx) const;
+
+        /**
+         * @brief Hint the kernel that a frame will not be used again, so that its pages can be dropped from memory.
+         * @param idx Index of the frame. Invalid indexes are ignored.
+         */
+        void release(const std::size_t idx) const;
+
+    private:
+        Raw_format format_;
+        std::size_t w_, h_;
+        double fps_;
+
+        int fd_ = -1;
+        const unsigned char *map_ = nullptr;
+        std::size_t map_size_ = 0;
+
+        std::size_t data_offset_ = 0;  /**< Offset of the first frame in the file. */
+        std::size_t frame_header_ = 0; /**< Bytes preceding the planes of every frame. Only y4m has frame headers. */
+        std::size_t frame_size_ = 0;   /**< Bytes of a frame including its header. */
+        std::size_t frame_count_ = 0;
+
+        void parse_y4m_header_(); /**< Reads resolution, fps and frame layout from the y4m stream header. */
+    };
+
+    /**
+     * @brief Parses a format given in the command line of the driver programs: "y4m", "nv12:WxH@fps" or "gray16:WxH@fps".
+     * @param spec Format string. The resolution is required for the headerless formats, the fps is optional.
+     * @param width Outputs the width given in spec. Untouched for y4m.
+     * @param height Outputs the height given in spec. Untouched for y4m.
+     * @param fps Outputs the fps given in spec. Untouched if not given.
+     * @return Raw_format
+     * @throw invalid_argument if the format is unknown or the resolution or fps are missing or not numbers.
+     */
+    Raw_format parse_format(const std::string &spec, std::size_t &width, std::size_t &height, double &fps);
+
+} // namespace raw_video
+
+#endif // __MOTDET_RAW_VIDEO_READER_HPP__
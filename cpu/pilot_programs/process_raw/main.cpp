@@ -0,0 +1,138 @@
+#include <iostream>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include <exception>
+
+#include <motion_detector.hpp>
+#include <raw_video_reader.hpp> // Maps raw video files into memory, no decoding library required.
+
+namespace md = motdet; // Rename namespaces for convenience.
+namespace rv = raw_video;
+
+using std::chrono::high_resolution_clock;
+using std::chrono::duration_cast;
+using std::chrono::duration;
+using std::chrono::milliseconds;
+
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::cerr <<
+        "ERROR: Missing parameters" << std::endl <<
+        "Specify the following parameters: " << std::endl <<
+        " - input: Path to a raw video file." << std::endl <<
+        " - format: 'y4m', 'nv12:WxH@fps' or 'gray16:WxH@fps'. Headerless formats need the resolution, fps is optional (30 by default)." << std::endl <<
+        " [OPTIONAL] - threads : Amount of threads, by defaul, 1." << std::endl <<
+        " [OPTIONAL] - downscale factor : Resolution reductor for input video, 4 is fastest while still working. 1 is native resolution." << std::endl <<
+        " [OPTIONAL] - display stats : Print timing stats. 1 for true, 0 for false" << std::endl;
+
+        return 0;
+    }
+
+    std::string in_source;
+    rv::Raw_format format;
+    std::size_t width = 0, height = 0;
+    double fps = 30;
+    unsigned int threads = 1;
+    unsigned int reduction_factor = 1;
+    bool display_stats = false;
+
+    // Get input source
+    in_source = argv[1];
+
+    // Get format, and the resolution for the headerless ones.
+    format = rv::parse_format(argv[2], width, height, fps);
+
+    // Get threads
+    try { if(argc >= 4) threads = std::abs(std::stoi(argv[3])); }
+    catch(const std::exception &e) { throw std::invalid_argument("The number of threads must be a number."); }
+    if(threads == 0) throw std::invalid_argument("The number of threads must be at least 1");
+
+    // Get reduction factor
+    try { if(argc >= 5) reduction_factor = std::abs(std::stoi(argv[4])); }
+    catch(const std::exception &e) { throw std::invalid_argument("The reduction factor must be a number."); }
+    if(reduction_factor == 0) throw std::invalid_argument("The reduction factor must be at least 1");
+
+    // Get display stats
+    if(argc >= 6) display_stats = std::stoi(argv[5]) == 1 ? true : false;
+
+    // At this point, all input parameters have been validated and stored.
+
+    // Map the file. For y4m the resolution and fps are taken from the header.
+    rv::Raw_video_reader reader(in_source, format, width, height, fps);
+    width = reader.get_width();
+    height = reader.get_height();
+    std::cout << "Reading " << reader.get_frame_count() << " frames of " << width << "x" << height << " at " << reader.get_fps() << " fps..." << std::endl;
+
+    // Create the Motion detector object from the library.
+    // Specify an input queue 2 times the amount of threads, so that threads are always busy working.
+    md::Motion_detector motion_detector(width, height, threads, threads*2, reduction_factor);
+
+    // How many frames ahead of the one being converted to ask the kernel to read. Enough to cover the frames in flight.
+    const std::size_t prefetch_distance = threads*2 + 2;
+    for(std::size_t i = 0; i < prefetch_distance; ++i) reader.prefetch(i);
+
+    std::size_t next_frame = 0, results = 0, detections = 0;
+
+    auto video_procesing_start = high_resolution_clock::now(); // Chrono the time it takes to process the input source.
+    while(results < reader.get_frame_count())
+    {
+        if(next_frame < reader.get_frame_count())
+        {
+            // The luma plane is read straight from the mapping, the only copy is the conversion to the 16b image the detector owns.
+            auto grayscale_input_frame = std::make_unique<md::Image<unsigned short>>(width, height, 0);
+            const unsigned char *luma = reader.get_luma(next_frame);
+
+            if(reader.get_bytes_per_sample() == 2) std::memcpy(&(*grayscale_input_frame)[0], luma, width*height*2);
+            else md::luma_to_bw(luma, width*height, *grayscale_input_frame.get());
+
+            // This frame will not be read again, drop its pages and ask for the ones that will be needed soon.
+            reader.release(next_frame);
+            reader.prefetch(next_frame + prefetch_distance);
+
+            motion_detector.enqueue_frame(std::move(grayscale_input_frame), reader.get_timestamp(next_frame), true);
+            ++next_frame;
+        }
+
+        // Poll for results in non-blocking mode so the queue keeps filling up while the threads work.
+        // Once every frame has been enqueued, block until the remaining ones are done.
+
+        md::Detection detected_result;
+        bool result_available = true;
+
+        try{ detected_result = motion_detector.get_detection(next_frame < reader.get_frame_count() ? false : true); }
+        catch(const std::runtime_error &e){ result_available = false; };
+
+        if(result_available)
+        {
+            ++results;
+            if(detected_result.has_detections)
+            {
+                ++detections;
+                std::cout << "Motion at " << detected_result.timestamp << " ms:";
+                for(md::Contour &cont : detected_result.detection_contours)
+                    std::cout << " [" << cont.bb_tl_x << "," << cont.bb_tl_y << " " << cont.bb_br_x << "," << cont.bb_br_y << "]";
+                std::cout << std::endl;
+            }
+            if(display_stats) std::cout << "Got results for " << detected_result.timestamp << ". | Processing time: " << detected_result.processing_time << " milliseconds." << std::endl;
+        }
+    }
+
+    if(display_stats)
+    {
+        auto video_procesing_end = high_resolution_clock::now();
+        auto millis = duration_cast<milliseconds>(video_procesing_end - video_procesing_start).count();
+        std::cout << "Processed " << results << " frames in " << millis << " millis";
+        if(millis > 0) std::cout << " (" << results * 1000.0 / millis << " fps)";
+        std::cout << ", " << detections << " with motion." << std::endl;
+    }
+    else
+    {
+        std::cout << "Finished processing video, " << detections << " of " << results << " frames with motion, exiting..." << std::endl;
+    }
+
+    return 0;
+}
@@ -5,6 +5,12 @@
 #include <vector>
 #include <chrono>
 #include <exception>
+#include <deque>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <motion_detector.hpp>
 #include <opencv2/core.hpp>     // OpenCV is used to capture frames to feed into the motion detector
@@ -19,6 +25,189 @@ using std::chrono::duration_cast;
 using std::chrono::duration;
 using std::chrono::milliseconds;
 
+/**
+ * @brief Encodes recordings in its own thread, so that drawing and writing frames never stall the thread that feeds
+ * and polls the motion detector.
+ * @details Jobs are queued in order: open a new file, write a frame with the contours to draw on it, close the file.
+ * Frames are received as the shared_ptr sent as data_keep, so they are never copied. Every queued frame keeps a whole
+ * decoded frame alive, so at most max_frames are queued: if the encoder falls behind, the oldest queued frames are
+ * dropped and reported, open and close jobs are never dropped.
+ */
+class Async_video_writer
+{
+public:
+    Async_video_writer(const int codec, const double fps, const cv::Size resolution, const std::size_t max_frames):
+        codec_(codec),
+        fps_(fps),
+        resolution_(resolution),
+        max_frames_(max_frames)
+    {
+        if(max_frames_ == 0) throw std::invalid_argument("ERROR Async_video_writer: max_frames must be at least 1.");
+        worker_ = std::thread(&Async_video_writer::encode_, this);
+    };
+
+    Async_video_writer(const Async_video_writer &other) = delete;
+    Async_video_writer& operator=(const Async_video_writer &other) = delete;
+
+    /**
+     * @brief Waits for all the queued jobs to be encoded and stops the encoder thread.
+     */
+    ~Async_video_writer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            stop_ = true;
+        }
+        jobs_cv_.notify_one();
+        worker_.join();
+    };
+
+    /**
+     * @brief Start a new recording. Any recording still open is closed first.
+     * @param path Path of the new video file.
+     */
+    void open(const fs::path &path) { push_({Job_::Kind::open, path, {}, {}}); };
+
+    /**
+     * @brief Append a frame to the current recording. Never blocks, if max_frames are already queued the oldest one is dropped.
+     * @param frame Frame to write, the contours will be drawn on it by the encoder thread.
+     * @param contours Motion to draw as green rectangles. Empty for frames without motion.
+     */
+    void write(std::shared_ptr<cv::Mat> frame, const std::vector<md::Contour> &contours) { push_({Job_::Kind::write, {}, std::move(frame), contours}); };
+
+    /**
+     * @brief Close the current recording once all its frames are written.
+     */
+    void close() { push_({Job_::Kind::close, {}, {}, {}}); };
+
+    /**
+     * @brief Waits until every queued job has been encoded.
+     */
+    void wait_idle()
+    {
+        std::unique_lock<std::mutex> lock(jobs_mutex_);
+        idle_cv_.wait(lock, [this]{ return jobs_.empty() && !busy_; });
+    };
+
+    /**
+     * @brief Get the amount of frames waiting to be encoded.
+     * @return std::size_t
+     */
+    std::size_t get_backlog()
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        return queued_frames_;
+    };
+
+    /**
+     * @brief Get the amount of frames dropped because the encoder fell behind.
+     * @return std::size_t
+     */
+    std::size_t get_dropped_frames()
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        return dropped_frames_;
+    };
+
+private:
+    struct Job_
+    {
+        enum class Kind {open, write, close} kind;
+        fs::path path;
+        std::shared_ptr<cv::Mat> frame;
+        std::vector<md::Contour> contours;
+    };
+
+    void push_(Job_ &&job)
+    {
+        bool dropped = false;
+        std::size_t dropped_frames;
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            if(job.kind == Job_::Kind::write)
+            {
+                if(queued_frames_ == max_frames_)
+                {
+                    // The encoder is behind, drop the oldest queued frame rather than growing without limit.
+                    auto oldest = std::find_if(jobs_.begin(), jobs_.end(), [](const Job_ &queued){ return queued.kind == Job_::Kind::write; });
+                    jobs_.erase(oldest);
+                    --queued_frames_;
+                    dropped_frames = ++dropped_frames_;
+                    dropped = true;
+                }
+                ++queued_frames_;
+            }
+            jobs_.push_back(std::move(job));
+        }
+        jobs_cv_.notify_one();
+
+        // Report the first drop and then every 100, to not flood the output while the encoder catches up.
+        if(dropped && dropped_frames % 100 == 1)
+            std::cerr << "WARNING: The encoder is falling behind, dropped the oldest queued frame (" << dropped_frames << " dropped so far)." << std::endl;
+    };
+
+    void encode_()
+    {
+        cv::VideoWriter writer;
+
+        while(true)
+        {
+            Job_ job;
+            {
+                std::unique_lock<std::mutex> lock(jobs_mutex_);
+                busy_ = false;
+                if(jobs_.empty()) idle_cv_.notify_all();
+                jobs_cv_.wait(lock, [this]{ return stop_ || !jobs_.empty(); });
+                if(jobs_.empty()) break; // Only reached when stopping with no jobs left.
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+                if(job.kind == Job_::Kind::write) --queued_frames_;
+                busy_ = true;
+            }
+
+            switch(job.kind)
+            {
+                case Job_::Kind::open:
+                    if(writer.isOpened()) writer.release();
+                    writer.open(job.path, codec_, fps_, resolution_, true); // Color video is assumed.
+                    break;
+
+                case Job_::Kind::write:
+                    if(!writer.isOpened()) break;
+
+                    // Draw the detected motion onto the frame as rectangles.
+                    for(md::Contour &cont : job.contours)
+                    {
+                        cv::Point pt1(cont.bb_tl_x, cont.bb_tl_y);
+                        cv::Point pt2(cont.bb_br_x, cont.bb_br_y);
+                        cv::rectangle(*job.frame, pt1, pt2, cv::Scalar(0, 255, 0));
+                    }
+                    writer.write(*job.frame);
+                    break;
+
+                case Job_::Kind::close:
+                    writer.release();
+                    break;
+            }
+        }
+
+        writer.release();
+    };
+
+    int codec_;
+    double fps_;
+    cv::Size resolution_;
+    std::size_t max_frames_;
+
+    std::deque<Job_> jobs_;
+    std::size_t queued_frames_ = 0;  /**< Write jobs in jobs_. */
+    std::size_t dropped_frames_ = 0;
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_cv_, idle_cv_;
+    bool stop_ = false, busy_ = false;
+    std::thread worker_;
+};
+
 int main(int argc, char** argv)
 {
     if(argc < 3)
@@ -30,7 +219,8 @@ int main(int argc, char** argv)
         " - output: Folder to store captured video in. Will create .mp4 files with date when motion is detected. NOTE: All files are deleted in the directory." << std::endl <<
         " [OPTIONAL] - threads : Amount of threads, by defaul, 1." << std::endl <<
         " [OPTIONAL] - downscale factor : Resolution reductor for input video, 4 is fastest while still working. 1 is native resolution." << std::endl <<
-        " [OPTIONAL] - display stats : Print timing stats. 1 for true, 0 for false" << std::endl;
+        " [OPTIONAL] - display stats : Print timing stats. 1 for true, 0 for false" << std::endl <<
+        " [OPTIONAL] - pre-roll : Seconds of video before the motion to include in each recording, by default, 3." << std::endl;
 
         return 0;
     }
@@ -40,6 +230,7 @@ int main(int argc, char** argv)
     unsigned int threads = 1;
     unsigned int reduction_factor = 1;
     bool display_stats = false;
+    double pre_roll_seconds = 3;
 
     // Get input source
     in_source = argv[1];
@@ -67,6 +258,11 @@ int main(int argc, char** argv)
     // Get display stats
     if(argc >= 6) display_stats = std::stoi(argv[5]) == 1 ? true : false;
 
+    // Get pre-roll
+    try { if(argc >= 7) pre_roll_seconds = std::stod(argv[6]); }
+    catch(const std::exception &e) { throw std::invalid_argument("The pre-roll must be a number."); }
+    if(pre_roll_seconds < 0) throw std::invalid_argument("The pre-roll cannot be negative.");
+
     // At this point, all input parameters have been validated and stored.
 
     cv::VideoCapture cap;
@@ -87,15 +283,22 @@ int main(int argc, char** argv)
     if (!cap.isOpened()) throw std::runtime_error("Failed opening input.");
 
     // When motion is detected a new .mp4 video will eb created in the output directory.
-    // In order to do this, create a .mp4 writer from OpenCV.
+    // In order to do this, create a .mp4 writer from OpenCV, running in its own thread.
 
-    cv::VideoWriter writer;
     int codec = cv::VideoWriter::fourcc('m', 'p', '4', 'v'); // Saving to .mp4
     unsigned char fps = cap.get(cv::CAP_PROP_FPS);
     std::size_t width = cap.get(cv::CAP_PROP_FRAME_WIDTH);
     std::size_t height = cap.get(cv::CAP_PROP_FRAME_HEIGHT);
     cv::Size stream_res = cv::Size(width, height);
 
+    // Keep the last few seconds of frames that had no motion, so that recordings start a bit before the motion does.
+    // Only the shared_ptrs sent as data_keep are kept, the frames themselves are never copied.
+    const std::size_t pre_roll_frames = pre_roll_seconds * fps;
+    std::deque<std::shared_ptr<cv::Mat>> pre_roll;
+
+    // The encoder can hold the whole pre-roll plus 2 seconds of video before it starts dropping frames.
+    Async_video_writer writer(codec, fps, stream_res, pre_roll_frames + 2*std::max<std::size_t>(fps, 1));
+
     // Create the Motion detector object from the library.
     // Specify an input queue 2 times the amount of threads, so that threads are always busy working.
     md::Motion_detector motion_detector(width, height, threads, threads*2, reduction_factor);
@@ -182,6 +385,9 @@ int main(int argc, char** argv)
             if(display_stats) std::cout << " | Processing time: " << detected_result.processing_time << " milliseconds." << std::endl;
             else std::cout << std::endl;
 
+            // Remember how we sent the raw frame as a shared_ptr when enqueueing? Recover it now.
+            auto recovered_frame = std::static_pointer_cast<cv::Mat>(detected_result.data_keep);
+
             if(detected_result.has_detections)
             {
                 if(!recording)
@@ -192,7 +398,11 @@ int main(int argc, char** argv)
                     fs::path rec_path = out_recordings_dir / file;
 
                     std::cout << "Motion detected. Recording to " << rec_path << std::endl;
-                    writer.open(rec_path, codec, fps, stream_res, true); // Color video is assumed.
+                    writer.open(rec_path);
+
+                    // Flush the frames leading up to the motion into the new recording.
+                    for(auto &pre_frame : pre_roll) writer.write(std::move(pre_frame), {});
+                    pre_roll.clear();
                 }
 
                 millis_last_movement = detected_result.timestamp;
@@ -210,35 +420,33 @@ int main(int argc, char** argv)
 
                     contours.clear();
                     recording = false;
-                    writer.release();
+                    writer.close();
                 }
             }
 
             if(recording)
             {
-                // Remember how we sent the raw frame as a shared_ptr when enqueueing? Recover it now.
-                cv::Mat* recovered_frame = (cv::Mat*)detected_result.data_keep.get();
-
-                // Draw the detected motion onto the recovered frame as rectangles.
-                for(md::Contour &cont : contours)
-                {
-                    // Draw the detected movement on screen
-
-                    cv::Point pt1(cont.bb_tl_x, cont.bb_tl_y);
-                    cv::Point pt2(cont.bb_br_x, cont.bb_br_y);
-                    cv::rectangle(*recovered_frame, pt1, pt2, cv::Scalar(0, 255, 0));
-                }
-
-                // Save the edited frame into the video we are recording.
-                writer.write(*recovered_frame);
+                // Hand the frame to the encoder thread, it will draw the detected motion and save it into the video.
+                writer.write(std::move(recovered_frame), contours);
+            }
+            else if(pre_roll_frames > 0)
+            {
+                pre_roll.push_back(std::move(recovered_frame));
+                if(pre_roll.size() > pre_roll_frames) pre_roll.pop_front();
             }
         }
     }
 
+    auto video_procesing_end = high_resolution_clock::now();
+    if(display_stats) std::cout << "Waiting for " << writer.get_backlog() << " frames to be encoded..." << std::endl;
+    writer.wait_idle();
+
     if(display_stats)
     {
-        auto video_procesing_end = high_resolution_clock::now();
+        auto encoding_end = high_resolution_clock::now();
         std::cout << "Processed video in " << duration_cast<milliseconds>(video_procesing_end - video_procesing_start).count() << " millis " << std::endl;
+        std::cout << "Finished encoding " << duration_cast<milliseconds>(encoding_end - video_procesing_end).count() << " millis later, "
+                  << writer.get_dropped_frames() << " frames dropped." << std::endl;
     }
     else
     {
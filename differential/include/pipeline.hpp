@@ -0,0 +1,112 @@
+#ifndef __MOTDET_DIFF_PIPELINE_HPP__
+#define __MOTDET_DIFF_PIPELINE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The base and fast libraries and the HLS IP core define the same types and functions in the motdet namespace, so they
+// can not be linked into a single program. Each one is built into its own shared library with hidden visibility, and
+// only the types in this header, which use no motdet type, cross between them and the harness.
+#define MOTDET_DIFF_API __attribute__((visibility("default")))
+
+namespace motdet
+{
+    namespace diff
+    {
+        /**
+         * @brief Processing stages compared between implementations, in pipeline order.
+         */
+        enum class Stage : std::size_t { downsample, blur, subtraction, threshold, dilation, contours };
+
+        const std::size_t stage_count = 6;
+        const std::size_t image_stage_count = 5; /**< Stages that produce an image, from downsample to dilation. */
+
+        /**
+         * @brief Name of a stage, for reports.
+         */
+        inline const char* stage_name(const Stage stage)
+        {
+            static const char *names[stage_count] = { "downsample", "blur", "subtraction", "threshold", "dilation", "contours" };
+            return names[(std::size_t)stage];
+        }
+
+        /**
+         * @brief Bounding box in the original resolution, as reported by the implementation.
+         */
+        struct Box
+        {
+            std::size_t tl_x, tl_y;
+            std::size_t br_x, br_y;
+        };
+
+        /**
+         * @brief Output of every stage of an implementation for one frame.
+         * @details Images are in the downsampled resolution. The threshold and dilation stages are binary masks with values
+         * 0 or 1, the threshold mask being the final one, after hysteresis in the CPU libraries. On the first frame only
+         * the downsample and blur images are produced, since the frame becomes the reference.
+         */
+        struct Frame_result
+        {
+            std::vector<std::uint16_t> images[image_stage_count]; /**< Empty for stages not run on this frame.            */
+            bool has_boxes = false;                 /**< False on the first frame, which only sets the reference.          */
+            std::vector<Box> boxes;                 /**< Boxes left after the area filter, scaled to the original size.    */
+            double stage_ms[stage_count] = {};      /**< Time spent in every stage, in milliseconds.                       */
+            bool library_checked = false;           /**< True if the boxes were checked against the library detector.      */
+            bool library_agrees = true;             /**< False if the library detector found different boxes.              */
+        };
+
+        /**
+         * @brief One implementation of the motion detection pipeline, run stage by stage on a sequence of frames.
+         * @details The stages are the same functions the implementation uses internally, called in the same order, so
+         * intermediate results can be compared. Where possible the real detector of the library is fed the same frames
+         * too, so the stage by stage replica is checked against it.
+         */
+        class MOTDET_DIFF_API Pipeline
+        {
+        public:
+            virtual ~Pipeline() = default;
+
+            /**
+             * @brief Get the name of the implementation.
+             * @return const char*
+             */
+            virtual const char* get_name() const = 0;
+
+            /**
+             * @brief Processes the next frame of the sequence.
+             * @param frame Grayscale frame in the original resolution, row major.
+             * @param result Output of every stage. Overwritten.
+             */
+            virtual void process(const std::vector<std::uint16_t> &frame, Frame_result &result) = 0;
+        };
+
+        /**
+         * @brief Pipeline of the generic base library, cpu/libraries/base.
+         * @param check_library Also run the Motion_detector of the library and compare its boxes.
+         * @throw invalid_argument if the sizes are smaller than the library accepts or factor == 0.
+         */
+        MOTDET_DIFF_API std::unique_ptr<Pipeline> make_base_pipeline(const std::size_t width, const std::size_t height, const unsigned int factor, const bool check_library);
+
+        /**
+         * @brief Pipeline of the optimized library, cpu/libraries/fast.
+         * @param check_library Also run the Motion_detector of the library and compare its boxes.
+         * @throw invalid_argument if the sizes are smaller than the library accepts or factor == 0.
+         */
+        MOTDET_DIFF_API std::unique_ptr<Pipeline> make_fast_pipeline(const std::size_t width, const std::size_t height, const unsigned int factor, const bool check_library);
+
+        /**
+         * @brief Pipeline of the HLS IP core, hls/final, built natively as in hls/emulation. Stages run one after the other
+         * instead of as a dataflow region, so timings are those of the C++ model, not of the hardware.
+         * @details The reference of the IP core is global, so only one HLS pipeline can exist at a time. It is cleared
+         * when the pipeline is made.
+         * @throw invalid_argument if the sizes or factor are not the ones the IP core is built for.
+         * @throw runtime_error if another HLS pipeline still exists.
+         */
+        MOTDET_DIFF_API std::unique_ptr<Pipeline> make_hls_pipeline(const std::size_t width, const std::size_t height, const unsigned int factor);
+
+    } // namespace diff
+} // namespace motdet
+
+#endif // __MOTDET_DIFF_PIPELINE_HPP__
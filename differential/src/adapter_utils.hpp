@@ -0,0 +1,75 @@
+#ifndef __MOTDET_DIFF_ADAPTER_UTILS_HPP__
+#define __MOTDET_DIFF_ADAPTER_UTILS_HPP__
+
+// Helpers shared by the pipeline adapters. Header only, every adapter library gets its own hidden copy.
+
+#include <chrono>
+#include <vector>
+
+#include "pipeline.hpp"
+
+namespace motdet
+{
+    namespace diff
+    {
+        /**
+         * @brief Measures consecutive stages of a frame, each from the end of the previous one.
+         */
+        class Stage_timer
+        {
+        public:
+            Stage_timer(Frame_result &result): result_(result), start_(std::chrono::steady_clock::now()) {}
+
+            /**
+             * @brief Stores the time since the previous stage ended, or since construction, in the given stage.
+             */
+            void end_stage(const Stage stage)
+            {
+                auto now = std::chrono::steady_clock::now();
+                result_.stage_ms[(std::size_t)stage] = std::chrono::duration<double, std::milli>(now - start_).count();
+                start_ = now;
+            }
+
+            /**
+             * @brief Restarts the measure, so the time until the next end_stage is not counted in any stage.
+             */
+            void skip() { start_ = std::chrono::steady_clock::now(); }
+
+        private:
+            Frame_result &result_;
+            std::chrono::steady_clock::time_point start_;
+        };
+
+        /**
+         * @brief Copies an image of any integer pixel type into the result of a stage.
+         * @param binary Store every non zero pixel as 1, for masks whose implementation uses other values for "set".
+         */
+        template <typename T>
+        void store_stage(Frame_result &result, const Stage stage, const T *data, const std::size_t total, const bool binary = false)
+        {
+            std::vector<std::uint16_t> &image = result.images[(std::size_t)stage];
+            image.resize(total);
+            for(std::size_t k = 0; k < total; ++k) image[k] = binary ? (data[k] != 0) : (long long)data[k];
+        }
+
+        /**
+         * @brief Compares boxes of any type with the bb_tl_x... members of the libraries against the boxes of a result.
+         * @return true if both have the same boxes in the same order.
+         */
+        template <typename CONTOUR_T>
+        bool same_boxes(const std::vector<CONTOUR_T> &contours, const std::vector<Box> &boxes)
+        {
+            if(contours.size() != boxes.size()) return false;
+            for(std::size_t k = 0; k < boxes.size(); ++k)
+            {
+                const CONTOUR_T &cont = contours[k];
+                const Box &box = boxes[k];
+                if(cont.bb_tl_x != box.tl_x || cont.bb_tl_y != box.tl_y || cont.bb_br_x != box.br_x || cont.bb_br_y != box.br_y) return false;
+            }
+            return true;
+        }
+
+    } // namespace diff
+} // namespace motdet
+
+#endif // __MOTDET_DIFF_ADAPTER_UTILS_HPP__
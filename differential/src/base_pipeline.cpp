@@ -0,0 +1,142 @@
+#include "pipeline.hpp"
+#include "adapter_utils.hpp"
+
+#include "motion_detector.hpp"
+#include "image_utils.hpp"
+#include "contour_detector.hpp"
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+namespace motdet
+{
+    namespace diff
+    {
+        namespace // Anonymous namespace
+        {
+            /**
+             * @brief Runs the steps of Motion_detector::detect_motion_ of the base library one by one.
+             */
+            class Base_pipeline_ : public Pipeline
+            {
+            public:
+                Base_pipeline_(const std::size_t width, const std::size_t height, const unsigned int factor, const bool check_library):
+                    w_(width),
+                    h_(height),
+                    factor_(factor),
+                    min_cont_area_(width*height*0.002+5)
+                {
+                    if(width < 10 || height < 10) throw std::invalid_argument("ERROR make_base_pipeline: width and height must be at least 10.");
+                    if(factor == 0) throw std::invalid_argument("ERROR make_base_pipeline: factor must be at least 1.");
+
+                    downsampled_w_ = std::ceil((float)w_ / factor_);
+                    downsampled_h_ = std::ceil((float)h_ / factor_);
+
+                    if(check_library) detector_ = std::make_unique<Motion_detector>(w_, h_, 1, 2, factor_, frame_update_ratio_);
+                }
+
+                const char* get_name() const override { return "base"; }
+
+                void process(const std::vector<std::uint16_t> &frame, Frame_result &result) override
+                {
+                    if(frame.size() != w_*h_) throw std::invalid_argument("ERROR process: The frame does not have the size of the pipeline.");
+                    result = Frame_result();
+                    Stage_timer timer(result);
+
+                    Image<unsigned short> in(frame, w_);
+                    timer.skip();
+
+                    Image<unsigned short> downsampled_in(downsampled_w_, downsampled_h_, 0);
+                    if(factor_ > 1) imgutil::downsample<unsigned short, unsigned short>(in, downsampled_in, factor_);
+                    else downsampled_in = in;
+                    timer.end_stage(Stage::downsample);
+                    store_(result, Stage::downsample, downsampled_in);
+
+                    Image<unsigned short> blur_image(downsampled_w_, downsampled_h_, 0);
+                    timer.skip();
+                    imgutil::gaussian_blur_filter<unsigned short, unsigned short>(downsampled_in, blur_image);
+                    timer.end_stage(Stage::blur);
+                    store_(result, Stage::blur, blur_image);
+
+                    if(has_reference_)
+                    {
+                        Image<unsigned short> sub_image(downsampled_w_, downsampled_h_, 0), new_ref_image(downsampled_w_, downsampled_h_, 0);
+                        Image<unsigned char> thr_image(downsampled_w_, downsampled_h_, 0), cnt_image(downsampled_w_, downsampled_h_, 0);
+                        Image<int> dil_image(downsampled_w_, downsampled_h_, 0);
+                        timer.skip();
+
+                        // The base library subtracts the reference before updating it with the frame.
+                        imgutil::image_subtraction<unsigned short, unsigned short>(blur_image, reference_, sub_image);
+                        imgutil::image_interpolation<unsigned short, unsigned short>(reference_, blur_image, new_ref_image, frame_update_ratio_);
+                        reference_ = std::move(new_ref_image);
+                        timer.end_stage(Stage::subtraction);
+                        store_(result, Stage::subtraction, sub_image);
+
+                        timer.skip();
+                        imgutil::double_threshold<unsigned short, unsigned char>(sub_image, thr_image, 5000, 22500);
+                        imgutil::hysteresis<unsigned char, unsigned char>(thr_image, cnt_image);
+                        timer.end_stage(Stage::threshold);
+                        store_(result, Stage::threshold, cnt_image, true);
+
+                        timer.skip();
+                        imgutil::dilation<unsigned char, int>(cnt_image, dil_image);
+                        timer.end_stage(Stage::dilation);
+                        store_(result, Stage::dilation, dil_image, true);
+
+                        // Every contour is kept, holes included, as the library does.
+                        timer.skip();
+                        std::vector<Extended_contour> unfiltered_contours;
+                        imgutil::contour_detection(dil_image, unfiltered_contours);
+                        for(Extended_contour &cont : unfiltered_contours)
+                        {
+                            unsigned int cont_area = (cont.bb_tl_x - cont.bb_br_x) * (cont.bb_tl_y - cont.bb_br_y) * factor_;
+                            if(cont_area > min_cont_area_)
+                                result.boxes.push_back({ cont.bb_tl_x * factor_, cont.bb_tl_y * factor_, cont.bb_br_x * factor_, cont.bb_br_y * factor_ });
+                        }
+                        timer.end_stage(Stage::contours);
+                        result.has_boxes = true;
+                    }
+                    else
+                    {
+                        reference_ = std::move(blur_image);
+                        has_reference_ = true;
+                    }
+
+                    if(detector_)
+                    {
+                        detector_->enqueue_frame(std::make_unique<Image<unsigned short>>(frame, w_), timestamp_, true);
+                        timestamp_ += 33;
+                        result.library_checked = true;
+                        result.library_agrees = same_boxes(detector_->get_detection(true).detection_contours, result.boxes);
+                    }
+                }
+
+            private:
+                template <typename T>
+                static void store_(Frame_result &result, const Stage stage, const Image<T> &image, const bool binary = false)
+                {
+                    store_stage(result, stage, image.get_data().data(), image.get_total(), binary);
+                }
+
+                const float frame_update_ratio_ = 0.0067; /**< Default of the library constructor. */
+
+                std::size_t w_, h_, downsampled_w_, downsampled_h_;
+                unsigned int factor_;
+                unsigned int min_cont_area_;
+
+                bool has_reference_ = false;
+                Image<unsigned short> reference_;
+
+                std::unique_ptr<Motion_detector> detector_;
+                unsigned long long timestamp_ = 0;
+            };
+        } // Anonymous namespace
+
+        std::unique_ptr<Pipeline> make_base_pipeline(const std::size_t width, const std::size_t height, const unsigned int factor, const bool check_library)
+        {
+            return std::make_unique<Base_pipeline_>(width, height, factor, check_library);
+        }
+
+    } // namespace diff
+} // namespace motdet
@@ -0,0 +1,80 @@
+#include "compare.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+namespace motdet
+{
+    namespace diff
+    {
+        void accumulate_image_diff(const std::vector<std::uint16_t> &a, const std::vector<std::uint16_t> &b, Image_diff &diff)
+        {
+            if(a.empty() || b.empty()) return;
+
+            std::size_t total = std::min(a.size(), b.size()), differing = 0;
+            for(std::size_t k = 0; k < total; ++k)
+            {
+                unsigned int pix_diff = a[k] > b[k] ? a[k] - b[k] : b[k] - a[k];
+                differing += pix_diff != 0;
+                diff.max_diff = std::max(diff.max_diff, pix_diff);
+            }
+
+            // Images of different sizes count every pixel out of the smaller one as different.
+            differing += std::max(a.size(), b.size()) - total;
+
+            ++diff.frames;
+            diff.pixels += std::max(a.size(), b.size());
+            diff.differing_pixels += differing;
+            diff.differing_frames += differing != 0;
+        }
+
+        void accumulate_box_diff(const std::vector<Box> &a, const std::vector<Box> &b, Box_diff &diff, const double min_iou)
+        {
+            std::vector<std::tuple<double, std::size_t, std::size_t>> pairs; // IoU, box of a, box of b.
+            for(std::size_t i = 0; i < a.size(); ++i)
+            {
+                for(std::size_t j = 0; j < b.size(); ++j)
+                {
+                    double iou = box_iou(a[i], b[j]);
+                    if(iou >= min_iou) pairs.emplace_back(iou, i, j);
+                }
+            }
+            std::sort(pairs.begin(), pairs.end(), [](const auto &p0, const auto &p1){ return std::get<0>(p0) > std::get<0>(p1); });
+
+            std::vector<bool> used_a(a.size(), false), used_b(b.size(), false);
+            std::size_t matched = 0, exact = 0;
+            for(const auto &[iou, i, j] : pairs)
+            {
+                if(used_a[i] || used_b[j]) continue;
+                used_a[i] = used_b[j] = true;
+
+                ++matched;
+                exact += iou == 1;
+                diff.iou_sum += iou;
+            }
+
+            ++diff.frames;
+            diff.boxes_a += a.size();
+            diff.boxes_b += b.size();
+            diff.matched += matched;
+            diff.exact += exact;
+            diff.differing_frames += !(exact == a.size() && exact == b.size());
+        }
+
+        double box_iou(const Box &a, const Box &b)
+        {
+            // Boxes with the corners swapped have no area, and overlap nothing.
+            if(a.br_x < a.tl_x || a.br_y < a.tl_y || b.br_x < b.tl_x || b.br_y < b.tl_y) return 0;
+
+            double inter_w = (double)std::min(a.br_x, b.br_x) - std::max(a.tl_x, b.tl_x) + 1;
+            double inter_h = (double)std::min(a.br_y, b.br_y) - std::max(a.tl_y, b.tl_y) + 1;
+            if(inter_w <= 0 || inter_h <= 0) return 0;
+
+            double area_a = (double)(a.br_x - a.tl_x + 1) * (a.br_y - a.tl_y + 1);
+            double area_b = (double)(b.br_x - b.tl_x + 1) * (b.br_y - b.tl_y + 1);
+            double inter = inter_w * inter_h;
+            return inter / (area_a + area_b - inter);
+        }
+
+    } // namespace diff
+} // namespace motdet
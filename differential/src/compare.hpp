@@ -0,0 +1,58 @@
+#ifndef __MOTDET_DIFF_COMPARE_HPP__
+#define __MOTDET_DIFF_COMPARE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pipeline.hpp"
+
+namespace motdet
+{
+    namespace diff
+    {
+        /**
+         * @brief Differences between the images of a stage of two implementations, accumulated over a sequence.
+         */
+        struct Image_diff
+        {
+            std::size_t frames = 0;           /**< Frames where both implementations produced the image. */
+            std::size_t pixels = 0;           /**< Pixels compared.                                      */
+            std::size_t differing_pixels = 0; /**< Pixels with different values.                         */
+            std::size_t differing_frames = 0; /**< Frames with at least one differing pixel.             */
+            unsigned int max_diff = 0;        /**< Largest absolute difference of a pixel.               */
+        };
+
+        /**
+         * @brief Differences between the boxes of two implementations, accumulated over a sequence.
+         */
+        struct Box_diff
+        {
+            std::size_t frames = 0;           /**< Frames where both implementations produced boxes.      */
+            std::size_t boxes_a = 0, boxes_b = 0;
+            std::size_t matched = 0;          /**< Pairs of boxes overlapping by the minimum IoU or more. */
+            std::size_t exact = 0;            /**< Matched pairs with the very same coordinates.          */
+            std::size_t differing_frames = 0; /**< Frames where the boxes are not exactly the same.       */
+            double iou_sum = 0;               /**< Sum of the IoU of the matched pairs.                   */
+        };
+
+        /**
+         * @brief Adds the comparison of two images of the same size to diff. Does nothing if any of them is empty.
+         */
+        void accumulate_image_diff(const std::vector<std::uint16_t> &a, const std::vector<std::uint16_t> &b, Image_diff &diff);
+
+        /**
+         * @brief Adds the comparison of the boxes of a frame to diff. Boxes are paired greedily from the highest IoU down.
+         * @param min_iou Pairs overlapping less than this are not matched.
+         */
+        void accumulate_box_diff(const std::vector<Box> &a, const std::vector<Box> &b, Box_diff &diff, const double min_iou = 0.5);
+
+        /**
+         * @brief Intersection over union of two boxes. Corners are inclusive.
+         */
+        double box_iou(const Box &a, const Box &b);
+
+    } // namespace diff
+} // namespace motdet
+
+#endif // __MOTDET_DIFF_COMPARE_HPP__
@@ -0,0 +1,143 @@
+#include "pipeline.hpp"
+#include "adapter_utils.hpp"
+
+#include "motion_detector.hpp"
+#include "image_utils.hpp"
+#include "contour_detector.hpp"
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+namespace motdet
+{
+    namespace diff
+    {
+        namespace // Anonymous namespace
+        {
+            /**
+             * @brief Runs the steps of Motion_detector::detect_motion_ of the fast library one by one, with the default
+             * configuration of its constructor.
+             */
+            class Fast_pipeline_ : public Pipeline
+            {
+            public:
+                Fast_pipeline_(const std::size_t width, const std::size_t height, const unsigned int factor, const bool check_library):
+                    w_(width),
+                    h_(height),
+                    factor_(factor),
+                    min_contour_area_(width*height*0.002+5)
+                {
+                    if(width < 10 || height < 10) throw std::invalid_argument("ERROR make_fast_pipeline: width and height must be at least 10.");
+                    if(factor == 0) throw std::invalid_argument("ERROR make_fast_pipeline: factor must be at least 1.");
+
+                    downsampled_w_ = std::ceil((float)w_ / factor_);
+                    downsampled_h_ = std::ceil((float)h_ / factor_);
+
+                    if(check_library) detector_ = std::make_unique<Motion_detector>(w_, h_, 1, 2, factor_, frame_update_ratio_);
+                }
+
+                const char* get_name() const override { return "fast"; }
+
+                void process(const std::vector<std::uint16_t> &frame, Frame_result &result) override
+                {
+                    if(frame.size() != w_*h_) throw std::invalid_argument("ERROR process: The frame does not have the size of the pipeline.");
+                    result = Frame_result();
+                    Stage_timer timer(result);
+
+                    Image<unsigned short> in(frame, w_);
+                    Image<unsigned short> downsampled_in(downsampled_w_, downsampled_h_, uninitialized), blur_image(downsampled_w_, downsampled_h_, uninitialized);
+                    timer.skip();
+
+                    if(factor_ > 1) imgutil::downsample(in, downsampled_in, factor_);
+                    else downsampled_in = std::move(in);
+                    timer.end_stage(Stage::downsample);
+                    store_(result, Stage::downsample, downsampled_in);
+
+                    timer.skip();
+                    imgutil::gaussian_blur_filter(downsampled_in, blur_image);
+                    timer.end_stage(Stage::blur);
+                    store_(result, Stage::blur, blur_image);
+
+                    if(has_reference_)
+                    {
+                        Image<unsigned short> sub_image(downsampled_w_, downsampled_h_, uninitialized), new_ref_image(downsampled_w_, downsampled_h_, uninitialized);
+                        Image<unsigned char> thr_image(downsampled_w_, downsampled_h_, uninitialized), cnt_image(downsampled_w_, downsampled_h_, 0);
+                        Image<unsigned char> dil_image(downsampled_w_, downsampled_h_, uninitialized);
+
+                        // Ratio as computed by enqueue_frame for a frame right after the previous one.
+                        const float update_ratio = 1 - std::pow(1 - frame_update_ratio_, std::size_t(1));
+                        timer.skip();
+
+                        // The fast library subtracts the frame from the old reference while it computes the new one.
+                        imgutil::image_interpolation_and_sub(reference_, blur_image, new_ref_image, sub_image, update_ratio);
+                        reference_ = std::move(new_ref_image);
+                        timer.end_stage(Stage::subtraction);
+                        store_(result, Stage::subtraction, sub_image);
+
+                        timer.skip();
+                        imgutil::double_threshold(sub_image, thr_image, low_threshold_, high_threshold_);
+                        imgutil::hysteresis(thr_image, cnt_image);
+                        timer.end_stage(Stage::threshold);
+                        store_(result, Stage::threshold, cnt_image, true);
+
+                        timer.skip();
+                        imgutil::dilation(cnt_image, dil_image);
+                        timer.end_stage(Stage::dilation);
+                        store_(result, Stage::dilation, dil_image, true);
+
+                        timer.skip();
+                        for(const Contour &raw_cont : imgutil::contour_detection(dil_image, true))
+                        {
+                            unsigned int cont_area = (raw_cont.bb_br_x - raw_cont.bb_tl_x) * (raw_cont.bb_br_y - raw_cont.bb_tl_y) * factor_;
+                            if(cont_area > min_contour_area_)
+                                result.boxes.push_back({ raw_cont.bb_tl_x * factor_, raw_cont.bb_tl_y * factor_, raw_cont.bb_br_x * factor_, raw_cont.bb_br_y * factor_ });
+                        }
+                        timer.end_stage(Stage::contours);
+                        result.has_boxes = true;
+                    }
+                    else
+                    {
+                        reference_ = std::move(blur_image);
+                        has_reference_ = true;
+                    }
+
+                    if(detector_)
+                    {
+                        detector_->enqueue_frame(std::make_unique<Image<unsigned short>>(frame, w_), timestamp_, true);
+                        timestamp_ += 33;
+                        result.library_checked = true;
+                        result.library_agrees = same_boxes(detector_->get_detection(true).detection_contours, result.boxes);
+                    }
+                }
+
+            private:
+                template <typename T>
+                static void store_(Frame_result &result, const Stage stage, const Image<T> &image, const bool binary = false)
+                {
+                    store_stage(result, stage, image.data(), image.get_total(), binary);
+                }
+
+                // Defaults of the library constructor and Detector_config.
+                const float frame_update_ratio_ = 0.0067;
+                const unsigned short low_threshold_ = 5000, high_threshold_ = 22500;
+
+                std::size_t w_, h_, downsampled_w_, downsampled_h_;
+                unsigned int factor_;
+                unsigned int min_contour_area_;
+
+                bool has_reference_ = false;
+                Image<unsigned short> reference_;
+
+                std::unique_ptr<Motion_detector> detector_;
+                unsigned long long timestamp_ = 0;
+            };
+        } // Anonymous namespace
+
+        std::unique_ptr<Pipeline> make_fast_pipeline(const std::size_t width, const std::size_t height, const unsigned int factor, const bool check_library)
+        {
+            return std::make_unique<Fast_pipeline_>(width, height, factor, check_library);
+        }
+
+    } // namespace diff
+} // namespace motdet
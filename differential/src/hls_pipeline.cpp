@@ -0,0 +1,160 @@
+#include "pipeline.hpp"
+#include "adapter_utils.hpp"
+
+#include "motion_detector.hpp"
+#include "image_utils.hpp"
+#include "contour_detector.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace motdet
+{
+    namespace diff
+    {
+        namespace // Anonymous namespace
+        {
+            std::atomic<bool> hls_pipeline_exists(false);
+
+            /**
+             * @brief Runs the processes of detect_motion of the IP core one after the other, keeping the stream between
+             * every pair of them.
+             */
+            class Hls_pipeline_ : public Pipeline
+            {
+            public:
+                Hls_pipeline_()
+                {
+                    if(hls_pipeline_exists.exchange(true)) throw std::runtime_error("ERROR make_hls_pipeline: Only one HLS pipeline can exist at a time.");
+                    imgutil::reset_reference<Top_config>();
+                }
+
+                ~Hls_pipeline_() { hls_pipeline_exists = false; }
+
+                const char* get_name() const override { return "hls"; }
+
+                void process(const std::vector<std::uint16_t> &frame, Frame_result &result) override
+                {
+                    if(frame.size() != Top_config::original_total) throw std::invalid_argument("ERROR process: The frame does not have the size of the pipeline.");
+                    result = Frame_result();
+                    Stage_timer timer(result);
+
+                    // Pack the pixels as the DMA of the testbench does, one group of a row per beat.
+                    std::vector<Packed_pix> in(Top_config::original_total/Top_config::beat_pixels);
+                    for(std::size_t k = 0; k < in.size(); ++k)
+                        for(std::size_t p = 0; p < Top_config::beat_pixels; ++p) in[k].pix[p] = frame[k*Top_config::beat_pixels + p];
+                    timer.skip();
+
+                    std::vector<Pix_vec> downsampled = run_process_<Packed_pix, Pix_vec>(imgutil::downsample<Top_config>, in);
+                    timer.end_stage(Stage::downsample);
+                    store_vec_stage_(result, Stage::downsample, downsampled);
+
+                    timer.skip();
+                    std::vector<Pix_vec> blurred = run_process_<Pix_vec, Pix_vec>(imgutil::gaussian_blur<Top_config>, downsampled);
+                    timer.end_stage(Stage::blur);
+                    store_vec_stage_(result, Stage::blur, blurred);
+
+                    // The IP core runs every stage on the first frame too, against a reference equal to the frame itself.
+                    // Its outputs are dropped so that every implementation is compared from the second frame on.
+                    timer.skip();
+                    std::vector<Pix_vec> subbed = run_process_<Pix_vec, Pix_vec>(apply_reference_, blurred);
+                    timer.end_stage(Stage::subtraction);
+
+                    timer.skip();
+                    std::vector<Bin_vec> thresholded = run_process_<Pix_vec, Bin_vec>(imgutil::single_threshold<Top_config>, subbed);
+                    timer.end_stage(Stage::threshold);
+
+                    timer.skip();
+                    std::vector<Bin_vec> dilated = run_process_<Bin_vec, Bin_vec>(imgutil::dilation<Top_config>, thresholded);
+                    timer.end_stage(Stage::dilation);
+
+                    timer.skip();
+                    std::vector<Box> boxes = detect_contours_(dilated);
+                    timer.end_stage(Stage::contours);
+
+                    if(has_reference_)
+                    {
+                        store_vec_stage_(result, Stage::subtraction, subbed);
+                        store_vec_stage_(result, Stage::threshold, thresholded);
+                        store_vec_stage_(result, Stage::dilation, dilated);
+                        result.boxes = std::move(boxes);
+                        result.has_boxes = true;
+                    }
+                    else for(std::size_t s = (std::size_t)Stage::subtraction; s < stage_count; ++s) result.stage_ms[s] = 0;
+                    has_reference_ = true;
+                }
+
+            private:
+                // The on-chip reference of the single camera the IP core is compared on.
+                static void apply_reference_(hls::stream<Pix_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<Pix_vec, MOTDET_STREAM_DEPTH> &out)
+                {
+                    imgutil::apply_reference<Top_config>(in, out, 0);
+                }
+
+                /**
+                 * @brief Runs a process of the IP core on a whole frame, feeding its input from another thread as the
+                 * previous process of the dataflow region would.
+                 * @return Every transaction the process wrote, in the downsampled resolution.
+                 */
+                template <typename IN_T, typename OUT_T>
+                static std::vector<OUT_T> run_process_(void (*process)(hls::stream<IN_T, MOTDET_STREAM_DEPTH>&, hls::stream<OUT_T, MOTDET_STREAM_DEPTH>&),
+                                                       const std::vector<IN_T> &in)
+                {
+                    hls::stream<IN_T, MOTDET_STREAM_DEPTH> in_stream("in");
+                    hls::stream<OUT_T, MOTDET_STREAM_DEPTH> out_stream("out");
+                    std::vector<OUT_T> out(Top_config::total/Top_config::pixels_per_clock);
+                    {
+                        hls_emu::Dataflow region;
+                        region.process([&](){ for(const IN_T &val : in) in_stream.write(val); });
+                        region.process([&](){ process(in_stream, out_stream); });
+                        for(OUT_T &val : out) out_stream.read(val);
+                    }
+                    return out;
+                }
+
+                /**
+                 * @brief Stores an image streamed in vectors of pixels, Pix_vec or Bin_vec, as the result of a stage.
+                 */
+                template <typename VEC_T>
+                static void store_vec_stage_(Frame_result &result, const Stage stage, const std::vector<VEC_T> &vecs)
+                {
+                    std::vector<long long> pixels;
+                    pixels.reserve(vecs.size()*Top_config::pixels_per_clock);
+                    for(const VEC_T &vec : vecs)
+                        for(std::size_t p = 0; p < Top_config::pixels_per_clock; ++p) pixels.push_back(vec.pix[p]);
+                    store_stage(result, stage, pixels.data(), pixels.size());
+                }
+
+                static std::vector<Box> detect_contours_(const std::vector<Bin_vec> &in)
+                {
+                    hls::stream<Bin_vec, MOTDET_STREAM_DEPTH> in_stream("in");
+                    hls::stream<Bin_vec, MOTDET_STREAM_DEPTH> active_stream("active");
+                    hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> active_rows("active_rows");
+                    hls::stream<Streamed_contour, MOTDET_STREAM_DEPTH> out_stream("out");
+                    std::vector<Box> boxes;
+                    {
+                        // The dilation stage is compared on the whole image, the row summary is added here as the IP core does.
+                        hls_emu::Dataflow region;
+                        region.process([&](){ for(const Bin_vec &val : in) in_stream.write(val); });
+                        region.process([&](){ imgutil::summarize_rows<Top_config>(in_stream, active_stream, active_rows); });
+                        region.process([&](){ imgutil::connected_components<Top_config>(active_stream, active_rows, out_stream); });
+                        for(Streamed_contour cont = out_stream.read(); !cont.stream_end; cont = out_stream.read())
+                            boxes.push_back({ cont.contour.bb_tl_x.to_uint64(), cont.contour.bb_tl_y.to_uint64(), cont.contour.bb_br_x.to_uint64(), cont.contour.bb_br_y.to_uint64() });
+                    }
+                    return boxes;
+                }
+
+                bool has_reference_ = false;
+            };
+        } // Anonymous namespace
+
+        std::unique_ptr<Pipeline> make_hls_pipeline(const std::size_t width, const std::size_t height, const unsigned int factor)
+        {
+            if(width != Top_config::original_width || height != Top_config::original_height || factor != Top_config::reduction_factor)
+                throw std::invalid_argument("ERROR make_hls_pipeline: The IP core is built for the resolution and factor of motdet::Top_config.");
+            return std::make_unique<Hls_pipeline_>();
+        }
+
+    } // namespace diff
+} // namespace motdet
@@ -0,0 +1,263 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+#include "pipeline.hpp"
+#include "sequence.hpp"
+#include "compare.hpp"
+
+namespace md = motdet::diff; // Rename namespaces for convenience.
+
+// Resolution and factor of the HLS IP core, the CPU libraries are run with the same ones.
+const std::size_t width = 1920, height = 1080;
+const unsigned int factor = 4;
+
+/**
+ * @brief A stage that two implementations must produce exactly the same for, given in the command line.
+ */
+struct Expectation
+{
+    std::size_t a, b; /**< Indices of the implementations. */
+    md::Stage stage;
+    std::string text; /**< As written in the command line. */
+};
+
+/**
+ * @brief Everything compared over the sequence of a scene.
+ */
+struct Scene_report
+{
+    std::vector<std::vector<md::Image_diff>> image_diffs; /**< Per pair of implementations, per image stage. */
+    std::vector<md::Box_diff> box_diffs;                  /**< Per pair of implementations.                   */
+    std::vector<std::vector<double>> stage_ms;            /**< Per implementation, per stage, summed.         */
+    std::vector<std::vector<std::size_t>> stage_frames;   /**< Per implementation, per stage, frames timed.   */
+    std::vector<std::size_t> library_checks, library_mismatches; /**< Per implementation.                    */
+};
+
+const char *impl_names[] = { "base", "fast", "hls" };
+const std::size_t impl_count = 3;
+
+std::vector<std::pair<std::size_t, std::size_t>> make_pairs()
+{
+    std::vector<std::pair<std::size_t, std::size_t>> pairs;
+    for(std::size_t a = 0; a < impl_count; ++a)
+        for(std::size_t b = a + 1; b < impl_count; ++b) pairs.emplace_back(a, b);
+    return pairs;
+}
+
+std::size_t find_impl(const std::string &name)
+{
+    for(std::size_t k = 0; k < impl_count; ++k) if(name == impl_names[k]) return k;
+    throw std::invalid_argument("Unknown implementation '" + name + "', use base, fast or hls.");
+}
+
+md::Stage find_stage(const std::string &name)
+{
+    for(std::size_t s = 0; s < md::stage_count; ++s) if(name == md::stage_name((md::Stage)s)) return (md::Stage)s;
+    throw std::invalid_argument("Unknown stage '" + name + "'.");
+}
+
+/**
+ * @brief Parses "a-b:stage,stage...", adding one expectation per stage.
+ */
+void parse_expectation(const std::string &text, std::vector<Expectation> &expectations)
+{
+    std::size_t dash = text.find('-'), colon = text.find(':');
+    if(dash == std::string::npos || colon == std::string::npos || dash > colon) throw std::invalid_argument("Expectations are written as impl-impl:stage[,stage...], got '" + text + "'.");
+
+    std::size_t a = find_impl(text.substr(0, dash)), b = find_impl(text.substr(dash + 1, colon - dash - 1));
+    if(a == b) throw std::invalid_argument("An expectation needs two different implementations, got '" + text + "'.");
+    if(a > b) std::swap(a, b);
+
+    for(std::size_t begin = colon + 1; begin <= text.size();)
+    {
+        std::size_t end = std::min(text.find(',', begin), text.size());
+        expectations.push_back({ a, b, find_stage(text.substr(begin, end - begin)), text });
+        begin = end + 1;
+    }
+}
+
+/**
+ * @brief Feeds the sequence of a scene to every implementation, comparing the output of every stage frame by frame.
+ */
+Scene_report run_scene(const md::Scene scene, const std::size_t frame_count)
+{
+    // Pipelines are made again for every scene, so every one starts without reference.
+    std::vector<std::unique_ptr<md::Pipeline>> pipelines;
+    pipelines.push_back(md::make_base_pipeline(width, height, factor, true));
+    pipelines.push_back(md::make_fast_pipeline(width, height, factor, true));
+    pipelines.push_back(md::make_hls_pipeline(width, height, factor));
+
+    auto pairs = make_pairs();
+    Scene_report report;
+    report.image_diffs.assign(pairs.size(), std::vector<md::Image_diff>(md::image_stage_count));
+    report.box_diffs.assign(pairs.size(), md::Box_diff());
+    report.stage_ms.assign(impl_count, std::vector<double>(md::stage_count, 0));
+    report.stage_frames.assign(impl_count, std::vector<std::size_t>(md::stage_count, 0));
+    report.library_checks.assign(impl_count, 0);
+    report.library_mismatches.assign(impl_count, 0);
+
+    std::vector<md::Frame_result> results(impl_count);
+    for(std::size_t f = 0; f < frame_count; ++f)
+    {
+        std::vector<std::uint16_t> frame = md::make_frame(scene, f, frame_count, width, height);
+
+        for(std::size_t k = 0; k < impl_count; ++k)
+        {
+            md::Frame_result &result = results[k];
+            pipelines[k]->process(frame, result);
+
+            // Stages not run in this frame are not timed.
+            for(std::size_t s = 0; s < md::stage_count; ++s)
+            {
+                bool ran = s < md::image_stage_count ? !result.images[s].empty() : result.has_boxes;
+                if(!ran) continue;
+                report.stage_ms[k][s] += result.stage_ms[s];
+                ++report.stage_frames[k][s];
+            }
+            report.library_checks[k] += result.library_checked;
+            report.library_mismatches[k] += !result.library_agrees;
+        }
+
+        for(std::size_t p = 0; p < pairs.size(); ++p)
+        {
+            const md::Frame_result &a = results[pairs[p].first], &b = results[pairs[p].second];
+            for(std::size_t s = 0; s < md::image_stage_count; ++s) md::accumulate_image_diff(a.images[s], b.images[s], report.image_diffs[p][s]);
+            if(a.has_boxes && b.has_boxes) md::accumulate_box_diff(a.boxes, b.boxes, report.box_diffs[p]);
+        }
+    }
+
+    return report;
+}
+
+void print_report(const Scene_report &report)
+{
+    auto pairs = make_pairs();
+
+    std::cout << "  Differing pixels per stage (frames with differences, largest difference):" << std::endl;
+    std::cout << "    " << std::left << std::setw(13) << "stage";
+    for(auto &pair : pairs) std::cout << std::setw(32) << (std::string(impl_names[pair.first]) + "-" + impl_names[pair.second]);
+    std::cout << std::endl;
+
+    for(std::size_t s = 0; s < md::image_stage_count; ++s)
+    {
+        std::cout << "    " << std::setw(13) << md::stage_name((md::Stage)s);
+        for(std::size_t p = 0; p < pairs.size(); ++p)
+        {
+            const md::Image_diff &diff = report.image_diffs[p][s];
+            std::ostringstream cell;
+            cell << diff.differing_pixels << "/" << diff.pixels << " (" << diff.differing_frames << "/" << diff.frames << ", " << diff.max_diff << ")";
+            std::cout << std::setw(32) << cell.str();
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "  Boxes (boxes of each, matched with IoU >= 0.5, exact, mean IoU, frames with differences):" << std::endl;
+    for(std::size_t p = 0; p < pairs.size(); ++p)
+    {
+        const md::Box_diff &diff = report.box_diffs[p];
+        std::cout << "    " << std::setw(13) << (std::string(impl_names[pairs[p].first]) + "-" + impl_names[pairs[p].second])
+                  << diff.boxes_a << " vs " << diff.boxes_b << ", " << diff.matched << " matched, " << diff.exact << " exact, mean IoU "
+                  << std::fixed << std::setprecision(3) << (diff.matched ? diff.iou_sum / diff.matched : 0) << ", "
+                  << diff.differing_frames << "/" << diff.frames << " frames" << std::endl;
+    }
+
+    std::cout << "  Mean time per frame in ms (hls is the C++ model, not the hardware):" << std::endl;
+    std::cout << "    " << std::setw(13) << "stage";
+    for(std::size_t k = 0; k < impl_count; ++k) std::cout << std::setw(10) << impl_names[k];
+    std::cout << std::endl;
+    std::vector<double> totals(impl_count, 0);
+    for(std::size_t s = 0; s < md::stage_count; ++s)
+    {
+        std::cout << "    " << std::setw(13) << md::stage_name((md::Stage)s);
+        for(std::size_t k = 0; k < impl_count; ++k)
+        {
+            double mean = report.stage_frames[k][s] ? report.stage_ms[k][s] / report.stage_frames[k][s] : 0;
+            totals[k] += mean;
+            std::cout << std::setw(10) << std::fixed << std::setprecision(2) << mean;
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "    " << std::setw(13) << "total";
+    for(std::size_t k = 0; k < impl_count; ++k) std::cout << std::setw(10) << totals[k];
+    std::cout << std::endl;
+
+    for(std::size_t k = 0; k < impl_count; ++k)
+    {
+        if(report.library_checks[k] == 0) continue;
+        std::cout << "  " << impl_names[k] << ": stage by stage boxes differ from its Motion_detector in " << report.library_mismatches[k]
+                  << "/" << report.library_checks[k] << " frames" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t frame_count = 30;
+    std::vector<md::Scene> scenes;
+    std::vector<Expectation> expectations;
+
+    for(int a = 1; a < argc; ++a)
+    {
+        std::string arg(argv[a]);
+        md::Scene scene;
+
+        if(arg == "-h" || arg == "--help")
+        {
+            std::cout <<
+            "Feeds the same synthetic sequences to the base and fast libraries and the HLS IP core, and compares every stage." << std::endl <<
+            "Every parameter is optional and can be given in any order: " << std::endl <<
+            " - frames : Length of every sequence, 30 by default." << std::endl <<
+            " - scene : 'objects', 'lighting' or 'noise'. Can be repeated. Every scene by default." << std::endl <<
+            " - impl-impl:stage[,stage...] : Stages two implementations must produce exactly the same, i.e. fast-hls:downsample." << std::endl <<
+            "   Stages are downsample, blur, subtraction, threshold, dilation and contours. The program exits with 1 if any differs." << std::endl;
+            return 0;
+        }
+        else if(md::parse_scene(arg, scene)) scenes.push_back(scene);
+        else if(arg.find(':') != std::string::npos) parse_expectation(arg, expectations);
+        else
+        {
+            try { frame_count = std::stoul(arg); }
+            catch(const std::exception &e) { throw std::invalid_argument("Unknown parameter '" + arg + "', see --help."); }
+            if(frame_count < 2) throw std::invalid_argument("At least 2 frames are needed, the first one only sets the reference.");
+        }
+    }
+    if(scenes.empty()) for(std::size_t s = 0; s < md::scene_count; ++s) scenes.push_back((md::Scene)s);
+
+    auto pairs = make_pairs();
+    bool failed = false;
+
+    for(md::Scene scene : scenes)
+    {
+        std::cout << "Scene '" << md::scene_name(scene) << "', " << frame_count << " frames of " << width << "x" << height << ", factor " << factor << std::endl;
+        Scene_report report = run_scene(scene, frame_count);
+        print_report(report);
+
+        for(std::size_t k = 0; k < impl_count; ++k)
+        {
+            if(report.library_mismatches[k] == 0) continue;
+            std::cout << "  FAILED: The " << impl_names[k] << " pipeline does not match its library, the harness is out of date." << std::endl;
+            failed = true;
+        }
+
+        for(const Expectation &exp : expectations)
+        {
+            std::size_t p = 0;
+            while(pairs[p].first != exp.a || pairs[p].second != exp.b) ++p;
+
+            bool equal = exp.stage == md::Stage::contours ? report.box_diffs[p].differing_frames == 0
+                                                          : report.image_diffs[p][(std::size_t)exp.stage].differing_pixels == 0;
+            if(equal) continue;
+            std::cout << "  FAILED: " << impl_names[exp.a] << " and " << impl_names[exp.b] << " differ in " << md::stage_name(exp.stage) << " (" << exp.text << ")" << std::endl;
+            failed = true;
+        }
+        std::cout << std::endl;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+#include "sequence.hpp"
+
+#include <algorithm>
+
+namespace motdet
+{
+    namespace diff
+    {
+        namespace // Anonymous namespace
+        {
+            /**
+             * @brief Integer hash, used as a noise source that does not depend on the order in which pixels are made.
+             */
+            std::uint32_t hash_(std::uint32_t x)
+            {
+                x ^= x >> 16;
+                x *= 0x7feb352d;
+                x ^= x >> 15;
+                x *= 0x846ca68b;
+                x ^= x >> 16;
+                return x;
+            }
+
+            /**
+             * @brief Sets a rectangle to a value, clipped to the frame. Coordinates can be negative or out of the frame.
+             */
+            void fill_rect_(std::vector<int> &frame, const std::size_t width, const std::size_t height, const long x, const long y, const long w, const long h, const int value)
+            {
+                long x0 = std::max(x, 0L), y0 = std::max(y, 0L);
+                long x1 = std::min(x + w, (long)width), y1 = std::min(y + h, (long)height);
+                for(long i = y0; i < y1; ++i)
+                    for(long j = x0; j < x1; ++j) frame[i*width + j] = value;
+            }
+        } // Anonymous namespace
+
+        const char* scene_name(const Scene scene)
+        {
+            switch(scene)
+            {
+                case Scene::objects:  return "objects";
+                case Scene::lighting: return "lighting";
+                case Scene::noise:    return "noise";
+            }
+            return "";
+        }
+
+        bool parse_scene(const std::string &name, Scene &scene)
+        {
+            for(std::size_t s = 0; s < scene_count; ++s)
+            {
+                if(name == scene_name((Scene)s))
+                {
+                    scene = (Scene)s;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::vector<std::uint16_t> make_frame(const Scene scene, const std::size_t index, const std::size_t frame_count, const std::size_t width, const std::size_t height)
+        {
+            std::vector<int> frame(width*height);
+
+            // Static background: gradient plus fine texture, so that blur and downsampling have something to round.
+            for(std::size_t i = 0; i < height; ++i)
+                for(std::size_t j = 0; j < width; ++j)
+                    frame[i*width + j] = 18000 + 12000*j/width + 6000*i/height + (int)(hash_(i*width + j) & 2047) - 1024;
+
+            // Moving objects, sizes and speeds relative to the frame so that any resolution works.
+            const long t = index;
+            const long w = width, h = height;
+            fill_rect_(frame, width, height, w/20 + t*w/64, h/4, w/12, h/9, 52000);
+            fill_rect_(frame, width, height, w*3/4 - t*w/96, h/10 + t*h/60, w/20, w/20, 4000);
+
+            if(scene == Scene::lighting)
+            {
+                // Global brightening of up to 60%, plus a region lit all at once halfway through.
+                const float gain = 1 + 0.6f*index/std::max<std::size_t>(frame_count, 1);
+                for(int &pix : frame) pix *= gain;
+                if(index >= frame_count/2)
+                {
+                    for(std::size_t i = h*2/3; i < height; ++i)
+                        for(std::size_t j = 0; j < width/3; ++j) frame[i*width + j] += 20000;
+                }
+            }
+            else if(scene == Scene::noise)
+            {
+                for(std::size_t k = 0; k < frame.size(); ++k)
+                {
+                    std::uint32_t rnd = hash_(k ^ hash_(index + 1));
+                    if(rnd % 500 == 0) frame[k] = rnd & 0x10000 ? 65535 : 0;
+                    else frame[k] += (int)(rnd >> 20) - 2048;
+                }
+            }
+
+            std::vector<std::uint16_t> out(frame.size());
+            for(std::size_t k = 0; k < frame.size(); ++k) out[k] = std::clamp(frame[k], 0, 65535);
+            return out;
+        }
+
+    } // namespace diff
+} // namespace motdet
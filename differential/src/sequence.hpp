@@ -0,0 +1,48 @@
+#ifndef __MOTDET_DIFF_SEQUENCE_HPP__
+#define __MOTDET_DIFF_SEQUENCE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace motdet
+{
+    namespace diff
+    {
+        /**
+         * @brief Synthetic scenes fed to the implementations. Every one has a textured static background and two objects,
+         * a bright and a dark one, moving at different speeds and leaving the frame partially.
+         */
+        enum class Scene
+        {
+            objects,  /**< Only the moving objects.                                                                    */
+            lighting, /**< The whole scene slowly brightens, and a region is suddenly lit halfway through the sequence. */
+            noise     /**< Sensor noise that changes every frame, plus salt and pepper impulses.                        */
+        };
+
+        const std::size_t scene_count = 3;
+
+        /**
+         * @brief Name of a scene, as accepted by parse_scene.
+         */
+        const char* scene_name(const Scene scene);
+
+        /**
+         * @brief Gets the scene with the given name.
+         * @return true if the name is the one of a scene.
+         */
+        bool parse_scene(const std::string &name, Scene &scene);
+
+        /**
+         * @brief Generates a frame of a scene. The same arguments always give the same frame.
+         * @param index Position of the frame in the sequence, from 0.
+         * @param frame_count Length of the sequence, the lighting scene spreads its changes over it.
+         * @return Grayscale frame, row major.
+         */
+        std::vector<std::uint16_t> make_frame(const Scene scene, const std::size_t index, const std::size_t frame_count, const std::size_t width, const std::size_t height);
+
+    } // namespace diff
+} // namespace motdet
+
+#endif // __MOTDET_DIFF_SEQUENCE_HPP__
@@ -0,0 +1,301 @@
+#ifndef __MOTDET_FRONTEND_HPP__
+#define __MOTDET_FRONTEND_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The base and fast libraries and the HLS IP core define the same types and functions in the motdet namespace, so they
+// can not be linked into a single program. Each backend is built into its own shared library with hidden visibility, and
+// only the types in this header, which use no motdet type, cross between them and the front end.
+#define MOTDET_FRONT_API __attribute__((visibility("default")))
+
+namespace motdet
+{
+    namespace front
+    {
+        /**
+         * @brief Implementations a Motion_detector can run on.
+         */
+        enum class Backend_kind : std::size_t
+        {
+            base,           /**< Generic base library, cpu/libraries/base.                                                   */
+            fast_scalar,    /**< Fast library built without autovectorization, frame parallel.                             */
+            fast_simd,      /**< Fast library as it is normally built, autovectorized, frame parallel.                     */
+            fast_pipeline,  /**< Fast library with its stage pipeline executor, see Motion_detector::set_executor.          */
+            hls_emulated    /**< HLS IP core driven through hls/driver, with the emulated transport.                       */
+        };
+
+        const std::size_t backend_kind_count = 5;
+
+        /**
+         * @brief Name of a backend, as written in configuration files and reports.
+         */
+        inline const char* backend_name(const Backend_kind kind)
+        {
+            static const char *names[backend_kind_count] = { "base", "fast-scalar", "fast-simd", "fast-pipeline", "hls-emulated" };
+            return names[(std::size_t)kind];
+        }
+
+        /**
+         * @brief Backend of a name given by backend_name.
+         * @throw invalid_argument if no backend has that name.
+         */
+        MOTDET_FRONT_API Backend_kind parse_backend(const std::string &name);
+
+        /**
+         * @brief Parses a comma separated list of backend names, such as "hls-emulated,fast-simd", in order of preference.
+         * @throw invalid_argument if a name is unknown or the list is empty.
+         */
+        MOTDET_FRONT_API std::vector<Backend_kind> parse_backend_list(const std::string &names);
+
+        /**
+         * @brief Bounding box of a detected movement, in pixels of the original frame.
+         */
+        struct Box
+        {
+            std::size_t tl_x, tl_y; /**< Top left point of the bounding box     */
+            std::size_t br_x, br_y; /**< Bottom right point of the bounding box */
+        };
+
+        /**
+         * @brief Container for all the relevant info to return as a result when a frame is checked for movement.
+         */
+        struct Detection
+        {
+            unsigned long long timestamp;       /**< The timestamp of the video the motion was detected from */
+            bool has_detections;                /**< True if motion has been detected                        */
+            std::vector<Box> detection_boxes;   /**< Bounding boxes of the detected movements                */
+            unsigned long long processing_time; /**< Time it took the frame to be processed, in milliseconds  */
+
+            std::shared_ptr<void> data_keep; /**< Will point at NULL if no data_keep was sent when enqueueing */
+        };
+
+        /**
+         * @brief Parameters of a detector, with the same meaning and defaults as in the constructor of the CPU libraries.
+         */
+        struct Detector_params
+        {
+            std::size_t width = 0;
+            std::size_t height = 0;
+            unsigned int threads = 1;                /**< Ignored by the stage pipeline and the IP core.                 */
+            std::size_t queue_size = 2;              /**< Frame buffers of the transport, for the IP core.               */
+            unsigned int downsample_factor = 1;
+            float frame_update_ratio = 0.0067;
+        };
+
+        class Backend;
+
+        /**
+         * @brief Grayscale frame of width*height pixels, row major, in the storage of the backend that made it.
+         * @details Made by Motion_detector::make_frame and filled by the producer, it is handed over to the backend
+         * without copying the pixels, as the fast library keeps its rows aligned with its own allocator.
+         */
+        class MOTDET_FRONT_API Frame
+        {
+        public:
+            virtual ~Frame() = default;
+
+            /**
+             * @brief Get a pointer to the first pixel.
+             * @return std::uint16_t*
+             */
+            virtual std::uint16_t* data() = 0;
+
+            /**
+             * @brief Get the pixel count.
+             * @return std::size_t
+             */
+            virtual std::size_t size() const = 0;
+
+            /**
+             * @brief Get the backend that made the frame, the only one it can be enqueued to.
+             * @return const Backend*
+             */
+            virtual const Backend* get_backend() const = 0;
+        };
+
+        /**
+         * @brief One implementation of the motion detector, behind the interface the CPU libraries share.
+         * @details The implementations differ by design, see differential/README.md, so the boxes found for the same
+         * frames may differ slightly from one backend to another.
+         */
+        class MOTDET_FRONT_API Backend
+        {
+        public:
+            virtual ~Backend() = default;
+
+            /**
+             * @brief Get the kind of the backend.
+             * @return Backend_kind
+             */
+            virtual Backend_kind get_kind() const = 0;
+
+            /**
+             * @brief Enqueues a grayscale frame of width*height pixels, see Motion_detector::enqueue_frame.
+             */
+            virtual void enqueue_frame(std::unique_ptr<std::vector<std::uint16_t>> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep) = 0;
+
+            /**
+             * @brief Makes a frame of width*height pixels of unspecified value, to be filled and enqueued to this backend.
+             */
+            virtual std::unique_ptr<Frame> make_frame() = 0;
+
+            /**
+             * @brief Enqueues a frame made by make_frame, without copying its pixels on the CPU libraries.
+             * @throw invalid_argument if the frame was made by another backend.
+             */
+            virtual void enqueue_frame(std::unique_ptr<Frame> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep) = 0;
+
+            /**
+             * @brief Gets the detection of the oldest frame enqueued, see Motion_detector::get_detection.
+             */
+            virtual Detection get_detection(bool blocking) = 0;
+
+            /**
+             * @brief Returns whether the oldest frame enqueued has been processed.
+             */
+            virtual bool is_frame_ready() const = 0;
+        };
+
+        /**
+         * @brief Backend of the generic base library.
+         * @throw invalid_argument if the library refuses the parameters.
+         */
+        MOTDET_FRONT_API std::unique_ptr<Backend> make_base_backend(const Detector_params &params);
+
+        /**
+         * @brief Backend of the fast library, autovectorized, either frame parallel or with the stage pipeline executor.
+         * @param kind Backend_kind::fast_simd or Backend_kind::fast_pipeline.
+         * @throw invalid_argument if the library refuses the parameters or kind is another one.
+         */
+        MOTDET_FRONT_API std::unique_ptr<Backend> make_fast_backend(const Detector_params &params, const Backend_kind kind);
+
+        /**
+         * @brief Backend of the fast library built without autovectorization, frame parallel.
+         * @throw invalid_argument if the library refuses the parameters.
+         */
+        MOTDET_FRONT_API std::unique_ptr<Backend> make_fast_scalar_backend(const Detector_params &params);
+
+        /**
+         * @brief Backend of the HLS IP core with the emulated transport of hls/driver, double buffered by default.
+         * @details The IP core is generated for a resolution, downsample factor and update ratio, and only one emulated
+         * core can exist at a time.
+         * @throw invalid_argument if the parameters are not the ones the IP core is built for, or queue_size == 0.
+         * @throw runtime_error if another emulated core exists.
+         */
+        MOTDET_FRONT_API std::unique_ptr<Backend> make_hls_backend(const Detector_params &params);
+
+        /**
+         * @brief Configuration of a Motion_detector, the backends to try and the parameters to make them with.
+         */
+        struct Frontend_config
+        {
+            std::vector<Backend_kind> backends = { Backend_kind::fast_simd }; /**< In order of preference. */
+            Detector_params params;
+        };
+
+        /**
+         * @brief Single entry point to every implementation of the motion detector. The backend is chosen when the
+         * detector is made, from a list in order of preference: the first one that can be made with the parameters is
+         * used, so a camera can be moved to another backend, or fall back to the CPU, by changing its configuration only.
+         * @details The calls are forwarded to the backend as they are, with its threading and blocking behaviour.
+         */
+        class MOTDET_FRONT_API Motion_detector
+        {
+        public:
+            /**
+             * @brief Constructor. Makes the first backend of the configuration that can be made.
+             * @param config Backends to try and their parameters.
+             * @throw invalid_argument if config.backends is empty.
+             * @throw runtime_error if no backend can be made, with the reason of each one.
+             */
+            explicit Motion_detector(const Frontend_config &config);
+
+            Motion_detector(const Motion_detector &other) = delete;
+            Motion_detector& operator=(const Motion_detector &other) = delete;
+
+            /**
+             * @brief Makes a backend, without falling back to any other.
+             * @throw invalid_argument or runtime_error as the factory of the backend does.
+             */
+            static std::unique_ptr<Backend> make_backend(const Backend_kind kind, const Detector_params &params);
+
+            // Getters
+
+            /**
+             * @brief Get the kind of the backend in use.
+             * @return Backend_kind
+             */
+            Backend_kind get_backend() const { return backend_->get_kind(); }
+
+            /**
+             * @brief Get the reasons the backends preferred over the one in use could not be made, in order.
+             * @return const std::vector<std::string>&
+             */
+            const std::vector<std::string>& get_fallback_reasons() const { return fallback_reasons_; }
+
+            /**
+             * @brief Get the width
+             * @return std::size_t
+             */
+            std::size_t get_width() const { return params_.width; }
+
+            /**
+             * @brief Get the height
+             * @return std::size_t
+             */
+            std::size_t get_height() const { return params_.height; }
+
+            // General Methods
+
+            /**
+             * @brief Will enqueue a frame to be processed by the backend.
+             * @param in Grayscale image to be processed, width*height pixels, row major. Transfers ownership.
+             * @param timestamp_millis Time in milliseconds of the frame being sent in.
+             * @param blocking If true, will wait for room in the queue of the backend.
+             * @param data_keep Extra info to keep as "metadata" of the inputted frame, is returned as is upon result extraction.
+             * @exception invalid_argument if the frame is NULL or of another resolution, or as the backend throws.
+             * @exception runtime_error as the backend throws.
+             */
+            void enqueue_frame(std::unique_ptr<std::vector<std::uint16_t>> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep = {});
+
+            /**
+             * @brief Makes a frame in the storage of the backend, with pixels of unspecified value. Filling it and
+             * enqueuing it saves the copy the fast library makes of frames given as vectors.
+             * @return std::unique_ptr<Frame>
+             */
+            std::unique_ptr<Frame> make_frame() { return backend_->make_frame(); }
+
+            /**
+             * @brief Will enqueue a frame made by make_frame, see the overload for vectors.
+             * @exception invalid_argument if the frame is NULL or was made by another detector, or as the backend throws.
+             * @exception runtime_error as the backend throws.
+             */
+            void enqueue_frame(std::unique_ptr<Frame> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep = {});
+
+            /**
+             * @brief Gets the detection of the oldest frame enqueued.
+             * @return detection struct with the detected motion.
+             * @exception runtime_error if no result is ready and blocking is set to false.
+             */
+            Detection get_detection(bool blocking) { return backend_->get_detection(blocking); }
+
+            /**
+             * @brief Returns whether the oldest frame enqueued has been processed.
+             * @return true if the detection can be extracted safely with a non blocking get.
+             */
+            bool is_frame_ready() const { return backend_->is_frame_ready(); }
+
+        private:
+            Detector_params params_;
+            std::vector<std::string> fallback_reasons_;
+            std::unique_ptr<Backend> backend_;
+        };
+
+    } // namespace front
+} // namespace motdet
+
+#endif // __MOTDET_FRONTEND_HPP__
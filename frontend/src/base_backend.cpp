@@ -0,0 +1,16 @@
+#include "frontend.hpp"
+
+#include "motion_detector.hpp"
+#include "cpu_backend.hpp"
+
+namespace motdet
+{
+    namespace front
+    {
+        std::unique_ptr<Backend> make_base_backend(const Detector_params &params)
+        {
+            return std::make_unique<Cpu_backend>(Backend_kind::base, params);
+        }
+
+    } // namespace front
+} // namespace motdet
@@ -0,0 +1,107 @@
+#ifndef __MOTDET_FRONT_CPU_BACKEND_HPP__
+#define __MOTDET_FRONT_CPU_BACKEND_HPP__
+
+// Adapter shared by the backends of the CPU libraries, which have the same Motion_detector interface. Header only, it is
+// included after the motion_detector.hpp of one library, and every backend library gets its own hidden copy.
+
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "frontend.hpp"
+
+namespace motdet
+{
+    namespace front
+    {
+        /**
+         * @brief Forwards the calls to the Motion_detector of a CPU library, translating frames and detections.
+         */
+        class Cpu_backend : public Backend
+        {
+        public:
+            Cpu_backend(const Backend_kind kind, const Detector_params &params):
+                kind_(kind),
+                w_(params.width),
+                h_(params.height),
+                detector_(params.width, params.height, params.threads, params.queue_size, params.downsample_factor, params.frame_update_ratio)
+            {}
+
+            /**
+             * @brief Get the detector of the library, to configure it before any frame is enqueued.
+             * @return motdet::Motion_detector&
+             */
+            motdet::Motion_detector& get_detector() { return detector_; }
+
+            Backend_kind get_kind() const override { return kind_; }
+
+            void enqueue_frame(std::unique_ptr<std::vector<std::uint16_t>> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep) override
+            {
+                if(in.get() == NULL) throw std::invalid_argument("ERROR Enqueue: The input image is NULL.");
+
+                // The base library adopts the pixels of the frame. The fast library keeps its rows aligned with another
+                // allocator, so they are copied once, which frames from make_frame avoid.
+                auto image = std::make_unique<Image<unsigned short>>();
+                image->set_data(std::move(*in), w_);
+                detector_.enqueue_frame(std::move(image), timestamp_millis, blocking, std::move(data_keep));
+            }
+
+            std::unique_ptr<Frame> make_frame() override { return std::make_unique<Frame_>(this, w_*h_); }
+
+            void enqueue_frame(std::unique_ptr<Frame> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep) override
+            {
+                if(in.get() == NULL) throw std::invalid_argument("ERROR Enqueue: The input image is NULL.");
+                if(in->get_backend() != this) throw std::invalid_argument("ERROR Enqueue: The frame was made by another backend.");
+
+                // Every library adopts the pixels, the buffer is already of the type it stores them in.
+                auto image = std::make_unique<Image<unsigned short>>();
+                image->set_data(std::move(static_cast<Frame_&>(*in).pixels_), w_);
+                detector_.enqueue_frame(std::move(image), timestamp_millis, blocking, std::move(data_keep));
+            }
+
+            Detection get_detection(bool blocking) override
+            {
+                motdet::Detection det = detector_.get_detection(blocking);
+
+                Detection result;
+                result.timestamp = det.timestamp;
+                result.has_detections = det.has_detections;
+                result.detection_boxes.reserve(det.detection_contours.size());
+                for(const Contour &cont : det.detection_contours) result.detection_boxes.push_back({ cont.bb_tl_x, cont.bb_tl_y, cont.bb_br_x, cont.bb_br_y });
+                result.processing_time = det.processing_time;
+                result.data_keep = std::move(det.data_keep);
+                return result;
+            }
+
+            bool is_frame_ready() const override { return detector_.is_frame_ready(); }
+
+        private:
+            // Storage of the pixels of an Image in the library, with its allocator.
+            using Buffer_ = std::decay_t<decltype(std::declval<const Image<unsigned short>&>().get_data())>;
+
+            /**
+             * @brief Frame whose pixels are already in the storage of the library.
+             */
+            class Frame_ : public Frame
+            {
+            public:
+                Frame_(const Backend *owner, const std::size_t size): owner_(owner), pixels_(size) {}
+
+                std::uint16_t* data() override { return pixels_.data(); }
+                std::size_t size() const override { return pixels_.size(); }
+                const Backend* get_backend() const override { return owner_; }
+
+                const Backend *owner_;
+                Buffer_ pixels_;
+            };
+
+            Backend_kind kind_;
+            std::size_t w_, h_;
+            motdet::Motion_detector detector_;
+        };
+
+    } // namespace front
+} // namespace motdet
+
+#endif // __MOTDET_FRONT_CPU_BACKEND_HPP__
@@ -0,0 +1,30 @@
+#include "frontend.hpp"
+
+#include "motion_detector.hpp"
+#include "cpu_backend.hpp"
+
+// Built twice, see CMakeLists.txt. With MOTDET_FRONT_SCALAR the library is built without autovectorization, and only the
+// scalar factory is defined.
+
+namespace motdet
+{
+    namespace front
+    {
+    #ifdef MOTDET_FRONT_SCALAR
+        std::unique_ptr<Backend> make_fast_scalar_backend(const Detector_params &params)
+        {
+            return std::make_unique<Cpu_backend>(Backend_kind::fast_scalar, params);
+        }
+    #else
+        std::unique_ptr<Backend> make_fast_backend(const Detector_params &params, const Backend_kind kind)
+        {
+            if(kind != Backend_kind::fast_simd && kind != Backend_kind::fast_pipeline) throw std::invalid_argument("ERROR make_fast_backend: The kind is not one of the fast library.");
+
+            auto backend = std::make_unique<Cpu_backend>(kind, params);
+            if(kind == Backend_kind::fast_pipeline) backend->get_detector().set_executor(Executor::stage_pipeline);
+            return backend;
+        }
+    #endif
+
+    } // namespace front
+} // namespace motdet
@@ -0,0 +1,88 @@
+#include "frontend.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace motdet
+{
+    namespace front
+    {
+        Backend_kind parse_backend(const std::string &name)
+        {
+            for(std::size_t k = 0; k < backend_kind_count; ++k)
+                if(name == backend_name((Backend_kind)k)) return (Backend_kind)k;
+
+            throw std::invalid_argument("ERROR parse_backend: Unknown backend " + name + ".");
+        }
+
+        std::vector<Backend_kind> parse_backend_list(const std::string &names)
+        {
+            std::vector<Backend_kind> kinds;
+            std::size_t start = 0;
+            while(true)
+            {
+                std::size_t end = names.find(',', start);
+                kinds.push_back(parse_backend(names.substr(start, end == std::string::npos ? std::string::npos : end - start)));
+                if(end == std::string::npos) return kinds;
+                start = end + 1;
+            }
+        }
+
+        // Motion_detector implementation
+
+        Motion_detector::Motion_detector(const Frontend_config &config):
+            params_(config.params)
+        {
+            if(config.backends.empty()) throw std::invalid_argument("ERROR Constructor: At least one backend is needed.");
+
+            // Every backend refuses the parameters it can not run with by throwing, so the next one is tried.
+            for(const Backend_kind kind : config.backends)
+            {
+                try
+                {
+                    backend_ = make_backend(kind, params_);
+                    return;
+                }
+                catch(const std::exception &e)
+                {
+                    fallback_reasons_.push_back(std::string(backend_name(kind)) + ": " + e.what());
+                }
+            }
+
+            std::string reasons;
+            for(const std::string &reason : fallback_reasons_) reasons += " " + reason;
+            throw std::runtime_error("ERROR Constructor: No backend could be made." + reasons);
+        }
+
+        std::unique_ptr<Backend> Motion_detector::make_backend(const Backend_kind kind, const Detector_params &params)
+        {
+            switch(kind)
+            {
+                case Backend_kind::base:          return make_base_backend(params);
+                case Backend_kind::fast_scalar:   return make_fast_scalar_backend(params);
+                case Backend_kind::fast_simd:     return make_fast_backend(params, kind);
+                case Backend_kind::fast_pipeline: return make_fast_backend(params, kind);
+                case Backend_kind::hls_emulated:  return make_hls_backend(params);
+            }
+            throw std::invalid_argument("ERROR make_backend: Unknown backend.");
+        }
+
+        void Motion_detector::enqueue_frame(std::unique_ptr<std::vector<std::uint16_t>> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep)
+        {
+            // Checked here so that every backend refuses the same frames.
+            if(in.get() == NULL) throw std::invalid_argument("ERROR Enqueue: The input image is NULL.");
+            if(in->size() != params_.width * params_.height) throw std::invalid_argument("ERROR Enqueue: Wrong resolution.");
+
+            backend_->enqueue_frame(std::move(in), timestamp_millis, blocking, std::move(data_keep));
+        }
+
+        void Motion_detector::enqueue_frame(std::unique_ptr<Frame> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep)
+        {
+            if(in.get() == NULL) throw std::invalid_argument("ERROR Enqueue: The input image is NULL.");
+            if(in->get_backend() != backend_.get()) throw std::invalid_argument("ERROR Enqueue: The frame was made by another detector.");
+
+            backend_->enqueue_frame(std::move(in), timestamp_millis, blocking, std::move(data_keep));
+        }
+
+    } // namespace front
+} // namespace motdet
@@ -0,0 +1,98 @@
+#include "frontend.hpp"
+
+#include "hls_motion_detector.hpp"
+
+// Only for the configuration the IP core is built for.
+#include "motion_detector.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace motdet
+{
+    namespace front
+    {
+        namespace // Anonymous namespace
+        {
+            /**
+             * @brief Forwards the calls to the driver of the IP core, translating detections.
+             */
+            class Hls_backend_ : public Backend
+            {
+            public:
+                explicit Hls_backend_(const Detector_params &params):
+                    size_(params.width * params.height),
+                    detector_(fpga::make_emulated_transport(params.queue_size))
+                {}
+
+                Backend_kind get_kind() const override { return Backend_kind::hls_emulated; }
+
+                void enqueue_frame(std::unique_ptr<std::vector<std::uint16_t>> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep) override
+                {
+                    detector_.enqueue_frame(std::move(in), timestamp_millis, blocking, std::move(data_keep));
+                }
+
+                std::unique_ptr<Frame> make_frame() override { return std::make_unique<Frame_>(this, size_); }
+
+                void enqueue_frame(std::unique_ptr<Frame> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep) override
+                {
+                    if(in.get() == NULL) throw std::invalid_argument("ERROR Enqueue: The input image is NULL.");
+                    if(in->get_backend() != this) throw std::invalid_argument("ERROR Enqueue: The frame was made by another backend.");
+
+                    // The driver copies the pixels into the buffer of the transport either way.
+                    enqueue_frame(std::make_unique<std::vector<std::uint16_t>>(std::move(static_cast<Frame_&>(*in).pixels_)), timestamp_millis, blocking, std::move(data_keep));
+                }
+
+                Detection get_detection(bool blocking) override
+                {
+                    fpga::Detection det = detector_.get_detection(blocking);
+
+                    Detection result;
+                    result.timestamp = det.timestamp;
+                    result.has_detections = det.has_detections;
+                    result.detection_boxes.reserve(det.detection_boxes.size());
+                    for(const fpga::Box &box : det.detection_boxes) result.detection_boxes.push_back({ box.tl_x, box.tl_y, box.br_x, box.br_y });
+                    result.processing_time = det.processing_time;
+                    result.data_keep = std::move(det.data_keep);
+                    return result;
+                }
+
+                bool is_frame_ready() const override { return detector_.is_frame_ready(); }
+
+            private:
+                /**
+                 * @brief Frame in a vector, as the driver takes them.
+                 */
+                class Frame_ : public Frame
+                {
+                public:
+                    Frame_(const Backend *owner, const std::size_t size): owner_(owner), pixels_(size) {}
+
+                    std::uint16_t* data() override { return pixels_.data(); }
+                    std::size_t size() const override { return pixels_.size(); }
+                    const Backend* get_backend() const override { return owner_; }
+
+                    const Backend *owner_;
+                    std::vector<std::uint16_t> pixels_;
+                };
+
+                std::size_t size_;
+                fpga::Hls_motion_detector detector_;
+            };
+        } // Anonymous namespace
+
+        std::unique_ptr<Backend> make_hls_backend(const Detector_params &params)
+        {
+            if(params.width != Top_config::original_width || params.height != Top_config::original_height)
+                throw std::invalid_argument("ERROR make_hls_backend: The IP core is built for another resolution.");
+            if(params.downsample_factor != Top_config::reduction_factor)
+                throw std::invalid_argument("ERROR make_hls_backend: The IP core is built for another downsample factor.");
+            if(std::fabs(params.frame_update_ratio - motdet_frame_update_ratio) > 1e-6f)
+                throw std::invalid_argument("ERROR make_hls_backend: The IP core is built for another frame update ratio.");
+            if(params.queue_size == 0) throw std::invalid_argument("ERROR make_hls_backend: queue_size must be at least 1.");
+
+            return std::make_unique<Hls_backend_>(params);
+        }
+
+    } // namespace front
+} // namespace motdet
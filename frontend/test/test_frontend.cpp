@@ -0,0 +1,224 @@
+#include "test_frontend.hpp"
+#include "test_utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace test
+{
+    namespace frontend
+    {
+        using motdet::front::Backend_kind;
+        using motdet::front::Box;
+        using motdet::front::Detection;
+        using motdet::front::Frame;
+        using motdet::front::Frontend_config;
+        using motdet::front::Motion_detector;
+
+        void test_all()
+        {
+            log_test_result(test_backend_names(), "Backend names");
+            log_test_result(test_backends(), "Backends");
+            log_test_result(test_frames(), "Frames");
+            log_test_result(test_fallback(), "Fallback");
+            std::cout << std::endl;
+        }
+
+        namespace
+        {
+            // The resolution and factor the IP core is built for by default, so that every backend can be made.
+            Frontend_config config_(const std::vector<Backend_kind> &backends, const std::size_t width = 1920, const std::size_t height = 1080)
+            {
+                Frontend_config config;
+                config.backends = backends;
+                config.params.width = width;
+                config.params.height = height;
+                config.params.downsample_factor = 4;
+                return config;
+            }
+
+            std::unique_ptr<std::vector<std::uint16_t>> frame_(const std::size_t width, const std::size_t height, const bool square)
+            {
+                auto frame = std::make_unique<std::vector<std::uint16_t>>(width*height, 10000);
+                if(square)
+                    for(std::size_t i = height/3; i < height/3 + height/5; ++i)
+                        for(std::size_t j = width/3; j < width/3 + height/5; ++j) (*frame)[i*width + j] = 65025;
+                return frame;
+            }
+
+            std::unique_ptr<Frame> frame_(Motion_detector &detector, const bool square)
+            {
+                std::unique_ptr<Frame> frame = detector.make_frame();
+                auto pixels = frame_(detector.get_width(), detector.get_height(), square);
+                std::copy(pixels->begin(), pixels->end(), frame->data());
+                return frame;
+            }
+        } // Anonymous namespace
+
+        bool test_backend_names()
+        {
+            // Check 1: Every name is parsed back to its backend.
+
+            bool test_round_trip = true;
+            for(std::size_t k = 0; k < motdet::front::backend_kind_count; ++k)
+                test_round_trip = test_round_trip && motdet::front::parse_backend(motdet::front::backend_name((Backend_kind)k)) == (Backend_kind)k;
+            CHECK_TRUE(test_round_trip);
+
+            // Check 2: Lists keep their order, unknown names and empty lists are refused.
+
+            bool test_list = motdet::front::parse_backend_list("hls-emulated,fast-simd,base") ==
+                             std::vector<Backend_kind>({ Backend_kind::hls_emulated, Backend_kind::fast_simd, Backend_kind::base });
+            int refused = 0;
+            for(const std::string names : { "", "fast", "base,", "base,,fast-simd" })
+            {
+                try{ motdet::front::parse_backend_list(names); }
+                catch(const std::invalid_argument &e){ ++refused; }
+            }
+            test_list = test_list && refused == 4;
+            CHECK_TRUE(test_list);
+
+            return test_round_trip && test_list;
+        }
+
+        bool test_backends()
+        {
+            // Check 1: Every backend detects a square that appears on a static scene, behind the same interface.
+
+            const std::size_t width = 1920, height = 1080;
+            const std::size_t side = height / 5, top = height / 3, left = width / 3;
+            bool test_square = true;
+            for(std::size_t k = 0; k < motdet::front::backend_kind_count; ++k)
+            {
+                const Backend_kind kind = (Backend_kind)k;
+                Motion_detector detector(config_({ kind }));
+                auto keep = std::make_shared<int>(7);
+
+                detector.enqueue_frame(frame_(width, height, false), 0, true);
+                detector.enqueue_frame(frame_(width, height, false), 33, true);
+                Detection first = detector.get_detection(true), second = detector.get_detection(true);
+                detector.enqueue_frame(frame_(width, height, true), 66, true, keep);
+                Detection third = detector.get_detection(true);
+
+                bool test_kind = detector.get_backend() == kind && detector.get_fallback_reasons().empty() &&
+                                 !first.has_detections && !second.has_detections && third.has_detections && third.detection_boxes.size() == 1 &&
+                                 first.timestamp == 0 && second.timestamp == 33 && third.timestamp == 66 && third.data_keep == keep;
+                if(test_kind)
+                {
+                    // Every backend works on the downsampled frame and dilates the mask, so the box is only known within a few pixels.
+                    const Box &box = third.detection_boxes[0];
+                    test_kind = box.tl_x <= left && box.tl_y <= top && box.br_x >= left + side - 8 && box.br_y >= top + side - 8 &&
+                                box.tl_x + 24 >= left && box.tl_y + 24 >= top && box.br_x <= left + side + 24 && box.br_y <= top + side + 24;
+                }
+                if(!test_kind) std::cout << "    " << motdet::front::backend_name(kind) << " failed" << std::endl;
+                test_square = test_square && test_kind;
+            }
+            CHECK_TRUE(test_square);
+
+            // Check 2: Frames that are NULL or of another resolution are refused the same way by every backend.
+
+            int refused = 0;
+            for(std::size_t k = 0; k < motdet::front::backend_kind_count; ++k)
+            {
+                Motion_detector detector(config_({ (Backend_kind)k }));
+                try{ detector.enqueue_frame(std::unique_ptr<std::vector<std::uint16_t>>(), 0, true); }
+                catch(const std::invalid_argument &e){ ++refused; }
+                try{ detector.enqueue_frame(frame_(width, height - 1, false), 0, true); }
+                catch(const std::invalid_argument &e){ ++refused; }
+            }
+            bool test_refused = refused == 2 * (int)motdet::front::backend_kind_count;
+            CHECK_TRUE(test_refused);
+
+            return test_square && test_refused;
+        }
+
+        bool test_frames()
+        {
+            // Check 1: Frames made by the backend give the same detections as vectors, and are aligned on the fast library.
+
+            const std::size_t width = 1920, height = 1080;
+            bool test_same = true;
+            for(std::size_t k = 0; k < motdet::front::backend_kind_count; ++k)
+            {
+                const Backend_kind kind = (Backend_kind)k;
+                Detection expected;
+                {
+                    // Only one emulated IP core exists at a time.
+                    Motion_detector from_vectors(config_({ kind }));
+                    from_vectors.enqueue_frame(frame_(width, height, false), 0, true);
+                    from_vectors.enqueue_frame(frame_(width, height, true), 33, true);
+                    from_vectors.get_detection(true);
+                    expected = from_vectors.get_detection(true);
+                }
+
+                Motion_detector from_frames(config_({ kind }));
+                std::unique_ptr<Frame> frame = frame_(from_frames, false);
+                bool test_kind = frame->size() == width*height && frame->get_backend() != nullptr;
+                if(kind == Backend_kind::fast_scalar || kind == Backend_kind::fast_simd || kind == Backend_kind::fast_pipeline)
+                    test_kind = test_kind && reinterpret_cast<std::uintptr_t>(frame->data()) % 64 == 0;
+                from_frames.enqueue_frame(std::move(frame), 0, true);
+                from_frames.enqueue_frame(frame_(from_frames, true), 33, true);
+                from_frames.get_detection(true);
+                Detection third = from_frames.get_detection(true);
+
+                test_kind = test_kind && third.has_detections == expected.has_detections && third.detection_boxes.size() == expected.detection_boxes.size();
+                for(std::size_t b = 0; test_kind && b < third.detection_boxes.size(); ++b)
+                {
+                    const Box &box = third.detection_boxes[b], &other = expected.detection_boxes[b];
+                    test_kind = box.tl_x == other.tl_x && box.tl_y == other.tl_y && box.br_x == other.br_x && box.br_y == other.br_y;
+                }
+                if(!test_kind) std::cout << "    " << motdet::front::backend_name(kind) << " failed" << std::endl;
+                test_same = test_same && test_kind;
+            }
+            CHECK_TRUE(test_same);
+
+            // Check 2: Frames that are NULL or made by another detector are refused.
+
+            Motion_detector first(config_({ Backend_kind::fast_simd })), second(config_({ Backend_kind::fast_simd }));
+            int refused = 0;
+            try{ first.enqueue_frame(std::unique_ptr<Frame>(), 0, true); }
+            catch(const std::invalid_argument &e){ ++refused; }
+            try{ first.enqueue_frame(second.make_frame(), 0, true); }
+            catch(const std::invalid_argument &e){ ++refused; }
+            bool test_refused = refused == 2;
+            CHECK_TRUE(test_refused);
+
+            return test_same && test_refused;
+        }
+
+        bool test_fallback()
+        {
+            // Check 1: A backend that can not run with the parameters is skipped, with its reason kept.
+
+            Motion_detector small(config_({ Backend_kind::hls_emulated, Backend_kind::fast_simd }, 640, 360));
+            bool test_parameters = small.get_backend() == Backend_kind::fast_simd && small.get_fallback_reasons().size() == 1 &&
+                                   small.get_fallback_reasons()[0].find("hls-emulated") == 0;
+            CHECK_TRUE(test_parameters);
+
+            // Check 2: Only one emulated IP core exists at a time, a second camera falls back to the CPU.
+
+            bool test_busy;
+            {
+                Motion_detector first(config_({ Backend_kind::hls_emulated, Backend_kind::base }));
+                Motion_detector second(config_({ Backend_kind::hls_emulated, Backend_kind::base }));
+                test_busy = first.get_backend() == Backend_kind::hls_emulated && second.get_backend() == Backend_kind::base;
+            }
+            Motion_detector again(config_({ Backend_kind::hls_emulated }));
+            test_busy = test_busy && again.get_backend() == Backend_kind::hls_emulated;
+            CHECK_TRUE(test_busy);
+
+            // Check 3: Without backends, or when none can be made, the detector is not made.
+
+            bool test_empty = false, test_none = false;
+            try{ Motion_detector detector(config_({})); }
+            catch(const std::invalid_argument &e){ test_empty = true; }
+            try{ Motion_detector detector(config_({ Backend_kind::hls_emulated, Backend_kind::base }, 5, 5)); }
+            catch(const std::runtime_error &e){ test_none = true; }
+            CHECK_TRUE(test_empty);
+            CHECK_TRUE(test_none);
+
+            return test_parameters && test_busy && test_empty && test_none;
+        }
+
+    } // namespace frontend
+} // namespace test
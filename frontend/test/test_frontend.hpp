@@ -0,0 +1,19 @@
+#ifndef __TEST_MOTDET_FRONTEND_HPP__
+#define __TEST_MOTDET_FRONTEND_HPP__
+
+#include "frontend.hpp"
+
+namespace test
+{
+    namespace frontend
+    {
+        void test_all();
+
+        bool test_backend_names();
+        bool test_backends();
+        bool test_frames();
+        bool test_fallback();
+    } // namespace frontend
+} // namespace test
+
+#endif // __TEST_MOTDET_FRONTEND_HPP__
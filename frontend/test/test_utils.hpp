@@ -0,0 +1,20 @@
+#ifndef __TEST_UTILS_HPP__
+#define __TEST_UTILS_HPP__
+
+#include <string>
+#include <iostream>
+
+namespace test
+{
+
+    #define CHECK_TRUE(x) { if (!(x)) std::cout << __FUNCTION__ << " failed on line " << __LINE__ << std::endl; }
+
+    inline void log_test_result(bool passed, std::string func_name)
+    {
+        if(passed) std::cout << "[PASS] : " << func_name << std::endl;
+        else std::cout << "> [FAIL] : " << func_name << std::endl;
+    }
+
+} // namespace test
+
+#endif // __TEST_UTILS_HPP__
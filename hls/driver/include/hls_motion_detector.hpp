@@ -0,0 +1,185 @@
+#ifndef __MOTDET_HLS_MOTION_DETECTOR_HPP__
+#define __MOTDET_HLS_MOTION_DETECTOR_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+
+#include "transport.hpp"
+
+namespace motdet
+{
+    namespace fpga
+    {
+        struct Detection
+        {
+            unsigned long long timestamp;       /**< The timestamp of the video the motion was detected from */
+            bool has_detections;                /**< True if motion has been detected                        */
+            std::vector<Box> detection_boxes;   /**< Bounding boxes of the detected movements                */
+            unsigned long long processing_time; /**< Milliseconds from the submission of the frame to its contours being read back */
+
+            std::shared_ptr<void> data_keep; /**< Will point at NULL if no data_keep was sent when enqueueing */
+        };
+
+        /**
+         * @brief Host side driver of the HLS IP core, with the same interface as the CPU Motion_detector.
+         * @details Frames are written straight into the buffers of a Transport and submitted. With 2 buffers they are
+         * double buffered: the next frame is written while the core processes the previous one. A thread of the driver
+         * reads back the contours of every frame as soon as the core is done with it, and frees its buffer.
+         */
+        class Hls_motion_detector
+        {
+        public:
+            /**
+             * @brief Constructor. Frames are queued up to the amount of buffers of the transport.
+             * @param transport Transport to the IP core. Transfers ownership.
+             * @throw invalid_argument if transport is NULL or has no buffers.
+             */
+            explicit Hls_motion_detector(std::unique_ptr<Transport> transport);
+
+            /**
+             * @brief Destructor. Waits for the frames being processed, the results not collected are lost.
+             */
+            ~Hls_motion_detector();
+
+            Hls_motion_detector(const Hls_motion_detector &other) = delete;
+            Hls_motion_detector& operator=(const Hls_motion_detector &other) = delete;
+
+            // Getters
+
+            /**
+             * @brief Get the width
+             * @return std::size_t
+             */
+            std::size_t get_width() const { return w_; }
+
+            /**
+             * @brief Get the height
+             * @return std::size_t
+             */
+            std::size_t get_height() const { return h_; }
+
+            /**
+             * @brief Get the total pixels
+             * @return std::size_t
+             */
+            std::size_t get_total() const { return total_; }
+
+            /**
+             * @brief Get the maximum amount of frames that can be queued, the buffers of the transport.
+             * @return std::size_t
+             */
+            std::size_t get_queue_capacity() const { return capacity_; }
+
+            /**
+             * @brief Get the amount of frames submitted to the IP core whose contours have not been read back yet.
+             * @return std::size_t
+             */
+            std::size_t get_queue_size() const;
+
+            /**
+             * @brief Get the amount of results read back and not collected yet. Note they are stored without limit, make sure to collect them.
+             * @return std::size_t
+             */
+            std::size_t get_completed_size() const;
+
+            // General Methods
+
+            /**
+             * @brief Will enqueue a frame to be processed by the IP core. It is copied into a buffer of the transport.
+             * @param in Grayscale image to be processed, width*height pixels. Transfers ownership.
+             * @param timestamp_millis Time in milliseconds of the frame being sent in.
+             * @param blocking If true, will wait for a buffer to be free, if false, will throw if every buffer is in use.
+             * @param data_keep Extra info to keep as "metadata" of the inputted frame, is returned as is upon result extraction.
+             * @exception runtime_error if every buffer is in use and blocking is set to false. The input frame is lost forever.
+             * @exception invalid_argument if the timestamp is older than one of the already enqueued frames.
+             * @exception invalid_argument if the new frame has a different resolution from the one of the IP core or is NULL.
+             */
+            void enqueue_frame(std::unique_ptr<std::vector<std::uint16_t>> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep = {});
+
+            /**
+             * @brief Same as enqueue_frame, from a frame in 8 bit RGB, which is converted to grayscale straight into the
+             * buffer of the transport, without any intermediate copy.
+             * @param rgb width*height pixels of 3 bytes, red, green and blue.
+             * @exception invalid_argument if rgb is NULL.
+             */
+            void enqueue_rgb_frame(const unsigned char *rgb, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep = {});
+
+            /**
+             * @brief Gets the contours detected in the oldest frame submitted to the IP core.
+             * @return detection struct with the detected motion.
+             * @exception runtime_error if no result is ready and blocking is set to false.
+             */
+            Detection get_detection(bool blocking);
+
+            /**
+             * @brief Returns whether the oldest frame submitted has been processed. Thread safe method.
+             * @return true if the oldest contours detected can be extracted safely with a non blocking get.
+             * @return false if the contours are not yet ready to be returned.
+             */
+            bool is_frame_ready() const { return get_completed_size() > 0; }
+
+            /**
+             * @brief Converts 8 bit RGB pixels to the 16 bit grayscale the IP core takes, with the weights of the testbench
+             * in fixed point. White is 65025.
+             * @param rgb Pixels of 3 bytes, red, green and blue.
+             * @param gray Output pixels.
+             * @param pixels Amount of pixels.
+             */
+            static void rgb_to_gray(const unsigned char *rgb, std::uint16_t *gray, const std::size_t pixels);
+
+        private:
+            /**
+             * @brief A frame submitted to the IP core, until its contours are read back.
+             */
+            struct In_flight_
+            {
+                unsigned long long timestamp;
+                std::size_t buffer;
+                std::chrono::steady_clock::time_point start;
+                std::shared_ptr<void> data_keep;
+            };
+
+            /**
+             * @brief Takes a free buffer, waiting for one if blocking. Must be called with enqueue_mutex_ locked.
+             * @return std::size_t Index of the buffer.
+             */
+            std::size_t acquire_buffer_(const unsigned long long timestamp_millis, const bool blocking);
+
+            /**
+             * @brief Submits a buffer already written with a frame. Must be called with enqueue_mutex_ locked.
+             */
+            void submit_(const std::size_t buffer, const unsigned long long timestamp_millis, std::shared_ptr<void> data_keep);
+
+            /**
+             * @brief Body of the thread that reads back the contours of the frames, in submission order.
+             */
+            void read_results_();
+
+            std::unique_ptr<Transport> transport_;
+            std::size_t w_, h_, total_;
+            std::size_t capacity_;
+
+            std::mutex enqueue_mutex_;          /**< Keeps the frames of several enqueuing threads in order. */
+            mutable std::mutex mutex_;          /**< Guards everything below.                                */
+            std::condition_variable buffer_free_cond_, in_flight_cond_, results_empty_cond_;
+            std::vector<std::size_t> free_buffers_;
+            std::deque<In_flight_> in_flight_;
+            std::deque<Detection> result_queue_;
+            unsigned long long last_submitted_time_ = 0;
+            bool stop_ = false;
+
+            std::thread reader_;
+        };
+
+    } // namespace fpga
+} // namespace motdet
+
+#endif // __MOTDET_HLS_MOTION_DETECTOR_HPP__
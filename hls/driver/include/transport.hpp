@@ -0,0 +1,91 @@
+#ifndef __MOTDET_TRANSPORT_HPP__
+#define __MOTDET_TRANSPORT_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+namespace motdet
+{
+    namespace fpga
+    {
+        /**
+         * @brief Bounding box of a movement detected by the IP core, in pixels of the original frame.
+         */
+        struct Box
+        {
+            std::size_t tl_x, tl_y; /**< Top left point of the bounding box     */
+            std::size_t br_x, br_y; /**< Bottom right point of the bounding box */
+        };
+
+        /**
+         * @brief Path to an instance of the IP core, shaped after a DMA engine. The host writes frames into the buffers of
+         * the transport, submits them, and reads back the contours of every frame in the order they were submitted.
+         * @details One thread may submit frames while another one reads results. A buffer must not be written from the
+         * moment it is submitted until the result of its frame has been read.
+         */
+        class Transport
+        {
+        public:
+            virtual ~Transport() = default;
+
+            /**
+             * @brief Get the width of the frames the IP core is generated for.
+             * @return std::size_t
+             */
+            virtual std::size_t get_width() const = 0;
+
+            /**
+             * @brief Get the height of the frames the IP core is generated for.
+             * @return std::size_t
+             */
+            virtual std::size_t get_height() const = 0;
+
+            /**
+             * @brief Get the amount of frame buffers. With 2 or more, a frame can be written while the core processes another.
+             * @return std::size_t
+             */
+            virtual std::size_t get_buffer_count() const = 0;
+
+            /**
+             * @brief Get the memory of a frame buffer, width*height grayscale pixels the IP core reads the frame from.
+             * @param index Buffer, below get_buffer_count().
+             * @return std::uint16_t* Never NULL.
+             * @throw invalid_argument if index is not below get_buffer_count().
+             */
+            virtual std::uint16_t* get_buffer(const std::size_t index) = 0;
+
+            /**
+             * @brief Starts the transfer of a frame buffer to the IP core, which processes it once the frames submitted
+             * before are done. Returns right away.
+             * @param index Buffer, below get_buffer_count().
+             * @throw invalid_argument if index is not below get_buffer_count().
+             */
+            virtual void submit(const std::size_t index) = 0;
+
+            /**
+             * @brief Waits for the contours of the oldest submitted frame that have not been read yet. Its buffer can be
+             * written again afterwards. Must only be called while some frame has been submitted and not read.
+             * @param boxes Replaced with the bounding boxes of the contours.
+             */
+            virtual void read_result(std::vector<Box> &boxes) = 0;
+        };
+
+        /**
+         * @brief Transport to the IP core built natively, see hls/emulation, so that the host code can be run and tested
+         * without a board. The core runs in a thread of its own and processes the frames in submission order, like the
+         * DMA and the core of the board do. It is generated for motdet::Top_config, set with the same macros.
+         * @details The IP core keeps its reference image in global state, so only one emulated transport can exist at a
+         * time. It starts without a reference, as after a reset of the core.
+         * @param buffer_count Amount of frame buffers.
+         * @return std::unique_ptr<Transport> Never NULL.
+         * @throw invalid_argument if buffer_count == 0.
+         * @throw runtime_error if another emulated transport exists.
+         */
+        std::unique_ptr<Transport> make_emulated_transport(const std::size_t buffer_count = 2);
+
+    } // namespace fpga
+} // namespace motdet
+
+#endif // __MOTDET_TRANSPORT_HPP__
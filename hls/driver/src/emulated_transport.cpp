@@ -0,0 +1,147 @@
+#include "transport.hpp"
+
+// The IP core, built natively through the shim headers of hls/emulation.
+#include "motion_detector.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <stdexcept>
+
+namespace motdet
+{
+    namespace fpga
+    {
+        namespace // Anonymous namespace
+        {
+            std::atomic<bool> emulated_transport_exists(false);
+
+            class Emulated_transport_ : public Transport
+            {
+            public:
+                explicit Emulated_transport_(const std::size_t buffer_count)
+                {
+                    if(buffer_count == 0) throw std::invalid_argument("ERROR make_emulated_transport: At least one buffer is needed.");
+                    if(emulated_transport_exists.exchange(true)) throw std::runtime_error("ERROR make_emulated_transport: Only one emulated transport can exist at a time.");
+
+                    buffers_.assign(buffer_count, std::vector<std::uint16_t>(Top_config::original_total));
+                #if MOTDET_REFERENCE_IN_DDR
+                    reference_.resize(reference_vectors);
+                #endif
+                    imgutil::reset_reference<Top_config>();
+                    core_ = std::thread(&Emulated_transport_::run_core_, this);
+                }
+
+                ~Emulated_transport_()
+                {
+                    std::unique_lock<std::mutex> locker(mutex_);
+                    stop_ = true;
+                    locker.unlock();
+                    submitted_cond_.notify_all();
+
+                    core_.join();
+                    emulated_transport_exists = false;
+                }
+
+                std::size_t get_width() const override { return Top_config::original_width; }
+                std::size_t get_height() const override { return Top_config::original_height; }
+                std::size_t get_buffer_count() const override { return buffers_.size(); }
+
+                std::uint16_t* get_buffer(const std::size_t index) override
+                {
+                    if(index >= buffers_.size()) throw std::invalid_argument("ERROR get_buffer: There is no such buffer.");
+                    return buffers_[index].data();
+                }
+
+                void submit(const std::size_t index) override
+                {
+                    if(index >= buffers_.size()) throw std::invalid_argument("ERROR submit: There is no such buffer.");
+
+                    std::unique_lock<std::mutex> locker(mutex_);
+                    submitted_.push_back(index);
+                    locker.unlock();
+                    submitted_cond_.notify_one();
+                }
+
+                void read_result(std::vector<Box> &boxes) override
+                {
+                    std::unique_lock<std::mutex> locker(mutex_);
+                    results_cond_.wait(locker, [this](){ return results_.size() > 0; });
+                    boxes = std::move(results_.front());
+                    results_.pop_front();
+                }
+
+            private:
+                // Body of the thread of the core, which takes the submitted buffers in order.
+                void run_core_()
+                {
+                    while(true)
+                    {
+                        std::unique_lock<std::mutex> locker(mutex_);
+                        submitted_cond_.wait(locker, [this](){ return submitted_.size() > 0 || stop_; });
+                        if(submitted_.empty()) return;
+                        std::size_t index = submitted_.front();
+                        submitted_.pop_front();
+                        locker.unlock();
+
+                        std::vector<Box> boxes = process_(buffers_[index]);
+
+                        locker.lock();
+                        results_.push_back(std::move(boxes));
+                        locker.unlock();
+                        results_cond_.notify_one();
+                    }
+                }
+
+                // Streams a frame into the core from another thread, as the DMA does, and collects the contours.
+                std::vector<Box> process_(const std::vector<std::uint16_t> &frame)
+                {
+                    hls::stream<Packed_pix, MOTDET_STREAM_DEPTH> in("in");
+                    hls::stream<Streamed_contour, MOTDET_STREAM_DEPTH> out("out");
+
+                    std::thread feeder([&in, &frame]()
+                    {
+                        for(std::size_t i = 0; i < Top_config::original_total; i += Top_config::beat_pixels)
+                        {
+                            Packed_pix packed;
+                            for(std::size_t k = 0; k < Top_config::beat_pixels; ++k) packed.pix[k] = frame[i + k];
+                            in.write(packed);
+                        }
+                    });
+                #if MOTDET_REFERENCE_IN_DDR
+                    detect_motion<Top_config>(in, out, reference_.data(), reference_.data());
+                #else
+                    detect_motion<Top_config>(in, out);
+                #endif
+                    feeder.join();
+
+                    std::vector<Box> boxes;
+                    for(Streamed_contour cont = out.read(); !cont.stream_end; cont = out.read())
+                        boxes.push_back({ cont.contour.bb_tl_x.to_uint64(), cont.contour.bb_tl_y.to_uint64(), cont.contour.bb_br_x.to_uint64(), cont.contour.bb_br_y.to_uint64() });
+                    return boxes;
+                }
+
+                std::vector<std::vector<std::uint16_t>> buffers_;
+            #if MOTDET_REFERENCE_IN_DDR
+                std::vector<Pix_vec> reference_; /**< Stands in for the buffer in DDR. */
+            #endif
+
+                std::mutex mutex_;
+                std::condition_variable submitted_cond_, results_cond_;
+                std::deque<std::size_t> submitted_;
+                std::deque<std::vector<Box>> results_;
+                bool stop_ = false;
+
+                std::thread core_;
+            };
+        } // Anonymous namespace
+
+        std::unique_ptr<Transport> make_emulated_transport(const std::size_t buffer_count)
+        {
+            return std::unique_ptr<Transport>(new Emulated_transport_(buffer_count));
+        }
+
+    } // namespace fpga
+} // namespace motdet
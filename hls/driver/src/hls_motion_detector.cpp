@@ -0,0 +1,168 @@
+#include "hls_motion_detector.hpp"
+
+#include <utility>
+#include <algorithm>
+
+namespace motdet
+{
+    namespace fpga
+    {
+        Hls_motion_detector::Hls_motion_detector(std::unique_ptr<Transport> transport)
+        {
+            if(transport.get() == NULL) throw std::invalid_argument("ERROR Hls_motion_detector: The transport is NULL.");
+            if(transport->get_buffer_count() == 0) throw std::invalid_argument("ERROR Hls_motion_detector: The transport has no buffers.");
+
+            transport_ = std::move(transport);
+            w_ = transport_->get_width();
+            h_ = transport_->get_height();
+            total_ = w_ * h_;
+            capacity_ = transport_->get_buffer_count();
+
+            // Buffers are taken from the back, so the first frames go to the first buffers.
+            for(std::size_t k = capacity_; k > 0; --k) free_buffers_.push_back(k - 1);
+
+            reader_ = std::thread(&Hls_motion_detector::read_results_, this);
+        }
+
+        Hls_motion_detector::~Hls_motion_detector()
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            stop_ = true;
+            locker.unlock();
+            in_flight_cond_.notify_all();
+
+            reader_.join();
+        }
+
+        std::size_t Hls_motion_detector::get_queue_size() const
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            return in_flight_.size();
+        }
+
+        std::size_t Hls_motion_detector::get_completed_size() const
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            return result_queue_.size();
+        }
+
+        void Hls_motion_detector::enqueue_frame(std::unique_ptr<std::vector<std::uint16_t>> in, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep)
+        {
+            if(in.get() == NULL) throw std::invalid_argument("ERROR Enqueue: The input image is NULL.");
+            if(in->size() != total_) throw std::invalid_argument("ERROR Enqueue: Wrong resolution.");
+
+            std::unique_lock<std::mutex> enqueue_locker(enqueue_mutex_);
+            std::size_t buffer = acquire_buffer_(timestamp_millis, blocking);
+
+            // Only this thread touches a buffer between taking it and submitting it.
+            std::copy(in->begin(), in->end(), transport_->get_buffer(buffer));
+            submit_(buffer, timestamp_millis, std::move(data_keep));
+        }
+
+        void Hls_motion_detector::enqueue_rgb_frame(const unsigned char *rgb, unsigned long long timestamp_millis, bool blocking, std::shared_ptr<void> data_keep)
+        {
+            if(rgb == NULL) throw std::invalid_argument("ERROR Enqueue: The input image is NULL.");
+
+            std::unique_lock<std::mutex> enqueue_locker(enqueue_mutex_);
+            std::size_t buffer = acquire_buffer_(timestamp_millis, blocking);
+
+            rgb_to_gray(rgb, transport_->get_buffer(buffer), total_);
+            submit_(buffer, timestamp_millis, std::move(data_keep));
+        }
+
+        Detection Hls_motion_detector::get_detection(bool blocking)
+        {
+            // Lock mutex for checks
+            std::unique_lock<std::mutex> locker(mutex_);
+
+            if(blocking)
+            {
+                // Blocking mode, sleep until the oldest frame is ready for output.
+                results_empty_cond_.wait(locker, [this](){ return result_queue_.size() > 0; });
+            }
+            else
+            {
+                // Non-blocking, throw exception if the oldest frame is not ready
+                if(result_queue_.size() == 0) throw std::runtime_error("ERROR get_detection: No results ready.");
+            }
+
+            Detection result = std::move(result_queue_.front());
+            result_queue_.pop_front();
+
+            return result;
+        }
+
+        void Hls_motion_detector::rgb_to_gray(const unsigned char *rgb, std::uint16_t *gray, const std::size_t pixels)
+        {
+            // 76.245, 149.685 and 29.07 in fixed point with 8 fractional bits, they add up to 255 so white is 255*255.
+            for(std::size_t k = 0; k < pixels; ++k, rgb += 3)
+                gray[k] = (rgb[0] * 19519u + rgb[1] * 38319u + rgb[2] * 7442u) >> 8;
+        }
+
+        std::size_t Hls_motion_detector::acquire_buffer_(const unsigned long long timestamp_millis, const bool blocking)
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            if(timestamp_millis < last_submitted_time_) throw std::invalid_argument("ERROR Enqueue: Submitted timestamps must be chronologically ordered.");
+
+            if(blocking)
+            {
+                // Blocking mode, sleep until the contours of a frame are read back and its buffer is free.
+                buffer_free_cond_.wait(locker, [this](){ return free_buffers_.size() > 0; });
+            }
+            else
+            {
+                // Non-blocking, check if every buffer is in use and if it is, throw exception
+                if(free_buffers_.size() == 0) throw std::runtime_error("ERROR Enqueue: Queue is full.");
+            }
+            last_submitted_time_ = timestamp_millis;
+
+            std::size_t buffer = free_buffers_.back();
+            free_buffers_.pop_back();
+            return buffer;
+        }
+
+        void Hls_motion_detector::submit_(const std::size_t buffer, const unsigned long long timestamp_millis, std::shared_ptr<void> data_keep)
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            in_flight_.push_back({ timestamp_millis, buffer, std::chrono::steady_clock::now(), std::move(data_keep) });
+            transport_->submit(buffer);
+            locker.unlock();
+
+            in_flight_cond_.notify_one();
+        }
+
+        void Hls_motion_detector::read_results_()
+        {
+            std::vector<Box> boxes;
+            while(true)
+            {
+                std::unique_lock<std::mutex> locker(mutex_);
+                in_flight_cond_.wait(locker, [this](){ return in_flight_.size() > 0 || stop_; });
+                if(in_flight_.empty()) return; // Stopping, and every frame submitted has been read back.
+                locker.unlock();
+
+                // Only this thread pops frames in flight, so the oldest one stays at the front while waiting.
+                transport_->read_result(boxes);
+
+                locker.lock();
+                In_flight_ done = std::move(in_flight_.front());
+                in_flight_.pop_front();
+
+                Detection det;
+                det.timestamp = done.timestamp;
+                det.has_detections = boxes.size() > 0;
+                det.detection_boxes = boxes;
+                det.processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - done.start).count();
+                det.data_keep = std::move(done.data_keep);
+
+                result_queue_.push_back(std::move(det));
+                free_buffers_.push_back(done.buffer);
+                locker.unlock();
+
+                buffer_free_cond_.notify_one();
+                results_empty_cond_.notify_all();
+            }
+        }
+
+    } // namespace fpga
+} // namespace motdet
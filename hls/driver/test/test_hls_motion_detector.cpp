@@ -0,0 +1,252 @@
+#include "test_hls_motion_detector.hpp"
+#include "test_utils.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+namespace test
+{
+    namespace hls_motion_detector
+    {
+        using motdet::fpga::Box;
+        using motdet::fpga::Detection;
+        using motdet::fpga::Hls_motion_detector;
+        using motdet::fpga::Transport;
+
+        void test_all()
+        {
+            log_test_result(test_rgb_to_gray(), "rgb_to_gray");
+            log_test_result(test_arguments(), "Arguments");
+            log_test_result(test_double_buffering(), "Double buffering");
+            log_test_result(test_emulated_transport(), "Emulated transport");
+            std::cout << std::endl;
+        }
+
+        namespace
+        {
+            // What a Manual_transport_ has been asked to do, shared with the test that drives it.
+            struct Manual_state_
+            {
+                std::mutex mutex;
+                std::condition_variable released_cond;
+                std::deque<std::size_t> submitted; // Buffers submitted and not read back.
+                std::vector<std::size_t> history;  // Every buffer submitted, in order.
+                std::size_t released = 0;          // Frames the core is allowed to have finished.
+                std::size_t read = 0;
+
+                void release(const std::size_t frames)
+                {
+                    std::unique_lock<std::mutex> locker(mutex);
+                    released += frames;
+                    locker.unlock();
+                    released_cond.notify_all();
+                }
+            };
+
+            // Transport whose frames only finish when the test releases them. The single box of every result has the
+            // first pixel of the frame as tl_x, to tell which frame it comes from.
+            class Manual_transport_ : public Transport
+            {
+            public:
+                Manual_transport_(const std::size_t width, const std::size_t height, const std::size_t buffer_count, std::shared_ptr<Manual_state_> state)
+                    : w_(width), h_(height), buffers_(buffer_count, std::vector<std::uint16_t>(width*height)), state_(state) {}
+
+                std::size_t get_width() const override { return w_; }
+                std::size_t get_height() const override { return h_; }
+                std::size_t get_buffer_count() const override { return buffers_.size(); }
+                std::uint16_t* get_buffer(const std::size_t index) override { return buffers_.at(index).data(); }
+
+                void submit(const std::size_t index) override
+                {
+                    std::unique_lock<std::mutex> locker(state_->mutex);
+                    state_->submitted.push_back(index);
+                    state_->history.push_back(index);
+                }
+
+                void read_result(std::vector<Box> &boxes) override
+                {
+                    std::unique_lock<std::mutex> locker(state_->mutex);
+                    state_->released_cond.wait(locker, [this](){ return state_->released > state_->read; });
+                    ++state_->read;
+                    boxes = { { buffers_[state_->submitted.front()][0], 0, 0, 0 } };
+                    state_->submitted.pop_front();
+                }
+
+            private:
+                std::size_t w_, h_;
+                std::vector<std::vector<std::uint16_t>> buffers_;
+                std::shared_ptr<Manual_state_> state_;
+            };
+
+            std::unique_ptr<std::vector<std::uint16_t>> frame_(const std::size_t total, const std::uint16_t value)
+            {
+                return std::unique_ptr<std::vector<std::uint16_t>>(new std::vector<std::uint16_t>(total, value));
+            }
+        } // Anonymous namespace
+
+        bool test_rgb_to_gray()
+        {
+            // Check 1: Black and white, and the same as the weights in floating point of the testbench, within a level.
+
+            const unsigned char rgb[] = { 0, 0, 0, 255, 255, 255, 255, 0, 0, 0, 255, 0, 0, 0, 255, 12, 200, 77 };
+            std::uint16_t gray[6];
+            Hls_motion_detector::rgb_to_gray(rgb, gray, 6);
+
+            bool test_weights = gray[0] == 0 && gray[1] == 65025;
+            for(std::size_t k = 0; k < 6; ++k)
+            {
+                double expected = rgb[k*3] * 76.245 + rgb[k*3 + 1] * 149.685 + rgb[k*3 + 2] * 29.07;
+                test_weights = test_weights && gray[k] <= expected + 1 && gray[k] + 1 >= expected;
+            }
+            CHECK_TRUE(test_weights);
+
+            return test_weights;
+        }
+
+        bool test_arguments()
+        {
+            auto state = std::make_shared<Manual_state_>();
+
+            // Check 1: Without transport or buffers.
+
+            bool test_transport = false, test_buffers = false;
+            try{ Hls_motion_detector detector(nullptr); }
+            catch(const std::invalid_argument &e){ test_transport = true; }
+            try{ Hls_motion_detector detector(std::unique_ptr<Transport>(new Manual_transport_(16, 8, 0, state))); }
+            catch(const std::invalid_argument &e){ test_buffers = true; }
+            CHECK_TRUE(test_transport);
+            CHECK_TRUE(test_buffers);
+
+            // Check 2: Frames that are NULL, of another resolution or older than the last one are refused.
+
+            Hls_motion_detector detector(std::unique_ptr<Transport>(new Manual_transport_(16, 8, 2, state)));
+            bool test_frames = detector.get_width() == 16 && detector.get_height() == 8 && detector.get_total() == 128 && detector.get_queue_capacity() == 2;
+            int refused = 0;
+            try{ detector.enqueue_frame(nullptr, 0, false); }
+            catch(const std::invalid_argument &e){ ++refused; }
+            try{ detector.enqueue_rgb_frame(nullptr, 0, false); }
+            catch(const std::invalid_argument &e){ ++refused; }
+            try{ detector.enqueue_frame(frame_(127, 0), 0, false); }
+            catch(const std::invalid_argument &e){ ++refused; }
+            detector.enqueue_frame(frame_(128, 0), 10, false);
+            try{ detector.enqueue_frame(frame_(128, 0), 9, false); }
+            catch(const std::invalid_argument &e){ ++refused; }
+            test_frames = test_frames && refused == 4 && detector.get_queue_size() == 1;
+            CHECK_TRUE(test_frames);
+
+            state->release(1);
+            return test_transport && test_buffers && test_frames;
+        }
+
+        bool test_double_buffering()
+        {
+            auto state = std::make_shared<Manual_state_>();
+            Hls_motion_detector detector(std::unique_ptr<Transport>(new Manual_transport_(16, 8, 2, state)));
+            auto keep = std::make_shared<int>(7);
+
+            // Check 1: A frame per buffer can be in flight, no result is ready until the core is done with one.
+
+            detector.enqueue_frame(frame_(128, 10), 0, false, keep);
+            detector.enqueue_frame(frame_(128, 11), 1, false);
+            bool test_full = false, test_empty = false;
+            try{ detector.enqueue_frame(frame_(128, 12), 2, false); }
+            catch(const std::runtime_error &e){ test_full = true; }
+            try{ detector.get_detection(false); }
+            catch(const std::runtime_error &e){ test_empty = true; }
+            bool test_in_flight = test_full && test_empty && detector.get_queue_size() == 2 && !detector.is_frame_ready();
+            CHECK_TRUE(test_in_flight);
+
+            // Check 2: Once the first frame is done, its result comes back with its metadata and its buffer is reused.
+
+            state->release(1);
+            Detection det = detector.get_detection(true);
+            detector.enqueue_frame(frame_(128, 12), 2, false);
+            bool test_reuse = det.timestamp == 0 && det.has_detections && det.detection_boxes.size() == 1 && det.detection_boxes[0].tl_x == 10 &&
+                              det.data_keep == keep;
+            CHECK_TRUE(test_reuse);
+
+            // Check 3: A blocking enqueue waits for a buffer to be freed.
+
+            std::atomic<bool> released(false);
+            std::thread releaser([&state, &released]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                released = true;
+                state->release(1);
+            });
+            detector.enqueue_frame(frame_(128, 13), 3, true);
+            bool test_blocking = released;
+            releaser.join();
+            CHECK_TRUE(test_blocking);
+
+            // Check 4: Every result in order, from the buffers in the order they were freed.
+
+            state->release(2);
+            bool test_order = true;
+            for(std::uint16_t k = 1; k < 4; ++k)
+            {
+                det = detector.get_detection(true);
+                test_order = test_order && det.timestamp == k && det.detection_boxes[0].tl_x == 10 + k && det.data_keep == nullptr;
+            }
+            test_order = test_order && state->history == std::vector<std::size_t>({ 0, 1, 0, 1 }) && detector.get_queue_size() == 0;
+            CHECK_TRUE(test_order);
+
+            return test_in_flight && test_reuse && test_blocking && test_order;
+        }
+
+        bool test_emulated_transport()
+        {
+            std::unique_ptr<Transport> transport = motdet::fpga::make_emulated_transport();
+
+            // Check 1: There is only one IP core to emulate.
+
+            bool test_single = false;
+            try{ motdet::fpga::make_emulated_transport(); }
+            catch(const std::runtime_error &e){ test_single = true; }
+            CHECK_TRUE(test_single);
+
+            // Check 2: A square that appears on a static scene is detected, with the frames in RGB and in grayscale.
+
+            std::size_t width = transport->get_width(), height = transport->get_height();
+            std::size_t side = height / 5, top = height / 3, left = width / 3;
+            std::vector<unsigned char> rgb(width*height*3, 40);
+            std::vector<std::uint16_t> gray(width*height);
+            Hls_motion_detector::rgb_to_gray(rgb.data(), gray.data(), width*height);
+
+            bool test_square;
+            {
+                Hls_motion_detector detector(std::move(transport));
+                detector.enqueue_frame(std::unique_ptr<std::vector<std::uint16_t>>(new std::vector<std::uint16_t>(gray)), 0, true);
+                detector.enqueue_rgb_frame(rgb.data(), 33, true);
+                for(std::size_t i = top; i < top + side; ++i)
+                    for(std::size_t j = left; j < left + side; ++j)
+                        for(std::size_t c = 0; c < 3; ++c) rgb[(i*width + j)*3 + c] = 255;
+                detector.enqueue_rgb_frame(rgb.data(), 66, true);
+
+                Detection first = detector.get_detection(true), second = detector.get_detection(true), third = detector.get_detection(true);
+                test_square = !first.has_detections && !second.has_detections && third.has_detections && third.detection_boxes.size() == 1 &&
+                              first.timestamp == 0 && second.timestamp == 33 && third.timestamp == 66;
+                if(test_square)
+                {
+                    // The core works on the downsampled frame, so the box is only known within a few pixels.
+                    const Box &box = third.detection_boxes[0];
+                    test_square = box.tl_x <= left && box.tl_y <= top && box.br_x >= left + side - 8 && box.br_y >= top + side - 8 &&
+                                  box.tl_x + 16 >= left && box.tl_y + 16 >= top && box.br_x <= left + side + 16 && box.br_y <= top + side + 16;
+                }
+            }
+            CHECK_TRUE(test_square);
+
+            // Check 3: Once destroyed, the IP core can be emulated again.
+
+            bool test_again = motdet::fpga::make_emulated_transport().get() != nullptr;
+            CHECK_TRUE(test_again);
+
+            return test_single && test_square && test_again;
+        }
+
+    } // namespace hls_motion_detector
+} // namespace test
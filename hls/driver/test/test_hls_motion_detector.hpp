@@ -0,0 +1,19 @@
+#ifndef __TEST_MOTDET_HLS_MOTION_DETECTOR_HPP__
+#define __TEST_MOTDET_HLS_MOTION_DETECTOR_HPP__
+
+#include "hls_motion_detector.hpp"
+
+namespace test
+{
+    namespace hls_motion_detector
+    {
+        void test_all();
+
+        bool test_rgb_to_gray();
+        bool test_arguments();
+        bool test_double_buffering();
+        bool test_emulated_transport();
+    } // namespace hls_motion_detector
+} // namespace test
+
+#endif // __TEST_MOTDET_HLS_MOTION_DETECTOR_HPP__
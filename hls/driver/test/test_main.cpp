@@ -0,0 +1,14 @@
+#include <iostream>
+
+#include "test_hls_motion_detector.hpp"
+
+int main()
+{
+    std::cout << "Starting all module tests..." << std::endl << std::endl;
+
+    test::hls_motion_detector::test_all();
+
+    std::cout << "Finished all module tests." << std::endl;
+
+    return 0;
+}
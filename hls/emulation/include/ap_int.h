@@ -0,0 +1,74 @@
+#ifndef __MOTDET_EMU_AP_INT_H__
+#define __MOTDET_EMU_AP_INT_H__
+
+// Native stand-in for the Vitis HLS arbitrary precision integers, covering what hls/final uses.
+// Only meant to build the IP core with a regular compiler, see hls/emulation/README.md.
+
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @brief Unsigned integer of N bits. Values are wrapped to N bits when stored, like in hardware.
+ * @details Arithmetic is done after converting to long long, so, as with the Vitis types, subtracting two ap_uint can
+ * give a negative result instead of wrapping around. Only widths that fit in a long long are supported.
+ * @tparam N Width in bits. From 1 to 63.
+ */
+template <int N> class ap_uint
+{
+    static_assert(N >= 1 && N <= 63, "ap_uint: Only widths from 1 to 63 bits are emulated.");
+
+public:
+    using storage_type = std::conditional_t<(N <= 8), std::uint8_t,
+                         std::conditional_t<(N <= 16), std::uint16_t,
+                         std::conditional_t<(N <= 32), std::uint32_t, std::uint64_t>>>;
+
+    ap_uint(): val_(0) {}
+
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+    ap_uint(const T val): val_(wrap_(val)) {}
+
+    template <int M>
+    ap_uint(const ap_uint<M> &other): val_(wrap_((long long)other)) {}
+
+    // Operator Overload
+
+    operator long long() const { return val_; }
+
+    template <typename T> ap_uint& operator +=(const T &other) { val_ = wrap_(val_ + (long long)other); return *this; }
+    template <typename T> ap_uint& operator -=(const T &other) { val_ = wrap_((long long)val_ - (long long)other); return *this; }
+    template <typename T> ap_uint& operator *=(const T &other) { val_ = wrap_(val_ * (long long)other); return *this; }
+    template <typename T> ap_uint& operator /=(const T &other) { val_ = wrap_(val_ / (long long)other); return *this; }
+    template <typename T> ap_uint& operator %=(const T &other) { val_ = wrap_(val_ % (long long)other); return *this; }
+    template <typename T> ap_uint& operator &=(const T &other) { val_ = wrap_(val_ & (long long)other); return *this; }
+    template <typename T> ap_uint& operator |=(const T &other) { val_ = wrap_(val_ | (long long)other); return *this; }
+    template <typename T> ap_uint& operator ^=(const T &other) { val_ = wrap_(val_ ^ (long long)other); return *this; }
+    template <typename T> ap_uint& operator <<=(const T &other) { val_ = wrap_((unsigned long long)val_ << (long long)other); return *this; }
+    template <typename T> ap_uint& operator >>=(const T &other) { val_ = wrap_(val_ >> (long long)other); return *this; }
+
+    ap_uint& operator ++() { val_ = wrap_(val_ + 1ULL); return *this; }
+    ap_uint& operator --() { val_ = wrap_(val_ - 1ULL); return *this; }
+    ap_uint operator ++(int) { ap_uint old = *this; ++*this; return old; }
+    ap_uint operator --(int) { ap_uint old = *this; --*this; return old; }
+
+    // Getters and Setters
+
+    /**
+     * @brief Get the value as an unsigned integer, without going through long long.
+     * @return unsigned long long
+     */
+    unsigned long long to_uint64() const { return val_; }
+
+private:
+    static constexpr unsigned long long mask_ = (1ULL << N) - 1;
+
+    template <typename T> static storage_type wrap_(const T val)
+    {
+        // Floating point values are truncated towards 0 first, negative values wrap around like in two's complement.
+        if constexpr(std::is_floating_point<T>::value) return (unsigned long long)(long long)val & mask_;
+        else return (unsigned long long)val & mask_;
+    }
+
+    storage_type val_;
+};
+
+#endif // __MOTDET_EMU_AP_INT_H__
@@ -0,0 +1,38 @@
+#ifndef __MOTDET_EMU_HLS_DATAFLOW_H__
+#define __MOTDET_EMU_HLS_DATAFLOW_H__
+
+// Native emulation of the HLS DATAFLOW regions. Not part of Vitis HLS, only used when MOTDET_EMULATION is defined.
+
+#include <thread>
+#include <vector>
+#include <utility>
+
+namespace hls_emu
+{
+    /**
+     * @brief Runs every process of a dataflow region in its own thread, so they work concurrently on the streams that
+     * connect them, like the processes of the region do in hardware. Waits for all of them when destroyed.
+     * @details Declare it after the streams of the region, so the processes are done before the streams are destroyed.
+     */
+    class Dataflow
+    {
+    public:
+        Dataflow() = default;
+        Dataflow(const Dataflow &other) = delete;
+        Dataflow& operator=(const Dataflow &other) = delete;
+
+        ~Dataflow() { for(std::thread &process : processes_) process.join(); }
+
+        /**
+         * @brief Starts a process of the region.
+         * @param func Callable with the body of the process.
+         */
+        template <typename FUNC> void process(FUNC &&func) { processes_.emplace_back(std::forward<FUNC>(func)); }
+
+    private:
+        std::vector<std::thread> processes_;
+    };
+
+} // namespace hls_emu
+
+#endif // __MOTDET_EMU_HLS_DATAFLOW_H__
@@ -0,0 +1,26 @@
+#ifndef __MOTDET_EMU_HLS_MATH_H__
+#define __MOTDET_EMU_HLS_MATH_H__
+
+// Native stand-in for the Vitis HLS math library, covering what hls/final uses.
+
+#include <type_traits>
+
+#include "ap_int.h"
+
+namespace hls
+{
+    /**
+     * @brief Absolute value, in the same type as the input.
+     */
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+    inline T abs(const T val) { return val < 0 ? -val : val; }
+
+    /**
+     * @brief Absolute value of an unsigned integer, which is the integer itself.
+     */
+    template <int N>
+    inline ap_uint<N> abs(const ap_uint<N> &val) { return val; }
+
+} // namespace hls
+
+#endif // __MOTDET_EMU_HLS_MATH_H__
@@ -0,0 +1,151 @@
+#ifndef __MOTDET_EMU_HLS_STREAM_H__
+#define __MOTDET_EMU_HLS_STREAM_H__
+
+// Native stand-in for the Vitis HLS streams, covering what hls/final uses.
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <string>
+
+// Minimum capacity of every emulated stream. The depths used in hardware (1 for most streams) would make the threads of a
+// dataflow region hand over every single value, so streams are widened to this. Results do not depend on it.
+#ifndef MOTDET_EMU_STREAM_CAPACITY
+#define MOTDET_EMU_STREAM_CAPACITY 4096
+#endif
+
+namespace hls_emu
+{
+    /**
+     * @brief Waits for the other end of a stream. Spins first, since the other thread usually answers within a few
+     * values, then yields, and sleeps when it has been waiting for long, such as a region waiting for its next frame.
+     * @param attempt Times waited in a row, updated.
+     */
+    inline void wait_for_stream(std::size_t &attempt)
+    {
+        if(attempt < 64) {}
+        else if(attempt < 4096) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(50));
+        ++attempt;
+    }
+} // namespace hls_emu
+
+namespace hls
+{
+    /**
+     * @brief FIFO between a producer and a consumer, each in its own thread. Lock free ring buffer.
+     * @details Unlike in C simulation, where streams are unbounded, writes wait while the stream is full, as in hardware.
+     * So the inputs of a top function must be fed from another thread, as a DMA would, unless they fit in the capacity.
+     * Only one thread can write and only one thread can read.
+     * @tparam T Type of the values.
+     * @tparam DEPTH Depth in hardware. The capacity is the largest of this and MOTDET_EMU_STREAM_CAPACITY.
+     */
+    template <typename T, int DEPTH = 0> class stream
+    {
+    public:
+        stream(): stream("") {}
+
+        stream(const char *name):
+            name_(name),
+            slots_(std::max<std::size_t>(DEPTH, MOTDET_EMU_STREAM_CAPACITY) + 1),
+            buffer_(new T[slots_])
+        {}
+
+        stream(const stream &other) = delete;
+        stream& operator=(const stream &other) = delete;
+
+        // Operator Overload
+
+        void operator >>(T &val) { read(val); }
+        void operator <<(const T &val) { write(val); }
+
+        // Getters and Setters
+
+        /**
+         * @brief Get the name given in the constructor.
+         * @return const std::string&
+         */
+        const std::string& get_name() const { return name_; }
+
+        bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+        bool full() const { return next_(tail_.load(std::memory_order_acquire)) == head_.load(std::memory_order_acquire); }
+
+        std::size_t size() const
+        {
+            std::size_t head = head_.load(std::memory_order_acquire), tail = tail_.load(std::memory_order_acquire);
+            return tail >= head ? tail - head : tail + slots_ - head;
+        }
+
+        // General Methods
+
+        /**
+         * @brief Reads the oldest value, waiting for one to be written if the stream is empty.
+         */
+        T read()
+        {
+            T val;
+            read(val);
+            return val;
+        }
+
+        void read(T &val)
+        {
+            std::size_t head = head_.load(std::memory_order_relaxed);
+            for(std::size_t attempt = 0; head == tail_.load(std::memory_order_acquire);) hls_emu::wait_for_stream(attempt);
+
+            val = buffer_[head];
+            head_.store(next_(head), std::memory_order_release);
+        }
+
+        /**
+         * @brief Writes a value, waiting for space if the stream is full.
+         */
+        void write(const T &val)
+        {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            for(std::size_t attempt = 0; next_(tail) == head_.load(std::memory_order_acquire);) hls_emu::wait_for_stream(attempt);
+
+            buffer_[tail] = val;
+            tail_.store(next_(tail), std::memory_order_release);
+        }
+
+        /**
+         * @brief Reads the oldest value only if there is one.
+         * @return true if a value was read into val.
+         */
+        bool read_nb(T &val)
+        {
+            if(empty()) return false;
+            read(val);
+            return true;
+        }
+
+        /**
+         * @brief Writes a value only if there is space for it.
+         * @return true if the value was written.
+         */
+        bool write_nb(const T &val)
+        {
+            if(full()) return false;
+            write(val);
+            return true;
+        }
+
+    private:
+        std::size_t next_(const std::size_t idx) const { return idx + 1 == slots_ ? 0 : idx + 1; }
+
+        std::string name_;
+        std::size_t slots_; /**< Capacity + 1, one slot is always left empty to tell a full stream from an empty one. */
+        std::unique_ptr<T[]> buffer_;
+
+        // The producer only writes tail_ and the consumer only writes head_. Kept in separate cache lines.
+        alignas(64) std::atomic<std::size_t> head_{0};
+        alignas(64) std::atomic<std::size_t> tail_{0};
+    };
+
+} // namespace hls
+
+#endif // __MOTDET_EMU_HLS_STREAM_H__
@@ -0,0 +1,411 @@
+#include "test_emulation.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <type_traits>
+
+namespace test
+{
+    namespace emulation
+    {
+        void test_all()
+        {
+            std::cout << "Testing module emulation..." << std::endl;
+
+            log_test_result(test_ap_uint(), "ap_uint");
+            log_test_result(test_stream(), "hls::stream");
+            log_test_result(test_detect_motion(), "detect_motion");
+            log_test_result(test_configurations(), "Motdet_config");
+            log_test_result(test_pixels_per_clock(), "Pixels per clock");
+            log_test_result(test_external_reference(), "Reference in external memory");
+            log_test_result(test_channels(), "Channels");
+            log_test_result(test_empty_rows(), "Empty rows skipped");
+
+            std::cout << "Finished tests for module emulation." << std::endl << std::endl;
+        }
+
+        bool test_ap_uint()
+        {
+            // Check 1: Values are wrapped to the width when stored, not when operated with.
+
+            ap_uint<16> a = 65536 + 7, b = 9;
+            bool test_wrap = a == 7 && a - b == -2 && ap_uint<16>(a - b) == 65534 && ap_uint<4>(b * 2) == 2;
+            CHECK_TRUE(test_wrap);
+
+            // Check 2: Increments and compound assignments wrap too.
+
+            ap_uint<3> c = 6;
+            ap_uint<3> c_old = c++;
+            bool test_incr = c_old == 6 && c == 7 && ++c == 0 && --c == 7;
+            c += 3;
+            test_incr = test_incr && c == 2;
+            c *= 5;
+            test_incr = test_incr && c == 2;
+            CHECK_TRUE(test_incr);
+
+            // Check 3: Floating point values are truncated, and widths can be mixed.
+
+            ap_uint<16> d = 100.9f, e = 0.0067f * (ap_uint<16>(10) - ap_uint<16>(20000)) + 20000;
+            ap_uint<11> f = ap_uint<9>(300);
+            bool test_conv = d == 100 && e == 19866 && f == 300 && sizeof(ap_uint<9>) == 2;
+            CHECK_TRUE(test_conv);
+
+            return test_wrap && test_incr && test_conv;
+        }
+
+        bool test_stream()
+        {
+            // Check 1: Values arrive in order across threads, with far more values than the capacity.
+
+            hls::stream<unsigned int, 1> s0("s0");
+            std::thread producer([&s0]() { for(unsigned int k = 0; k < 100000; ++k) s0.write(k); });
+
+            bool test_order = true;
+            for(unsigned int k = 0; k < 100000; ++k) test_order = test_order && s0.read() == k;
+            producer.join();
+            test_order = test_order && s0.empty();
+            CHECK_TRUE(test_order);
+
+            // Check 2: The capacity is bounded.
+
+            hls::stream<unsigned int> s1;
+            std::size_t written = 0;
+            while(s1.write_nb(written)) ++written;
+
+            unsigned int val = 0;
+            bool test_bounded = written == MOTDET_EMU_STREAM_CAPACITY && s1.full() && s1.size() == written && s1.read_nb(val) && val == 0 && !s1.full();
+            CHECK_TRUE(test_bounded);
+
+            return test_order && test_bounded;
+        }
+
+        namespace
+        {
+            // Runs a frame through the IP core, fed from another thread like a DMA would, and collects the contours.
+            // The default configuration goes through the top function, any other one through the template directly.
+            // Given a reference, the one in external memory is used instead of the on-chip one.
+            template <typename CFG = motdet::Top_config>
+            std::vector<typename CFG::Contour> run_frame_(const std::vector<std::uint16_t> &frame, typename CFG::Pix_vec *reference = nullptr,
+                                                          const typename CFG::Channel channel = 0)
+            {
+                hls::stream<typename CFG::Packed_pix, MOTDET_STREAM_DEPTH> in("in");
+                hls::stream<typename CFG::Streamed_contour, MOTDET_STREAM_DEPTH> out("out");
+
+                std::thread feeder([&in, &frame]()
+                {
+                    for(std::size_t i = 0; i < CFG::original_total; i += CFG::beat_pixels)
+                    {
+                        typename CFG::Packed_pix packed;
+                        for(std::size_t k = 0; k < CFG::beat_pixels; ++k) packed.pix[k] = frame[i + k];
+                        in.write(packed);
+                    }
+                });
+                if(reference) motdet::detect_motion<CFG>(in, out, reference, reference, channel);
+                else if constexpr(std::is_same<CFG, motdet::Top_config>::value && !MOTDET_REFERENCE_IN_DDR && MOTDET_CHANNELS == 1) detect_motion(in, out);
+                else motdet::detect_motion<CFG>(in, out, channel);
+                feeder.join();
+
+                std::vector<typename CFG::Contour> conts;
+                for(typename CFG::Streamed_contour cont = out.read(); !cont.stream_end; cont = out.read()) conts.push_back(cont.contour);
+                return conts;
+            }
+
+            // Whether two sets of contours, possibly of different configurations, hold the same boxes in the same order.
+            template <typename CONT_A, typename CONT_B>
+            bool same_contours_(const std::vector<CONT_A> &a, const std::vector<CONT_B> &b)
+            {
+                bool same = a.size() == b.size();
+                for(std::size_t c = 0; same && c < a.size(); ++c)
+                {
+                    same = a[c].bb_tl_x == b[c].bb_tl_x && a[c].bb_tl_y == b[c].bb_tl_y &&
+                           a[c].bb_br_x == b[c].bb_br_x && a[c].bb_br_y == b[c].bb_br_y;
+                }
+                return same;
+            }
+
+            // Frame of a textured scene, different for every seed, with a bright square at a given position.
+            std::vector<std::uint16_t> square_frame_(const std::size_t width, const std::size_t height, const std::size_t seed,
+                                                     const std::size_t top, const std::size_t left, const std::size_t side)
+            {
+                std::vector<std::uint16_t> frame(width*height);
+                for(std::size_t i = 0; i < height; ++i)
+                    for(std::size_t j = 0; j < width; ++j)
+                    {
+                        bool square = i >= top && i < top + side && j >= left && j < left + side;
+                        frame[i*width + j] = square ? 63000 : 10000 + (i*(7 + seed) + j*(13 + 2*seed)) % 20000;
+                    }
+                return frame;
+            }
+
+            // Runs a kernel of CFG on a downsampled image, packing its pixels in the vectors of CFG, and unpacks the output.
+            template <typename CFG, typename IN_VEC, typename OUT_VEC>
+            std::vector<long long> run_kernel_(void (*process)(hls::stream<IN_VEC, MOTDET_STREAM_DEPTH>&, hls::stream<OUT_VEC, MOTDET_STREAM_DEPTH>&),
+                                               const std::vector<long long> &pixels)
+            {
+                hls::stream<IN_VEC, MOTDET_STREAM_DEPTH> in("in");
+                hls::stream<OUT_VEC, MOTDET_STREAM_DEPTH> out("out");
+                std::vector<long long> res;
+                {
+                    hls_emu::Dataflow region;
+                    region.process([&]()
+                    {
+                        for(std::size_t i = 0; i < pixels.size(); i += CFG::pixels_per_clock)
+                        {
+                            IN_VEC vec;
+                            for(std::size_t p = 0; p < CFG::pixels_per_clock; ++p) vec.pix[p] = pixels[i + p];
+                            in.write(vec);
+                        }
+                    });
+                    region.process([&](){ process(in, out); });
+                    for(std::size_t i = 0; i < pixels.size(); i += CFG::pixels_per_clock)
+                    {
+                        OUT_VEC vec = out.read();
+                        for(std::size_t p = 0; p < CFG::pixels_per_clock; ++p) res.push_back(vec.pix[p]);
+                    }
+                }
+                return res;
+            }
+        }
+
+        bool test_detect_motion()
+        {
+            // A square appears on a static scene. The first frame becomes the reference.
+
+            std::vector<std::uint16_t> frame(motdet::Top_config::original_total, 13000);
+
+            bool test_static = run_frame_(frame).empty() && run_frame_(frame).empty();
+            CHECK_TRUE(test_static);
+
+            for(std::size_t i = 400; i < 600; ++i)
+                for(std::size_t j = 400; j < 600; ++j) frame[i*motdet::Top_config::original_width + j] = 63000;
+
+            std::vector<motdet::Contour> conts = run_frame_(frame);
+            bool test_motion = conts.size() == 1;
+            CHECK_TRUE(test_motion);
+            if(test_motion)
+            {
+                const motdet::Contour &cont = conts[0];
+                test_motion = cont.bb_tl_x >= 380 && cont.bb_tl_x <= 400 && cont.bb_br_x >= 596 && cont.bb_br_x <= 616 &&
+                              cont.bb_tl_y >= 380 && cont.bb_tl_y <= 400 && cont.bb_br_y >= 596 && cont.bb_br_y <= 616;
+                CHECK_TRUE(test_motion);
+            }
+
+            return test_static && test_motion;
+        }
+
+        bool test_configurations()
+        {
+            // Check 1: The derived widths of 1080p are the ones the IP core was written with by hand.
+
+            using C1080 = motdet::Config_1080p;
+            bool test_widths = motdet::bits_for(0) == 1 && motdet::bits_for(1) == 1 && motdet::bits_for(2) == 2 && motdet::bits_for(480) == 9 &&
+                               C1080::width == 480 && C1080::height == 270 && C1080::col_bits == 9 && C1080::row_bits == 9 &&
+                               C1080::original_row_bits == 11 && C1080::pixel_bits == 17 && C1080::coord_bits == 11 &&
+                               C1080::block_sum_bits == 20 && C1080::tag_bits == 10 && C1080::null_tag == 0x3FF && C1080::min_cont_area == 523 &&
+                               motdet::Config_4k::coord_bits == 12 && motdet::Config_4k::col_bits == 10;
+            CHECK_TRUE(test_widths);
+
+            // Check 2: A 720p core finds a square moving in, with its own reference.
+
+            using C720 = motdet::Config_720p;
+            std::vector<std::uint16_t> frame(C720::original_total, 13000);
+            bool test_720p = run_frame_<C720>(frame).empty() && run_frame_<C720>(frame).empty();
+            for(std::size_t i = 200; i < 400; ++i)
+                for(std::size_t j = 800; j < 1000; ++j) frame[i*C720::original_width + j] = 63000;
+
+            std::vector<C720::Contour> conts = run_frame_<C720>(frame);
+            test_720p = test_720p && conts.size() == 1;
+            if(test_720p)
+            {
+                const C720::Contour &cont = conts[0];
+                test_720p = cont.bb_tl_x >= 780 && cont.bb_tl_x <= 800 && cont.bb_br_x >= 996 && cont.bb_br_x <= 1016 &&
+                            cont.bb_tl_y >= 180 && cont.bb_tl_y <= 200 && cont.bb_br_y >= 396 && cont.bb_br_y <= 416;
+            }
+            CHECK_TRUE(test_720p);
+
+            return test_widths && test_720p;
+        }
+
+        bool test_pixels_per_clock()
+        {
+            using C1 = motdet::Motdet_config<640, 360, 2, 1023, 1>;
+            using C2 = motdet::Motdet_config<640, 360, 2, 1023, 2>;
+            using C4 = motdet::Motdet_config<640, 360, 2, 1023, 4>;
+
+            // Check 1: The blur and the dilation give the same image with any pixels per clock, borders included.
+
+            std::vector<long long> gray(C1::total), bin(C1::total);
+            unsigned int seed = 12345;
+            for(std::size_t k = 0; k < C1::total; ++k)
+            {
+                seed = seed*1103515245 + 12345;
+                gray[k] = (seed >> 8) & 0xFFFF;
+                bin[k] = (seed >> 20) % 7 == 0;
+            }
+
+            auto blur1 = run_kernel_<C1, C1::Pix_vec, C1::Pix_vec>(motdet::imgutil::gaussian_blur<C1>, gray);
+            auto blur2 = run_kernel_<C2, C2::Pix_vec, C2::Pix_vec>(motdet::imgutil::gaussian_blur<C2>, gray);
+            auto blur4 = run_kernel_<C4, C4::Pix_vec, C4::Pix_vec>(motdet::imgutil::gaussian_blur<C4>, gray);
+            auto dil1 = run_kernel_<C1, C1::Bin_vec, C1::Bin_vec>(motdet::imgutil::dilation<C1>, bin);
+            auto dil2 = run_kernel_<C2, C2::Bin_vec, C2::Bin_vec>(motdet::imgutil::dilation<C2>, bin);
+            auto dil4 = run_kernel_<C4, C4::Bin_vec, C4::Bin_vec>(motdet::imgutil::dilation<C4>, bin);
+
+            bool test_kernels = blur1 == blur2 && blur1 == blur4 && dil1 == dil2 && dil1 == dil4 && blur1 != gray && dil1 != bin;
+            CHECK_TRUE(test_kernels);
+
+            // Check 2: A square moving over a textured scene gives the same contours, frame by frame.
+
+            bool test_sequence = true, found = false;
+            for(std::size_t f = 0; f < 4; ++f)
+            {
+                std::vector<std::uint16_t> frame(C1::original_total);
+                for(std::size_t i = 0; i < C1::original_height; ++i)
+                    for(std::size_t j = 0; j < C1::original_width; ++j)
+                    {
+                        bool square = i >= 100 && i < 180 && j >= 100 + f*40 && j < 180 + f*40;
+                        frame[i*C1::original_width + j] = square ? 63000 : 10000 + (i*7 + j*13) % 20000;
+                    }
+
+                auto conts1 = run_frame_<C1>(frame);
+                auto conts2 = run_frame_<C2>(frame);
+                auto conts4 = run_frame_<C4>(frame);
+                found = found || !conts1.empty();
+
+                bool same = conts1.size() == conts2.size() && conts1.size() == conts4.size();
+                for(std::size_t c = 0; same && c < conts1.size(); ++c)
+                {
+                    same = conts1[c].bb_tl_x == conts2[c].bb_tl_x && conts1[c].bb_tl_x == conts4[c].bb_tl_x &&
+                           conts1[c].bb_tl_y == conts2[c].bb_tl_y && conts1[c].bb_tl_y == conts4[c].bb_tl_y &&
+                           conts1[c].bb_br_x == conts2[c].bb_br_x && conts1[c].bb_br_x == conts4[c].bb_br_x &&
+                           conts1[c].bb_br_y == conts2[c].bb_br_y && conts1[c].bb_br_y == conts4[c].bb_br_y;
+                }
+                test_sequence = test_sequence && same;
+            }
+            test_sequence = test_sequence && found;
+            CHECK_TRUE(test_sequence);
+
+            return test_kernels && test_sequence;
+        }
+
+        bool test_external_reference()
+        {
+            using C = motdet::Motdet_config<640, 360, 2, 1023, 2>;
+            motdet::imgutil::reset_reference<C>();
+
+            // Check 1: A square moving over a textured scene gives the same contours with the reference in either memory.
+
+            std::vector<C::Pix_vec> ddr(C::total / C::pixels_per_clock);
+            for(C::Pix_vec &vec : ddr) for(auto &pix : vec.pix) pix = 12345; // Whatever the buffer held before.
+
+            bool test_contours = true, found = false;
+            for(std::size_t f = 0; f < 4; ++f)
+            {
+                std::vector<std::uint16_t> frame = square_frame_(C::original_width, C::original_height, 0, 100, 100 + f*40, 80);
+
+                auto conts_bram = run_frame_<C>(frame);
+                auto conts_ddr = run_frame_<C>(frame, ddr.data());
+                found = found || !conts_ddr.empty();
+                test_contours = test_contours && same_contours_(conts_bram, conts_ddr);
+            }
+            test_contours = test_contours && found;
+            CHECK_TRUE(test_contours);
+
+            // Check 2: Both hold the same reference afterwards.
+
+            bool test_reference = true;
+            for(std::size_t k = 0; k < ddr.size(); ++k)
+                for(std::size_t p = 0; p < C::pixels_per_clock; ++p)
+                    test_reference = test_reference && ddr[k].pix[p] == motdet::imgutil::Reference_<C>::pixels[0][k / C::vec_width][k % C::vec_width].pix[p];
+            CHECK_TRUE(test_reference);
+
+            return test_contours && test_reference;
+        }
+
+        bool test_channels()
+        {
+            using C = motdet::Motdet_config<640, 360, 2, 1023, 2, 3>;
+            using C_single = motdet::Motdet_config<640, 360, 2, 1023, 2>;
+            const std::size_t channels = C::channels, frames = 4;
+
+            // Three cameras, each with its own scene and a square moving its own way.
+            auto camera = [](std::size_t c, std::size_t f)
+            {
+                return square_frame_(C::original_width, C::original_height, c, 60 + c*80, 80 + f*(30 + c*10), 60 + c*10);
+            };
+
+            // Every camera on its own, through a core of a single channel.
+            std::vector<std::vector<std::vector<C_single::Contour>>> expected(channels);
+            for(std::size_t c = 0; c < channels; ++c)
+            {
+                motdet::imgutil::reset_reference<C_single>();
+                for(std::size_t f = 0; f < frames; ++f) expected[c].push_back(run_frame_<C_single>(camera(c, f)));
+            }
+
+            // Check 1: The frames of every camera interleaved round-robin through one core give the same contours as the
+            // camera on its own, with the references on chip and in external memory.
+
+            motdet::imgutil::reset_reference<C>();
+            std::vector<C::Pix_vec> ddr(channels * (C::total / C::pixels_per_clock));
+
+            bool test_interleaved = true, found = false;
+            for(std::size_t f = 0; f < frames; ++f)
+                for(std::size_t c = 0; c < channels; ++c)
+                {
+                    auto conts_bram = run_frame_<C>(camera(c, f), nullptr, c);
+                    auto conts_ddr = run_frame_<C>(camera(c, f), ddr.data(), c);
+                    found = found || !expected[c][f].empty();
+                    test_interleaved = test_interleaved && same_contours_(conts_bram, expected[c][f]) && same_contours_(conts_ddr, expected[c][f]);
+                }
+            test_interleaved = test_interleaved && found;
+            CHECK_TRUE(test_interleaved);
+
+            // Check 2: A channel left idle keeps its reference while the others get frames.
+
+            std::vector<std::uint16_t> idle_ref;
+            for(std::size_t i = 0; i < C::height; ++i)
+                for(std::size_t j = 0; j < C::vec_width; ++j)
+                    for(std::size_t p = 0; p < C::pixels_per_clock; ++p) idle_ref.push_back(motdet::imgutil::Reference_<C>::pixels[0][i][j].pix[p]);
+
+            for(std::size_t c = 1; c < channels; ++c) run_frame_<C>(camera(c, frames), nullptr, c);
+
+            bool test_idle = true;
+            for(std::size_t i = 0, k = 0; i < C::height; ++i)
+                for(std::size_t j = 0; j < C::vec_width; ++j)
+                    for(std::size_t p = 0; p < C::pixels_per_clock; ++p, ++k)
+                        test_idle = test_idle && idle_ref[k] == motdet::imgutil::Reference_<C>::pixels[0][i][j].pix[p];
+            CHECK_TRUE(test_idle);
+
+            return test_interleaved && test_idle;
+        }
+
+        bool test_empty_rows()
+        {
+            using C = motdet::Motdet_config<640, 360, 2>;
+            using Cycles = motdet::imgutil::Labeler_cycles_<C>;
+            motdet::imgutil::reset_reference<C>();
+
+            // Check 1: Frames without motion take a clock per row and one to end the contours.
+
+            std::vector<std::uint16_t> frame = square_frame_(C::original_width, C::original_height, 0, 0, 0, 0);
+            run_frame_<C>(frame);
+            bool test_idle = run_frame_<C>(frame).empty() && Cycles::last == C::height + 1;
+            CHECK_TRUE(test_idle);
+
+            // Check 2: Two squares above each other, with empty rows between them, stay apart. Only the rows they cover
+            // are labelled, and the merge output stops after the last representative.
+
+            for(std::size_t i = 40; i < 80; ++i)
+                for(std::size_t j = 200; j < 280; ++j) frame[i*C::original_width + j] = frame[(i + 100)*C::original_width + j] = 63000;
+            std::vector<C::Contour> conts = run_frame_<C>(frame);
+            unsigned long long labelled = Cycles::last - C::height - 1;
+            bool test_apart = conts.size() == 2 && conts[0].bb_tl_y < conts[0].bb_br_y && conts[0].bb_br_y < conts[1].bb_tl_y &&
+                              labelled > 0 && labelled < C::total / 4;
+            CHECK_TRUE(test_apart);
+
+            return test_idle && test_apart;
+        }
+    } // namespace emulation
+} // namespace test
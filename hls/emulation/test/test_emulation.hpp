@@ -0,0 +1,23 @@
+#ifndef __TEST_MOTDET_EMULATION_HPP__
+#define __TEST_MOTDET_EMULATION_HPP__
+
+#include "motion_detector.hpp"
+
+namespace test
+{
+    namespace emulation
+    {
+        void test_all();
+
+        bool test_ap_uint();
+        bool test_stream();
+        bool test_detect_motion();
+        bool test_configurations();
+        bool test_pixels_per_clock();
+        bool test_external_reference();
+        bool test_channels();
+        bool test_empty_rows();
+    } // namespace emulation
+} // namespace test
+
+#endif // __TEST_MOTDET_EMULATION_HPP__
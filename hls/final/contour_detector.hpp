@@ -2,22 +2,230 @@
 #define __MOTDET_CONTOUR_DETECTOR_HPP__
 
 #include <cstdint>
+#include "hls_math.h"
 #include "hls_stream.h"
 #include "ap_int.h"
 
-#include "motion_detector.hpp"
+#include "motdet_config.hpp"
 
 namespace motdet
 {
     namespace imgutil
     {
+    #ifndef __SYNTHESIS__
+        /**
+         * @brief Clock cycles connected_components took on the last frame in C simulation, estimated as the iterations of
+         * its pipelined loops times their initiation interval, without their depth.
+         */
+        template <typename CFG> struct Labeler_cycles_
+        {
+            static unsigned long long last;
+        };
+        template <typename CFG> unsigned long long Labeler_cycles_<CFG>::last = 0;
+    #define MOTDET_COUNT_CYCLES(n) (Labeler_cycles_<CFG>::last += (n))
+    #else
+    #define MOTDET_COUNT_CYCLES(n)
+    #endif
+
+        template <typename CFG>
+        class Disjoint_contour_connector
+        {
+        public:
+            using Tag = ap_uint<CFG::tag_bits>;
+            using Col = ap_uint<CFG::col_bits>;
+            using Row = ap_uint<CFG::row_bits>;
+
+            Disjoint_contour_connector(){}
+
+            Tag add_cont(Col point_x, Row point_y)
+            {
+                if(conts.contour_count >= CFG::max_contours) return CFG::null_tag;
+
+                Tag new_tag = conts.contour_count++;
+                ++roots;
+                conts.contours[new_tag].bb_br_x = point_x;
+                conts.contours[new_tag].bb_tl_x = point_x;
+                conts.contours[new_tag].bb_br_y = point_y;
+                conts.contours[new_tag].bb_tl_y = point_y;
+                parents[new_tag] = CFG::null_tag;
+                return new_tag;
+            }
+
+            void update_cont(Tag tag, Col point_x, Row point_y)
+            {
+                Tag repr = get_repr(tag);
+                if(point_x < conts.contours[repr].bb_tl_x) conts.contours[repr].bb_tl_x = point_x;
+                else if(point_x > conts.contours[repr].bb_br_x) conts.contours[repr].bb_br_x = point_x;
+                if(point_y < conts.contours[repr].bb_tl_y) conts.contours[repr].bb_tl_y = point_y;
+                else if(point_y > conts.contours[repr].bb_br_y) conts.contours[repr].bb_br_y = point_y;
+            }
+
+            Tag get_repr(Tag c)
+            {
+                Tag og_c = c;
+                Tag parent = parents[c];
+                while(parent != CFG::null_tag)
+                {
+#pragma HLS LOOP_TRIPCOUNT avg=1 max=2 min=0
+                    c = parents[c];
+                    parent = parents[c];
+                }
+                if(og_c != c) parents[og_c] = c;
+                return c;
+            }
+
+            void merge(Tag c0, Tag c1)
+            {
+                Tag repr_c0 = get_repr(c0);
+                Tag repr_c1 = get_repr(c1);
+                if(repr_c0 != repr_c1)
+                {
+                    parents[repr_c0] = repr_c1;
+                    --roots;
+                }
+                update_cont(repr_c1, conts.contours[repr_c0].bb_br_x, conts.contours[repr_c0].bb_br_y);
+                update_cont(repr_c1, conts.contours[repr_c0].bb_tl_x, conts.contours[repr_c0].bb_tl_y);
+            }
+
+            void get_merged_conts(hls::stream<typename CFG::Streamed_contour, MOTDET_STREAM_DEPTH> &out)
+            {
+                typename CFG::Streamed_contour streamed_cont;
+
+                // Stop as soon as every representative has been found, none at all on empty frames.
+                Tag roots_left = roots;
+                for(Tag k = 0; roots_left > 0; ++k)
+                {
+#pragma HLS LOOP_TRIPCOUNT avg=30 max=1023 min=0
+#pragma HLS PIPELINE II=2
+                    MOTDET_COUNT_CYCLES(2);
+                    if(parents[k] == CFG::null_tag)
+                    {
+                        --roots_left;
+                        ap_uint<CFG::pixel_bits> area = hls::abs((conts.contours[k].bb_tl_x - conts.contours[k].bb_br_x) * (conts.contours[k].bb_tl_y - conts.contours[k].bb_br_y));
+                        if(area >= CFG::min_cont_area)
+                        {
+                            streamed_cont.contour = conts.contours[k];
+                            streamed_cont.contour.bb_tl_x *= CFG::reduction_factor;
+                            streamed_cont.contour.bb_tl_y *= CFG::reduction_factor;
+                            streamed_cont.contour.bb_br_x *= CFG::reduction_factor;
+                            streamed_cont.contour.bb_br_y *= CFG::reduction_factor;
+                            streamed_cont.stream_end = false;
+                            out.write(streamed_cont);
+                        }
+                    }
+                }
+                streamed_cont.stream_end = true;
+                out.write(streamed_cont);
+                MOTDET_COUNT_CYCLES(1);
+            }
+
+        private:
+            typename CFG::Contour_package conts;
+            Tag roots = 0; /**< Contours that have not been merged into another one. */
+            Tag parents[CFG::max_contours];
+        };
 
         /**
          * @brief Detect connected components (contours) in a streamed binary image.
-         * @param in Binary image. All values must be either 0 or 1 upon input. It is completely consumed.
+         * @details The tags of a pixel depend on the ones of the pixel before, so pixels are tagged one per clock even when
+         * the input carries several per transaction. Rows without any pixel set are skipped in a clock, so an empty frame
+         * takes CFG::height clocks instead of CFG::total.
+         * @param in Rows of the binary image with some pixel set, as output by dilation. All values must be either 0 or 1
+         * upon input. It is completely consumed.
+         * @param active_rows Whether each row of the image has some pixel set, before the row itself.
          * @param conts The found contour boundign boxes without hierarchy.
          */
-    	void connected_components(hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> &in, hls::stream<motdet::Streamed_contour, MOTDET_STREAM_DEPTH> &out);
+        template <typename CFG>
+        void connected_components(hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> &active_rows,
+                                  hls::stream<typename CFG::Streamed_contour, MOTDET_STREAM_DEPTH> &out)
+        {
+            using Tag = typename Disjoint_contour_connector<CFG>::Tag;
+
+        // Find the contours in the image, we are using a one pass algorithm so in some cases it is not possible to know if 2 pixels belong to the same object.
+        // This why we tag them as different contours and then "merge" them when a pixel that connects both is discovered.
+        // In essence, we have a graph of blobs with a set of connections (mergers), so we can use well known graph theory algorithms here.
+        // Use a disjoint-set data structures, based on a list of trees with representative nodes.
+
+        #ifndef __SYNTHESIS__
+            Tag *buffer = new Tag[CFG::width];
+            Disjoint_contour_connector<CFG> &dcc = *(new Disjoint_contour_connector<CFG>());
+        #else
+            Tag buffer[CFG::width];
+            Disjoint_contour_connector<CFG> dcc;
+        #endif
+
+            // CFG::null_tag will be the tag representing a null tag.
+            // The buffer only holds the tags of the row above if it had some pixel set, otherwise they are all null.
+            Tag prev = CFG::null_tag, top_prev, tag;
+            bool top_active = false;
+            typename CFG::Bin_vec read_vec;
+
+        #ifndef __SYNTHESIS__
+            Labeler_cycles_<CFG>::last = 0;
+        #endif
+
+            for(ap_uint<CFG::row_bits> i = 0; i < CFG::height; ++i)
+            {
+                MOTDET_COUNT_CYCLES(1);
+                if(!active_rows.read())
+                {
+                    // Every tag of an empty row is null, as the last one that would be carried to the next row.
+                    prev = CFG::null_tag;
+                    top_active = false;
+                    continue;
+                }
+
+                for(ap_uint<CFG::col_bits> j = 0; j < CFG::width; ++j)
+                {
+#pragma HLS PIPELINE
+                    MOTDET_COUNT_CYCLES(1);
+                    tag = CFG::null_tag;
+
+                    if(j % CFG::pixels_per_clock == 0) read_vec = in.read();
+                    ap_uint<1> read_val = read_vec.pix[j % CFG::pixels_per_clock];
+                    if(read_val)
+                    {
+                        if(prev != CFG::null_tag){
+                            // Previous pix to the left exists
+                            tag = prev;
+
+                            top_prev = top_active ? buffer[j] : Tag(CFG::null_tag);
+                            if(top_prev != CFG::null_tag)
+                            {
+                                // And top pix also exists, check for merge.
+                                if(top_prev != tag) dcc.merge(top_prev, tag);
+                            }
+                        }
+                        else
+                        {
+                            top_prev = top_active ? buffer[j] : Tag(CFG::null_tag);
+                            if(top_prev != CFG::null_tag)
+                            {
+                                // Only the top pix exists.
+                                tag = top_prev;
+                            }
+                            else
+                            {
+                                // Neither pix exists, this is a new contour.
+                                tag = dcc.add_cont(j, i);
+                            }
+                        }
+                    }
+
+                    prev = tag;
+                    buffer[j] = tag;
+                    if(tag != CFG::null_tag) dcc.update_cont(tag, j, i);
+                }
+                top_active = true;
+            }
+
+            dcc.get_merged_conts(out);
+
+        #ifndef __SYNTHESIS__
+            delete[] buffer;
+            delete &dcc;
+        #endif
+        }
 
     } // namespace imgutil
 } // namespace motdet
@@ -1,50 +1,588 @@
 #ifndef __MOTDET_IMAGE_UTILS_HPP__
 #define __MOTDET_IMAGE_UTILS_HPP__
 
-#include "motion_detector.hpp"
+#include "motdet_config.hpp"
+#include "hls_math.h"
 #include "hls_stream.h"
 #include "ap_int.h"
 
 #include <cstdint>
 
+// The kernels are templates on a Motdet_config, so they are defined here. Sizes and bit widths all come from CFG.
+// After the downsample, every transaction carries CFG::pixels_per_clock pixels of a row, which are processed in parallel.
+
 namespace motdet
 {
     namespace imgutil
     {
+        namespace // Anonymous namespace
+        {
+            const ap_uint<7> gaussian_kernel[5] = { 16, 62, 99, 62, 16 }; // Total 255
+        } // Anonymous namespace
+
+        /**
+         * @brief Reference images of a configuration, one per channel, kept from one frame of the channel to the next.
+         * One vector of pixels per transaction. The pixels are only instantiated, and take BRAM, if the on-chip version
+         * of apply_reference is used.
+         */
+        template <typename CFG> struct Reference_
+        {
+            static typename CFG::Pix_vec pixels[CFG::channels][CFG::height][CFG::vec_width];
+            static bool valid[CFG::channels];          /**< The on-chip reference of a channel holds a frame.           */
+            static bool external_valid[CFG::channels]; /**< The reference of a channel in external memory holds a frame. */
+        };
+        template <typename CFG> typename CFG::Pix_vec Reference_<CFG>::pixels[CFG::channels][CFG::height][CFG::vec_width];
+        template <typename CFG> bool Reference_<CFG>::valid[CFG::channels] = {};
+        template <typename CFG> bool Reference_<CFG>::external_valid[CFG::channels] = {};
+
+        /**
+         * @brief Interpolates a vector of the reference towards a vector of the frame.
+         * @return The absolute difference between the frame and the updated reference.
+         */
+        template <typename CFG>
+        typename CFG::Pix_vec update_reference_(typename CFG::Pix_vec &ref, const typename CFG::Pix_vec &to_vec, const float update_ratio)
+        {
+            typename CFG::Pix_vec sub_vec;
+            for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p)
+            {
+                ap_uint<16> from_val = ref.pix[p];
+                ap_uint<16> to_val = to_vec.pix[p];
+                ap_uint<16> new_val = from_val + update_ratio * (to_val - from_val); // Simplified from equation: from*(1-ratio) + to*ratio
+                ref.pix[p] = new_val;
+
+                sub_vec.pix[p] = hls::abs(to_val - new_val);
+            }
+            return sub_vec;
+        }
+
+        /**
+         * @brief Sliding window over a row streamed in vectors of PPC pixels, for horizontal kernels of a given radius.
+         * @details Once a vector is pushed, the window holds the pixels from RADIUS before the vector pushed LAG vectors
+         * earlier, the one that can be output now, up to the last pixel pushed. Every loop over it is unrolled in the
+         * pipelined loops of the kernels, so it becomes a shift register.
+         */
+        template <typename T, unsigned int PPC, unsigned int RADIUS>
+        class Row_window_
+        {
+        public:
+            static constexpr unsigned int lag = (RADIUS + PPC - 1) / PPC; /**< Vectors pushed before one can be output. */
+            static constexpr unsigned int size = RADIUS + (lag + 1) * PPC;
+
+            void fill(const T val)
+            {
+                for(unsigned int k = 0; k < size; ++k) pix_[k] = val;
+            }
+
+            void push(const T (&vec)[PPC])
+            {
+                for(unsigned int k = 0; k + PPC < size; ++k) pix_[k] = pix_[k + PPC];
+                for(unsigned int p = 0; p < PPC; ++p) pix_[size - PPC + p] = vec[p];
+            }
+
+            /**
+             * @brief Pixel at an offset from the first pixel of the vector being output. From -RADIUS to PPC-1+RADIUS.
+             */
+            T at(const int offset) const { return pix_[RADIUS + offset]; }
+
+            /**
+             * @brief Last pixel pushed.
+             */
+            T last() const { return pix_[size - 1]; }
+
+        private:
+            T pix_[size];
+        };
+
+        /**
+         * @brief Blurs a vector of pixels vertically, from the 5 rows of the ring buffer starting at first_row.
+         */
+        template <typename CFG, typename BUFFER_T>
+        typename CFG::Pix_vec gaussian_blur_column_(BUFFER_T buffer, const ap_uint<3> first_row, const ap_uint<CFG::vec_col_bits> j)
+        {
+            typename CFG::Pix_vec res_vec;
+            for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p)
+            {
+                ap_uint<24> res = 0;
+                for(ap_uint<3> k = 0; k < 5; ++k) res += buffer[(first_row+k)%5][j].pix[p] * gaussian_kernel[k];
+                res_vec.pix[p] = res/255;
+            }
+            return res_vec;
+        }
+
+        template <typename CFG>
+        void gaussian_blur_filter_vline(hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &out)
+        {
+            using Pix_vec = typename CFG::Pix_vec;
+
+        #ifndef __SYNTHESIS__
+            Pix_vec** buffer = new Pix_vec*[5];
+            for(ap_uint<3> i = 0; i < 5; ++i) buffer[i] = new Pix_vec[CFG::vec_width];
+        #else
+            Pix_vec buffer[5][CFG::vec_width];
+#pragma HLS ARRAY_PARTITION variable=buffer dim=1 complete
+        #endif
+
+            ap_uint<3> buffer_ptr = 0;
+
+            // The first row we read will need to fill out the 2 extra pixels outside the border of the image.
+            for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j)
+            {
+#pragma HLS PIPELINE
+                Pix_vec curr_val = in.read();
+                buffer[3][j] = curr_val;
+                buffer[4][j] = curr_val;
+                buffer[0][j] = curr_val;
+            }
+
+            // The second row just needs to be written to the buffer, but we cannot still output results because we only have 4 rows out of 5.
+            for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j){
+#pragma HLS PIPELINE
+                buffer[1][j] = in.read();
+            }
+
+            // Now iterate over the rest of the rows, now each row we get, we can output results.
+            for(ap_uint<CFG::row_bits> i = 2; i < CFG::height; ++i)
+            {
+                buffer_ptr = i%5;
+                for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j)
+                {
+#pragma HLS PIPELINE
+                    buffer[buffer_ptr][j] = in.read();
+                    out.write(gaussian_blur_column_<CFG>(buffer, buffer_ptr+1, j));
+                }
+            }
+
+            // Now we have iterated the whole image, but we only have outputted height-2 rows.
+            // Output those last 2 rows now extending the pixels at the border of the image.
+            // The previous row is taken as (buffer_ptr+4)%5, buffer_ptr-1 would be negative for heights where it ends at 0.
+            for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j){
+#pragma HLS PIPELINE
+                buffer[buffer_ptr][j] = buffer[(buffer_ptr+4)%5][j];
+                out.write(gaussian_blur_column_<CFG>(buffer, buffer_ptr+1, j));
+            }
+
+            for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j){
+#pragma HLS PIPELINE
+                buffer[(buffer_ptr+1)%5][j] = buffer[buffer_ptr][j];
+                out.write(gaussian_blur_column_<CFG>(buffer, buffer_ptr+2, j));
+            }
+
+        #ifndef __SYNTHESIS__
+            for(ap_uint<3> i = 0; i < 5; ++i) delete[] buffer[i];
+            delete[] buffer;
+        #endif
+        }
+
+        template <typename CFG>
+        void gaussian_blur_filter_hline(hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &out)
+        {
+            using Window = Row_window_<ap_uint<16>, CFG::pixels_per_clock, 2>;
+            Window window;
+
+            for(ap_uint<CFG::row_bits> i = 0; i < CFG::height; ++i)
+            {
+                // The row is extended 2 pixels at each side with its first and last pixels, pushed as whole vectors at the
+                // end, and every vector is output once the 2 pixels after it are in the window.
+                for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width + Window::lag; ++j)
+                {
+#pragma HLS PIPELINE
+                    typename CFG::Pix_vec vec;
+                    if(j < CFG::vec_width)
+                    {
+                        vec = in.read();
+                        if(j == 0) window.fill(vec.pix[0]);
+                    }
+                    else for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p) vec.pix[p] = window.last();
+                    window.push(vec.pix);
+
+                    if(j < Window::lag) continue;
+
+                    typename CFG::Pix_vec res_vec;
+                    for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p)
+                    {
+                        ap_uint<24> res = 0;
+                        for(ap_uint<3> k = 0; k < 5; ++k) res += window.at(p + k - 2) * gaussian_kernel[k];
+                        res_vec.pix[p] = res/255;
+                    }
+                    out.write(res_vec);
+                }
+            }
+        }
+
         /**
          * @brief Apply a 5x5 blurring filter to an image using a split kernel.
          * @param in Grayscale streamed image to blur.
          * @param out Grayscale streamed blurred image.
          */
-        void gaussian_blur(hls::stream<ap_uint<16>, MOTDET_STREAM_DEPTH> &in, hls::stream<ap_uint<16>, MOTDET_STREAM_DEPTH> &out);
+        template <typename CFG>
+        void gaussian_blur(hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &out)
+        {
+#pragma HLS DATAFLOW
+            hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> half_blurred("half-blurred");
+            MOTDET_DATAFLOW_REGION;
+
+            // An NxN gaussian blur can be decomposed into 2 1-dimensional kernels, N vertical and N horizontal.
+            MOTDET_DATAFLOW_PROCESS(gaussian_blur_filter_vline<CFG>(in, half_blurred));
+            MOTDET_DATAFLOW_PROCESS(gaussian_blur_filter_hline<CFG>(half_blurred, out));
+        }
 
         /**
          * @brief Resizes to a lower resolution by a given factor. Ignores floating point precision.
          * @param in Streamed image to resize, will use the sizes original_width and original_height. with packed pixels.
          * @param out Resized image.
          */
-        void downsample(hls::stream<motdet::Packed_pix, MOTDET_STREAM_DEPTH> &in, hls::stream<ap_uint<16>, MOTDET_STREAM_DEPTH> &out);
+        template <typename CFG>
+        void downsample(hls::stream<typename CFG::Packed_pix, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &out)
+        {
+            using Sum = ap_uint<CFG::block_sum_bits>;
+
+        #ifndef __SYNTHESIS__
+            Sum (*buffer)[CFG::pixels_per_clock] = new Sum[CFG::vec_width][CFG::pixels_per_clock];
+        #else
+            Sum buffer[CFG::vec_width][CFG::pixels_per_clock];
+#pragma HLS ARRAY_PARTITION variable=buffer dim=2 complete
+        #endif
+
+            ap_uint<CFG::factor_sq_bits> squared_red_factor = CFG::reduction_factor*CFG::reduction_factor;
+
+            for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j)
+                for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p) buffer[j][p] = 0;
+
+            for(ap_uint<CFG::original_row_bits> i = 0; i < CFG::original_height; ++i)
+            {
+                // Keep filling the buffer
+                for(ap_uint<CFG::vec_col_bits> motdet_j = 0; motdet_j < CFG::vec_width; ++motdet_j)
+                {
+#pragma HLS PIPELINE
+                    typename CFG::Packed_pix packed = in.read();
+                    for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p)
+                    {
+                        ap_uint<CFG::beat_sum_bits> total = 0;
+                        for(ap_uint<CFG::factor_bits> k = 0; k < CFG::reduction_factor; ++k) total += packed.pix[p*CFG::reduction_factor + k];
+                        buffer[motdet_j][p] += total;
+                    }
+                }
+
+                // Processed the last line into the buffer, output.
+                if(!((i+1) % CFG::reduction_factor))
+                {
+                    // Line that completes the buffer, start outputting
+                    for(ap_uint<CFG::vec_col_bits> motdet_j = 0; motdet_j < CFG::vec_width; ++motdet_j)
+                    {
+#pragma HLS PIPELINE
+                        typename CFG::Pix_vec vec;
+                        for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p)
+                        {
+                            vec.pix[p] = buffer[motdet_j][p]/squared_red_factor;
+                            buffer[motdet_j][p] = 0;
+                        }
+                        out.write(vec);
+                    }
+                }
+            }
+
+        #ifndef __SYNTHESIS__
+           delete[] buffer;
+        #endif
+        }
 
         /**
-		 * @brief Gets the absolute difference between an image and the reference image, while updating it.
-		 * @param in Grayscale streamed image to subtract.
-		 * @param out Subtracted grayscale image, values are always positive.
-		 */
-        void apply_reference(hls::stream<ap_uint<16>, MOTDET_STREAM_DEPTH> &in, hls::stream<ap_uint<16>, MOTDET_STREAM_DEPTH> &out);
+         * @brief Gets the absolute difference between an image and the reference image of its channel, while updating it.
+         * @param in Grayscale streamed image to subtract.
+         * @param out Subtracted grayscale image, values are always positive.
+         * @param channel Camera the image comes from, below CFG::channels.
+         */
+        template <typename CFG>
+        void apply_reference(hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &out,
+                             const typename CFG::Channel channel = 0)
+        {
+            float update_ratio = Reference_<CFG>::valid[channel] ? motdet_frame_update_ratio : 1.0;
+            Reference_<CFG>::valid[channel] = true;
+
+            for(ap_uint<CFG::row_bits> i = 0; i < CFG::height; ++i)
+            {
+                for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j)
+                {
+#pragma HLS PIPELINE
+                    out.write(update_reference_<CFG>(Reference_<CFG>::pixels[channel][i][j], in.read(), update_ratio));
+                }
+            }
+        }
+
+        template <typename CFG>
+        void read_reference_(const typename CFG::Pix_vec *reference, hls::stream<typename CFG::Pix_vec, CFG::vec_width> &out, const typename CFG::Channel channel)
+        {
+            const ap_uint<32> base = channel * (CFG::total / CFG::pixels_per_clock);
+            for(ap_uint<CFG::row_bits> i = 0; i < CFG::height; ++i)
+            {
+                // Consecutive addresses in a pipelined loop, read as a burst per row.
+                for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j)
+                {
+#pragma HLS PIPELINE
+                    out.write(reference[base + i*CFG::vec_width + j]);
+                }
+            }
+        }
+
+        template <typename CFG>
+        void update_reference_rows_(hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Pix_vec, CFG::vec_width> &ref_in,
+                                    hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &out, hls::stream<typename CFG::Pix_vec, CFG::vec_width> &ref_out,
+                                    const typename CFG::Channel channel)
+        {
+            float update_ratio = Reference_<CFG>::external_valid[channel] ? motdet_frame_update_ratio : 1.0;
+            Reference_<CFG>::external_valid[channel] = true;
+
+            for(ap_uint<CFG::vec_pixel_bits> k = 0; k < CFG::total / CFG::pixels_per_clock; ++k)
+            {
+#pragma HLS PIPELINE
+                typename CFG::Pix_vec ref = ref_in.read();
+                out.write(update_reference_<CFG>(ref, in.read(), update_ratio));
+                ref_out.write(ref);
+            }
+        }
+
+        template <typename CFG>
+        void write_reference_(hls::stream<typename CFG::Pix_vec, CFG::vec_width> &in, typename CFG::Pix_vec *reference, const typename CFG::Channel channel)
+        {
+            const ap_uint<32> base = channel * (CFG::total / CFG::pixels_per_clock);
+            for(ap_uint<CFG::row_bits> i = 0; i < CFG::height; ++i)
+            {
+                // Consecutive addresses in a pipelined loop, written as a burst per row.
+                for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j)
+                {
+#pragma HLS PIPELINE
+                    reference[base + i*CFG::vec_width + j] = in.read();
+                }
+            }
+        }
+
+        /**
+         * @brief Same as the on-chip apply_reference, with the reference in external memory instead, so the BRAM used
+         * does not grow with the resolution. Row by row, the reference is read in bursts ahead of the frame into a FIFO
+         * of a line, and the updated rows are written back in bursts.
+         * @details The reference is read and written through separate ports, so each one gets its own burst engine, but
+         * both must point at the same buffer, of CFG::total / CFG::pixels_per_clock vectors per channel, one channel after
+         * the other. Rows are always read before they are written. The reference of a channel is ignored until the first
+         * frame of the channel has been processed.
+         * @param in Grayscale streamed image to subtract.
+         * @param out Subtracted grayscale image, values are always positive.
+         * @param reference_in References in external memory, to read from.
+         * @param reference_out Same references, to write to.
+         * @param channel Camera the image comes from, below CFG::channels.
+         */
+        template <typename CFG>
+        void apply_reference(hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &out,
+                             const typename CFG::Pix_vec *reference_in, typename CFG::Pix_vec *reference_out, const typename CFG::Channel channel = 0)
+        {
+#pragma HLS DATAFLOW
+            hls::stream<typename CFG::Pix_vec, CFG::vec_width> prefetched("prefetched");
+            hls::stream<typename CFG::Pix_vec, CFG::vec_width> updated("updated");
+            MOTDET_DATAFLOW_REGION;
+
+            MOTDET_DATAFLOW_PROCESS(read_reference_<CFG>(reference_in, prefetched, channel));
+            MOTDET_DATAFLOW_PROCESS(update_reference_rows_<CFG>(in, prefetched, out, updated, channel));
+            MOTDET_DATAFLOW_PROCESS(write_reference_<CFG>(updated, reference_out, channel));
+        }
+
+    #ifdef MOTDET_EMULATION
+        /**
+         * @brief Forgets the reference images of every channel, so the next frame of each becomes its new reference as after
+         * a reset of the core. Only in native builds, where a program can feed several unrelated sequences to the IP core.
+         */
+        template <typename CFG>
+        void reset_reference()
+        {
+            for(unsigned int c = 0; c < CFG::channels; ++c) Reference_<CFG>::valid[c] = Reference_<CFG>::external_valid[c] = false;
+        }
+    #endif
 
         /**
          * @brief Collapses all the values in a grayscale image to the states Culled 0 and Strong 1 depending on a threshold.
          * @param in Streamed image to collapse. Used motdet_threshold.
          * @param out Streamed image of the collapsed states.
          */
-        void single_threshold(hls::stream<ap_uint<16>, MOTDET_STREAM_DEPTH> &in, hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> &out);
+        template <typename CFG>
+        void single_threshold(hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &out)
+        {
+            for(ap_uint<CFG::vec_pixel_bits> i = 0; i < CFG::total / CFG::pixels_per_clock; ++i){
+#pragma HLS PIPELINE
+                typename CFG::Pix_vec vec = in.read();
+                typename CFG::Bin_vec bin_vec;
+                for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p) bin_vec.pix[p] = vec.pix[p] > motdet_threshold ? 1 : 0;
+                out.write(bin_vec);
+            }
+        }
+
+        template <typename CFG>
+        void dilation_vline(hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &out)
+        {
+            using Bin_vec = typename CFG::Bin_vec;
+
+        #ifndef __SYNTHESIS__
+            Bin_vec** buffer = new Bin_vec*[2];
+            for(ap_uint<2> i = 0; i < 2; ++i) buffer[i] = new Bin_vec[CFG::vec_width];
+        #else
+            Bin_vec buffer[2][CFG::vec_width];
+        #endif
+            ap_uint<3> buffer_ptr;
+
+            // The first row we read will need to fill out the pixels outside the border of the image as if they were 0.
+            for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j){
+#pragma HLS PIPELINE
+                for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p) buffer[1][j].pix[p] = 0;
+            }
+
+            // The second row just needs to be written to the buffer, but we cannot still output results because we only have 2 rows out of 3.
+            for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j)
+            {
+#pragma HLS PIPELINE
+                buffer[0][j] = in.read();
+            }
+
+            // Now iterate over the rest of the rows, now each row we get, we can output results.
+            for(ap_uint<CFG::row_bits> i = 1; i < CFG::height; ++i)
+            {
+                buffer_ptr = i%2;
+                for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j)
+                {
+#pragma HLS PIPELINE
+                    Bin_vec val_read = in.read(), res_vec;
+                    for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p)
+                        res_vec.pix[p] = val_read.pix[p] || buffer[0][j].pix[p] || buffer[1][j].pix[p];
+                    out.write(res_vec);
+
+                    buffer[buffer_ptr][j] = val_read;
+                }
+            }
+
+            // Now we have iterated the whole image, but we only have outputted height-1 rows.
+            // Output those last row extending the image with zeros at the bottom.
+            for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j){
+#pragma HLS PIPELINE
+                Bin_vec res_vec;
+                for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p) res_vec.pix[p] = buffer[0][j].pix[p] || buffer[1][j].pix[p];
+                out.write(res_vec);
+            }
+
+        #ifndef __SYNTHESIS__
+            for(ap_uint<2> i = 0; i < 2; ++i) delete[] buffer[i];
+            delete[] buffer;
+        #endif
+        }
+
+        template <typename CFG>
+        void dilation_hline(hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &out)
+        {
+            using Window = Row_window_<ap_uint<1>, CFG::pixels_per_clock, 1>;
+            Window window;
+
+            for(ap_uint<CFG::row_bits> i = 0; i < CFG::height; ++i)
+            {
+                // The row is extended with zeros at each side, every vector is output once the pixel after it is in the window.
+                window.fill(0);
+                for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width + Window::lag; ++j)
+                {
+#pragma HLS PIPELINE
+                    typename CFG::Bin_vec vec;
+                    if(j < CFG::vec_width) vec = in.read();
+                    else for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p) vec.pix[p] = 0;
+                    window.push(vec.pix);
+
+                    if(j < Window::lag) continue;
+
+                    typename CFG::Bin_vec res_vec;
+                    for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p) res_vec.pix[p] = window.at(p - 1) || window.at(p) || window.at(p + 1);
+                    out.write(res_vec);
+                }
+            }
+        }
+
+        /**
+         * @brief Holds every row of a binary image back for a row, so that whether any of its pixels is set is known
+         * before it is output, and only outputs the rows with some pixel set.
+         * @param in Streamed binary image.
+         * @param out The rows of the image with some pixel set, in order.
+         * @param active_rows Whether each row of the image has some pixel set, written before the row itself.
+         */
+        template <typename CFG>
+        void summarize_rows(hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &out,
+                            hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> &active_rows)
+        {
+            using Bin_vec = typename CFG::Bin_vec;
+
+        #ifndef __SYNTHESIS__
+            Bin_vec** buffer = new Bin_vec*[2];
+            for(ap_uint<2> i = 0; i < 2; ++i) buffer[i] = new Bin_vec[CFG::vec_width];
+        #else
+            Bin_vec buffer[2][CFG::vec_width];
+        #endif
+            ap_uint<1> held_active = 0;
+
+            // Every row is read while the one before, held back in the other buffer, is output. One more row to drain.
+            for(ap_uint<CFG::row_bits + 1> i = 0; i <= CFG::height; ++i)
+            {
+                ap_uint<1> read_ptr = i % 2, row_active = 0;
+                for(ap_uint<CFG::vec_col_bits> j = 0; j < CFG::vec_width; ++j)
+                {
+#pragma HLS PIPELINE
+                    if(i > 0)
+                    {
+                        if(j == 0) active_rows.write(held_active);
+                        if(held_active) out.write(buffer[1 - read_ptr][j]);
+                    }
+                    if(i < CFG::height)
+                    {
+                        Bin_vec vec = in.read();
+                        for(ap_uint<CFG::lane_bits> p = 0; p < CFG::pixels_per_clock; ++p) row_active |= vec.pix[p];
+                        buffer[read_ptr][j] = vec;
+                    }
+                }
+                held_active = row_active;
+            }
+
+        #ifndef __SYNTHESIS__
+            for(ap_uint<2> i = 0; i < 2; ++i) delete[] buffer[i];
+            delete[] buffer;
+        #endif
+        }
 
         /**
          * @brief Takes a binary image (0 or 1) and dilates the 1-pixels.
          * @param in Streamed binary image to process.
          * @param out Streamed dilated binary image.
          */
-        void dilation(hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> &in, hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> &out);
+        template <typename CFG>
+        void dilation(hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &out)
+        {
+#pragma HLS DATAFLOW
+            hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> half_dilated;
+            MOTDET_DATAFLOW_REGION;
+
+            // An NxN dilation can be decomposed into 2 1-dimensional kernels, N vertical and N horizontal.
+            MOTDET_DATAFLOW_PROCESS(dilation_vline<CFG>(in, half_dilated));
+            MOTDET_DATAFLOW_PROCESS(dilation_hline<CFG>(half_dilated, out));
+        }
+
+        /**
+         * @brief Same as the other dilation, along with a summary of the rows with some pixel set, so that
+         * connected_components can skip the empty ones. Only those rows are output, see summarize_rows.
+         * @param in Streamed binary image to process.
+         * @param out Rows of the dilated binary image with some pixel set.
+         * @param active_rows Whether each row of the dilated image has some pixel set, written before the row itself.
+         */
+        template <typename CFG>
+        void dilation(hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> &out,
+                      hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> &active_rows)
+        {
+#pragma HLS DATAFLOW
+            hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> half_dilated;
+            hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> dilated;
+            MOTDET_DATAFLOW_REGION;
+
+            MOTDET_DATAFLOW_PROCESS(dilation_vline<CFG>(in, half_dilated));
+            MOTDET_DATAFLOW_PROCESS(dilation_hline<CFG>(half_dilated, dilated));
+            MOTDET_DATAFLOW_PROCESS(summarize_rows<CFG>(dilated, out, active_rows));
+        }
 
     } // namespace imgutil
 } // namespace motdet
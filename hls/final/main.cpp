@@ -37,6 +37,9 @@ int main(int argc, char** argv)
 	cv::Size stream_res = cv::Size(width, height);
 
 	std::vector<motdet::Contour> detected_conts;
+#if MOTDET_REFERENCE_IN_DDR
+	std::vector<motdet::Pix_vec> reference(motdet::reference_vectors); // Stands in for the buffer in DDR.
+#endif
 
     // Start grabbing frames and checking for motion. Store the captured frame is a OpenCV Matrix (Mat).
     while(true)
@@ -64,14 +67,14 @@ int main(int argc, char** argv)
 
         unsigned char *rgb_data = (unsigned char *)frame.data;
 
-        hls::stream<motdet::Packed_pix, MOTDET_STREAM_DEPTH> &image_in = *(new hls::stream<motdet::Packed_pix, MOTDET_STREAM_DEPTH>());
-        hls::stream<motdet::Streamed_contour, MOTDET_STREAM_DEPTH> &conts_out = *(new hls::stream<motdet::Streamed_contour, MOTDET_STREAM_DEPTH>("out_main"));
+        hls::stream<motdet::Packed_pix, MOTDET_STREAM_DEPTH> image_in("in_main");
+        hls::stream<motdet::Streamed_contour, MOTDET_STREAM_DEPTH> conts_out("out_main");
 
         // Turn the RGB image to grayscale before sending to FPGA
-        for(uint32_t i = 0; i < ORIGINAL_TOTAL; i += MOTDET_REDUCTION_FACTOR)
+        for(uint32_t i = 0; i < motdet::Top_config::original_total; i += motdet::Top_config::beat_pixels)
         {
         	motdet::Packed_pix packed;
-        	for(uint8_t k = 0; k < MOTDET_REDUCTION_FACTOR; ++k)
+        	for(uint8_t k = 0; k < motdet::Top_config::beat_pixels; ++k)
         	{
         		uint32_t mapped = (i+k)*3;
         		packed.pix[k] = rgb_data[mapped] * 76.245 + rgb_data[mapped+1] * 149.685 + rgb_data[mapped+2] * 29.07;
@@ -80,7 +83,16 @@ int main(int argc, char** argv)
 
         }
 
-        detect_motion(image_in, conts_out); // Submit frame to FPGA for processing.
+        // Submit frame to FPGA for processing. This testbench records a single camera, on channel 0.
+        // Several cameras interleaved through one core are tested in hls/emulation.
+        detect_motion(image_in, conts_out
+#if MOTDET_REFERENCE_IN_DDR
+                      , reference.data(), reference.data()
+#endif
+#if MOTDET_CHANNELS > 1
+                      , 0
+#endif
+                      );
 
 		motdet::Streamed_contour cont = conts_out.read();
 
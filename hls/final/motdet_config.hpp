@@ -0,0 +1,190 @@
+#ifndef __MOTDET_MOTDET_CONFIG_HPP__
+#define __MOTDET_MOTDET_CONFIG_HPP__
+
+#include <cstdint>
+#include "ap_int.h"
+
+#define MOTDET_STREAM_DEPTH 1
+
+// Configuration of the top function detect_motion. Every one can be overridden when generating the IP core, i.e. with
+// -DORIGINAL_WIDTH=1280 -DORIGINAL_HEIGHT=720 in the cflags of the tcl script for a 720p core.
+#ifndef ORIGINAL_WIDTH
+#define ORIGINAL_WIDTH 1920
+#endif
+#ifndef ORIGINAL_HEIGHT
+#define ORIGINAL_HEIGHT 1080
+#endif
+#ifndef MOTDET_REDUCTION_FACTOR
+#define MOTDET_REDUCTION_FACTOR 4
+#endif
+#ifndef MOTDET_MAX_CONTOURS
+#define MOTDET_MAX_CONTOURS 1023
+#endif
+#ifndef MOTDET_PIXELS_PER_CLOCK
+#define MOTDET_PIXELS_PER_CLOCK 1
+#endif
+
+// Cameras served by the IP core, time-multiplexed frame by frame. With more than one, the top function takes the channel
+// of every frame and keeps a reference image per channel, see detect_motion.
+#ifndef MOTDET_CHANNELS
+#define MOTDET_CHANNELS 1
+#endif
+
+// Keep the reference image in external memory, read and written through m_axi ports, instead of in on-chip BRAM.
+// The top function then takes the address of the reference twice, see detect_motion.
+#ifndef MOTDET_REFERENCE_IN_DDR
+#define MOTDET_REFERENCE_IN_DDR 0
+#endif
+
+// Dataflow regions. In Vitis HLS the processes of a region are plain calls, made concurrent by the DATAFLOW pragma.
+// When built natively with MOTDET_EMULATION (see hls/emulation), each process runs in its own thread instead.
+#ifdef MOTDET_EMULATION
+#include "hls_dataflow.h"
+#define MOTDET_DATAFLOW_REGION hls_emu::Dataflow dataflow_region_
+#define MOTDET_DATAFLOW_PROCESS(call) dataflow_region_.process([&](){ call; })
+#else
+#define MOTDET_DATAFLOW_REGION
+#define MOTDET_DATAFLOW_PROCESS(call) call
+#endif
+
+namespace motdet
+{
+    const float motdet_frame_update_ratio = 0.0067;
+    const ap_uint<15> motdet_threshold = 23500;
+
+    // Stream depths
+
+    const ap_uint<1> stream_depth = 1;
+
+    /**
+     * @brief Bits needed to hold every value from 0 to n, both included. Used to size the ap_uint of loop counters,
+     * coordinates and accumulators from the configuration.
+     */
+    constexpr int bits_for(const unsigned long long n) { return n < 2 ? 1 : 1 + bits_for(n / 2); }
+
+    /**
+     * @brief Resolution, reduction factor and contour capacity the IP core is generated for, with every size and bit
+     * width derived from them. The kernels take one as template parameter.
+     * @tparam ORIG_WIDTH Width of the input frames. Must be a multiple of FACTOR.
+     * @tparam ORIG_HEIGHT Height of the input frames. Must be a multiple of FACTOR.
+     * @tparam FACTOR Reduction factor. Every beat of the input stream packs FACTOR pixels per downsampled pixel.
+     * @tparam MAX_CONTOURS Contours that can be tracked in a frame, before merging. Any more are dropped.
+     * @tparam PPC Downsampled pixels carried by every transaction of the streams, and processed every clock, from the
+     * downsample to the dilation. The width of the downsampled image must be a multiple of it.
+     * @tparam CHANNELS Cameras whose frames are interleaved through the core, each one with its own reference image.
+     */
+    template <unsigned int ORIG_WIDTH, unsigned int ORIG_HEIGHT, unsigned int FACTOR, unsigned int MAX_CONTOURS = 1023, unsigned int PPC = 1, unsigned int CHANNELS = 1>
+    struct Motdet_config
+    {
+        static_assert(FACTOR > 0 && ORIG_WIDTH % FACTOR == 0 && ORIG_HEIGHT % FACTOR == 0, "Motdet_config: The resolution must be a multiple of the reduction factor.");
+        static_assert(PPC > 0 && (ORIG_WIDTH / FACTOR) % PPC == 0, "Motdet_config: The downsampled width must be a multiple of the pixels per clock.");
+        static_assert(ORIG_WIDTH / FACTOR >= 5 && ORIG_HEIGHT / FACTOR >= 5, "Motdet_config: The downsampled image must be at least 5x5 for the blur.");
+        static_assert(MAX_CONTOURS > 0, "Motdet_config: At least one contour must fit.");
+        static_assert(CHANNELS > 0, "Motdet_config: At least one channel must be served.");
+
+        static constexpr unsigned int original_width = ORIG_WIDTH;
+        static constexpr unsigned int original_height = ORIG_HEIGHT;
+        static constexpr unsigned int original_total = ORIG_WIDTH * ORIG_HEIGHT;
+        static constexpr unsigned int reduction_factor = FACTOR;
+
+        static constexpr unsigned int width = ORIG_WIDTH / FACTOR;
+        static constexpr unsigned int height = ORIG_HEIGHT / FACTOR;
+        static constexpr unsigned int total = width * height;
+
+        static constexpr unsigned int pixels_per_clock = PPC;
+        static constexpr unsigned int vec_width = width / PPC;         /**< Transactions per downsampled row. */
+        static constexpr unsigned int beat_pixels = FACTOR * PPC;      /**< Input pixels per transaction.     */
+
+        static constexpr unsigned int max_contours = MAX_CONTOURS;
+        static constexpr unsigned int channels = CHANNELS;
+        static constexpr unsigned int min_cont_area = total * 0.004 + 5;
+
+        // Bit widths. Loop counters must also hold the bound that ends the loop.
+
+        static constexpr int col_bits = bits_for(width);                          /**< Columns of the downsampled image.  */
+        static constexpr int row_bits = bits_for(height);                         /**< Rows of the downsampled image.     */
+        static constexpr int pixel_bits = bits_for(total);                        /**< Pixels of the downsampled image.   */
+        static constexpr int vec_col_bits = bits_for(vec_width + 2);              /**< Transactions of a row, plus lag.   */
+        static constexpr int vec_pixel_bits = bits_for(total / PPC);              /**< Transactions of the image.         */
+        static constexpr int lane_bits = bits_for(PPC);                           /**< Pixels of a transaction.           */
+        static constexpr int original_row_bits = bits_for(ORIG_HEIGHT);           /**< Rows of the input frame.           */
+        static constexpr int coord_bits = bits_for(ORIG_WIDTH > ORIG_HEIGHT ? ORIG_WIDTH : ORIG_HEIGHT); /**< Box corners.   */
+        static constexpr int factor_bits = bits_for(FACTOR);                      /**< Pixels of a packed beat.           */
+        static constexpr int factor_sq_bits = bits_for(FACTOR * FACTOR);          /**< Pixels of a downsampled block.     */
+        static constexpr int beat_sum_bits = bits_for(65535ULL * FACTOR);         /**< Sum of the pixels of a beat.       */
+        static constexpr int block_sum_bits = bits_for(65535ULL * FACTOR * FACTOR); /**< Sum of the pixels of a block.    */
+        static constexpr int tag_bits = bits_for(MAX_CONTOURS);                   /**< Contour tags, plus the null tag.   */
+        static constexpr unsigned int null_tag = (1U << tag_bits) - 1;            /**< Tag of pixels without contour.     */
+        static constexpr int channel_bits = bits_for(CHANNELS - 1);               /**< Channel of a frame.                */
+
+        using Channel = ap_uint<channel_bits>;
+
+        struct Contour
+        {
+            ap_uint<coord_bits> bb_tl_x, bb_tl_y; /**< Top left point of the bounding box of the Contour     */
+            ap_uint<coord_bits> bb_br_x, bb_br_y; /**< Bottom right point of the bounding box of the Contour */
+        };
+
+        struct Streamed_contour
+        {
+            Contour contour;
+            bool stream_end;
+        };
+
+        struct Contour_package
+        {
+            Contour contours[MAX_CONTOURS];
+            ap_uint<tag_bits> contour_count = 0;
+        };
+
+        /**
+         * @brief Input transaction. The FACTOR pixels of a row that make each of PPC consecutive downsampled pixels.
+         */
+        struct Packed_pix
+        {
+            ap_uint<16> pix[FACTOR * PPC];
+        };
+
+        /**
+         * @brief Transaction of the grayscale streams after the downsample, PPC consecutive pixels of a row.
+         */
+        struct Pix_vec
+        {
+            ap_uint<16> pix[PPC];
+        };
+
+        /**
+         * @brief Transaction of the binary streams, PPC consecutive pixels of a row.
+         */
+        struct Bin_vec
+        {
+            ap_uint<1> pix[PPC];
+        };
+    };
+
+    /**
+     * @brief Configuration of the top function, set by the macros above.
+     */
+    using Top_config = Motdet_config<ORIGINAL_WIDTH, ORIGINAL_HEIGHT, MOTDET_REDUCTION_FACTOR, MOTDET_MAX_CONTOURS, MOTDET_PIXELS_PER_CLOCK, MOTDET_CHANNELS>;
+
+    // Common variants.
+
+    using Config_720p = Motdet_config<1280, 720, 4>;
+    using Config_1080p = Motdet_config<1920, 1080, 4>;
+    using Config_4k = Motdet_config<3840, 2160, 4>;
+    using Config_1080p_f2 = Motdet_config<1920, 1080, 2, 1023, 2>; /**< 1080p60 at factor 2, 2 pixels per clock. */
+    using Config_1080p_f1 = Motdet_config<1920, 1080, 1, 1023, 4>; /**< 1080p60 at factor 1, 4 pixels per clock. */
+
+    // Types of the top function.
+
+    using Contour = Top_config::Contour;
+    using Streamed_contour = Top_config::Streamed_contour;
+    using Contour_package = Top_config::Contour_package;
+    using Packed_pix = Top_config::Packed_pix;
+    using Pix_vec = Top_config::Pix_vec;
+    using Bin_vec = Top_config::Bin_vec;
+    using Channel = Top_config::Channel;
+
+} // namespace motdet
+
+#endif // __MOTDET_MOTDET_CONFIG_HPP__
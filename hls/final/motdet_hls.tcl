@@ -17,6 +17,16 @@ set SOLUTION_NAME "initial"
 set SOLUTION_PART "xc7z020clg400-1"
 set SOLUTION_CLKP 10
 
+# Resolution and reduction factor of the generated core, see motdet_config.hpp. I.e. for 720p:
+# set MOTDET_CONFIG_FLAGS "-DORIGINAL_WIDTH=1280 -DORIGINAL_HEIGHT=720"
+# or for 1080p60 at factor 2, with 2 pixels per clock after the downsample:
+# set MOTDET_CONFIG_FLAGS "-DMOTDET_REDUCTION_FACTOR=2 -DMOTDET_PIXELS_PER_CLOCK=2"
+# or with the reference image in DDR instead of BRAM, for resolutions that do not fit on chip:
+# set MOTDET_CONFIG_FLAGS "-DORIGINAL_WIDTH=3840 -DORIGINAL_HEIGHT=2160 -DMOTDET_REFERENCE_IN_DDR=1"
+# or for 4 cameras time-multiplexed through one core, with their references in DDR:
+# set MOTDET_CONFIG_FLAGS "-DMOTDET_CHANNELS=4 -DMOTDET_REFERENCE_IN_DDR=1"
+set MOTDET_CONFIG_FLAGS ""
+
 # ------------------------------------------------------------------------------
 # OpenCV C Simulation / CoSimulation Library References
 #------------------------------------------------------------------------------
@@ -34,13 +44,12 @@ open_project -reset $PROJ_NAME
 # ------------------------------------------------------------------------------
 # Add C++ source and Testbench files with Vision and OpenCV includes
 # ------------------------------------------------------------------------------
-add_files "${SOURCE_DIR}/motion_detector.hpp"
-add_files "${SOURCE_DIR}/motion_detector.cpp"
-add_files "${SOURCE_DIR}/image_utils.hpp"
-add_files "${SOURCE_DIR}/image_utils.cpp"
-add_files "${SOURCE_DIR}/contour_detector.hpp"
-add_files "${SOURCE_DIR}/contour_detector.cpp"
-add_files -tb "${TB_DIR}/main.cpp" -cflags "${OPENCV_INC_FLAGS}" -csimflags "${OPENCV_INC_FLAGS}"
+add_files "${SOURCE_DIR}/motdet_config.hpp" -cflags "${MOTDET_CONFIG_FLAGS}"
+add_files "${SOURCE_DIR}/motion_detector.hpp" -cflags "${MOTDET_CONFIG_FLAGS}"
+add_files "${SOURCE_DIR}/motion_detector.cpp" -cflags "${MOTDET_CONFIG_FLAGS}"
+add_files "${SOURCE_DIR}/image_utils.hpp" -cflags "${MOTDET_CONFIG_FLAGS}"
+add_files "${SOURCE_DIR}/contour_detector.hpp" -cflags "${MOTDET_CONFIG_FLAGS}"
+add_files -tb "${TB_DIR}/main.cpp" -cflags "${OPENCV_INC_FLAGS} ${MOTDET_CONFIG_FLAGS}" -csimflags "${OPENCV_INC_FLAGS} ${MOTDET_CONFIG_FLAGS}"
 
 # ------------------------------------------------------------------------------
 # Create Project and Solution
@@ -1,37 +1,32 @@
 #include "motion_detector.hpp"
 
-#include "image_utils.hpp"
-#include "contour_detector.hpp"
-
-void detect_motion(hls::stream<motdet::Packed_pix, MOTDET_STREAM_DEPTH> &in, hls::stream<motdet::Streamed_contour, MOTDET_STREAM_DEPTH> &out)
+void detect_motion(hls::stream<motdet::Packed_pix, MOTDET_STREAM_DEPTH> &in, hls::stream<motdet::Streamed_contour, MOTDET_STREAM_DEPTH> &out
+#if MOTDET_REFERENCE_IN_DDR
+                   , const motdet::Pix_vec *reference_in, motdet::Pix_vec *reference_out
+#endif
+#if MOTDET_CHANNELS > 1
+                   , motdet::Channel channel
+#endif
+                   )
 {
 #pragma HLS INTERFACE ap_fifo port=in
 #pragma HLS INTERFACE ap_fifo port=out
+#if MOTDET_REFERENCE_IN_DDR
+    const unsigned int reference_depth = motdet::reference_vectors; // Only used by the co-simulation.
+#pragma HLS INTERFACE m_axi port=reference_in offset=slave bundle=reference_rd depth=reference_depth max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=reference_out offset=slave bundle=reference_wr depth=reference_depth max_write_burst_length=256
+#pragma HLS INTERFACE s_axilite port=reference_in bundle=control
+#pragma HLS INTERFACE s_axilite port=reference_out bundle=control
+#endif
+#if MOTDET_CHANNELS > 1
+#pragma HLS INTERFACE ap_none port=channel
+#else
+    const motdet::Channel channel = 0;
+#endif
 #pragma HLS DATAFLOW
-    using namespace motdet;
-
-    hls::stream<ap_uint<16>, MOTDET_STREAM_DEPTH> downsampled("downsampled");
-    hls::stream<ap_uint<16>, MOTDET_STREAM_DEPTH> blurred("blurred");
-    hls::stream<ap_uint<16>, MOTDET_STREAM_DEPTH> subbed("subbed");
-    hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> thresholded("thresholded");
-    hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> dilated("dilated");
-
-	// Downsample the grayscale image.
-	imgutil::downsample(in, downsampled);
-
-	imgutil::gaussian_blur(downsampled, blurred);
-
-    // Interpolate the blurred image and the reference frame to obtain a new reference.
-    // Also subtract the blurred frame with the reference image. Leaving only the changes between frames.
-    imgutil::apply_reference(blurred, subbed);
-
-	// Threshold the image so that any value below a certain number is ignored.
-	imgutil::single_threshold(subbed, thresholded);
-
-	// Dilate the image so that the contours are better defined and with less holes.
-	imgutil::dilation(thresholded, dilated);
-
-	// Detect contours in the image. Any contour detected here is "movement".
-	imgutil::connected_components(dilated, out);
+#if MOTDET_REFERENCE_IN_DDR
+    motdet::detect_motion<motdet::Top_config>(in, out, reference_in, reference_out, channel);
+#else
+    motdet::detect_motion<motdet::Top_config>(in, out, channel);
+#endif
 }
-
@@ -6,60 +6,107 @@
 #include "hls_stream.h"
 #include "ap_int.h"
 
-#define MOTDET_STREAM_DEPTH 1
+#include "motdet_config.hpp"
+#include "image_utils.hpp"
+#include "contour_detector.hpp"
 
-#define ORIGINAL_WIDTH 1920 // (11b) 32
-#define ORIGINAL_HEIGHT 1080 // (11b) 32
-#define ORIGINAL_TOTAL 2073600 // (21b) 1024
+namespace motdet
+{
+    /**
+     * @brief Detects motion in a sequence of grayscale frames of any configuration. Body of the top function, can also be
+     * called directly to C-simulate other configurations than the one of the top function.
+     * @tparam CFG Motdet_config to process the frames with.
+     * @param in grayscale streamed image where each pixel is represented by a 16b unsigned integer. The higher, the more intense white.
+     * @param out Set of contours that have been detected as movement.
+     * @param channel Camera the frame comes from, below CFG::channels. Selects the reference image it is compared with.
+     */
+    template <typename CFG>
+    void detect_motion(hls::stream<typename CFG::Packed_pix, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Streamed_contour, MOTDET_STREAM_DEPTH> &out,
+                       const typename CFG::Channel channel = 0)
+    {
+#pragma HLS DATAFLOW
+        // Every stream after the downsample carries CFG::pixels_per_clock pixels per transaction.
+        hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> downsampled("downsampled");
+        hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> blurred("blurred");
+        hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> subbed("subbed");
+        hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> thresholded("thresholded");
+        hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> dilated("dilated");
+        hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> active_rows("active_rows");
+        MOTDET_DATAFLOW_REGION;
 
-// How to calculate: motdet_width = ceil( original_width/reduction_factor )
-#define MOTDET_WIDTH 480 // (9b) 8
-#define MOTDET_HEIGHT 270 // (9b) 8
-#define MOTDET_TOTAL 129600 // (17b) 64
+        // Downsample the grayscale image.
+        MOTDET_DATAFLOW_PROCESS(imgutil::downsample<CFG>(in, downsampled));
 
-#define MOTDET_MAX_CONTOURS 1023
-#define MOTDET_REDUCTION_FACTOR 4
+        MOTDET_DATAFLOW_PROCESS(imgutil::gaussian_blur<CFG>(downsampled, blurred));
 
-namespace motdet
-{
-    const float motdet_frame_update_ratio = 0.0067;
-    const ap_uint<15> motdet_threshold = 23500;
-    const ap_uint<12> motdet_min_cont_area = MOTDET_TOTAL*0.004+5;
+        // Interpolate the blurred image and the reference frame to obtain a new reference.
+        // Also subtract the blurred frame with the reference image. Leaving only the changes between frames.
+        MOTDET_DATAFLOW_PROCESS(imgutil::apply_reference<CFG>(blurred, subbed, channel));
 
-    // Stream depths
+        // Threshold the image so that any value below a certain number is ignored.
+        MOTDET_DATAFLOW_PROCESS(imgutil::single_threshold<CFG>(subbed, thresholded));
 
-    const ap_uint<1> stream_depth = 1;
+        // Dilate the image so that the contours are better defined and with less holes.
+        // Only the rows with some pixel set are passed on, the others are just flagged as empty.
+        MOTDET_DATAFLOW_PROCESS(imgutil::dilation<CFG>(thresholded, dilated, active_rows));
 
-    struct Contour
-    {
-    	ap_uint<11> bb_tl_x, bb_tl_y; /**< Top left point of the bounding box of the Contour     */
-    	ap_uint<11> bb_br_x, bb_br_y; /**< Bottom right point of the bounding box of the Contour */
-    };
+        // Detect contours in the image. Any contour detected here is "movement".
+        MOTDET_DATAFLOW_PROCESS(imgutil::connected_components<CFG>(dilated, active_rows, out));
+    }
 
-    struct Streamed_contour
+    /**
+     * @brief Same as the other detect_motion, with the reference image in external memory instead of BRAM.
+     * @tparam CFG Motdet_config to process the frames with.
+     * @param in grayscale streamed image where each pixel is represented by a 16b unsigned integer. The higher, the more intense white.
+     * @param out Set of contours that have been detected as movement.
+     * @param reference_in Reference images in external memory, CFG::total / CFG::pixels_per_clock vectors per channel.
+     * @param reference_out Same buffer as reference_in, the updated reference is written through it.
+     * @param channel Camera the frame comes from, below CFG::channels. Selects the reference image it is compared with.
+     */
+    template <typename CFG>
+    void detect_motion(hls::stream<typename CFG::Packed_pix, MOTDET_STREAM_DEPTH> &in, hls::stream<typename CFG::Streamed_contour, MOTDET_STREAM_DEPTH> &out,
+                       const typename CFG::Pix_vec *reference_in, typename CFG::Pix_vec *reference_out, const typename CFG::Channel channel = 0)
     {
-    	Contour contour;
-    	bool stream_end;
-    };
+#pragma HLS DATAFLOW
+        hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> downsampled("downsampled");
+        hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> blurred("blurred");
+        hls::stream<typename CFG::Pix_vec, MOTDET_STREAM_DEPTH> subbed("subbed");
+        hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> thresholded("thresholded");
+        hls::stream<typename CFG::Bin_vec, MOTDET_STREAM_DEPTH> dilated("dilated");
+        hls::stream<ap_uint<1>, MOTDET_STREAM_DEPTH> active_rows("active_rows");
+        MOTDET_DATAFLOW_REGION;
 
-    struct Contour_package
-    {
-        Contour contours[MOTDET_MAX_CONTOURS];
-        ap_uint<10> contour_count = 0;
-    };
+        MOTDET_DATAFLOW_PROCESS(imgutil::downsample<CFG>(in, downsampled));
+        MOTDET_DATAFLOW_PROCESS(imgutil::gaussian_blur<CFG>(downsampled, blurred));
+        MOTDET_DATAFLOW_PROCESS(imgutil::apply_reference<CFG>(blurred, subbed, reference_in, reference_out, channel));
+        MOTDET_DATAFLOW_PROCESS(imgutil::single_threshold<CFG>(subbed, thresholded));
+        MOTDET_DATAFLOW_PROCESS(imgutil::dilation<CFG>(thresholded, dilated, active_rows));
+        MOTDET_DATAFLOW_PROCESS(imgutil::connected_components<CFG>(dilated, active_rows, out));
+    }
 
-    struct Packed_pix
-    {
-    	ap_uint<16> pix[MOTDET_REDUCTION_FACTOR];
-    };
+    /**
+     * @brief Vectors of the reference images in external memory of the top function, with MOTDET_REFERENCE_IN_DDR.
+     */
+    const unsigned int reference_vectors = Top_config::channels * (Top_config::total / Top_config::pixels_per_clock);
 
 } // namespace motdet
 
 /**
- * @brief Detects motion in a sequence of grayscale frames. HLS TOP FUNCTION.
+ * @brief Detects motion in a sequence of grayscale frames. HLS TOP FUNCTION, generated for motdet::Top_config.
  * @param in grayscale streamed image where each pixel is represented by a 16b unsigned integer. The higher, the more intense white.
  * @param out Set of contours that have been detected as movement.
+ * @param reference_in Only with MOTDET_REFERENCE_IN_DDR. Address of a buffer of motdet::reference_vectors in external
+ * memory, that holds the references.
+ * @param reference_out Only with MOTDET_REFERENCE_IN_DDR. The same address as reference_in.
+ * @param channel Only with MOTDET_CHANNELS above 1. Camera the frame comes from, sampled with the start of the frame.
  */
-void detect_motion(hls::stream<motdet::Packed_pix, MOTDET_STREAM_DEPTH> &in, hls::stream<motdet::Streamed_contour, MOTDET_STREAM_DEPTH> &out);
+void detect_motion(hls::stream<motdet::Packed_pix, MOTDET_STREAM_DEPTH> &in, hls::stream<motdet::Streamed_contour, MOTDET_STREAM_DEPTH> &out
+#if MOTDET_REFERENCE_IN_DDR
+                   , const motdet::Pix_vec *reference_in, motdet::Pix_vec *reference_out
+#endif
+#if MOTDET_CHANNELS > 1
+                   , motdet::Channel channel
+#endif
+                   );
 
 #endif // __MOTDET_MOTION_DETECTOR_HPP__